@@ -0,0 +1,87 @@
+#include <Cala/CascadeFitting.h>
+#include <cmath>
+#include <cstdio>
+
+using namespace cala;
+
+// moves and turns a camera by amounts smaller than a shadow map texel and checks the fitted cascade only ever moves
+// in whole texels of light space and keeps the same extent, either of which would make shadow edges shimmer
+constexpr u32 resolution = 2048;
+constexpr f32 cascadeNear = 0.1f;
+constexpr f32 cascadeFar = 30.f;
+constexpr f32 tolerance = 0.01f; // fraction of a texel allowed for precision lost transforming in and out of light space
+
+struct Fit {
+    f32 x = 0;
+    f32 y = 0;
+    f32 extentX = 0;
+    f32 extentY = 0;
+};
+
+// origin of the cascade in the light's view space along with the width and height its projection covers
+static Fit fit(const Camera& camera, const ende::math::Quaternion& direction) {
+    auto cascade = fitCascade(cascadeSphere(camera, cascadeNear, cascadeFar), direction, resolution, { 1, 1, 1 }, { -1, -1, -1 });
+
+    Transform lightTransform({ 0, 0, 0 }, direction);
+    Camera lightCamera(ende::math::identity<4, f32>(), &lightTransform);
+    auto origin = lightCamera.view().transform(ende::math::Vec4f{ cascade.position.x(), cascade.position.y(), cascade.position.z(), 1.f });
+    // w of 0 drops the translation leaving the scale the orthographic projection applies
+    f32 scaleX = cascade.projection.transform(ende::math::Vec4f{ 1, 0, 0, 0 }).x();
+    f32 scaleY = cascade.projection.transform(ende::math::Vec4f{ 0, 1, 0, 0 }).y();
+    return { origin.x(), origin.y(), 2.f / std::abs(scaleX), 2.f / std::abs(scaleY) };
+}
+
+static f32 texelError(f32 value, f32 texelSize) {
+    f32 texels = value / texelSize;
+    return std::abs(texels - std::round(texels));
+}
+
+int main() {
+    auto direction = ende::math::Quaternion(ende::math::rad(-84), 0, ende::math::rad(-11));
+    Transform cameraTransform({ 0, 5, 0 });
+    Camera camera(ende::math::rad(60), 1920, 1080, 0.1f, 100.f, &cameraTransform);
+
+    const Fit initial = fit(camera, direction);
+    const f32 texelSize = initial.extentX / resolution;
+    std::printf("extent: %f x %f, texel: %f\n", initial.extentX, initial.extentY, texelSize);
+
+    u32 failures = 0;
+    f32 maxOriginError = 0;
+    f32 maxExtentChange = 0;
+    auto check = [&](const char* label, u32 step) {
+        Fit current = fit(camera, direction);
+        f32 originError = std::max(texelError(current.x, texelSize), texelError(current.y, texelSize));
+        f32 extentChange = std::max(std::abs(current.extentX - initial.extentX), std::abs(current.extentY - initial.extentY));
+        maxOriginError = std::max(maxOriginError, originError);
+        maxExtentChange = std::max(maxExtentChange, extentChange);
+        if (originError > tolerance || extentChange > texelSize * tolerance) {
+            if (failures < 10)
+                std::printf("%s step %u: origin off the texel grid by %f texels, extent changed by %f\n", label, step, originError, extentChange);
+            failures++;
+        }
+    };
+
+    // translations a fraction of a texel each, along an axis that isn't aligned to the light
+    const ende::math::Vec3f stepDirection = { 0.37f, 0.11f, -0.92f };
+    for (u32 step = 0; step < 2000; step++) {
+        cameraTransform.setPos(ende::math::Vec3f{ 0, 5, 0 } + stepDirection * (texelSize * 0.137f * static_cast<f32>(step)));
+        check("translate", step);
+    }
+
+    // rotations of a twentieth of a degree in yaw and pitch, the sphere radius only depends on the projection
+    cameraTransform.setPos({ 0, 5, 0 });
+    for (u32 step = 0; step < 2000; step++) {
+        cameraTransform.rotate({ 0, 1, 0 }, ende::math::rad(0.05f));
+        if (step % 4 == 0)
+            cameraTransform.rotate({ 1, 0, 0 }, ende::math::rad(step < 1000 ? 0.05f : -0.05f));
+        check("rotate", step);
+    }
+
+    std::printf("max origin error: %f texels, max extent change: %f\n", maxOriginError, maxExtentChange);
+    if (failures > 0) {
+        std::printf("%u unstable fits\n", failures);
+        return 1;
+    }
+    std::printf("all fits stable\n");
+    return 0;
+}
@@ -134,6 +134,7 @@ int main() {
     bool running = true;
     SDL_Event event;
     while (running) {
+        renderer.waitForFrame(&swapchain);
         while (SDL_PollEvent(&event)) {
             switch (event.type) {
                 case SDL_QUIT:
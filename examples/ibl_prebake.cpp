@@ -0,0 +1,43 @@
+#include <Cala/vulkan/OfflinePlatform.h>
+#include <Cala/Engine.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace cala;
+
+// bakes the sky light maps of equirectangular images into the asset cache without opening a window, so scenes using
+// them only upload the results. the brdf lut is baked by the engine on startup. image paths are relative to the asset
+// path, which can be changed with --assets <path> before the images
+int main(int argc, char* argv[]) {
+    vk::OfflinePlatform platform(1, 1);
+    Engine engine(platform);
+
+    i32 baked = 0;
+    for (i32 i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--assets") == 0 && i + 1 < argc) {
+            engine.assetManager()->setAssetPath(argv[++i]);
+            continue;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        auto image = engine.assetManager()->loadImage(argv[i], argv[i], vk::Format::RGBA32_SFLOAT);
+        if (!image) {
+            std::printf("unable to load %s\n", argv[i]);
+            continue;
+        }
+        engine.loadSkyLightMaps(image);
+        engine.device().wait();
+        f64 milliseconds = std::chrono::duration<f64, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        std::printf("%s: %.1f ms\n", argv[i], milliseconds);
+        baked++;
+    }
+
+    if (baked == 0) {
+        std::printf("usage: ibl_prebake [--assets <path>] <image>...\n");
+        return -1;
+    }
+    std::printf("cached in %s\n", engine.assetManager()->getCachePath().c_str());
+    return 0;
+}
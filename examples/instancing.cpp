@@ -0,0 +1,114 @@
+#include <Cala/vulkan/SDLPlatform.h>
+#include <Cala/Engine.h>
+#include <Cala/Renderer.h>
+#include <Cala/Scene.h>
+#include <Cala/Camera.h>
+#include <Cala/Light.h>
+#include <Cala/Material.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+using namespace cala;
+
+// places instanceCount copies of a few models on a grid and reports per instance memory, cpu time spent preparing
+// and recording the frame and gpu time while the camera flies over the grid
+int main(int argc, char* argv[]) {
+    u32 instanceCount = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    u32 frameCount = argc > 2 ? std::stoul(argv[2]) : 1000;
+    const u32 warmupFrames = 100;
+    const f32 spacing = 3;
+
+    vk::SDLPlatform platform("instancing", 1920, 1080);
+    Engine engine(platform);
+    auto swapchainResult = vk::Swapchain::create(&engine.device(), {
+        .platform = &platform
+    });
+    if (!swapchainResult)
+        return -10;
+    auto swapchain = std::move(swapchainResult.value());
+    swapchain.setPresentMode(vk::PresentMode::IMMEDIATE);
+    Renderer renderer(&engine, {});
+
+    Material* material = engine.loadMaterial("../../res/materials/pbr.mat");
+    if (!material)
+        return -2;
+
+    std::pair<const char*, const char*> modelPaths[] = {
+        { "sphere", "models/sphere.glb" },
+        { "suzanne", "models/gltf/glTF-Sample-Models/2.0/Suzanne/glTF/Suzanne.gltf" },
+        { "dragon", "models/gltf/glTF-Sample-Models/2.0/DragonAttenuation/glTF/DragonAttenuation.gltf" }
+    };
+    std::vector<AssetManager::Asset<Model>> models;
+    for (auto& [name, path] : modelPaths) {
+        auto model = engine.assetManager()->loadModel(name, path, material);
+        if (!model)
+            return -3;
+        models.push_back(model);
+    }
+
+    Scene scene(&engine, 10);
+    Camera camera((f32)ende::math::rad(54.4), platform.windowSize().first, platform.windowSize().second, 0.1f, 1000.f);
+    scene.addCamera(camera, Transform({ 0, 20, 0 }));
+
+    Light light(Light::DIRECTIONAL, true);
+    light.setDirection(ende::math::Quaternion(ende::math::rad(-84), 0, ende::math::rad(-11)));
+    light.setIntensity(2);
+    scene.addLight(light, Transform());
+
+    // models alternate across the grid so each gets an even share of the instances
+    u32 side = std::ceil(std::sqrt(static_cast<f32>(instanceCount)));
+    std::vector<std::vector<ende::math::Mat4f>> transforms(models.size());
+    for (u32 i = 0; i < instanceCount; i++) {
+        f32 x = (static_cast<f32>(i % side) - side / 2.f) * spacing;
+        f32 z = (static_cast<f32>(i / side) - side / 2.f) * spacing;
+        transforms[i % models.size()].push_back(Transform({ x, 0, z }).local());
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (u32 modelIndex = 0; modelIndex < models.size(); modelIndex++)
+        scene.addModelInstances(modelPaths[modelIndex].first, *models[modelIndex], transforms[modelIndex]);
+    f64 addTime = std::chrono::duration<f64, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    f64 cpuTime = 0;
+    f64 gpuTime = 0;
+    u32 frames = 0;
+    u32 gpuFrames = 0;
+    f32 extent = side * spacing / 2;
+    for (u32 frame = 0; frame < warmupFrames + frameCount; frame++) {
+        f32 position = -extent + 2 * extent * static_cast<f32>(frame % 600) / 600;
+        scene.getMainCamera()->transform().setPos({ position, 20, position });
+
+        if (!renderer.beginFrame(&swapchain))
+            continue;
+        // the frame index has just been waited on so its timers hold the results of the frame FRAMES_IN_FLIGHT ago
+        if (frame >= warmupFrames + vk::FRAMES_IN_FLIGHT) {
+            for (auto& timer : renderer.timers())
+                gpuTime += timer.second.result() / 1e6;
+            gpuFrames++;
+        }
+        auto frameStart = std::chrono::high_resolution_clock::now();
+        scene.prepare();
+        renderer.render(scene);
+        f64 frameTime = std::chrono::duration<f64, std::milli>(std::chrono::high_resolution_clock::now() - frameStart).count();
+        renderer.endFrame();
+
+        if (frame < warmupFrames)
+            continue;
+        cpuTime += frameTime;
+        frames++;
+    }
+    engine.device().wait();
+
+    if (frames == 0 || gpuFrames == 0)
+        return 0;
+    u64 instanceBytes = sizeof(GPUInstance) + sizeof(ende::math::Mat4f);
+    std::printf("instances: %u, unique meshes: %u\n", scene.instanceCount(), scene.meshCount());
+    std::printf("per instance: %lu bytes (mesh definition: %lu bytes shared)\n", instanceBytes, sizeof(GPUMesh));
+    std::printf("instance data: %.2f mb, mesh data: %.2f mb\n", scene.instanceCount() * instanceBytes / 1e6, scene.meshCount() * sizeof(GPUMesh) / 1e6);
+    std::printf("add instances: %.3f ms\n", addTime);
+    std::printf("%14s %14s\n", "cpu (ms)", "gpu (ms)");
+    std::printf("%14.3f %14.3f\n", cpuTime / frames, gpuTime / gpuFrames);
+    return 0;
+}
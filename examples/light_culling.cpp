@@ -0,0 +1,126 @@
+#include <Cala/vulkan/SDLPlatform.h>
+#include <Cala/Engine.h>
+#include <Cala/Renderer.h>
+#include <Cala/Scene.h>
+#include <Cala/Camera.h>
+#include <Cala/Light.h>
+#include <Cala/Material.h>
+#include <Cala/MaterialInstance.h>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <random>
+#include <string>
+
+using namespace cala;
+
+// scatters 10k then 100k small point lights over a grid of spheres and reports gpu time of light binning, cluster
+// compaction and the lit material resolve along with how much of the light index list was dropped
+int main(int argc, char* argv[]) {
+    u32 frameCount = argc > 1 ? std::stoul(argv[1]) : 1000;
+    const u32 warmupFrames = 100;
+    const u32 gridSize = 100;
+    const u32 lightCounts[] = { 10000, 100000 };
+
+    vk::SDLPlatform platform("light_culling", 1920, 1080);
+    Engine engine(platform);
+    auto swapchainResult = vk::Swapchain::create(&engine.device(), {
+        .platform = &platform
+    });
+    if (!swapchainResult)
+        return -10;
+    auto swapchain = std::move(swapchainResult.value());
+    swapchain.setPresentMode(vk::PresentMode::IMMEDIATE);
+    Renderer renderer(&engine, {});
+
+    Material* material = engine.loadMaterial("../../res/materials/pbr.mat");
+    if (!material)
+        return -2;
+    auto materialInstance = material->instance();
+
+    auto sphere = engine.assetManager()->loadModel("sphere", "models/sphere.glb", engine.getMaterial(0));
+    if (!sphere)
+        return -3;
+
+    struct Result {
+        u32 lights = 0;
+        f64 binTime = 0;
+        f64 cullTime = 0;
+        f64 resolveTime = 0;
+        u32 capacity = 0;
+        u32 dropped = 0;
+        u32 frames = 0;
+    };
+    std::vector<Result> results;
+
+    for (u32 lightCount : lightCounts) {
+        Result result;
+        result.lights = lightCount;
+
+        Scene scene(&engine, gridSize * gridSize, lightCount);
+        Camera camera((f32)ende::math::rad(54.4), platform.windowSize().first, platform.windowSize().second, 0.1f, 1000.f);
+        auto cameraNode = scene.addCamera(camera, Transform({ 0, 30, 60 }, ende::math::Quaternion({ 1, 0, 0 }, ende::math::rad(-30))));
+
+        std::vector<ende::math::Mat4f> transforms;
+        for (u32 i = 0; i < gridSize * gridSize; i++) {
+            f32 x = static_cast<f32>(i % gridSize) - gridSize / 2.f;
+            f32 z = static_cast<f32>(i / gridSize) - gridSize / 2.f;
+            transforms.push_back(Transform({ x, 0, z }).local());
+        }
+        scene.addModelInstances("sphere", *sphere, transforms, &materialInstance);
+
+        // fixed seed so both runs place lights the same way
+        std::mt19937 generator(0);
+        std::uniform_real_distribution<f32> position(-gridSize / 2.f, gridSize / 2.f);
+        std::uniform_real_distribution<f32> height(0.5f, 3.f);
+        std::uniform_real_distribution<f32> colour(0.f, 1.f);
+        for (u32 i = 0; i < lightCount; i++) {
+            Light light(Light::POINT, false);
+            light.setColour({ colour(generator), colour(generator), colour(generator) });
+            light.setIntensity(1);
+            light.setRange(2);
+            scene.addLight(light, Transform({ position(generator), height(generator), position(generator) }));
+        }
+
+        for (u32 frame = 0; frame < warmupFrames + frameCount; frame++) {
+            if (!renderer.beginFrame(&swapchain))
+                continue;
+            // the frame index has just been waited on so its timers and feedback hold the results of the frame
+            // FRAMES_IN_FLIGHT ago
+            if (frame >= warmupFrames + vk::FRAMES_IN_FLIGHT) {
+                for (auto& timer : renderer.timers()) {
+                    f64 time = timer.second.result() / 1e6;
+                    if (std::strcmp(timer.first, "bin_lights") == 0)
+                        result.binTime += time;
+                    else if (std::strcmp(timer.first, "cull_lights") == 0)
+                        result.cullTime += time;
+                    else if (std::strcmp(timer.first, "visibility_material_pass") == 0)
+                        result.resolveTime += time;
+                }
+                result.dropped = std::max(result.dropped, renderer.stats().droppedLightIndices);
+                result.frames++;
+            }
+            // culling is skipped while nothing moves so the camera sways to time it every frame
+            cameraNode->transform.setPos({ std::sin(static_cast<f32>(frame) * 0.01f) * 5.f, 30, 60 });
+            scene.prepare();
+            renderer.render(scene);
+            renderer.endFrame();
+        }
+        result.capacity = renderer.stats().lightIndexCapacity;
+        engine.device().wait();
+        results.push_back(result);
+    }
+
+    std::printf("%-10s %12s %12s %14s %14s %10s\n", "lights", "bin (ms)", "cull (ms)", "resolve (ms)", "index list", "dropped");
+    for (auto& result : results) {
+        if (result.frames == 0)
+            continue;
+        std::printf("%-10u %12.3f %12.3f %14.3f %14u %10u\n", result.lights,
+                    result.binTime / result.frames,
+                    result.cullTime / result.frames,
+                    result.resolveTime / result.frames,
+                    result.capacity,
+                    result.dropped);
+    }
+    return 0;
+}
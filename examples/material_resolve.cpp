@@ -0,0 +1,109 @@
+#include <Cala/vulkan/SDLPlatform.h>
+#include <Cala/Engine.h>
+#include <Cala/Renderer.h>
+#include <Cala/Scene.h>
+#include <Cala/Camera.h>
+#include <Cala/Light.h>
+#include <Cala/Material.h>
+#include <Cala/MaterialInstance.h>
+#include <cstring>
+#include <cstdio>
+#include <string>
+
+using namespace cala;
+
+// fills the screen with a grid of spheres whose materials alternate so every material covers tiles all over the
+// screen, then reports gpu time of the visibility buffer material resolve for 1, 10 and 100 materials
+int main(int argc, char* argv[]) {
+    u32 frameCount = argc > 1 ? std::stoul(argv[1]) : 1000;
+    const u32 warmupFrames = 100;
+    const u32 gridSize = 100;
+    const u32 materialCounts[] = { 1, 10, 100 };
+
+    vk::SDLPlatform platform("material_resolve", 1920, 1080);
+    Engine engine(platform);
+    auto swapchainResult = vk::Swapchain::create(&engine.device(), {
+        .platform = &platform
+    });
+    if (!swapchainResult)
+        return -10;
+    auto swapchain = std::move(swapchainResult.value());
+    swapchain.setPresentMode(vk::PresentMode::IMMEDIATE);
+    Renderer renderer(&engine, {});
+
+    // every material is loaded up front so the tile masks are the same size for each run
+    std::vector<MaterialInstance> materialInstances;
+    materialInstances.reserve(100);
+    for (u32 i = 0; i < 100; i++) {
+        Material* material = engine.loadMaterial("../../res/materials/pbr.mat");
+        if (!material)
+            return -2;
+        materialInstances.push_back(material->instance());
+    }
+
+    auto sphere = engine.assetManager()->loadModel("sphere", "models/sphere.glb", engine.getMaterial(0));
+    if (!sphere)
+        return -3;
+
+    struct Result {
+        u32 materials = 0;
+        f64 classifyTime = 0;
+        f64 resolveTime = 0;
+        u32 frames = 0;
+    };
+    std::vector<Result> results;
+
+    for (u32 materialCount : materialCounts) {
+        Result result;
+        result.materials = materialCount;
+
+        Scene scene(&engine, 10);
+        Camera camera((f32)ende::math::rad(54.4), platform.windowSize().first, platform.windowSize().second, 0.1f, 1000.f);
+        scene.addCamera(camera, Transform({ 0, 60, 0 }, ende::math::Quaternion({ 1, 0, 0 }, ende::math::rad(-90))));
+
+        Light light(Light::DIRECTIONAL, false);
+        light.setDirection(ende::math::Quaternion(ende::math::rad(-84), 0, ende::math::rad(-11)));
+        light.setIntensity(2);
+        scene.addLight(light, Transform());
+
+        std::vector<std::vector<ende::math::Mat4f>> transforms(materialCount);
+        for (u32 i = 0; i < gridSize * gridSize; i++) {
+            f32 x = static_cast<f32>(i % gridSize) - gridSize / 2.f;
+            f32 z = static_cast<f32>(i / gridSize) - gridSize / 2.f;
+            transforms[i % materialCount].push_back(Transform({ x, 0, z }).local());
+        }
+        for (u32 i = 0; i < materialCount; i++)
+            scene.addModelInstances("sphere", *sphere, transforms[i], &materialInstances[i]);
+
+        for (u32 frame = 0; frame < warmupFrames + frameCount; frame++) {
+            if (!renderer.beginFrame(&swapchain))
+                continue;
+            // the frame index has just been waited on so its timers hold the results of the frame FRAMES_IN_FLIGHT ago
+            if (frame >= warmupFrames + vk::FRAMES_IN_FLIGHT) {
+                for (auto& timer : renderer.timers()) {
+                    f64 time = timer.second.result() / 1e6;
+                    if (std::strcmp(timer.first, "visibility_count_pass") == 0)
+                        result.classifyTime += time;
+                    else if (std::strcmp(timer.first, "visibility_material_pass") == 0)
+                        result.resolveTime += time;
+                }
+                result.frames++;
+            }
+            scene.prepare();
+            renderer.render(scene);
+            renderer.endFrame();
+        }
+        engine.device().wait();
+        results.push_back(result);
+    }
+
+    std::printf("%-10s %16s %16s %14s\n", "materials", "classify (ms)", "resolve (ms)", "total (ms)");
+    for (auto& result : results) {
+        if (result.frames == 0)
+            continue;
+        f64 classify = result.classifyTime / result.frames;
+        f64 resolve = result.resolveTime / result.frames;
+        std::printf("%-10u %16.3f %16.3f %14.3f\n", result.materials, classify, resolve, classify + resolve);
+    }
+    return 0;
+}
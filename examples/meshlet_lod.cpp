@@ -0,0 +1,91 @@
+#include <Cala/vulkan/SDLPlatform.h>
+#include <Cala/Engine.h>
+#include <Cala/Renderer.h>
+#include <Cala/Scene.h>
+#include <Cala/Camera.h>
+#include <Cala/Light.h>
+#include <Cala/Material.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+using namespace cala;
+
+// renders one model from increasing distances and reports how much of its meshlet hierarchy the cull visits. the
+// nodes visited and meshlets tested should follow the meshlets drawn as the cut coarsens, not the size of the
+// hierarchy, which stays the same at every distance
+int main(int argc, char* argv[]) {
+    const char* modelPath = argc > 1 ? argv[1] : "models/gltf/glTF-Sample-Models/2.0/DragonAttenuation/glTF/DragonAttenuation.gltf";
+    const u32 framesPerDistance = 32;
+
+    vk::SDLPlatform platform("meshlet_lod", 1920, 1080);
+    Engine engine(platform);
+    auto swapchainResult = vk::Swapchain::create(&engine.device(), {
+        .platform = &platform
+    });
+    if (!swapchainResult)
+        return -10;
+    auto swapchain = std::move(swapchainResult.value());
+    swapchain.setPresentMode(vk::PresentMode::IMMEDIATE);
+    Renderer renderer(&engine, {});
+
+    Material* material = engine.loadMaterial("../../res/materials/pbr.mat");
+    if (!material)
+        return -2;
+    auto model = engine.assetManager()->loadModel("model", modelPath, material);
+    if (!model)
+        return -3;
+
+    ende::math::Vec3f min = { 1e9, 1e9, 1e9 };
+    ende::math::Vec3f max = { -1e9, -1e9, -1e9 };
+    for (auto& primitive : (*model).primitives) {
+        min = { std::min(min.x(), primitive.aabb.min.x()), std::min(min.y(), primitive.aabb.min.y()), std::min(min.z(), primitive.aabb.min.z()) };
+        max = { std::max(max.x(), primitive.aabb.max.x()), std::max(max.y(), primitive.aabb.max.y()), std::max(max.z(), primitive.aabb.max.z()) };
+    }
+    ende::math::Vec3f center = (min + max) * 0.5f;
+    ende::math::Vec3f halfExtent = (max - min) * 0.5f;
+    f32 radius = std::max(std::sqrt(halfExtent.x() * halfExtent.x() + halfExtent.y() * halfExtent.y() + halfExtent.z() * halfExtent.z()), 0.01f);
+
+    // shadows would add their own cull of the same hierarchy to the feedback
+    Scene scene(&engine, 10);
+    Camera camera((f32)ende::math::rad(54.4), platform.windowSize().first, platform.windowSize().second, radius * 0.01f, radius * 1000.f);
+    scene.addCamera(camera, Transform(center, ende::math::Quaternion({ 0, 1, 0 }, ende::math::rad(-90))));
+    Light light(Light::DIRECTIONAL, false);
+    light.setDirection(ende::math::Quaternion(ende::math::rad(-84), 0, ende::math::rad(-11)));
+    scene.addLight(light, Transform());
+    scene.addModel("model", *model, Transform());
+
+    std::printf("%10s %12s %12s %12s %12s %12s %12s\n", "distance", "hierarchy", "nodes", "tested", "drawn", "cull (ms)", "draw (ms)");
+    const f32 distances[] = { 1.5f, 3, 6, 12, 24, 48, 96, 192, 384 };
+    for (f32 distance : distances) {
+        scene.getMainCamera()->transform().setPos(center + ende::math::Vec3f{ radius * distance, 0, 0 });
+
+        // feedback and timers come back FRAMES_IN_FLIGHT frames late so only the last frames at each distance count
+        f64 cullTime = 0;
+        f64 drawTime = 0;
+        u32 timedFrames = 0;
+        for (u32 frame = 0; frame < framesPerDistance; frame++) {
+            if (!renderer.beginFrame(&swapchain))
+                continue;
+            if (frame >= framesPerDistance / 2) {
+                for (auto& [name, timer] : renderer.timers()) {
+                    if (std::strcmp(name, "cull") == 0)
+                        cullTime += timer.result() / 1e6;
+                    else if (std::strcmp(name, "visibility_pass") == 0)
+                        drawTime += timer.result() / 1e6;
+                }
+                timedFrames++;
+            }
+            scene.prepare();
+            renderer.render(scene);
+            renderer.endFrame();
+        }
+        auto stats = renderer.stats();
+        std::printf("%10.1f %12u %12u %12u %12u %12.3f %12.3f\n", distance, stats.sceneMeshlets, stats.visitedNodes,
+                    stats.drawnMeshlets + stats.culledMeshlets, stats.drawnMeshlets,
+                    timedFrames > 0 ? cullTime / timedFrames : 0.0, timedFrames > 0 ? drawTime / timedFrames : 0.0);
+    }
+    engine.device().wait();
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <Cala/TextureCompression.h>
+#include <stb_image.h>
+#include <filesystem>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+using namespace cala;
+
+// encodes every image in a directory to each block format and reports quality, size and encoder throughput
+int main(int argc, char* argv[]) {
+    std::filesystem::path directory = argc > 1 ? argv[1] : "../../res/textures";
+
+    struct Result {
+        vk::Format format;
+        u32 channels;
+        f64 squaredError = 0;
+        u64 samples = 0;
+        u64 uncompressedSize = 0;
+        u64 compressedSize = 0;
+        f64 seconds = 0;
+    };
+    Result results[] = {
+        { vk::Format::BC1_RGB_UNORM, 3 },
+        { vk::Format::BC4_UNORM, 1 },
+        { vk::Format::BC5_UNORM, 2 },
+        { vk::Format::BC7_UNORM, 4 }
+    };
+
+    for (auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+        if (!entry.is_regular_file())
+            continue;
+        i32 width, height, channels;
+        u8* data = stbi_load(entry.path().c_str(), &width, &height, &channels, STBI_rgb_alpha);
+        if (!data)
+            continue;
+        std::span<const u8> texels(data, width * height * 4);
+
+        for (auto& result : results) {
+            auto start = std::chrono::high_resolution_clock::now();
+            auto blocks = bc::encode(result.format, texels, width, height);
+            result.seconds += std::chrono::duration<f64>(std::chrono::high_resolution_clock::now() - start).count();
+
+            auto decoded = bc::decode(result.format, blocks, width, height);
+            for (u32 i = 0; i < decoded.size(); i += 4) {
+                for (u32 c = 0; c < result.channels; c++) {
+                    f64 difference = static_cast<f64>(texels[i + c]) - decoded[i + c];
+                    result.squaredError += difference * difference;
+                }
+            }
+            result.samples += static_cast<u64>(width) * height * result.channels;
+            result.uncompressedSize += texels.size();
+            result.compressedSize += blocks.size();
+        }
+        std::printf("%s: %dx%d\n", entry.path().filename().c_str(), width, height);
+        stbi_image_free(data);
+    }
+
+    std::printf("\n%-16s %10s %10s %12s\n", "format", "psnr (db)", "ratio", "mtexels/s");
+    for (auto& result : results) {
+        if (result.samples == 0)
+            continue;
+        f64 mse = result.squaredError / static_cast<f64>(result.samples);
+        f64 psnr = mse > 0 ? 10 * std::log10(255.0 * 255.0 / mse) : INFINITY;
+        f64 ratio = static_cast<f64>(result.uncompressedSize) / static_cast<f64>(result.compressedSize);
+        f64 throughput = static_cast<f64>(result.uncompressedSize / 4) / result.seconds / 1e6;
+        std::printf("%-16s %10.2f %9.1f:1 %12.2f\n", vk::formatToString(result.format), psnr, ratio, throughput);
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <Cala/vulkan/SDLPlatform.h>
+#include <Cala/Engine.h>
+#include <Cala/Renderer.h>
+#include <Cala/Scene.h>
+#include <Cala/Camera.h>
+#include <Cala/Light.h>
+#include <Cala/Material.h>
+#include <cstring>
+#include <cstdio>
+#include <string>
+
+using namespace cala;
+
+// loads a model with full and compact vertices and reports vertex memory and gpu time of the shadow passes while the
+// camera moves through the model so the shadow cascades keep being redrawn
+int main(int argc, char* argv[]) {
+    std::filesystem::path modelPath = argc > 1 ? argv[1] : "models/gltf/glTF-Sample-Models/2.0/Sponza/glTF/Sponza.gltf";
+    u32 frameCount = argc > 2 ? std::stoul(argv[2]) : 1000;
+    const u32 warmupFrames = 100;
+
+    vk::SDLPlatform platform("vertex_compression", 1920, 1080);
+    Engine engine(platform);
+    auto swapchainResult = vk::Swapchain::create(&engine.device(), {
+        .platform = &platform
+    });
+    if (!swapchainResult)
+        return -10;
+    auto swapchain = std::move(swapchainResult.value());
+    swapchain.setPresentMode(vk::PresentMode::IMMEDIATE);
+    Renderer renderer(&engine, {});
+
+    Material* material = engine.loadMaterial("../../res/materials/pbr.mat");
+    if (!material)
+        return -2;
+
+    struct Result {
+        const char* name;
+        Model::VertexFormat format;
+        u64 vertexBytes = 0;
+        f64 shadowTime = 0;
+        f64 gpuTime = 0;
+        u32 frames = 0;
+    };
+    Result results[] = {
+        { "full", Model::VertexFormat::FULL },
+        { "compact", Model::VertexFormat::COMPACT }
+    };
+
+    for (auto& result : results) {
+        auto model = engine.assetManager()->loadModel(std::string("model_") + result.name, modelPath, material, result.format);
+        if (!model)
+            return -3;
+        result.vertexBytes = (*model).vertexDataSize;
+
+        Scene scene(&engine, 10);
+        Camera camera((f32)ende::math::rad(54.4), platform.windowSize().first, platform.windowSize().second, 0.1f, 100.f);
+        scene.addCamera(camera, Transform({ -10, 1.3, 0 }, ende::math::Quaternion({ 0, 1, 0 }, ende::math::rad(90))));
+
+        Light light(Light::DIRECTIONAL, true);
+        light.setDirection(ende::math::Quaternion(ende::math::rad(-84), 0, ende::math::rad(-11)));
+        light.setIntensity(2);
+        light.setShadowing(true);
+        light.setCascadeCount(4);
+        light.setCascadeSplit(0, 4.5);
+        light.setCascadeSplit(1, 20);
+        light.setCascadeSplit(2, 50);
+        scene.addLight(light, Transform());
+        scene.addModel(result.name, *model, Transform());
+
+        for (u32 frame = 0; frame < warmupFrames + frameCount; frame++) {
+            f32 position = -10 + 20 * static_cast<f32>(frame % 600) / 600;
+            scene.getMainCamera()->transform().setPos({ position, 1.3, 0 });
+
+            if (!renderer.beginFrame(&swapchain))
+                continue;
+            // the frame index has just been waited on so its timers hold the results of the frame FRAMES_IN_FLIGHT ago
+            if (frame >= warmupFrames + vk::FRAMES_IN_FLIGHT) {
+                for (auto& timer : renderer.timers()) {
+                    f64 time = timer.second.result() / 1e6;
+                    result.gpuTime += time;
+                    if (std::strncmp(timer.first, "shadow", 6) == 0)
+                        result.shadowTime += time;
+                }
+                result.frames++;
+            }
+            scene.prepare();
+            renderer.render(scene);
+            renderer.endFrame();
+        }
+        engine.device().wait();
+    }
+
+    std::printf("%-10s %14s %16s %14s\n", "format", "vertices (mb)", "shadows (ms)", "gpu (ms)");
+    for (auto& result : results) {
+        if (result.frames == 0)
+            continue;
+        std::printf("%-10s %14.2f %16.3f %14.3f\n", result.name, result.vertexBytes / 1e6,
+                    result.shadowTime / result.frames, result.gpuTime / result.frames);
+    }
+    return 0;
+}
@@ -9,6 +9,10 @@
 #include <span>
 #include <Cala/util.h>
 #include <Cala/Model.h>
+#include <Cala/MappedFile.h>
+#include <Cala/vulkan/Image.h>
+#include <Cala/shaderBridge.h>
+#include <future>
 
 namespace cala {
 
@@ -32,6 +36,56 @@ namespace cala {
 
         std::span<const std::filesystem::path> getSearchPaths() const { return _searchPaths; }
 
+        // encoded block compressed textures and model geometry are stored here, defaults to "cache" in the asset path
+        void setCachePath(const std::filesystem::path& path) { _cachePath = path; }
+
+        std::filesystem::path getCachePath() const;
+
+        // model textures are block compressed if the device supports it
+        void setTextureCompression(bool compress) { _textureCompression = compress; }
+
+        bool textureCompression() const { return _textureCompression; }
+
+        // processed model geometry is written to the cache path as meshopt encoded streams and decoded on the thread
+        // pool by later loads of the model instead of being rebuilt
+        void setGeometryCache(bool cache) { _geometryCache = cache; }
+
+        bool geometryCache() const { return _geometryCache; }
+
+        // bytes of streamed mip levels uploaded each frame, at least one level is uploaded per frame while streaming
+        void setStreamingBudget(u32 bytes) { _streamingBudget = bytes; }
+
+        u32 streamingBudget() const { return _streamingBudget; }
+
+        // device memory available to the mip levels of streamed images. when requests exceed it the most detailed levels
+        // of the largest images are dropped first
+        void setResidencyBudget(u64 bytes) { _residencyBudget = bytes; }
+
+        u64 residencyBudget() const { return _residencyBudget; }
+
+        // bytes of device memory held by streamed images
+        u64 residentBytes() const;
+
+        // bytes streamed images would hold at the mip levels last requested by the gpu
+        u64 requestedBytes() const;
+
+        // frames a less detailed mip level must be requested for before an image is shrunk to it
+        void setResidencyDelay(u32 frames) { _residencyDelay = frames; }
+
+        u32 residencyDelay() const { return _residencyDelay; }
+
+        // mip levels requested by shaders indexed by bindless image index, read back by the renderer each frame
+        void updateMipFeedback(std::span<const u32> requests);
+
+        // resizes streamed images to their requested mip levels and uploads the next levels, called once per frame by
+        // the engine
+        void streamImages();
+
+        u32 streamedImages() const { return _imageStreams.size(); }
+
+        // streamed images with levels still to upload
+        u32 streamingImages() const;
+
 
         i32 getAssetIndex(u32 hash);
 
@@ -82,12 +136,19 @@ namespace cala {
         vk::ShaderModuleHandle reloadShaderModule(u32 hash);
 
 
+        // block compressed formats are encoded on the cpu with their mip chain and cached in the cache path. ktx2
+        // containers use their own format and mip levels. both are streamed from the mapped file, the small mips are
+        // uploaded immediately and the rest as shaders request them
         vk::ImageHandle loadImage(const std::string& name, const std::filesystem::path& path, vk::Format format = vk::Format::RGBA8_UNORM);
 
         vk::ImageHandle reloadImage(u32 hash);
 
+        // path relative to the asset path of an image loaded by the asset manager
+        std::optional<std::filesystem::path> getImagePath(vk::ImageHandle handle) const;
+
 
-        Asset<Model> loadModel(const std::string& name, const std::filesystem::path& path, Material* material);
+        // compact vertices halve the vertex memory of the model at the cost of position precision
+        Asset<Model> loadModel(const std::string& name, const std::filesystem::path& path, Material* material, Model::VertexFormat vertexFormat = Model::VertexFormat::FULL);
 
 
         bool isLoaded(u32 hash);
@@ -101,10 +162,54 @@ namespace cala {
 
         friend ui::AssetManagerWindow;
 
+        // cpu side of loading an image, safe to produce on worker threads and uploaded on the loading thread
+        struct DecodedImage {
+            u32 width = 0;
+            u32 height = 0;
+            u32 mips = 1;
+            vk::Format format = vk::Format::UNDEFINED;
+            // offset and size of each provided mip level within data or the mapped file, the rest are generated
+            std::vector<std::pair<u64, u64>> levels;
+            std::vector<u8> data;
+            // when open the levels are streamed from the file instead of data
+            MappedFile file;
+            f64 decodeTime = 0;
+        };
+
+        // images embedded in another file are decoded from bytes, path is then the containing file
+        std::optional<DecodedImage> decodeImage(const std::filesystem::path& path, u32 hash, vk::Format format, std::span<const u8> bytes = {});
+
+        std::optional<DecodedImage> decodeUncompressedImage(const std::filesystem::path& path, vk::Format format, std::span<const u8> bytes);
+
+        std::optional<DecodedImage> decodeCompressedImage(const std::filesystem::path& path, u32 hash, vk::Format format, std::span<const u8> bytes);
+
+        std::optional<DecodedImage> decodeKTX2Image(const std::filesystem::path& path);
+
+        // creates the decoded image, stages its levels and marks the image asset at index as loaded
+        vk::ImageHandle uploadImage(i32 index, u32 hash, const std::string& name, const std::filesystem::path& path, vk::Format format, std::optional<DecodedImage> image);
+
+        // model geometry read from the geometry cache. the streams are decoded on the thread pool and are empty if
+        // decoding failed
+        struct CachedGeometry {
+            std::vector<Model::Primitive> meshes;
+            std::vector<Meshlet> meshlets;
+            std::vector<MeshletNode> nodes;
+            std::future<std::vector<u8>> vertices;
+            std::future<std::vector<u32>> indices;
+            std::future<std::vector<u8>> primitives;
+        };
+
+        std::optional<CachedGeometry> readGeometryCache(const std::filesystem::path& sourcePath, u32 hash, u32 vertexSize);
+
+        void writeGeometryCache(const std::filesystem::path& sourcePath, u32 hash, u32 vertexSize, std::span<const Model::Primitive> meshes, std::span<const Meshlet> meshlets, std::span<const MeshletNode> nodes, std::span<const u8> vertices, std::span<const u32> indices, std::span<const u8> primitives);
+
         Engine* _engine;
 
         std::filesystem::path _rootAssetPath;
         std::vector<std::filesystem::path> _searchPaths;
+        std::filesystem::path _cachePath;
+        bool _textureCompression = true;
+        bool _geometryCache = true;
 
         struct AssetMetadata {
             std::string name;
@@ -134,9 +239,47 @@ namespace cala {
             std::filesystem::path path;
             vk::Format format;
             vk::ImageHandle imageHandle;
+            // milliseconds spent decoding or encoding on the cpu
+            f64 decodeTime = 0;
         };
         std::vector<ImageMetadata> _images;
 
+        // image whose mip levels are read from a mapped file on demand. levels are numbered from the full resolution
+        // level of the file, the image only holds the levels from baseMip
+        struct ImageStream {
+            vk::ImageHandle image;
+            MappedFile file;
+            // offset and size of each mip level within the file
+            std::vector<std::pair<u64, u64>> levels;
+            u32 width;
+            u32 height;
+            vk::Format format;
+            // first level held by the image, most detailed level uploaded and the level the view starts from
+            u32 baseMip;
+            u32 residentMip;
+            u32 viewMip;
+            // least detailed level the image is shrunk to
+            u32 tailMip;
+            // level last requested by shaders and the frame it was requested
+            u32 requestedMip;
+            u32 requestedFrame;
+            u32 createdFrame;
+            vk::Image::View view;
+        };
+        std::vector<ImageStream> _imageStreams;
+        // views replaced while streaming are kept until the frames that may use them have finished
+        std::vector<std::pair<u32, vk::Image::View>> _retiredViews;
+        u32 _streamingBudget = 16 * 1024 * 1024;
+        u64 _residencyBudget = 512 * 1024 * 1024;
+        u32 _residencyDelay = 120;
+        u32 _streamFrame = 0;
+
+        vk::ImageHandle createImageStream(MappedFile file, std::vector<std::pair<u64, u64>> levels, u32 width, u32 height, vk::Format format);
+
+        // recreates the image of a stream to hold the levels from baseMip and restages the resident levels it keeps,
+        // returns the bytes staged
+        u64 resizeImageStream(ImageStream& stream, u32 baseMip);
+
         struct ModelMetadata {
             u32 hash;
             std::string name;
@@ -6,6 +6,7 @@
 #include <Ende/math/Frustum.h>
 #include <Ende/math/Vec.h>
 #include <vector>
+#include <array>
 #include <Cala/shaderBridge.h>
 
 namespace cala {
@@ -34,7 +35,7 @@ namespace cala {
         void updateFrustum();
 
         // returns the 8 corners of a frustum
-        std::vector<ende::math::Vec4f> getFrustumCorners() const;
+        std::array<ende::math::Vec4f, 8> getFrustumCorners() const;
 
         void setExposure(f32 exposure);
 
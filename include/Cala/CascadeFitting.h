@@ -0,0 +1,26 @@
+#ifndef CALA_CASCADEFITTING_H
+#define CALA_CASCADEFITTING_H
+
+#include <Cala/Camera.h>
+#include <Ende/math/Quaternion.h>
+
+namespace cala {
+
+    struct CascadeSphere {
+        ende::math::Vec3f center;
+        f32 radius;
+    };
+
+    // bounding sphere of the slice of the camera frustum between near and far. the radius only depends on the
+    // projection so the cascade keeps its size as the camera rotates
+    CascadeSphere cascadeSphere(const Camera& camera, f32 near, f32 far);
+
+    // orthographic camera looking along the light direction enclosing the sphere. the position is snapped to whole
+    // texels of a tile with the given resolution so the projection only moves in texel steps as the camera moves.
+    // depth is fitted to the sphere and the bounds of the shadow casters (ignored if min > max)
+    GPUCamera fitCascade(const CascadeSphere& sphere, const ende::math::Quaternion& direction, u32 resolution,
+                         const ende::math::Vec3f& casterMin, const ende::math::Vec3f& casterMax);
+
+}
+
+#endif //CALA_CASCADEFITTING_H
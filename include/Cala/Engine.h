@@ -11,6 +11,8 @@
 #include <spdlog/spdlog.h>
 
 #include <Cala/AssetManager.h>
+#include <Cala/ThreadPool.h>
+#include <Cala/ShadowAtlas.h>
 
 #include <Cala/shaderBridge.h>
 
@@ -34,6 +36,8 @@ namespace cala {
 
         AssetManager* assetManager() { return &_assetManager; }
 
+        ThreadPool& threadPool() { return _threadPool; }
+
         std::chrono::system_clock::duration getRunningTime() const { return std::chrono::system_clock::now() - _startTime; }
 
         bool gc();
@@ -44,12 +48,25 @@ namespace cala {
 
         vk::ImageHandle generatePrefilteredIrradiance(vk::ImageHandle cubeMap);
 
+        struct SkyLightMaps {
+            vk::ImageHandle cubeMap;
+            vk::ImageHandle irradiance;
+            vk::ImageHandle prefiltered;
+        };
+
+        // converts an equirectangular sky to a cube map and generates its irradiance and prefiltered maps. the results
+        // are cached in the asset cache path keyed by the contents of the source image and the map sizes, so later
+        // loads only upload them
+        SkyLightMaps loadSkyLightMaps(vk::ImageHandle equirectangular);
+
         u32 uploadVertexData(std::span<f32> data);
 
         u32 uploadIndexData(std::span<u32> data);
 
         u32 uploadMeshletData(std::span<Meshlet> data);
 
+        u32 uploadMeshletNodeData(std::span<MeshletNode> data);
+
         u32 uploadPrimitiveData(std::span<u8> data);
 
         template <typename T>
@@ -113,6 +130,8 @@ namespace cala {
 
         vk::BufferHandle meshletBuffer() const { return _globalMeshletBuffer; }
 
+        vk::BufferHandle meshletNodeBuffer() const { return _globalMeshletNodeBuffer; }
+
         vk::BufferHandle primitiveBuffer() const { return _globalPrimitiveBuffer; }
 
         VkVertexInputBindingDescription globalBinding() const {
@@ -142,15 +161,23 @@ namespace cala {
             BLOOM_DOWNSAMPLE,
             BLOOM_UPSAMPLE,
             BLOOM_COMPOSITE,
+            BLOOM_DOWNSAMPLE_SPD,
+            BLOOM_UPSAMPLE_CHAIN,
+            UPSCALE,
+            MOTION_VECTORS,
+            TAA,
             CULL_MESH_SHADER,
             CULL_POINT,
             CULL_DIRECT,
             CULL_LIGHTS,
-            CREATE_CLUSTERS,
+            BIN_LIGHTS,
             VISIBILITY,
             VISIBILITY_COUNT,
             VISIBILITY_OFFSET,
             VISIBILITY_POSITION,
+            SHADING_RATE,
+            DEPTH_PYRAMID,
+            PROBE_UPDATE,
             DEBUG_MESHLETS,
             DEBUG_PRIMITIVES,
             DEBUG_CLUSTER,
@@ -167,15 +194,21 @@ namespace cala {
 
         const vk::ShaderProgram& getProgram(ProgramType type);
 
-        vk::ImageHandle getShadowMap(u32 index, bool point, vk::CommandHandle cmd = {});
-
+        // size of the largest tile a single shadow view can be assigned in the atlas
         void setShadowMapSize(u32 size);
 
-        u32 getShadowMapSize() const { return _shadowMapSize; }
+        u32 getShadowMapSize() const { return _shadowAtlas.maxTileSize(); }
+
+        void setShadowAtlasSize(u32 size);
+
+        u32 getShadowAtlasSize() const { return _shadowAtlas.size(); }
 
-        vk::ImageHandle getShadowTarget() const { return _shadowTarget; }
+        vk::ImageHandle getShadowAtlasImage() const { return _shadowAtlasImage; }
 
-        vk::Framebuffer* getShadowFramebuffer();
+        // static shadow casters are cached here and composited into the atlas with dynamic casters each frame
+        vk::ImageHandle getShadowCacheImage() const { return _shadowCacheImage; }
+
+        ShadowAtlas& shadowAtlas() { return _shadowAtlas; }
 
 
         void saveImageToDisk(const std::filesystem::path& path, vk::ImageHandle handle);
@@ -188,6 +221,8 @@ namespace cala {
 
         spdlog::logger _logger;
 
+        ThreadPool _threadPool;
+
         std::unique_ptr<vk::Device> _device;
 
         AssetManager _assetManager;
@@ -197,8 +232,6 @@ namespace cala {
         vk::SamplerHandle _lodSampler;
         vk::SamplerHandle _irradianceSampler;
 
-        vk::RenderPass _shadowPass;
-
         vk::ShaderProgram _pointShadowProgram;
         vk::ShaderProgram _directShadowProgram;
 
@@ -211,17 +244,25 @@ namespace cala {
         vk::ShaderProgram _cullMeshShaderProgram;
         vk::ShaderProgram _pointShadowCullProgram;
         vk::ShaderProgram _directShadowCullProgram;
-        vk::ShaderProgram _createClustersProgram;
+        vk::ShaderProgram _binLightsProgram;
         vk::ShaderProgram _cullLightsProgram;
 
         vk::ShaderProgram _bloomDownsampleProgram;
         vk::ShaderProgram _bloomUpsampleProgram;
         vk::ShaderProgram _bloomCompositeProgram;
+        vk::ShaderProgram _bloomDownsampleSpdProgram;
+        vk::ShaderProgram _bloomUpsampleChainProgram;
+        vk::ShaderProgram _upscaleProgram;
+        vk::ShaderProgram _motionVectorsProgram;
+        vk::ShaderProgram _taaProgram;
 
         vk::ShaderProgram _visibilityBufferProgram;
         vk::ShaderProgram _visibilityCountProgram;
         vk::ShaderProgram _visibilityOffsetProgram;
         vk::ShaderProgram _visibilityPositionsProgram;
+        vk::ShaderProgram _shadingRateProgram;
+        vk::ShaderProgram _depthPyramidProgram;
+        vk::ShaderProgram _probeUpdateProgram;
 
         vk::ShaderProgram _meshletDebugProgram;
         vk::ShaderProgram _primitiveDebugProgram;
@@ -243,8 +284,10 @@ namespace cala {
         u32 _indexOffset;
 
         vk::BufferHandle _globalMeshletBuffer;
+        vk::BufferHandle _globalMeshletNodeBuffer;
         vk::BufferHandle _globalPrimitiveBuffer;
         u32 _meshletOffset;
+        u32 _meshletNodeOffset;
         u32 _primitiveOffset;
 
         struct StagedBufferInfo {
@@ -273,10 +316,9 @@ namespace cala {
 
         Mesh* _cube;
 
-        std::vector<vk::ImageHandle> _shadowMaps;
-        u32 _shadowMapSize;
-        vk::ImageHandle _shadowTarget;
-        vk::Framebuffer* _shadowFramebuffer;
+        ShadowAtlas _shadowAtlas;
+        vk::ImageHandle _shadowAtlasImage;
+        vk::ImageHandle _shadowCacheImage;
 
         std::vector<Material> _materials;
 
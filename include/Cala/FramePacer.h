@@ -0,0 +1,86 @@
+#ifndef CALA_FRAMEPACER_H
+#define CALA_FRAMEPACER_H
+
+#include <Ende/platform.h>
+#include <Cala/vulkan/Device.h>
+#include <array>
+#include <chrono>
+
+namespace cala {
+
+    namespace vk {
+        class Swapchain;
+    }
+
+    // holds the cpu back so input is sampled as close to when the frame reaches the screen as possible. wait() belongs
+    // right before input is polled, it blocks until no more than framesInFlight frames are queued, on their
+    // presentation when VK_KHR_present_wait is available or their gpu completion otherwise, then sleeps until the gpu
+    // is predicted to be ready for the next frame
+    class FramePacer {
+    public:
+
+        struct Settings {
+            u32 framesInFlight = vk::FRAMES_IN_FLIGHT; // 1 to FRAMES_IN_FLIGHT, fewer lowers latency at the cost of throughput
+            bool adaptiveWait = true; // sleep until queued gpu work is predicted to finish instead of queueing behind it
+            f32 waitMargin = 1.f; // milliseconds the adaptive wait wakes up early to absorb mispredictions
+            bool presentWait = true; // pace on presentation rather than gpu completion when supported
+            f32 targetFrameTime = 0; // milliseconds between frames when capping the frame rate, 0 for uncapped
+        };
+
+        struct Stats {
+            f32 latency = 0; // smoothed milliseconds from input sampling until the frame was presented or finished on the gpu
+            f32 waitTime = 0; // milliseconds the last wait() blocked or slept
+            f32 cpuTime = 0; // smoothed milliseconds from input sampling until present was called
+            u32 framesInFlight = 0;
+            bool presentWait = false; // latency measured to presentation, otherwise to gpu completion
+        };
+
+        explicit FramePacer(vk::Device* device);
+
+        // gpuTime is the predicted gpu milliseconds of a frame
+        void wait(vk::Swapchain* swapchain, f64 gpuTime);
+
+        // true if wait() was called since the last submitted()
+        bool waited() const { return _waited; }
+
+        // called once the frame has been presented, presentId as returned by the swapchain, 0 without one
+        void submitted(u64 presentId);
+
+        Settings& settings() { return _settings; }
+
+        Stats stats() const { return _stats; }
+
+    private:
+
+        using Clock = std::chrono::steady_clock;
+
+        struct FrameRecord {
+            u64 frame = 0;
+            u64 presentId = 0;
+            Clock::time_point inputTime = {};
+            Clock::time_point submitTime = {};
+            bool submitted = false;
+            bool complete = false;
+        };
+
+        bool usePresentWait(vk::Swapchain* swapchain) const;
+
+        void complete(FrameRecord& record, Clock::time_point time);
+
+        FrameRecord& record(u64 frame) { return _records[frame % _records.size()]; }
+
+        vk::Device* _device = nullptr;
+        Settings _settings = {};
+        Stats _stats = {};
+
+        // frames move through the ring from input sampling to completion, it only has to outlive the frames in flight
+        std::array<FrameRecord, vk::FRAMES_IN_FLIGHT + 2> _records = {};
+        u64 _currentFrame = 0;
+        Clock::time_point _lastFrameStart = {};
+        bool _waited = false;
+
+    };
+
+}
+
+#endif //CALA_FRAMEPACER_H
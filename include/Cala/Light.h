@@ -77,7 +77,9 @@ namespace cala {
         f32 getCascadeSplit(i32 cascade) const { return _cascadeSplits[cascade]; }
         void setCascadeSplit(i32 cascade, f32 range) { _cascadeSplits[cascade] = range; }
 
-        void setCascadeShadowMap(i32 cascade, vk::ImageHandle shadowMap);
+        // tile within the shadow map used by a cascade or cube face, offset in xy and scale in zw
+        void setShadowTile(u32 view, const ende::math::Vec4f& tile);
+        const ende::math::Vec4f& getShadowTile(u32 view) const { return _shadowTiles[view]; }
 
         i32 getCameraIndex() const { return _cameraIndex; }
         void setCameraIndex(i32 index) { _cameraIndex = index; }
@@ -97,7 +99,7 @@ namespace cala {
         f32 _range;
         i32 _cascadeCount = 0;
         f32 _cascadeSplits[10] = {};
-        vk::ImageHandle _cascadeMaps[10] = {};
+        ende::math::Vec4f _shadowTiles[MAX_CASCADES] = {};
         i32 _cameraIndex = -1;
 
         vk::ImageHandle _shadowMap = {};
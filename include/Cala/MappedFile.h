@@ -0,0 +1,42 @@
+#ifndef CALA_MAPPEDFILE_H
+#define CALA_MAPPEDFILE_H
+
+#include <Ende/platform.h>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+namespace cala {
+
+    // read only memory mapping of a whole file, unmapped on destruction
+    class MappedFile {
+    public:
+
+        // padding zeroed bytes are readable past the end of the file for parsers that read ahead
+        static std::optional<MappedFile> open(const std::filesystem::path& path, u64 padding = 0);
+
+        MappedFile() = default;
+
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& rhs) noexcept;
+        MappedFile& operator=(MappedFile&& rhs) noexcept;
+
+        std::span<const u8> data() const { return { _data, _size }; }
+
+        u64 size() const { return _size; }
+
+    private:
+
+        const u8* _data = nullptr;
+        u64 _size = 0;
+        u64 _mappedSize = 0;
+
+    };
+
+}
+
+#endif //CALA_MAPPEDFILE_H
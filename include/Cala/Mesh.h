@@ -22,6 +22,12 @@ namespace cala {
         VkVertexInputBindingDescription _binding = {};
         std::array<vk::Attribute, 3> _attributes = {};
 
+        bool compactVertices = false;
+
+        // roots of the meshlet node hierarchy in the engine's node buffer, one per simplification level
+        u32 nodeOffset = 0;
+        u32 rootCount = 0;
+
     };
 
 }
@@ -14,6 +14,11 @@ namespace cala {
 
         Model() = default;
 
+        enum class VertexFormat {
+            FULL,
+            COMPACT // 16 byte CompactVertex with positions quantized to each primitive's bounds
+        };
+
         struct AABB {
             ende::math::Vec3f min;
             ende::math::Vec3f max;
@@ -33,6 +38,9 @@ namespace cala {
             AABB aabb;
             LOD lods[10];
             u32 lodCount;
+            u32 nodeOffset;
+            u32 rootCount;
+            bool compactVertices;
         };
 
         struct Node {
@@ -49,6 +57,9 @@ namespace cala {
 
         std::vector<vk::ImageHandle> images;
 
+        VertexFormat vertexFormat = VertexFormat::FULL;
+        u64 vertexDataSize = 0;
+
         VkVertexInputBindingDescription _binding = {};
         std::array<vk::Attribute, 4> _attributes = {};
 
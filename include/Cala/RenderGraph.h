@@ -6,6 +6,8 @@
 #include <tsl/robin_map.h>
 #include <Cala/vulkan/Timer.h>
 #include <Ende/math/Vec.h>
+#include <future>
+#include <algorithm>
 
 namespace cala {
 
@@ -18,12 +20,16 @@ namespace cala {
 
     struct ImageResource : public Resource {
         bool matchSwapchain = true;
+        // with matchSwapchain, follows the scaled backbuffer the scene is rendered at instead of the backbuffer
+        bool scaled = false;
         u32 width = 1;
         u32 height = 1;
         u32 depth = 1;
         u32 mipLevels = 1;
         vk::Format format = vk::Format::RGBA8_UNORM;
         vk::ImageUsage usage = vk::ImageUsage::SAMPLED | vk::ImageUsage::TRANSFER_SRC;
+        // contents are kept between frames. first access loads instead of clearing and last access stores
+        bool persistent = false;
     };
 
     struct BufferResource : public Resource {
@@ -55,6 +61,10 @@ namespace cala {
 
         void setDimensions(u32 width, u32 height);
 
+        // allows pass to be recorded into a secondary command buffer on a worker thread. execute function must not
+        // depend on state modified by other passes while recording (e.g. reading tracked image layouts)
+        void setParallelRecording(bool parallel) { _parallelRecording = parallel; }
+
 
         void addColourWrite(const char* label, const std::array<f32, 4>& clearColour = { 0.f, 0.f, 0.f, 1.f });
         void addColourWrite(ImageIndex index, const std::array<f32, 4>& clearColour = { 0.f, 0.f, 0.f, 1.f });
@@ -168,6 +178,8 @@ namespace cala {
 
         const char* _debugGroup = nullptr;
 
+        bool _parallelRecording = false;
+
     };
 
     class RenderGraph {
@@ -185,6 +197,17 @@ namespace cala {
 
         ende::math::Vec<2, u32> getBackbufferDimensions() { return { _backbufferWidth, _backbufferHeight }; }
 
+        void setRenderScale(f32 scale) { _renderScale = scale; }
+
+        f32 getRenderScale() const { return _renderScale; }
+
+        ende::math::Vec<2, u32> getScaledBackbufferDimensions() {
+            return {
+                std::max(static_cast<u32>(static_cast<f32>(_backbufferWidth) * _renderScale), 1u),
+                std::max(static_cast<u32>(static_cast<f32>(_backbufferHeight) * _renderScale), 1u)
+            };
+        }
+
         ImageIndex addImageResource(const char* label, ImageResource resource, vk::ImageHandle handle = {});
 
         BufferIndex addBufferResource(const char* label, BufferResource resource, vk::BufferHandle handle = {});
@@ -212,10 +235,14 @@ namespace cala {
 
         void reset();
 
+        void setParallelRecording(bool enabled) { _parallelRecording = enabled; }
+
+        // timers of the last graph compiled on the current frame index, which may hold a different pass count to the
+        // graph compiled since on the other frame index
         std::span<std::pair<const char*, vk::Timer>> getTimers() {
             u32 frameIndex = _engine->device().frameIndex();
-            assert(_orderedPasses.size() <= _timers[frameIndex].size());
-            return { _timers[frameIndex].data(), static_cast<u32>(_orderedPasses.size()) };
+            u32 count = std::min(_timedPassCount[frameIndex], static_cast<u32>(_timers[frameIndex].size()));
+            return { _timers[frameIndex].data(), count };
         }
 
 //    private:
@@ -228,6 +255,8 @@ namespace cala {
 
         void buildRenderPasses();
 
+        void recordSecondaryBuffers();
+
         void log();
 
         Engine* _engine;
@@ -235,6 +264,7 @@ namespace cala {
         const char* _backbuffer;
         u32 _backbufferWidth;
         u32 _backbufferHeight;
+        f32 _renderScale = 1.f;
 
         std::vector<RenderPass> _passes;
 
@@ -246,9 +276,15 @@ namespace cala {
         std::vector<vk::BufferHandle> _buffers;
 
         std::vector<std::pair<const char*, vk::Timer>> _timers[vk::FRAMES_IN_FLIGHT];
+        u32 _timedPassCount[vk::FRAMES_IN_FLIGHT] = {};
 
         std::vector<RenderPass*> _orderedPasses;
 
+        bool _parallelRecording;
+        // recording thread and secondary buffer for each ordered pass, thread is -1 if recorded inline
+        std::vector<std::pair<i32, vk::CommandHandle>> _secondaryBuffers;
+        std::vector<std::future<void>> _recordingTasks;
+
     };
 
 }
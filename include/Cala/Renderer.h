@@ -6,6 +6,7 @@
 #include <Cala/vulkan/Buffer.h>
 #include <Cala/vulkan/Timer.h>
 #include <Cala/RenderGraph.h>
+#include <Cala/FramePacer.h>
 
 #include <Cala/shaderBridge.h>
 
@@ -31,11 +32,13 @@ namespace cala {
             i32 tonemapType = 0;
             bool bloom = true;
             f32 bloomStrength = 0.3;
+            bool compactBloom = true; // half precision mip chains and a single pass downsample
             int shadowMode = 0;
             i32 pcfSamples = 20;
             i32 blockerSamples = 20;
             float lodTransitionBase = 20;
             float lodTransitionStep = 1.25;
+            f32 lodErrorThreshold = 1.f; // pixels of simplification error allowed before meshlets are refined
             i32 lodBias = 0;
             i32 shadowLodBias = 0;
             bool depthPre = false;
@@ -43,8 +46,31 @@ namespace cala {
             bool freezeFrustum = false;
             bool ibl = false;
             bool gpuCulling = true;
+            bool coneCulling = true;
+            bool shadowConeCulling = false; // shadows are two sided so only safe for closed meshes
+            bool smallPrimitiveCulling = true;
+            bool occlusionCulling = false; // culls against last frame's depth so newly disoccluded meshlets can pop in
             bool boundedFrameTime = false;
             f32 millisecondTarget = 1000.f / 60.f;
+            i32 framesInFlight = vk::FRAMES_IN_FLIGHT; // frames queued ahead of the display, at most FRAMES_IN_FLIGHT
+            bool adaptiveFrameWait = true; // delays input sampling until the gpu is predicted to need the next frame
+            f32 frameWaitMargin = 1.f; // milliseconds of slack left by the adaptive wait
+            bool presentWait = true; // paces on presentation when VK_KHR_present_wait is supported
+            bool dynamicResolution = false; // scales the internal resolution to hold gpuTimeTarget
+            f32 gpuTimeTarget = 1000.f / 60.f;
+            f32 minRenderScale = 0.5f;
+            f32 maxRenderScale = 1.f;
+            f32 renderScale = 1.f; // fixed internal resolution used when dynamicResolution is off
+            bool taa = false;
+            f32 taaBlendFactor = 0.1f; // weight of the new frame against the accumulated history
+            bool variableRateShading = false; // shades flat tiles of the lit resolve at 2x1 or 2x2
+            f32 shadingRateThreshold = 0.02f; // neighbour luminance variance relative to the tile's squared brightness
+            f32 shadingRateDepthThreshold = 0.05f; // relative depth range above which a tile is shaded fully
+            bool probeGI = false; // diffuse bounce light from a grid of irradiance probes fit around the scene
+            std::array<i32, 3> probeGridSize = { 16, 8, 16 };
+            i32 probeUpdateBudget = 256; // probes updated per frame, bounds the cost whatever the grid size
+            f32 probeHysteresis = 0.95f; // weight of a probe's history against each new update
+            bool parallelRecording = true;
 
             bool debugUnlit = false;
             bool debugClusters = false;
@@ -65,6 +91,10 @@ namespace cala {
 
         Renderer(Engine* engine, Settings settings);
 
+        // blocks until the next frame should start, call right before sampling input. beginFrame waits here itself
+        // if it wasn't called
+        void waitForFrame(vk::Swapchain* swapchain);
+
         bool beginFrame(vk::Swapchain* swapchain);
 
         f64 endFrame();
@@ -79,11 +109,28 @@ namespace cala {
             u32 drawnMeshlets = 0;
             u32 culledMeshes = 0;
             u32 culledMeshlets = 0;
+            u32 coneCulledMeshlets = 0;
+            u32 smallCulledMeshlets = 0;
+            u32 occludedMeshlets = 0;
             u32 drawnTriangles = 0;
             u32 sceneMeshlets = 0;
             u32 sceneIndices = 0;
             u32 currentMeshlet = 0;
             u32 currentMesh = 0;
+            u32 shadowViewsRefreshed = 0;
+            u32 shadowViewsComposited = 0;
+            u32 shadowViewsReused = 0;
+            u32 lightIndexCapacity = 0;
+            u32 droppedLightIndices = 0;
+            u32 visitedNodes = 0; // meshlet hierarchy nodes tested, grows with the lod cut rather than the whole hierarchy
+            u32 drawCommandCapacity = 0;
+            u32 droppedDrawCommands = 0;
+            f32 shadedPixelRatio = 1.f; // shaded over covered pixels in the lit resolve, below 1 with variable rate shading
+            f32 renderScale = 1.f;
+            f32 gpuTime = 0; // smoothed milliseconds of all timed passes
+            f32 inputLatency = 0; // smoothed milliseconds from input sampling to presentation, or gpu completion without present wait
+            f32 frameWaitTime = 0; // milliseconds the frame pacer held the cpu back before input sampling
+            bool presentLatency = false; // inputLatency is measured to presentation
         };
 
         Stats stats() const { return _stats; }
@@ -104,6 +151,7 @@ namespace cala {
 
         vk::BufferHandle _globalDataBuffer[vk::FRAMES_IN_FLIGHT];
         vk::BufferHandle _feedbackBuffer[vk::FRAMES_IN_FLIGHT];
+        vk::BufferHandle _mipFeedbackBuffer[vk::FRAMES_IN_FLIGHT];
 
     public:
         RenderGraph _graph;
@@ -122,8 +170,66 @@ namespace cala {
         GlobalData _globalData;
         FeedbackInfo _feedbackInfo;
 
+        // pyramid built at the end of the last frame along with the camera it was rendered from
+        vk::ImageHandle _depthPyramid;
+        std::vector<vk::Image::View> _depthPyramidViews;
+        ende::math::Mat4f _depthPyramidViewProjection;
+        bool _depthPyramidValid = false;
+
+        // per mip views of the compact bloom chains, recreated when the graph hands back different images
+        vk::ImageHandle _bloomDownsampleChain;
+        std::vector<vk::Image::View> _bloomDownsampleViews;
+        vk::ImageHandle _bloomUpsampleChain;
+        std::vector<vk::Image::View> _bloomUpsampleViews;
+        // per mip views replaced while frames that bound them may still be in flight, with the frames left until destroyed
+        std::vector<std::pair<u32, vk::Image::View>> _retiredViews;
+
+        // taa history ping pongs between two persistent images, accumulation restarts if the one read isn't the one
+        // written last frame
+        vk::ImageHandle _taaHistory;
+        bool _taaHistoryValid = false;
+        u32 _taaFrame = 0;
+
+        // last frame's unjittered camera and transforms, motion vectors reproject into them
+        ende::math::Mat4f _previousViewProjection;
+        vk::BufferHandle _previousTransforms;
+        bool _previousTransformsValid = false;
+
+        // hdr image the last resolve wrote while history was kept, shading rates and probe updates only read last frame's
+        // lighting from it while it's the same image
+        vk::ImageHandle _hdrHistory;
+        // unjittered camera and jitter the history was rendered with, shading rates reproject into it
+        ende::math::Mat4f _hdrHistoryViewProjection;
+        ende::math::Vec<2, f32> _hdrHistoryJitter = { 0, 0 };
+
+        // probe grid bounds and size, probes are cleared when these change or the graph hands back a different buffer
+        ende::math::Vec3f _probeGridMin = { 0, 0, 0 };
+        ende::math::Vec3f _probeGridMax = { 0, 0, 0 };
+        ende::math::Vec<3, u32> _probeGridSize = { 0, 0, 0 };
+        vk::BufferHandle _probeBuffer;
+        bool _probeGridValid = false;
+        // probes are updated round robin through the part of the grid inside the camera frustum
+        u32 _probeCursor = 0;
+
+        // entries in the clustered light index list, grown when the gpu reports it overflowed
+        u32 _lightIndexCapacity = 0;
+        // meshlet range commands of the main view and of each light's shadow views, grown the same way
+        u32 _drawCommandCapacity = 0;
+        u32 _shadowDrawCommandCapacity = 0;
+        // what the light grid was last culled into and with, culling is skipped while these still match
+        vk::BufferHandle _culledLightGrid;
+        vk::BufferHandle _culledLightIndices;
+        ende::math::Vec<2, u32> _culledLightsSize = { 0, 0 };
+        i32 _culledLightsCamera = -1;
+
         ende::math::Vec<2, u32> _cursorPos;
 
+        FramePacer _framePacer;
+
+        f32 _renderScale = 1.f;
+        f64 _gpuTime = 0;
+        u32 _renderScaleCooldown = 0;
+
     };
 
 }
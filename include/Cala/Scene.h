@@ -10,6 +10,8 @@
 #include <Cala/Light.h>
 #include <Cala/Engine.h>
 #include <Cala/shaderBridge.h>
+#include <tsl/robin_map.h>
+#include <span>
 
 namespace cala {
 
@@ -25,13 +27,18 @@ namespace cala {
 
         u32 meshCount() const { return _meshData.size(); }
 
+        u32 instanceCount() const { return _instances.size(); }
+
+        bool materialInUse(u32 materialID) const { return materialID < _materialInstanceCounts.size() && _materialInstanceCounts[materialID] > 0; }
+
         u32 lightCount() const { return _lights.size(); }
 
         enum class NodeType {
             NONE = 0,
             MESH = 1,
             LIGHT = 2,
-            CAMERA = 3
+            CAMERA = 3,
+            INSTANCES = 4
         };
 
         struct SceneNode {
@@ -49,6 +56,12 @@ namespace cala {
             i32 index;
         };
 
+        // many instances of one mesh placed relative to the node
+        struct InstancesNode : public SceneNode {
+            u32 firstInstance;
+            std::vector<ende::math::Mat4f> transforms;
+        };
+
         struct LightNode : public SceneNode {
             i32 index;
         };
@@ -61,8 +74,14 @@ namespace cala {
 
         SceneNode* addModel(const std::string& name, Model& model, const Transform& transform, SceneNode* parent = nullptr);
 
+        // places the whole model at every transform, each primitive is stored once and drawn as instances. the material
+        // instance overrides the model's materials if set
+        SceneNode* addModelInstances(const std::string& name, Model& model, std::span<const ende::math::Mat4f> transforms, MaterialInstance* materialInstance = nullptr, SceneNode* parent = nullptr);
+
         SceneNode* addMesh(const Mesh& mesh, const Transform& transform, MaterialInstance* materialInstance = nullptr, SceneNode* parent = nullptr);
 
+        SceneNode* addInstances(const Mesh& mesh, std::span<const ende::math::Mat4f> transforms, MaterialInstance* materialInstance = nullptr, SceneNode* parent = nullptr);
+
         SceneNode* addLight(const Light& light, const Transform& transform, SceneNode* parent = nullptr);
 
         SceneNode* addCamera(const Camera& camera, const Transform& transform, SceneNode* parent = nullptr);
@@ -87,13 +106,26 @@ namespace cala {
 
 //    private:
 
+        // returns the index of the stored copy of the mesh, adding it if this is its first placement
+        u32 addMeshData(const Mesh& mesh);
+
+        u32 addInstance(u32 meshIndex, MaterialInstance* materialInstance, const ende::math::Mat4f& transform);
+
+        void removeInstances(u32 firstInstance, u32 count);
+
         Engine* _engine;
 
         u32 _directionalLightCount;
 
+        // light data and cameras are only uploaded for this many more frames after they change
         i32 _lightsDirtyFrame;
+        i32 _camerasDirtyFrame = vk::FRAMES_IN_FLIGHT;
+        // set by prepare when the light data or the scene cameras changed that frame
+        bool _lightsChanged = true;
+        bool _camerasChanged = true;
 
         vk::BufferHandle _meshDataBuffer[vk::FRAMES_IN_FLIGHT];
+        vk::BufferHandle _instanceBuffer[vk::FRAMES_IN_FLIGHT];
         vk::BufferHandle _meshTransformsBuffer[vk::FRAMES_IN_FLIGHT];
         vk::BufferHandle _lightBuffer[vk::FRAMES_IN_FLIGHT];
         vk::BufferHandle _cameraBuffer[vk::FRAMES_IN_FLIGHT];
@@ -104,14 +136,54 @@ namespace cala {
         bool _hdrSkyLight;
         u32 _skyLight;
 
+        // meshes are stored once and looked up by their first index and meshlet so repeated placements share them
         std::vector<GPUMesh> _meshData;
+        std::vector<Mesh> _meshes;
+        tsl::robin_map<u64, u32> _meshLookup;
+        std::vector<GPUInstance> _instances;
+        std::vector<MaterialInstance*> _instanceMaterials;
+        // number of instances using each material, indexed by material id
+        std::vector<u32> _materialInstanceCounts;
         std::vector<ende::math::Mat4f> _meshTransforms;
+        // instances and transforms are only uploaded for this many more frames after they change
+        i32 _instancesDirtyFrame = 0;
         std::vector<GPULight> _lightData;
         std::vector<GPUCamera> _cameraData;
+        // culling camera followed by the scene cameras, the start of _cameraData
+        std::vector<GPUCamera> _sceneCameraData;
+        u32 _sceneCameraCount = 0;
+        // caster bounds the cascades were last fit around
+        ende::math::Vec3f _casterMin = { 0, 0, 0 };
+        ende::math::Vec3f _casterMax = { 0, 0, 0 };
+
+        struct ShadowRequest {
+            u32 lightIndex;
+            u32 size;
+        };
+        std::vector<ShadowRequest> _shadowRequests;
+        std::vector<ShadowRequest> _packedShadowRequests;
+
+        // per shadow atlas view state used to decide whether the cached static shadows can be reused
+        struct ShadowViewCache {
+            GPUCamera camera = {};
+            bool valid = false;
+            bool dynamic = false; // dynamic casters were drawn into the view last frame
+        };
+        std::vector<ShadowViewCache> _shadowViewCache;
+
+        struct MeshShadowState {
+            ende::math::Vec4f bounds = { 0, 0, 0, 0 }; // world space bounding sphere
+            u32 staticFrames = 0;
+            bool cached = false; // mesh is drawn into the static shadow cache
+        };
+        std::vector<MeshShadowState> _meshShadowStates;
+        std::vector<u32> _movedMeshes;
+        std::vector<u32> _dynamicMeshes;
+        // bounds of casters that entered or left the shadow cache this frame
+        std::vector<ende::math::Vec4f> _shadowInvalidations;
 
         ende::math::Vec3f _min = { 1000, 1000, 1000 };
         ende::math::Vec3f _max = { -1000, -1000, -1000 };
-        std::vector<Mesh> _meshes;
         std::vector<Light> _lights;
         std::vector<Camera> _cameras;
         i32 _mainCameraIndex = -1;
@@ -0,0 +1,98 @@
+#ifndef CALA_SHADOWATLAS_H
+#define CALA_SHADOWATLAS_H
+
+#include <Ende/platform.h>
+#include <Ende/math/Vec.h>
+#include <vector>
+#include <span>
+
+namespace cala {
+
+    // packs square power of two shadow map tiles into a single atlas. tiles are allocated by recursively splitting
+    // the atlas into quadrants so larger tiles should be allocated first to reduce fragmentation
+    class ShadowAtlas {
+    public:
+
+        struct Tile {
+            u32 x = 0;
+            u32 y = 0;
+            u32 size = 0;
+        };
+
+        struct View {
+            u32 lightIndex = 0;
+            u32 viewIndex = 0; // cascade for directional lights, cube face for point lights
+            Tile tile = {};
+            bool refresh = true; // static geometry is re-rendered into the shadow cache
+            bool composite = true; // cached tile is copied into the atlas and dynamic geometry drawn on top
+        };
+
+        ShadowAtlas(u32 size, u32 maxTileSize, u32 minTileSize = 64);
+
+        void resize(u32 size);
+
+        u32 size() const { return _size; }
+
+        void setMaxTileSize(u32 size);
+
+        u32 maxTileSize() const { return _maxTileSize; }
+
+        u32 minTileSize() const { return _minTileSize; }
+
+        // frees all tiles and views
+        void clear();
+
+        // allocates a tile of the requested size, falling back to smaller tiles if the atlas is full.
+        // returns a tile with size 0 if nothing fits
+        Tile allocate(u32 size);
+
+        void addView(const View& view) { _views.push_back(view); }
+
+        std::span<const View> views() const { return _views; }
+
+        View& view(u32 index) { return _views[index]; }
+
+        // when caching is disabled every view is refreshed each frame
+        void setCaching(bool caching) { _caching = caching; }
+
+        bool caching() const { return _caching; }
+
+        // number of texels a cached view's projection can drift before it is refreshed
+        void setCacheThreshold(f32 texels) { _cacheThreshold = texels; }
+
+        f32 cacheThreshold() const { return _cacheThreshold; }
+
+        // fit cascades to texel snapped bounding spheres so they stay stable as the camera moves
+        void setStableCascades(bool stable) { _stableCascades = stable; }
+
+        bool stableCascades() const { return _stableCascades; }
+
+        u32 refreshedViews() const;
+
+        u32 compositedViews() const;
+
+        u32 reusedViews() const;
+
+        // returns tile offset in xy and scale in zw in normalised atlas coordinates
+        ende::math::Vec4f tileCoords(const Tile& tile) const;
+
+    private:
+
+        u32 levelOf(u32 size) const;
+
+        u32 _size;
+        u32 _maxTileSize;
+        u32 _minTileSize;
+        bool _caching = true;
+        f32 _cacheThreshold = 0.5f;
+        bool _stableCascades = true;
+
+        // free tiles for each level of the quadtree, level 0 is the whole atlas
+        std::vector<std::vector<Tile>> _freeTiles;
+        std::vector<View> _views;
+
+    };
+
+}
+
+#endif //CALA_SHADOWATLAS_H
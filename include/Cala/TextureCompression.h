@@ -0,0 +1,56 @@
+#ifndef CALA_TEXTURECOMPRESSION_H
+#define CALA_TEXTURECOMPRESSION_H
+
+#include <Ende/platform.h>
+#include <Cala/vulkan/primitives.h>
+#include <vector>
+#include <span>
+
+namespace cala::bc {
+
+    // blocks encode 4x4 rgba8 texels read row by row
+
+    // rgb endpoints in 565 with 2 bit indices, alpha is ignored
+    void encodeBC1(const u8* texels, u8* block);
+
+    // single channel with 3 bit indices. channel selects which of the rgba components is encoded
+    void encodeBC4(const u8* texels, u8* block, u32 channel = 0);
+
+    // red and green encoded as two bc4 blocks
+    void encodeBC5(const u8* texels, u8* block);
+
+    // mode 6 only, rgba endpoints with per endpoint p-bit and 4 bit indices
+    void encodeBC7(const u8* texels, u8* block);
+
+    void decodeBC1(const u8* block, u8* texels);
+
+    void decodeBC4(const u8* block, u8* texels, u32 channel = 0);
+
+    void decodeBC5(const u8* block, u8* texels);
+
+    // only decodes mode 6 blocks as written by encodeBC7, other modes decode to black
+    void decodeBC7(const u8* block, u8* texels);
+
+    u32 blockCount(u32 width, u32 height);
+
+    // encodes a rgba8 image in the given block format. edge blocks of images that aren't a multiple of 4 repeat the
+    // last row and column
+    std::vector<u8> encode(vk::Format format, std::span<const u8> texels, u32 width, u32 height);
+
+    std::vector<u8> decode(vk::Format format, std::span<const u8> blocks, u32 width, u32 height);
+
+    enum class MipFilter {
+        LINEAR,
+        SRGB, // colour is averaged in linear space
+        NORMAL // xy is averaged as a unit vector and renormalised
+    };
+
+    // halves a rgba8 image using a box filter. odd dimensions round down and clamp at the edge
+    std::vector<u8> downsample(std::span<const u8> texels, u32 width, u32 height, MipFilter filter);
+
+    // filter suitable for the contents of the given format
+    MipFilter mipFilter(vk::Format format);
+
+}
+
+#endif //CALA_TEXTURECOMPRESSION_H
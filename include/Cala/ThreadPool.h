@@ -0,0 +1,56 @@
+#ifndef CALA_THREADPOOL_H
+#define CALA_THREADPOOL_H
+
+#include <Ende/platform.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <memory>
+
+namespace cala {
+
+    class ThreadPool {
+    public:
+
+        ThreadPool(u32 threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1);
+
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        template <typename F>
+        auto submit(F func) -> std::future<std::invoke_result_t<F>> {
+            using Result = std::invoke_result_t<F>;
+            auto task = std::make_shared<std::packaged_task<Result()>>(std::move(func));
+            auto future = task->get_future();
+            {
+                std::unique_lock lock(_mutex);
+                _tasks.emplace_back([task] { (*task)(); });
+            }
+            _condition.notify_one();
+            return future;
+        }
+
+        u32 threadCount() const { return _threads.size(); }
+
+    private:
+
+        void run();
+
+        std::vector<std::thread> _threads;
+        std::deque<std::function<void()>> _tasks;
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        bool _stop;
+
+    };
+
+}
+
+#endif //CALA_THREADPOOL_H
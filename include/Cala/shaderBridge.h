@@ -30,12 +30,29 @@ struct DispatchCommand {
     uint z;
 };
 
+// the visibility buffer is resolved in square tiles, each tile is dispatched once per material covering it
+#define MATERIAL_TILE_SIZE 8
+
+// rate each material tile is shaded at, one pixel of every 1x1, 2x1 or 2x2 block is shaded and copied to the rest
+#define SHADING_RATE_1X1 0
+#define SHADING_RATE_2X1 1
+#define SHADING_RATE_2X2 2
+
+// lights are binned into screen tiles and depth slices separately, a cluster's lights are those in both its tile and
+// its slice
+#define LIGHT_TILES_X 16
+#define LIGHT_TILES_Y 9
+#define LIGHT_SLICES 24
+
 struct MeshTaskCommand {
     uint x;
     uint y;
     uint z;
     uint meshID;
-    uint meshLOD;
+    // meshlets culled individually by the task shader, a range of the hierarchy that survived node culling
+    uint meshletOffset;
+    uint meshletCount;
+    uint viewIndex; // cascade or cube face when drawing multiple shadow views at once
 };
 
 struct Meshlet {
@@ -49,6 +66,32 @@ struct Meshlet {
     vec3 coneApex;
     vec3 coneAxis;
     float coneCutoff;
+    // simplification hierarchy. lodBounds and lodError belong to the group the meshlet was simplified from and the
+    // parent values to the group it was simplified into. errors are object space distances, roots have a parent
+    // error of FLT_MAX
+    vec4 lodBounds;
+    vec4 parentLodBounds;
+    float lodError;
+    float parentLodError;
+};
+
+// node of a bounding volume hierarchy built over one level of a mesh's simplification hierarchy. a node covers the
+// meshlets from meshletOffset, leaves at most one task workgroup of them, and its children are the childCount nodes
+// from childOffset counted from the mesh's nodeOffset. the bounds and errors are conservative over every meshlet below so whole subtrees are rejected
+// before their meshlets are read
+#define MESHLET_NODE_LEAF_SIZE 64
+#define MESHLET_NODE_CHILDREN 8
+
+struct MeshletNode {
+    vec4 bounds; // encloses the culling spheres of the meshlets
+    vec4 lodBounds; // encloses their lod bounds
+    vec4 parentLodBounds; // encloses their parent lod bounds
+    float minLodError;
+    float maxParentLodError;
+    uint meshletOffset;
+    uint meshletCount;
+    uint childOffset;
+    uint childCount; // 0 for leaves
 };
 
 #ifndef __cplusplus
@@ -56,11 +99,16 @@ layout (scalar, buffer_reference, buffer_reference_align = 8) readonly buffer Me
     Meshlet meshlets[];
 };
 
+layout (scalar, buffer_reference, buffer_reference_align = 8) readonly buffer MeshletNodeBuffer {
+    MeshletNode nodes[];
+};
+
 layout (scalar, buffer_reference, buffer_reference_align = 8) readonly buffer PrimitiveBuffer {
     uint8_t primitives[];
 };
 #else
 #define MeshletBuffer u64
+#define MeshletNodeBuffer u64
 #define PrimitiveBuffer u64
 #endif
 
@@ -71,14 +119,15 @@ struct LOD {
     uint meshletCount;
 };
 
+// geometry stored once and shared by every instance of it
 struct GPUMesh {
-    uint materialID;
-    uint materialIndex;
     vec4 min;
     vec4 max;
-    uint enabled;
-    uint castShadows;
     uint lodCount;
+    uint compactVertices; // vertices are stored as CompactVertex quantized to min and max
+    // roots of the node hierarchy, one per simplification level. meshes without one draw all of lods[0]
+    uint nodeOffset;
+    uint rootCount;
     LOD lods[MAX_LODS];
 };
 
@@ -90,6 +139,26 @@ layout (scalar, buffer_reference, buffer_reference_align = 8) readonly buffer Me
 #define MeshBuffer u64
 #endif
 
+#define CALA_INSTANCE_ENABLED 0x1
+#define CALA_INSTANCE_CAST_SHADOWS 0x2
+#define CALA_INSTANCE_DYNAMIC 0x4 // recently moved, excluded from cached shadows
+
+// one placement of a mesh. the instance index is the draw id and indexes the transforms
+struct GPUInstance {
+    uint meshIndex;
+    uint materialID;
+    uint materialIndex;
+    uint flags;
+};
+
+#ifndef __cplusplus
+layout (scalar, buffer_reference, buffer_reference_align = 8) readonly buffer InstanceBuffer {
+    GPUInstance instances[];
+};
+#else
+#define InstanceBuffer u64
+#endif
+
 #ifndef __cplusplus
 layout (scalar, buffer_reference, buffer_reference_align = 8) readonly buffer TransformsBuffer {
     mat4 transforms[];
@@ -132,7 +201,6 @@ struct LightGrid {
 
 struct Cascade {
     float distance;
-    int shadowMapIndex;
 };
 
 struct GPULight {
@@ -147,6 +215,8 @@ struct GPULight {
     int cameraIndex;
     uint cascadeCount;
     Cascade cascades[MAX_CASCADES];
+    // shadow atlas tile of each cascade or cube face, xy offset and zw scale in atlas uv. zero scale if unassigned
+    vec4 shadowTiles[MAX_CASCADES];
 };
 
 #ifndef __cplusplus
@@ -174,11 +244,25 @@ struct Vertex {
     vec2 texCoords;
 };
 
+// position is quantized to 16 bits per axis within the mesh bounds, normal is octahedral encoded as two snorm16 and
+// texture coordinates are half floats. the upper half of positionZ is unused to keep vertices 16 byte aligned
+struct CompactVertex {
+    uint positionXY;
+    uint positionZ;
+    uint normal;
+    uint texCoords;
+};
+
 #ifndef __cplusplus
 layout (scalar, buffer_reference, buffer_reference_align = 8) buffer VertexBuffer {
     Vertex vertices[];
 };
 
+// aliases the vertex buffer for meshes imported with compact vertices
+layout (scalar, buffer_reference, buffer_reference_align = 16) readonly buffer CompactVertexBuffer {
+    CompactVertex vertices[];
+};
+
 layout (scalar, buffer_reference, buffer_reference_align = 8) buffer IndexBuffer {
     uint indices[];
 };
@@ -194,9 +278,20 @@ struct FeedbackInfo {
     uint totalMeshes;
     uint drawnMeshlets;
     uint totalMeshlets;
+    uint coneCulledMeshlets;
+    uint smallCulledMeshlets;
+    uint occludedMeshlets;
     uint drawnTriangles;
     uint meshletID;
     uint meshID;
+    uint droppedLightIndices; // light indices that didn't fit in the list
+    uint requiredLightIndices; // size the list needed, only written when it overflowed
+    uint coveredPixels; // pixels covered by geometry in the variable rate resolve
+    uint shadedPixels; // of those, the pixels that were actually shaded
+    uint visitedNodes; // meshlet hierarchy nodes tested by the cull passes
+    uint droppedDrawCommands; // meshlet ranges that didn't fit in the draw commands
+    uint requiredDrawCommands; // size the main draw commands needed, only written when they overflowed
+    uint requiredShadowDrawCommands; // size a light's shadow draw commands needed, only written when they overflowed
 };
 
 #ifndef __cplusplus
@@ -207,6 +302,30 @@ layout (scalar, buffer_reference, buffer_reference_align = 8) buffer FeedbackBuf
 #define FeedbackBuffer u64
 #endif
 
+// one entry per bindless image index holding one more than log2 of the texels per uv unit sampled from the image,
+// zero if the image wasn't sampled
+#ifndef __cplusplus
+layout (scalar, buffer_reference, buffer_reference_align = 4) buffer MipFeedbackBuffer {
+    uint requestedResolution[];
+};
+#else
+#define MipFeedbackBuffer u64
+#endif
+
+// diffuse gi probe on a regular grid. radiance arriving at the probe is stored as l1 spherical harmonics, one rgb
+// coefficient per basis function in xyz. w of the first counts the updates blended in, zero until the first
+struct IrradianceProbe {
+    vec4 sh[4];
+};
+
+#ifndef __cplusplus
+layout (scalar, buffer_reference, buffer_reference_align = 16) buffer ProbeBuffer {
+    IrradianceProbe probes[];
+};
+#else
+#define ProbeBuffer u64
+#endif
+
 struct GlobalData {
     float gamma;
     uint time;
@@ -216,6 +335,7 @@ struct GlobalData {
     uvec2 swapchainSize;
     uvec2 cursorPos;
     vec2 randomOffset;
+    vec2 jitter;
     int poissonIndex;
     float bloomStrength;
     int shadowMode;
@@ -223,6 +343,7 @@ struct GlobalData {
     int blockerSamples;
     float lodTransitionBase;
     float lodTransitionStep;
+    float lodErrorThreshold;
     uint lodBias;
     uint shadowLodBias;
     int irradianceIndex;
@@ -234,17 +355,29 @@ struct GlobalData {
     int shadowSampler;
     int primaryCameraIndex;
     int cullingCameraIndex;
+    uint coneCulling;
+    uint shadowConeCulling;
+    uint smallPrimitiveCulling;
     VertexBuffer vertexBuffer;
     IndexBuffer indexBuffer;
     MeshletBuffer meshletBuffer;
+    MeshletNodeBuffer meshletNodeBuffer;
     PrimitiveBuffer primitiveBuffer;
     MeshBuffer meshBuffer;
+    InstanceBuffer instanceBuffer;
     TransformsBuffer transformsBuffer;
     CameraBuffer cameraBuffer;
     LightBuffer lightBuffer;
     LightGridBuffer lightGridBuffer;
     LightIndicesBuffer lightIndicesBuffer;
     FeedbackBuffer feedbackBuffer;
+    MipFeedbackBuffer mipFeedbackBuffer;
+    // probe at x, y, z is at origin + spacing * xyz and indexed x + y * size.x + z * size.x * size.y, size is zero
+    // without a grid
+    vec4 probeGridOrigin;
+    vec4 probeGridSpacing;
+    uvec4 probeGridSize;
+    ProbeBuffer probeBuffer;
 };
 
 #define CALA_GLOBAL_DATA_SET 1
@@ -23,6 +23,7 @@ namespace cala::ui {
         std::array<std::pair<f32, f32>, MAX_FRAME_COUNT> _globalTime;
         std::array<f32, MAX_FRAME_COUNT> _cpuTimes;
         std::array<f32, MAX_FRAME_COUNT> _gpuTimes;
+        std::array<f32, MAX_FRAME_COUNT> _latencies;
         u32 _frameOffset;
         tsl::robin_map<const char*, std::array<f32, MAX_FRAME_COUNT>> _times;
 
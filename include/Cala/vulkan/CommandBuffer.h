@@ -40,8 +40,11 @@ namespace cala::vk {
 
         bool end();
 
-        void begin(RenderPass& renderPass, VkFramebuffer framebuffer, std::pair<u32, u32> extent);
-        void begin(Framebuffer& framebuffer);
+        // begins a secondary command buffer, if framebuffer is provided buffer continues the render pass of the primary
+        bool beginSecondary(Framebuffer* framebuffer = nullptr);
+
+        void begin(RenderPass& renderPass, VkFramebuffer framebuffer, std::pair<u32, u32> extent, bool secondaryContents = false);
+        void begin(Framebuffer& framebuffer, bool secondaryContents = false);
 
         void end(RenderPass& renderPass);
         void end(Framebuffer& framebuffer);
@@ -56,7 +59,10 @@ namespace cala::vk {
 
         void bindVertexArray(std::span<VkVertexInputBindingDescription> bindings, std::span<VkVertexInputAttributeDescription> attributes);
 
+        // viewport is dynamic state, it is reset to the full framebuffer extent when a render pass begins
         void bindViewPort(const ViewPort& viewport);
+        // binds multiple viewports selected per primitive with gl_ViewportIndex, scissors match each viewport
+        void bindViewPorts(std::span<const ViewPort> viewports);
 
         struct RasterState {
             CullMode cullMode = CullMode::BACK;
@@ -125,6 +131,9 @@ namespace cala::vk {
 
         void clearBuffer(BufferHandle buffer, u32 clearValue = 0);
 
+        // clears a region of the depth attachment of the active render pass
+        void clearDepthAttachment(const ViewPort& region, f32 depth = 1.f);
+
         void pipelineBarrier(std::span<VkBufferMemoryBarrier2> bufferBarriers, std::span<VkImageMemoryBarrier2> imageBarriers);
 
         void pipelineBarrier(std::span<Image::Barrier> imageBarriers);
@@ -140,6 +149,9 @@ namespace cala::vk {
 
         void pipelineBarrier(std::span<MemoryBarrier> memoryBarriers);
 
+        // executes secondary and applies image layout transitions recorded in it
+        void executeCommands(CommandHandle secondary);
+
         void pushDebugLabel(std::string_view label, std::array<f32, 4> colour = {0, 1, 0, 1});
 
         void popDebugLabel();
@@ -156,6 +168,8 @@ namespace cala::vk {
 
         bool active() const { return _active; }
 
+        bool secondary() const { return _secondary; }
+
         u32 drawCalls() const { return _drawCallCount; }
 
     private:
@@ -168,6 +182,10 @@ namespace cala::vk {
         VkCommandBuffer _buffer;
         VkQueue _queue;
         bool _active;
+        bool _secondary;
+
+        // layout changes are deferred until secondary is executed so image state is only updated in submission order
+        std::vector<std::pair<Image*, VkImageLayout>> _pendingLayouts;
 
         BufferHandle _indexBuffer = {};
         const ShaderProgram* _boundProgram = nullptr;
@@ -182,7 +200,6 @@ namespace cala::vk {
             VkVertexInputAttributeDescription attributes[MAX_VERTEX_INPUT_ATTRIBUTES]{};
             Framebuffer* framebuffer = nullptr;
             VkPipelineLayout layout = VK_NULL_HANDLE;
-            ViewPort viewPort = {};
             RasterState raster = {};
             DepthState depth = {};
             BlendState blend = {};
@@ -11,7 +11,7 @@ namespace cala::vk {
 
         CommandPool() = default;
 
-        CommandPool(Device* device, QueueType queueType);
+        CommandPool(Device* device, QueueType queueType, bool secondary = false);
 
         ~CommandPool();
 
@@ -36,6 +36,7 @@ namespace cala::vk {
         VkCommandPool _pool = VK_NULL_HANDLE;
         std::vector<CommandBuffer> _buffers = {};
         QueueType _queueType = QueueType::NONE;
+        bool _secondary = false;
         u32 _index = 0;
 
     };
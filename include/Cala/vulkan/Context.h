@@ -45,6 +45,10 @@ namespace cala::vk {
 
         f32 timestampPeriod = 0;
 
+        u32 minStorageBufferOffsetAlignment = 0;
+
+        u32 maxViewports = 0;
+
         u32 maxTaskWorkGroupTotalCount = 0;
         u32 maxTaskWorkGroupCount[3] = {};
         u32 maxTaskWorkGroupInvocations = 0;
@@ -99,6 +103,8 @@ namespace cala::vk {
         bool KHR_ray_query = false;
         bool KHR_pipeline_library = false;
         bool KHR_deferred_host_operations = false;
+        bool KHR_present_id = false;
+        bool KHR_present_wait = false;
 
         bool EXT_debug_report = false;
         bool EXT_debug_marker = false;
@@ -158,6 +164,9 @@ namespace cala::vk {
 
         Format depthFormat() const { return _depthFormat; }
 
+        // true if images of format with optimal tiling support all of features
+        bool formatSupported(Format format, VkFormatFeatureFlags features) const;
+
         VkQueryPool timestampPool() const { return _timestampQueryPool; }
 
         VkQueryPool pipelineStatisticsPool() const { return _pipelineStatistics; }
@@ -197,6 +206,7 @@ namespace cala::vk {
             bool meshShading = false;
             bool deviceAddress = false;
             bool sync2 = false;
+            bool textureCompressionBC = false;
         };
 
         Features getEnabledFeatures() const { return _enabledFeatures; }
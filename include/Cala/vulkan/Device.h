@@ -11,6 +11,7 @@
 #include <Ende/time/StopWatch.h>
 #include <spdlog/spdlog.h>
 #include <Cala/vulkan/Timer.h>
+#include <mutex>
 
 namespace cala::ui {
     class ResourceViewer;
@@ -27,6 +28,7 @@ namespace cala::vk {
             bool useTimeline = true;
             Platform* platform = nullptr;
             spdlog::logger* logger = nullptr;
+            u32 recordingThreads = 4;
         };
 
 //        Device(Platform& platform, spdlog::logger& logger, CreateInfo createInfo = { true });
@@ -57,7 +59,12 @@ namespace cala::vk {
 
         u32 nextFrameIndex() const { return (_frameCount + 1) % FRAMES_IN_FLIGHT; }
 
-        std::expected<void, Error> waitFrame(u64 frame, u64 timeout = 1000000000);
+        // reset is only used without timelines, frames waited on outside of beginFrame must leave their fence signaled
+        std::expected<void, Error> waitFrame(u64 frame, u64 timeout = 1000000000, bool reset = true);
+
+        bool frameComplete(u64 frame);
+
+        u64 frameCount() const { return _frameCount; }
 
         bool wait(u64 timeout = 1000000000); // waits for all frames
 
@@ -74,6 +81,11 @@ namespace cala::vk {
 
         std::expected<void, Error> endSingleTimeCommands(CommandHandle buffer);
 
+        // each recording thread has its own pool per frame, a thread index must only be used by one thread at a time
+        CommandHandle getSecondaryCommandBuffer(u32 frame, u32 thread);
+
+        u32 recordingThreadCount() const { return _secondaryCommandPools[0].size(); }
+
         template <typename F>
         u64 immediate(F func, QueueType queueType = QueueType::GRAPHICS, bool time = false) {
             auto cmd = beginSingleTimeCommands(queueType);
@@ -121,6 +133,9 @@ namespace cala::vk {
 
 
         ImageHandle createImage(Image::CreateInfo info);
+        // replaces the image behind handle keeping its index and bindless slot, the previous image is destroyed once
+        // the frames that may use it have finished
+        ImageHandle recreateImage(ImageHandle handle, Image::CreateInfo info);
 
         ImageHandle getImageHandle(u32 index);
 
@@ -216,6 +231,9 @@ namespace cala::vk {
         spdlog::logger* _logger = nullptr;
         Context _context = {};
         std::array<std::array<CommandPool, 3>, FRAMES_IN_FLIGHT> _commandPools = {}; // 0 = graphics, 1 = compute, 2 = transfer
+        std::array<std::vector<CommandPool>, FRAMES_IN_FLIGHT> _secondaryCommandPools = {};
+        // guards caches which may be accessed while recording on multiple threads
+        std::mutex _recordMutex;
         Semaphore _timelineSemaphore = {};
         Semaphore _immediateSemaphore = {};
         u64 _frameValues[FRAMES_IN_FLIGHT] = {};
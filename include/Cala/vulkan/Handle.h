@@ -3,6 +3,7 @@
 
 #include <Ende/platform.h>
 #include <functional>
+#include <atomic>
 
 #include <cstdio>
 
@@ -24,7 +25,7 @@ namespace cala::vk {
 
         struct Data {
             i32 index = -1;
-            i32 count = 0;
+            std::atomic<i32> count = 0;
             std::function<void(i32)> deleter;
         };
 
@@ -94,8 +95,7 @@ namespace cala::vk {
 
         bool release() {
             if (_data) {
-                --_data->count;
-                if (_data->count < 1) {
+                if (--_data->count < 1) {
                     _data->deleter(_data->index);
                     return true;
                 }
@@ -62,6 +62,8 @@ namespace cala::vk {
 
         void copy(CommandHandle buffer, Buffer& dst, u32 dstOffset, u32 srcLayer = 0, u32 srcMipLevel = 0);
         void copy(CommandHandle buffer, Image& dst, u32 srcLayer = 0, u32 dstLayer = 0, u32 srcMipLevel = 0, u32 dstMipLevel = 0);
+        // copies a region of the first layer and mip, images must be in transfer src/dst layouts
+        void copy(CommandHandle buffer, Image& dst, VkOffset3D srcOffset, VkOffset3D dstOffset, VkExtent3D extent);
         void blit(CommandHandle buffer, Image& dst, ImageLayout srcLayout, ImageLayout dstLayout, VkFilter filter = VK_FILTER_NEAREST);
 
         void generateMips();
@@ -122,7 +124,7 @@ namespace cala::vk {
 
         u32 layers() const { return _layers; }
 
-        u32 size() const { return _width * _height * _depth * _layers * _mips * formatToSize(_format); }
+        u32 size() const { return _width * _height * _depth * _layers * _mips * formatToSize(_format) / (isBlockFormat(_format) ? 16 : 1); }
 
         ImageType type() const { return _type; }
 
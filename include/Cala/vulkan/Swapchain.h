@@ -45,6 +45,15 @@ namespace cala::vk {
 
         std::expected<bool, Error> present(Frame frame);
 
+        // present ids are only attached when VK_KHR_present_wait is enabled, 0 otherwise
+        u64 lastPresentId() const { return _lastPresentId; }
+
+        bool presentWaitSupported() const;
+
+        // true once the present with presentId has been displayed, false on timeout. presents from before the
+        // swapchain was last recreated count as displayed
+        std::expected<bool, Error> waitForPresent(u64 presentId, u64 timeout);
+
         bool resize(u32 width, u32 height);
 
         void blitImageToFrame(u32 index, CommandHandle buffer, Image& src);
@@ -84,6 +93,7 @@ namespace cala::vk {
         PresentMode _mode = PresentMode::FIFO;
         VkExtent2D _extent = {};
         u64 _frame = 0;
+        u64 _lastPresentId = 0;
 
         std::vector<VkImage> _images = {};
         std::vector<VkImageView> _imageViews = {};
@@ -93,16 +93,34 @@ namespace cala::vk {
         R64_SINT = 111,
         R64_SFLOAT = 112,
 
+        B10G11R11_UFLOAT = 122,
+
         D16_UNORM = 124,
 
         D32_SFLOAT = 126,
-        D24_UNORM_S8_UINT = 129
+        D24_UNORM_S8_UINT = 129,
+
+        BC1_RGB_UNORM = 131,
+        BC1_RGB_SRGB = 132,
+        BC1_RGBA_UNORM = 133,
+        BC1_RGBA_SRGB = 134,
+        BC4_UNORM = 139,
+        BC4_SNORM = 140,
+        BC5_UNORM = 141,
+        BC5_SNORM = 142,
+        BC7_UNORM = 145,
+        BC7_SRGB = 146
     };
 
     constexpr inline bool isDepthFormat(Format format) {
         return format == Format::D16_UNORM || format == Format::D32_SFLOAT || format == Format::D24_UNORM_S8_UINT;
     }
 
+    // block compressed formats store 4x4 texel blocks
+    constexpr inline bool isBlockFormat(Format format) {
+        return format >= Format::BC1_RGB_UNORM && format <= Format::BC7_SRGB;
+    }
+
     enum class MemoryProperties {
         STAGING = 1,
         DEVICE = 2,
@@ -400,6 +418,8 @@ namespace cala::vk {
                 return tostr(Format::RG16_SFLOAT);
             case Format::RGBA16_SFLOAT:
                 return tostr(Format::RGBA16_SFLOAT);
+            case Format::B10G11R11_UFLOAT:
+                return tostr(Format::B10G11R11_UFLOAT);
             case Format::R32_SFLOAT:
                 return tostr(Format::R32_SFLOAT);
             case Format::RG32_SFLOAT:
@@ -418,6 +438,26 @@ namespace cala::vk {
                 return tostr(Format::D32_SFLOAT);
             case Format::D24_UNORM_S8_UINT:
                 return tostr(Format::D24_UNORM_S8_UINT);
+            case Format::BC1_RGB_UNORM:
+                return tostr(Format::BC1_RGB_UNORM);
+            case Format::BC1_RGB_SRGB:
+                return tostr(Format::BC1_RGB_SRGB);
+            case Format::BC1_RGBA_UNORM:
+                return tostr(Format::BC1_RGBA_UNORM);
+            case Format::BC1_RGBA_SRGB:
+                return tostr(Format::BC1_RGBA_SRGB);
+            case Format::BC4_UNORM:
+                return tostr(Format::BC4_UNORM);
+            case Format::BC4_SNORM:
+                return tostr(Format::BC4_SNORM);
+            case Format::BC5_UNORM:
+                return tostr(Format::BC5_UNORM);
+            case Format::BC5_SNORM:
+                return tostr(Format::BC5_SNORM);
+            case Format::BC7_UNORM:
+                return tostr(Format::BC7_UNORM);
+            case Format::BC7_SRGB:
+                return tostr(Format::BC7_SRGB);
         }
 
         return nullptr;
@@ -444,6 +484,7 @@ namespace cala::vk {
             case Format::RGBA16_SFLOAT:
                 return 2 * 4;
             case Format::R32_SFLOAT:
+            case Format::B10G11R11_UFLOAT:
                 return 4 * 1;
             case Format::RG32_SFLOAT:
                 return 4 * 2;
@@ -458,6 +499,19 @@ namespace cala::vk {
             case Format::D32_SFLOAT:
             case Format::D24_UNORM_S8_UINT:
                 return 4;
+            // size of a 4x4 block
+            case Format::BC1_RGB_UNORM:
+            case Format::BC1_RGB_SRGB:
+            case Format::BC1_RGBA_UNORM:
+            case Format::BC1_RGBA_SRGB:
+            case Format::BC4_UNORM:
+            case Format::BC4_SNORM:
+                return 8;
+            case Format::BC5_UNORM:
+            case Format::BC5_SNORM:
+            case Format::BC7_UNORM:
+            case Format::BC7_SRGB:
+                return 16;
         }
 
         return 0;
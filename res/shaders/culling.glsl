@@ -0,0 +1,68 @@
+#ifndef SHADER_CULLING_GLSL
+#define SHADER_CULLING_GLSL
+
+// depth increases away from the camera so the depth row of the view projection points along the view direction
+vec3 orthographicViewDirection(GPUCamera camera) {
+    mat4 viewProjection = camera.projection * camera.view;
+    return normalize(vec3(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2]));
+}
+
+// true if every triangle of the meshlet faces away from the camera. cones only survive rotation and uniform scale so
+// meshlets of mirrored or non uniformly scaled meshes are kept
+bool coneCull(Meshlet meshlet, mat4 transform, GPUCamera camera) {
+    mat3 basis = mat3(transform);
+    if (determinant(basis) <= 0.0)
+        return false;
+    vec3 scale = vec3(length(basis[0]), length(basis[1]), length(basis[2]));
+    float maxScale = max(scale.x, max(scale.y, scale.z));
+    if (maxScale - min(scale.x, min(scale.y, scale.z)) > maxScale * 0.001)
+        return false;
+
+    vec3 axis = normalize(basis * meshlet.coneAxis);
+    if (camera.projection[3][3] == 1.0)
+        return dot(orthographicViewDirection(camera), axis) >= meshlet.coneCutoff;
+    vec3 apex = (transform * vec4(meshlet.coneApex, 1.0)).xyz;
+    return dot(normalize(apex - camera.position), axis) >= meshlet.coneCutoff;
+}
+
+// pixel rect (min xy, max zw) and nearest depth of the box around a world space sphere. fails if part of the box is
+// behind the camera
+bool projectSphere(vec3 center, float radius, mat4 viewProjection, vec2 screenSize, out vec4 rect, out float nearestDepth) {
+    rect = vec4(vec2(1e30), vec2(-1e30));
+    nearestDepth = 1.0;
+    for (int i = 0; i < 8; i++) {
+        vec3 corner = center + radius * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+        vec4 clip = viewProjection * vec4(corner, 1.0);
+        if (clip.w <= 0.0)
+            return false;
+        vec3 ndc = clip.xyz / clip.w;
+        vec2 pixel = (ndc.xy * 0.5 + 0.5) * screenSize;
+        rect.xy = min(rect.xy, pixel);
+        rect.zw = max(rect.zw, pixel);
+        nearestDepth = min(nearestDepth, ndc.z);
+    }
+    return true;
+}
+
+// a rect between two pixel centres on either axis can't produce any fragments
+bool smallPrimitiveCull(vec4 rect) {
+    return any(equal(round(rect.xy), round(rect.zw)));
+}
+
+// tests a pixel rect against the level of a max depth pyramid where it covers at most 2x2 texels. size is the size of
+// the first level which covers the whole screen
+bool occlusionCull(vec4 rect, float nearestDepth, vec2 screenSize, sampler2D depthPyramid, uvec2 size, uint levels) {
+    vec2 scale = vec2(size) / screenSize;
+    vec4 texels = clamp(rect * scale.xyxy, vec4(0.0), vec2(size).xyxy);
+    vec2 extent = texels.zw - texels.xy;
+    int level = min(int(ceil(log2(max(max(extent.x, extent.y), 1.0)))), int(levels) - 1);
+
+    ivec2 levelSize = max(ivec2(size) >> level, ivec2(1));
+    ivec2 minTexel = min(ivec2(texels.xy) >> level, levelSize - 1);
+    ivec2 maxTexel = min(minTexel + 1, levelSize - 1);
+    float depth = max(max(texelFetch(depthPyramid, minTexel, level).r, texelFetch(depthPyramid, ivec2(maxTexel.x, minTexel.y), level).r),
+                      max(texelFetch(depthPyramid, ivec2(minTexel.x, maxTexel.y), level).r, texelFetch(depthPyramid, maxTexel, level).r));
+    return nearestDepth > depth;
+}
+
+#endif
@@ -61,7 +61,7 @@ vec4 evalMaterial(Material material, InterpolatedValues values) {
     vec3 emissive = material.albedo.rgb * material.emissive * material.emissiveStrength;
     Lo += vec4(emissive, 0);
 
-    vec3 ambient = getAmbient(globalData.irradianceIndex, globalData.prefilterIndex, globalData.brdfIndex, material.normal, V, F0, material.albedo.rgb, material.roughness, material.metallic);
+    vec3 ambient = getAmbient(globalData.irradianceIndex, globalData.prefilterIndex, globalData.brdfIndex, values.worldPosition, material.normal, V, F0, material.albedo.rgb, material.roughness, material.metallic);
 
     vec4 colour = (vec4(ambient, 0.0) + Lo);
     return colour;
@@ -12,13 +12,16 @@ Material loadMaterial(MaterialData data, InterpolatedValues values) {
         vec4 albedaRGBA = textureGrad(CALA_COMBINED_SAMPLER2D(nonuniformEXT(data.albedoIndex), globalData.linearRepeatSampler), values.uvGrad.uv, values.uvGrad.ddx, values.uvGrad.ddy);
 /*if (albedaRGBA.a < 0.001)\n    discard;*/
         material.albedo = albedaRGBA.rgba;
+        requestImageResolution(data.albedoIndex, values.uvGrad);
     }
     if (data.normalIndex < 0) {
-        material.normal = vec3(0.52, 0.52, 1);
+        material.normal = vec3(0.52, 0.52, 1) * 2.0 - 1.0;
     } else {
-        material.normal = textureGrad(CALA_COMBINED_SAMPLER2D(nonuniformEXT(data.normalIndex), globalData.linearRepeatSampler), values.uvGrad.uv, values.uvGrad.ddx, values.uvGrad.ddy).rgb;
+        // z is rebuilt from xy so two channel (bc5) normal maps can be used
+        vec2 normalXY = textureGrad(CALA_COMBINED_SAMPLER2D(nonuniformEXT(data.normalIndex), globalData.linearRepeatSampler), values.uvGrad.uv, values.uvGrad.ddx, values.uvGrad.ddy).rg * 2.0 - 1.0;
+        material.normal = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
+        requestImageResolution(data.normalIndex, values.uvGrad);
     }
-    material.normal = material.normal * 2.0 - 1.0;
     material.normal = normalize(values.TBN * material.normal);
 
     if (data.metallicRoughnessIndex < 0) {
@@ -27,12 +30,14 @@ Material loadMaterial(MaterialData data, InterpolatedValues values) {
     } else {
         material.metallic = textureGrad(CALA_COMBINED_SAMPLER2D(nonuniformEXT(data.metallicRoughnessIndex), globalData.linearRepeatSampler), values.uvGrad.uv, values.uvGrad.ddx, values.uvGrad.ddy).b;
         material.roughness = textureGrad(CALA_COMBINED_SAMPLER2D(nonuniformEXT(data.metallicRoughnessIndex), globalData.linearRepeatSampler), values.uvGrad.uv, values.uvGrad.ddx, values.uvGrad.ddy).g;
+        requestImageResolution(data.metallicRoughnessIndex, values.uvGrad);
     }
 
     if (data.emissiveIndex < 0) {
         material.emissive = vec3(1);
     } else {
         material.emissive = textureGrad(CALA_COMBINED_SAMPLER2D(nonuniformEXT(data.emissiveIndex), globalData.linearRepeatSampler), values.uvGrad.uv, values.uvGrad.ddx, values.uvGrad.ddy).rgb;
+        requestImageResolution(data.emissiveIndex, values.uvGrad);
     }
 
     material.emissiveStrength = data.emissiveStrength;
@@ -13,7 +13,7 @@ vec4 pointLight(GPULight light, vec3 normal, vec3 viewPos, vec3 V, vec3 F0, vec3
 
     if (light.shadowIndex >= 0) {
         float bias = max(light.shadowBias * (1.0 - dot(normal, L)), 0.0001);
-        shadow = filterPCF(light.shadowIndex, worldPos, light.position, bias, light.shadowRange);
+        shadow = filterPCF(light.shadowIndex, light, worldPos, bias);
     }
 
     if (shadow == 0)
@@ -57,7 +57,7 @@ vec4 directionalLight(GPULight light, vec3 normal, vec3 viewPos, vec3 V, vec3 F0
             vec4 shadowPos = shadowCamera.projection * shadowCamera.view * vec4(worldPos, 1.0);
             vec3 shadowCoords = vec3(shadowPos.xy * 0.5 + 0.5, shadowPos.z);
             if (depthValue < light.cascades[cascadeIndex].distance &&
-                light.cascades[cascadeIndex].shadowMapIndex >= 0 &&
+                light.shadowTiles[cascadeIndex].z > 0.0 &&
                 shadowCoords.x > 0.0 && shadowCoords.x < 1.0 &&
                 shadowCoords.y > 0.0 && shadowCoords.y < 1.0) {
 
@@ -68,13 +68,13 @@ vec4 directionalLight(GPULight light, vec3 normal, vec3 viewPos, vec3 V, vec3 F0
                 float bias = max(light.shadowBias * (1.0 - dot(normal, L)), 0.0001);
                 switch (globalData.shadowMode) {
                     case 0:
-                        shadowMain = pcss2D(light.cascades[cascadeIndex].shadowMapIndex, shadowCoords, light.size, bias);
+                        shadowMain = pcss2D(light.shadowIndex, light.shadowTiles[cascadeIndex], shadowCoords, light.size, bias);
                         break;
                     case 1:
-                        shadowMain = filterPCF2D(light.cascades[cascadeIndex].shadowMapIndex, shadowCoords, 1, bias);
+                        shadowMain = filterPCF2D(light.shadowIndex, light.shadowTiles[cascadeIndex], shadowCoords, 1, bias);
                         break;
                     case 2:
-                        shadowMain = sampleShadow(light.cascades[cascadeIndex].shadowMapIndex, shadowCoords, vec2(0), bias);
+                        shadowMain = sampleShadow(light.shadowIndex, light.shadowTiles[cascadeIndex], shadowCoords, vec2(0), bias);
                         break;
                 }
 
@@ -85,20 +85,20 @@ vec4 directionalLight(GPULight light, vec3 normal, vec3 viewPos, vec3 V, vec3 F0
                     vec3 fadeShadowCoords = vec3(fadeShadowPos.xy * 0.5 + 0.5, fadeShadowPos.z);
 
                     if (depthValue < light.cascades[fadeCascadeIndex].distance &&
-                        light.cascades[fadeCascadeIndex].shadowMapIndex >= 0 &&
+                        light.shadowTiles[fadeCascadeIndex].z > 0.0 &&
                         fadeShadowCoords.x > 0.0 && fadeShadowCoords.x < 1.0 &&
                         fadeShadowCoords.y > 0.0 && fadeShadowCoords.y < 1.0) {
 
                         float shadowFade = 1.0;
                         switch (globalData.shadowMode) {
                             case 0:
-                                shadowFade = pcss2D(light.cascades[fadeCascadeIndex].shadowMapIndex, fadeShadowCoords, light.size, bias);
+                                shadowFade = pcss2D(light.shadowIndex, light.shadowTiles[fadeCascadeIndex], fadeShadowCoords, light.size, bias);
                                 break;
                             case 1:
-                                shadowFade = filterPCF2D(light.cascades[fadeCascadeIndex].shadowMapIndex, fadeShadowCoords, 1, bias);
+                                shadowFade = filterPCF2D(light.shadowIndex, light.shadowTiles[fadeCascadeIndex], fadeShadowCoords, 1, bias);
                                 break;
                             case 2:
-                                shadowFade = sampleShadow(light.cascades[fadeCascadeIndex].shadowMapIndex, fadeShadowCoords, vec2(0), bias);
+                                shadowFade = sampleShadow(light.shadowIndex, light.shadowTiles[fadeCascadeIndex], fadeShadowCoords, vec2(0), bias);
                                 break;
                         }
                         shadow = mix(shadowMain, shadowFade, fade);
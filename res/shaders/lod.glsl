@@ -0,0 +1,43 @@
+#ifndef SHADER_LOD_GLSL
+#define SHADER_LOD_GLSL
+
+float transformScale(mat4 transform) {
+    return max(length(transform[0].xyz), max(length(transform[1].xyz), length(transform[2].xyz)));
+}
+
+// size in pixels of a world space error seen from distance by camera
+float errorToPixels(float error, float distanceToError, GPUCamera camera) {
+    return error / max(distanceToError, camera.near) * abs(camera.projection[1][1]) * 0.5 * globalData.swapchainSize.y;
+}
+
+// size in pixels of an object space error at the closest point of bounds as seen from the primary camera. every view
+// uses the primary camera so shadows are cast by the geometry that is drawn
+float projectedError(vec4 bounds, float error, mat4 transform) {
+    GPUCamera camera = globalData.cameraBuffer[globalData.primaryCameraIndex].camera;
+    float scale = transformScale(transform);
+    vec3 center = (transform * vec4(bounds.xyz, 1.0)).xyz;
+    return errorToPixels(error * scale, distance(center, camera.position) - bounds.w * scale, camera);
+}
+
+// a meshlet is part of the cut through the hierarchy when its own error is acceptable and its parent's isn't. parents
+// enclose and never have less error than their children so exactly one level is chosen for any part of the mesh
+bool lodCut(Meshlet meshlet, mat4 transform, uint bias) {
+    float threshold = globalData.lodErrorThreshold * float(1u << bias);
+    return projectedError(meshlet.lodBounds, meshlet.lodError, transform) <= threshold &&
+        projectedError(meshlet.parentLodBounds, meshlet.parentLodError, transform) > threshold;
+}
+
+// conservative lodCut of every meshlet below a node. their own errors project no smaller than the smallest of them at
+// the far side of the node's lod bounds, and their parents' no larger than the largest at the near side of its parent
+// bounds, so a node failing either can't contain part of the cut
+bool lodNodeCut(MeshletNode node, mat4 transform, uint bias) {
+    GPUCamera camera = globalData.cameraBuffer[globalData.primaryCameraIndex].camera;
+    float threshold = globalData.lodErrorThreshold * float(1u << bias);
+    float scale = transformScale(transform);
+    vec3 center = (transform * vec4(node.lodBounds.xyz, 1.0)).xyz;
+    float farthest = distance(center, camera.position) + node.lodBounds.w * scale;
+    return errorToPixels(node.minLodError * scale, farthest, camera) <= threshold &&
+        projectedError(node.parentLodBounds, node.maxParentLodError, transform) > threshold;
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef SHADER_MESHLET_HIERARCHY_GLSL
+#define SHADER_MESHLET_HIERARCHY_GLSL
+
+// walks the meshlet node hierarchy of a mesh breadth first with the whole workgroup, a wave of nodes per depth of the
+// tree, so the cost grows with the nodes around the lod cut and in view rather than with every meshlet of every
+// level. shaders including this define before it
+//   bool nodeVisible(MeshletNode node) - false if no meshlet below the node can be drawn
+//   void emitMeshlets(uint meshletOffset, uint meshletCount) - hands a range of meshlets to the task shader
+
+#define HIERARCHY_QUEUE_SIZE 512
+
+// node indices relative to the mesh's first node, double buffered between waves
+shared uint hierarchyQueue[2][HIERARCHY_QUEUE_SIZE];
+shared uint hierarchyQueueCount[2];
+// entries from the first push that didn't fit are never written, only those before it are read
+shared uint hierarchyQueueEnd[2];
+
+void traverseHierarchy(GPUMesh mesh) {
+    uint thread = gl_LocalInvocationIndex;
+    // meshes without a hierarchy are drawn whole and culled per meshlet
+    if (mesh.rootCount == 0) {
+        if (thread == 0 && mesh.lods[0].meshletCount > 0)
+            emitMeshlets(mesh.lods[0].meshletOffset, mesh.lods[0].meshletCount);
+        return;
+    }
+
+    uint count = min(mesh.rootCount, HIERARCHY_QUEUE_SIZE);
+    for (uint i = thread; i < count; i += gl_WorkGroupSize.x)
+        hierarchyQueue[0][i] = i;
+    if (thread == 0) {
+        hierarchyQueueCount[1] = 0;
+        hierarchyQueueEnd[1] = HIERARCHY_QUEUE_SIZE;
+    }
+    barrier();
+
+    uint visited = 0;
+    uint current = 0;
+    while (count > 0) {
+        uint next = 1 - current;
+        for (uint i = thread; i < count; i += gl_WorkGroupSize.x) {
+            MeshletNode node = globalData.meshletNodeBuffer.nodes[mesh.nodeOffset + hierarchyQueue[current][i]];
+            visited++;
+            if (!nodeVisible(node))
+                continue;
+            if (node.childCount == 0) {
+                emitMeshlets(node.meshletOffset, node.meshletCount);
+                continue;
+            }
+            uint slot = atomicAdd(hierarchyQueueCount[next], node.childCount);
+            if (slot + node.childCount <= HIERARCHY_QUEUE_SIZE) {
+                for (uint child = 0; child < node.childCount; child++)
+                    hierarchyQueue[next][slot + child] = node.childOffset + child;
+            } else {
+                // out of queue space the subtree is drawn whole, the task shader still culls each of its meshlets
+                atomicMin(hierarchyQueueEnd[next], slot);
+                emitMeshlets(node.meshletOffset, node.meshletCount);
+            }
+        }
+        barrier();
+        count = min(hierarchyQueueCount[next], hierarchyQueueEnd[next]);
+        barrier();
+        // the queue just read becomes the one written next wave
+        if (thread == 0) {
+            hierarchyQueueCount[current] = 0;
+            hierarchyQueueEnd[current] = HIERARCHY_QUEUE_SIZE;
+        }
+        barrier();
+        current = next;
+    }
+
+    if (visited > 0)
+        atomicAdd(globalData.feedbackBuffer.feedback.visitedNodes, visited);
+}
+
+#endif
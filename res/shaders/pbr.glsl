@@ -2,6 +2,7 @@
 #define PBR_GLSL
 
 #include "bindings.glsl"
+#include "probes.glsl"
 CALA_USE_SAMPLED_IMAGE(Cube);
 CALA_USE_SAMPLED_IMAGE(2D);
 
@@ -42,14 +43,18 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness) {
     return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
 }
 
-vec3 getAmbient(int irradianceIndex, int prefilterIndex, int brdfIndex, vec3 normal, vec3 V, vec3 F0, vec3 albedo, float roughness, float metallic) {
+vec3 getAmbient(int irradianceIndex, int prefilterIndex, int brdfIndex, vec3 position, vec3 normal, vec3 V, vec3 F0, vec3 albedo, float roughness, float metallic) {
     vec3 R = reflect(-V, normal);
     vec3 F = fresnelSchlickRoughness(max(dot(normal, V), 0.0), F0, roughness);
     vec3 kD = vec3(1.0) - F;
     kD *= 1.0 - metallic;
     vec3 diffuse = vec3(0.0001) * albedo;
     vec3 specular = vec3(0.0);
-    if (irradianceIndex >= 0) {
+    // the probe grid includes light bounced off the scene, the sky alone lights anything outside it
+    vec3 gridIrradiance;
+    if (sampleProbeGrid(position, normal, gridIrradiance))
+        diffuse = gridIrradiance * albedo;
+    else if (irradianceIndex >= 0) {
         vec3 irradiance = texture(CALA_COMBINED_SAMPLERCUBE(irradianceIndex, globalData.linearRepeatSampler), normal).rgb;
         diffuse = irradiance * albedo;
     }
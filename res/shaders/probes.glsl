@@ -0,0 +1,70 @@
+#ifndef PROBES_GLSL
+#define PROBES_GLSL
+
+#include "shaderBridge.h"
+#include "bindings.glsl"
+
+// l1 spherical harmonics basis in the order the probe coefficients are stored
+vec4 shBasis(vec3 direction) {
+    return vec4(0.282095, 0.488603 * direction.y, 0.488603 * direction.z, 0.488603 * direction.x);
+}
+
+// radiance the probe recorded arriving from direction
+vec3 probeRadiance(IrradianceProbe probe, vec3 direction) {
+    vec4 basis = shBasis(direction);
+    return max(probe.sh[0].rgb * basis.x + probe.sh[1].rgb * basis.y + probe.sh[2].rgb * basis.z + probe.sh[3].rgb * basis.w, vec3(0.0));
+}
+
+// cosine convolved radiance over pi, the same quantity as the sky irradiance map so both are multiplied by albedo
+vec3 probeIrradiance(IrradianceProbe probe, vec3 normal) {
+    vec4 basis = shBasis(normal);
+    vec3 irradiance = probe.sh[0].rgb * basis.x + (2.0 / 3.0) * (probe.sh[1].rgb * basis.y + probe.sh[2].rgb * basis.z + probe.sh[3].rgb * basis.w);
+    return max(irradiance, vec3(0.0));
+}
+
+uint probeIndex(uvec3 coord) {
+    uvec3 size = globalData.probeGridSize.xyz;
+    return coord.x + coord.y * size.x + coord.z * size.x * size.y;
+}
+
+vec3 probePosition(uvec3 coord) {
+    return globalData.probeGridOrigin.xyz + vec3(coord) * globalData.probeGridSpacing.xyz;
+}
+
+// blends the eight probes around position, probes behind the surface are weighted down as they mostly see its back.
+// false outside the grid or if none of them have been updated
+bool sampleProbeGrid(vec3 position, vec3 normal, out vec3 irradiance) {
+    irradiance = vec3(0.0);
+    uvec3 size = globalData.probeGridSize.xyz;
+    if (size.x == 0)
+        return false;
+
+    vec3 gridPosition = (position - globalData.probeGridOrigin.xyz) / globalData.probeGridSpacing.xyz;
+    if (any(lessThan(gridPosition, vec3(0.0))) || any(greaterThan(gridPosition, vec3(size - 1))))
+        return false;
+
+    uvec3 base = min(uvec3(gridPosition), size - 2);
+    vec3 alpha = gridPosition - vec3(base);
+    float totalWeight = 0.0;
+    for (uint i = 0; i < 8; i++) {
+        uvec3 offset = uvec3(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+        uvec3 coord = base + offset;
+        IrradianceProbe probe = globalData.probeBuffer.probes[probeIndex(coord)];
+        if (probe.sh[0].w == 0.0)
+            continue;
+
+        vec3 trilinear = mix(1.0 - alpha, alpha, vec3(offset));
+        vec3 toProbe = probePosition(coord) - position;
+        float facing = (dot(toProbe, normal) / max(length(toProbe), 0.0001) + 1.0) * 0.5;
+        float weight = trilinear.x * trilinear.y * trilinear.z * (facing * facing + 0.2);
+
+        irradiance += probeIrradiance(probe, normal) * weight;
+        totalWeight += weight;
+    }
+    if (totalWeight < 0.0001)
+        return false;
+    irradiance /= totalWeight;
+    return true;
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef SHADER_SAMPLING_GLSL
+#define SHADER_SAMPLING_GLSL
+
+// catmull-rom filter folded into 9 bilinear taps, based on "Filmic SMAA" SIGGRAPH 2016 presentation. image must be
+// sampled with a bilinear sampler
+vec3 sampleCatmullRom(sampler2D image, vec2 texCoord, vec2 imageSize) {
+    vec2 samplePosition = texCoord * imageSize;
+    vec2 texPos1 = floor(samplePosition - 0.5) + 0.5;
+
+    vec2 f = samplePosition - texPos1;
+
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+
+    vec2 w12 = w1 + w2;
+    vec2 offset12 = w2 / w12;
+
+    vec2 texPos0 = (texPos1 - 1.0) / imageSize;
+    vec2 texPos3 = (texPos1 + 2.0) / imageSize;
+    vec2 texPos12 = (texPos1 + offset12) / imageSize;
+
+    vec3 result = vec3(0.0);
+    result += textureLod(image, vec2(texPos0.x, texPos0.y), 0.0).rgb * w0.x * w0.y;
+    result += textureLod(image, vec2(texPos12.x, texPos0.y), 0.0).rgb * w12.x * w0.y;
+    result += textureLod(image, vec2(texPos3.x, texPos0.y), 0.0).rgb * w3.x * w0.y;
+
+    result += textureLod(image, vec2(texPos0.x, texPos12.y), 0.0).rgb * w0.x * w12.y;
+    result += textureLod(image, vec2(texPos12.x, texPos12.y), 0.0).rgb * w12.x * w12.y;
+    result += textureLod(image, vec2(texPos3.x, texPos12.y), 0.0).rgb * w3.x * w12.y;
+
+    result += textureLod(image, vec2(texPos0.x, texPos3.y), 0.0).rgb * w0.x * w3.y;
+    result += textureLod(image, vec2(texPos12.x, texPos3.y), 0.0).rgb * w12.x * w3.y;
+    result += textureLod(image, vec2(texPos3.x, texPos3.y), 0.0).rgb * w3.x * w3.y;
+
+    // negative lobes can ring below zero around bright edges
+    return max(result, vec3(0.0));
+}
+
+#endif
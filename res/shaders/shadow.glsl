@@ -3,71 +3,75 @@
 
 #include "util.glsl"
 
-CALA_USE_SAMPLED_IMAGE(Cube)
 CALA_USE_SAMPLED_IMAGE(2D)
 
-float calcShadows(uint index, vec3 viewDir, vec3 offset, float bias, float range) {
-    float shadow = 1.0;
-    if(texture(CALA_COMBINED_SAMPLERCUBE(index, globalData.shadowSampler), viewDir + offset).r < length(viewDir) / range - bias) {
-        shadow = 0.0;
-    }
-    return shadow;
+// size of a texel relative to the tile, tile is xy offset and zw scale within the shadow atlas
+vec2 tileTexelSize(int index, vec4 tile) {
+    return 1.0 / (textureSize(CALA_COMBINED_SAMPLER2D(index, globalData.shadowSampler), 0) * tile.zw);
+}
+
+// maps coordinates within a tile to atlas coordinates, clamped half a texel inside so filtering doesn't read neighbouring tiles
+vec2 atlasCoords(int index, vec4 tile, vec2 coords) {
+    vec2 halfTexel = tileTexelSize(index, tile) * 0.5;
+    return tile.xy + clamp(coords, halfTexel, 1.0 - halfTexel) * tile.zw;
 }
 
-float sampleShadow(int index, vec3 shadowCoords, vec2 offset, float bias) {
-    float closestDepth = texture(CALA_COMBINED_SAMPLER2D(index, globalData.shadowSampler), shadowCoords.xy + offset).r;
+float sampleShadow(int index, vec4 tile, vec3 shadowCoords, vec2 offset, float bias) {
+    float closestDepth = texture(CALA_COMBINED_SAMPLER2D(index, globalData.shadowSampler), atlasCoords(index, tile, shadowCoords.xy + offset)).r;
     if (closestDepth < shadowCoords.z - bias)
         return 0.0;
     return 1.0;
 }
 
-vec3 sampleOffsetDirections[20] = vec3[](
-vec3(1, 1, 1), vec3(1, -1, 1), vec3(-1, -1, 1), vec3(-1, 1, 1),
-vec3(1, 1, -1), vec3(1, -1, -1), vec3(-1, -1, -1), vec3(-1, 1, -1),
-vec3(1, 1, 0), vec3(1, -1, 0), vec3(-1, -1, 0), vec3(-1, 1, 0),
-vec3(1, 0, 1), vec3(-1, 0, 1), vec3(1, 0, -1), vec3(-1, 0, -1),
-vec3(0, 1, 1), vec3(0, -1, 1), vec3(0, -1, -1), vec3(0, 1, -1)
-);
-
-float filterPCF(uint index, vec3 worldPos, vec3 lightPos, float bias, float range) {
+float filterPCF2D(int index, vec4 tile, vec3 shadowCoords, float radius, float bias) {
     float shadow = 0;
-    int samples = 20;
-    vec3 viewDir = worldPos - lightPos;
-    float viewDistance = length(viewDir);
-    float diskRadius = (1.0 + (viewDistance / 100.f)) / 25.0;
+    int samples = globalData.pcfSamples;
+    vec2 texelSize = tileTexelSize(index, tile);
 
     for (int i = 0; i < samples; i++) {
-        shadow += calcShadows(index, viewDir, sampleOffsetDirections[i] * diskRadius, bias, range);
+//        vec2 randomDirection = random2(globalData.randomOffset * gl_FragCoord.xy * i) * 2 - 1;
+        vec2 randomDirection = poisson(i / float(samples));
+        shadow += sampleShadow(index, tile, shadowCoords, randomDirection * texelSize * radius, bias);
     }
     return shadow / samples;
 }
 
-float filterPCF2D(int index, vec3 shadowCoords, float radius, float bias) {
-    float shadow = 0;
-    int samples = globalData.pcfSamples;
-    vec2 texelSize = 1.0 / textureSize(CALA_COMBINED_SAMPLER2D(index, globalData.shadowSampler), 0);
+// point lights render each cube face into its own atlas tile storing distance to the light divided by range
+float filterPCF(int index, GPULight light, vec3 worldPos, float bias) {
+    vec3 viewDir = worldPos - light.position;
+    float viewDistance = length(viewDir);
+    float radius = 1.0 + viewDistance / 100.0;
 
-    for (int i = 0; i < samples; i++) {
-//        vec2 randomDirection = random2(globalData.randomOffset * gl_FragCoord.xy * i) * 2 - 1;
-        vec2 randomDirection = poisson(i / float(samples));
-        shadow += sampleShadow(index, shadowCoords, randomDirection * texelSize * radius, bias);
-//        shadow += sampleShadow(index, shadowCoords, sampleOffsetDirections[i].xy * texelSize * radius, bias);
+    for (int face = 0; face < 6; face++) {
+        vec4 tile = light.shadowTiles[face];
+        if (tile.z <= 0.0)
+            continue;
+
+        GPUCamera faceCamera = globalData.cameraBuffer[light.cameraIndex + face].camera;
+        vec4 facePos = faceCamera.projection * faceCamera.view * vec4(worldPos, 1.0);
+        if (facePos.w <= 0.0)
+            continue;
+        vec2 faceCoords = facePos.xy / facePos.w;
+        if (abs(faceCoords.x) > 1.0 || abs(faceCoords.y) > 1.0)
+            continue;
+
+        vec3 shadowCoords = vec3(faceCoords * 0.5 + 0.5, viewDistance / light.shadowRange);
+        return filterPCF2D(index, tile, shadowCoords, radius, bias);
     }
-    return shadow / samples;
+    return 1.0;
 }
 
-float blockerDistance(int shadowMapIndex, vec3 shadowCoords, float lightSize) {
+float blockerDistance(int shadowMapIndex, vec4 tile, vec3 shadowCoords, float lightSize) {
     int blockers = 0;
     float avgDistance = 0;
     float searchWidth = lightSize * (shadowCoords.z - 0.1) / globalData.cameraBuffer[globalData.primaryCameraIndex].camera.position.z;
-    vec2 texelSize = 1.0 / textureSize(CALA_COMBINED_SAMPLER2D(shadowMapIndex, globalData.shadowSampler), 0);
+    vec2 texelSize = tileTexelSize(shadowMapIndex, tile);
     int samples = globalData.blockerSamples;
 
     for (int i = 0; i < samples; i++) {
 //        vec2 randomDirection = random2(globalData.randomOffset * gl_FragCoord.xy * i) * 2 - 1;
         vec2 randomDirection = poisson(i / float(samples));
-        float z = texture(CALA_COMBINED_SAMPLER2D(shadowMapIndex, globalData.shadowSampler), shadowCoords.xy + randomDirection * texelSize * searchWidth).r;
-//        float z = texture(CALA_COMBINED_SAMPLER2D(shadowMapIndex, globalData.shadowSampler), shadowCoords.xy + sampleOffsetDirections[i].xy * texelSize * searchWidth).r;
+        float z = texture(CALA_COMBINED_SAMPLER2D(shadowMapIndex, globalData.shadowSampler), atlasCoords(shadowMapIndex, tile, shadowCoords.xy + randomDirection * texelSize * searchWidth)).r;
         if (z < shadowCoords.z) {
             blockers++;
             avgDistance += z;
@@ -78,12 +82,12 @@ float blockerDistance(int shadowMapIndex, vec3 shadowCoords, float lightSize) {
     return avgDistance / blockers;
 }
 
-float pcss2D(int index, vec3 shadowCoords, float lightSize, float bias) {
-    float blockerDist = blockerDistance(index, shadowCoords, lightSize);
+float pcss2D(int index, vec4 tile, vec3 shadowCoords, float lightSize, float bias) {
+    float blockerDist = blockerDistance(index, tile, shadowCoords, lightSize);
     if (blockerDist < 0)
         return 1;
     float penumbraSize = lightSize * (shadowCoords.z - blockerDist) / blockerDist;
-    return filterPCF2D(index, shadowCoords, penumbraSize, bias);
+    return filterPCF2D(index, tile, shadowCoords, penumbraSize, bias);
 }
 
-#endif
\ No newline at end of file
+#endif
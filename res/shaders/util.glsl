@@ -11,10 +11,11 @@ float linearDepth(float depth, float near, float far) {
 
 uint getTileIndex(vec3 position, uvec4 tileSizes, uvec2 screenSize, float near, float far) {
     uvec2 tileSize = screenSize / tileSizes.xy;
-    float scale = 24.0 / log2(far / near);
-    float bias = -(24.0 * log2(near) / log2(far / near));
-    uint zTile = uint(max(log2(linearDepth(position.z, near, far)) * scale + bias, 0.0));
-    uvec3 tiles = uvec3(uvec2(position.xy / tileSize), zTile);
+    float scale = float(tileSizes.z) / log2(far / near);
+    float bias = -(float(tileSizes.z) * log2(near) / log2(far / near));
+    uint zTile = min(uint(max(log2(linearDepth(position.z, near, far)) * scale + bias, 0.0)), tileSizes.z - 1);
+    // pixels past the last whole tile belong to the edge tiles
+    uvec3 tiles = uvec3(min(uvec2(position.xy / tileSize), tileSizes.xy - 1), zTile);
     uint tileIndex = tiles.x + tileSizes.x * tiles.y + (tileSizes.x * tileSizes.y) * tiles.z;
     return tileIndex;
 }
@@ -0,0 +1,37 @@
+#ifndef SHADER_VERTEX_GLSL
+#define SHADER_VERTEX_GLSL
+
+vec3 octahedralDecode(vec2 encoded) {
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-normal.z, 0.0);
+    normal.x += normal.x >= 0.0 ? -fold : fold;
+    normal.y += normal.y >= 0.0 ? -fold : fold;
+    return normalize(normal);
+}
+
+// index is relative to the start of the vertex buffer in units of the mesh's vertex format
+Vertex loadVertex(GPUMesh mesh, uint index) {
+    if (mesh.compactVertices == 0)
+        return globalData.vertexBuffer.vertices[index];
+
+    CompactVertex compact = CompactVertexBuffer(globalData.vertexBuffer).vertices[index];
+    vec3 quantized = vec3(unpackUnorm2x16(compact.positionXY), unpackUnorm2x16(compact.positionZ).x);
+
+    Vertex vertex;
+    vertex.position = mix(mesh.min.xyz, mesh.max.xyz, quantized);
+    vertex.normal = octahedralDecode(unpackSnorm2x16(compact.normal));
+    vertex.texCoords = unpackHalf2x16(compact.texCoords);
+    return vertex;
+}
+
+// position only decode for depth passes
+vec3 loadVertexPosition(GPUMesh mesh, uint index) {
+    if (mesh.compactVertices == 0)
+        return globalData.vertexBuffer.vertices[index].position;
+
+    CompactVertex compact = CompactVertexBuffer(globalData.vertexBuffer).vertices[index];
+    vec3 quantized = vec3(unpackUnorm2x16(compact.positionXY), unpackUnorm2x16(compact.positionZ).x);
+    return mix(mesh.min.xyz, mesh.max.xyz, quantized);
+}
+
+#endif
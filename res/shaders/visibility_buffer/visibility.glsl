@@ -122,6 +122,15 @@ UVGradient calcUVDerivitives(BarycentricDeriv derivitives, vec2[3] uvs) {
     return gradient;
 }
 
+// records the resolution of an image needed by a sample for texture streaming
+void requestImageResolution(int imageIndex, UVGradient gradient) {
+    float footprint = max(length(gradient.ddx), length(gradient.ddy));
+    uint resolution = uint(clamp(ceil(-log2(max(footprint, 1e-9))), 0.0, 30.0)) + 1;
+    // most samples ask for what is already recorded so check before contending on the atomic
+    if (globalData.mipFeedbackBuffer.requestedResolution[imageIndex] < resolution)
+        atomicMax(globalData.mipFeedbackBuffer.requestedResolution[imageIndex], resolution);
+}
+
 struct InterpolatedValues {
     vec3 worldPosition;
     vec2 screenPosition;
@@ -14,6 +14,16 @@
 #include <stack>
 #include <meshoptimizer.h>
 #include <Cala/shaderBridge.h>
+#include <Cala/TextureCompression.h>
+#include <Cala/MappedFile.h>
+#include <Ende/profile/profile.h>
+#include <fstream>
+#include <cstring>
+#include <queue>
+#include <limits>
+#include <chrono>
+#include <numeric>
+#include <algorithm>
 
 template <>
 cala::vk::Handle<cala::vk::ShaderModule, cala::vk::Device>& cala::AssetManager::Asset<cala::vk::ShaderModuleHandle>::operator*() noexcept {
@@ -68,6 +78,12 @@ void cala::AssetManager::setAssetPath(const std::filesystem::path &path) {
     addSearchPath(path);
 }
 
+std::filesystem::path cala::AssetManager::getCachePath() const {
+    if (_cachePath.empty())
+        return _rootAssetPath / "cache";
+    return _cachePath;
+}
+
 void cala::AssetManager::addSearchPath(const std::filesystem::path &path) {
     _searchPaths.push_back(path);
 }
@@ -303,6 +319,24 @@ cala::vk::ShaderModuleHandle cala::AssetManager::reloadShaderModule(u32 hash) {
     return module;
 }
 
+// stages a tightly packed mip level, block compressed levels are staged in blocks
+void stageMipLevel(cala::Engine& engine, cala::vk::ImageHandle image, std::span<const u8> data, u32 level) {
+    auto format = image->format();
+    u32 width = std::max(image->width() >> level, 1u);
+    u32 height = std::max(image->height() >> level, 1u);
+    if (cala::vk::isBlockFormat(format)) {
+        width = (width + 3) / 4;
+        height = (height + 3) / 4;
+    }
+    engine.stageData(image, data, {
+        level,
+        width,
+        height,
+        1,
+        cala::vk::formatToSize(format)
+    });
+}
+
 cala::vk::ImageHandle cala::AssetManager::loadImage(const std::string &name, const std::filesystem::path &path, vk::Format format) {
     u32 hash = std::hash<std::filesystem::path>()(absolute(path));
 
@@ -316,60 +350,479 @@ cala::vk::ImageHandle cala::AssetManager::loadImage(const std::string &name, con
         return imageMetadata.imageHandle;
     }
 
-    auto filePath = _rootAssetPath / path;
+    return uploadImage(index, hash, name, path, format, decodeImage(_rootAssetPath / path, hash, format));
+}
+
+cala::vk::ImageHandle cala::AssetManager::uploadImage(i32 index, u32 hash, const std::string &name, const std::filesystem::path &path, vk::Format format, std::optional<DecodedImage> image) {
+    if (!image) {
+        _engine->logger().warn("unable to load image: {}", path.string());
+        return { nullptr, -1, nullptr };
+    }
+
+    vk::ImageHandle handle;
+    if (image->file.size() > 0)
+        handle = createImageStream(std::move(image->file), std::move(image->levels), image->width, image->height, image->format);
+    else {
+        // levels not provided are generated from the first
+        bool generateMips = image->levels.size() < image->mips;
+        auto usage = vk::ImageUsage::SAMPLED | vk::ImageUsage::TRANSFER_DST;
+        if (generateMips)
+            usage = usage | vk::ImageUsage::TRANSFER_SRC;
+        handle = _engine->device().createImage({
+            image->width,
+            image->height,
+            1,
+            image->format,
+            image->mips,
+            1,
+            usage});
+
+        if (generateMips) {
+            _engine->device().deferred([handle](vk::CommandHandle cmd) {
+                handle->generateMips(cmd);
+            });
+        }
+
+        for (u32 level = 0; level < image->levels.size(); level++) {
+            auto [offset, size] = image->levels[level];
+            stageMipLevel(*_engine, handle, std::span<const u8>(image->data).subspan(offset, size), level);
+        }
+    }
+
+    auto& metadata = _metadata[index];
+    auto& imageMetadata = _images[metadata.index];
+    imageMetadata.hash = hash;
+    imageMetadata.name = name;
+    imageMetadata.path = path;
+    imageMetadata.format = format;
+    imageMetadata.imageHandle = handle;
+    imageMetadata.decodeTime = image->decodeTime;
+
+    metadata.loaded = true;
+
+    return imageMetadata.imageHandle;
+}
+
+std::optional<cala::AssetManager::DecodedImage> cala::AssetManager::decodeImage(const std::filesystem::path &path, u32 hash, vk::Format format, std::span<const u8> bytes) {
+    auto start = std::chrono::high_resolution_clock::now();
+    std::optional<DecodedImage> image;
+    if (bytes.empty() && path.extension() == ".ktx2")
+        image = decodeKTX2Image(path);
+    else if (vk::isBlockFormat(format))
+        image = decodeCompressedImage(path, hash, format, bytes);
+    else
+        image = decodeUncompressedImage(path, format, bytes);
+    if (image)
+        image->decodeTime = std::chrono::duration<f64, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return image;
+}
 
+std::optional<cala::AssetManager::DecodedImage> cala::AssetManager::decodeUncompressedImage(const std::filesystem::path &path, vk::Format format, std::span<const u8> bytes) {
     i32 width, height, channels;
     u8* data = nullptr;
-    u32 length = 0;
+    // flip state is per thread as images are decoded on the thread pool
     if (vk::formatToSize(format) > 4) {
-        stbi_set_flip_vertically_on_load(true);
-        f32* hdrData = stbi_loadf(filePath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+        stbi_set_flip_vertically_on_load_thread(true);
+        f32* hdrData = bytes.empty() ?
+                stbi_loadf(path.c_str(), &width, &height, &channels, STBI_rgb_alpha) :
+                stbi_loadf_from_memory(bytes.data(), bytes.size(), &width, &height, &channels, STBI_rgb_alpha);
         data = reinterpret_cast<u8*>(hdrData);
     } else {
-        stbi_set_flip_vertically_on_load(false);
-        data = stbi_load(filePath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+        stbi_set_flip_vertically_on_load_thread(false);
+        data = bytes.empty() ?
+                stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha) :
+                stbi_load_from_memory(bytes.data(), bytes.size(), &width, &height, &channels, STBI_rgb_alpha);
     }
-    if (!data) {
-        _engine->logger().warn("unable to load image: {}", path.string());
-        return { nullptr, -1, nullptr };
-    };
+    if (!data)
+        return {};
+
+    u64 length = static_cast<u64>(width) * height * vk::formatToSize(format);
+
+    DecodedImage image;
+    image.width = width;
+    image.height = height;
+    image.mips = std::floor(std::log2(std::max(width, height))) + 1;
+    image.format = format;
+    image.levels.push_back({ 0, length });
+    image.data.assign(data, data + length);
+    stbi_image_free(data);
+    return image;
+}
+
+// header of cached block compressed images, followed by the blocks of each mip level
+struct CompressedImageHeader {
+    u32 magic = 0x31434243; // "CBC1"
+    u32 version = 1; // increment when the encoder changes to invalidate existing caches
+    u32 format = 0;
+    u32 width = 0;
+    u32 height = 0;
+    u32 mips = 0;
+    i64 sourceTime = 0;
+};
+
+std::optional<cala::AssetManager::DecodedImage> cala::AssetManager::decodeCompressedImage(const std::filesystem::path &path, u32 hash, vk::Format format, std::span<const u8> bytes) {
+    std::error_code error;
+    auto sourceTime = std::filesystem::last_write_time(path, error);
+    if (error)
+        return {};
+
+    CompressedImageHeader expected{};
+    expected.format = static_cast<u32>(format);
+    expected.sourceTime = sourceTime.time_since_epoch().count();
+
+    auto cacheFile = getCachePath() / std::format("{}_{}.bc", hash, static_cast<u32>(format));
+
+    CompressedImageHeader header{};
+    bool cached = false;
+    if (std::ifstream cache(cacheFile, std::ios::binary); cache) {
+        cache.read(reinterpret_cast<char*>(&header), sizeof(header));
+        cached = cache && header.magic == expected.magic && header.version == expected.version &&
+            header.format == expected.format && header.sourceTime == expected.sourceTime;
+    }
+
+    std::vector<u8> blocks;
+    if (!cached) {
+        i32 width, height, channels;
+        stbi_set_flip_vertically_on_load_thread(false);
+        u8* data = bytes.empty() ?
+                stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha) :
+                stbi_load_from_memory(bytes.data(), bytes.size(), &width, &height, &channels, STBI_rgb_alpha);
+        if (!data)
+            return {};
+        std::vector<u8> texels(data, data + width * height * 4);
+        stbi_image_free(data);
+
+        header = expected;
+        header.width = width;
+        header.height = height;
+        header.mips = std::floor(std::log2(std::max(width, height))) + 1;
+
+        auto filter = bc::mipFilter(format);
+        u32 mipWidth = header.width;
+        u32 mipHeight = header.height;
+        for (u32 mip = 0; mip < header.mips; mip++) {
+            auto mipBlocks = bc::encode(format, texels, mipWidth, mipHeight);
+            blocks.insert(blocks.end(), mipBlocks.begin(), mipBlocks.end());
+            if (mip + 1 < header.mips) {
+                texels = bc::downsample(texels, mipWidth, mipHeight, filter);
+                mipWidth = std::max(mipWidth / 2, 1u);
+                mipHeight = std::max(mipHeight / 2, 1u);
+            }
+        }
+
+        std::filesystem::create_directories(cacheFile.parent_path(), error);
+        if (std::ofstream cache(cacheFile, std::ios::binary | std::ios::trunc); cache) {
+            cache.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            cache.write(reinterpret_cast<const char*>(blocks.data()), blocks.size());
+            cached = static_cast<bool>(cache);
+        } else
+            _engine->logger().warn("unable to write texture cache: {}", cacheFile.string());
+    }
+
+    DecodedImage image;
+    image.width = header.width;
+    image.height = header.height;
+    image.mips = header.mips;
+    image.format = format;
+
+    // offset and size of each mip level within the cache file
+    image.levels.resize(header.mips);
+    u64 offset = sizeof(header);
+    for (u32 mip = 0; mip < header.mips; mip++) {
+        u64 size = bc::blockCount(std::max(header.width >> mip, 1u), std::max(header.height >> mip, 1u)) * vk::formatToSize(format);
+        image.levels[mip] = { offset, size };
+        offset += size;
+    }
+
+    bool supported = _engine->device().context().getEnabledFeatures().textureCompressionBC;
+    if (supported && cached) {
+        if (auto file = MappedFile::open(cacheFile); file && file->size() >= offset) {
+            image.file = std::move(*file);
+            return image;
+        }
+    }
+
+    if (blocks.empty()) {
+        std::ifstream cache(cacheFile, std::ios::binary);
+        blocks.resize(offset - sizeof(header));
+        cache.seekg(sizeof(header));
+        cache.read(reinterpret_cast<char*>(blocks.data()), blocks.size());
+        if (!cache)
+            return {};
+    }
+    for (auto& level : image.levels)
+        level.first -= sizeof(header);
 
-    length = width * height * vk::formatToSize(format);
+    if (supported) {
+        image.data = std::move(blocks);
+        return image;
+    }
+
+    // decode back to rgba8 for devices without block compression support
+    image.format = bc::mipFilter(format) == bc::MipFilter::SRGB ? vk::Format::RGBA8_SRGB : vk::Format::RGBA8_UNORM;
+    for (u32 mip = 0; mip < header.mips; mip++) {
+        u32 mipWidth = std::max(header.width >> mip, 1u);
+        u32 mipHeight = std::max(header.height >> mip, 1u);
+        auto [levelOffset, levelSize] = image.levels[mip];
+        auto texels = bc::decode(format, std::span<const u8>(blocks).subspan(levelOffset, levelSize), mipWidth, mipHeight);
+        image.levels[mip] = { image.data.size(), texels.size() };
+        image.data.insert(image.data.end(), texels.begin(), texels.end());
+    }
+    return image;
+}
+
+template <typename T>
+T readKTX2(std::span<const u8> data, u64 offset) {
+    T value;
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+std::optional<cala::AssetManager::DecodedImage> cala::AssetManager::decodeKTX2Image(const std::filesystem::path &path) {
+    auto file = MappedFile::open(path);
+    if (!file)
+        return {};
+    auto data = file->data();
+
+    constexpr u8 identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    constexpr u64 levelIndexOffset = 80;
+    if (data.size() < levelIndexOffset || std::memcmp(data.data(), identifier, sizeof(identifier)) != 0)
+        return {};
+
+    auto format = static_cast<vk::Format>(readKTX2<u32>(data, 12));
+    u32 width = readKTX2<u32>(data, 20);
+    u32 height = std::max(readKTX2<u32>(data, 24), 1u);
+    u32 depth = readKTX2<u32>(data, 28);
+    u32 layers = readKTX2<u32>(data, 32);
+    u32 faces = readKTX2<u32>(data, 36);
+    u32 levelCount = std::max(readKTX2<u32>(data, 40), 1u);
+    u32 supercompression = readKTX2<u32>(data, 44);
+
+    if (supercompression != 0) {
+        _engine->logger().warn("supercompressed ktx2 images are not supported: {}", path.string());
+        return {};
+    }
+    if (vk::formatToSize(format) == 0 || depth > 1 || layers > 1 || faces > 1) {
+        _engine->logger().warn("unsupported ktx2 image format or type: {}", path.string());
+        return {};
+    }
+    if (data.size() < levelIndexOffset + levelCount * 3 * sizeof(u64))
+        return {};
+
+    DecodedImage image;
+    image.width = width;
+    image.height = height;
+    image.mips = levelCount;
+    image.format = format;
+    image.levels.resize(levelCount);
+    for (u32 level = 0; level < levelCount; level++) {
+        u64 offset = readKTX2<u64>(data, levelIndexOffset + level * 3 * sizeof(u64));
+        u64 length = readKTX2<u64>(data, levelIndexOffset + level * 3 * sizeof(u64) + sizeof(u64));
+        u32 levelWidth = std::max(width >> level, 1u);
+        u32 levelHeight = std::max(height >> level, 1u);
+        u64 size = vk::isBlockFormat(format) ? bc::blockCount(levelWidth, levelHeight) * vk::formatToSize(format) : levelWidth * levelHeight * vk::formatToSize(format);
+        if (length < size || offset + size > data.size()) {
+            _engine->logger().warn("invalid ktx2 mip level {}: {}", level, path.string());
+            return {};
+        }
+        image.levels[level] = { offset, size };
+    }
+    image.file = std::move(*file);
+    return image;
+}
+
+// mips no larger than this are uploaded when a streamed image is loaded and are never evicted
+constexpr u32 streamTailSize = 128;
+
+// bytes of the mip levels from the given level to the end of the chain
+u64 levelBytes(std::span<const std::pair<u64, u64>> levels, u32 from) {
+    u64 bytes = 0;
+    for (u32 level = from; level < levels.size(); level++)
+        bytes += levels[level].second;
+    return bytes;
+}
 
-    u32 mips = std::floor(std::log2(std::max(width, height))) + 1;
+cala::vk::ImageHandle cala::AssetManager::createImageStream(MappedFile file, std::vector<std::pair<u64, u64>> levels, u32 width, u32 height, vk::Format format) {
+    u32 tailMip = 0;
+    while (tailMip + 1 < levels.size() && std::max(width >> tailMip, height >> tailMip) > streamTailSize)
+        tailMip++;
+
+    // the image starts with the tail of the mip chain so it can be used straight away
     auto handle = _engine->device().createImage({
-        (u32)width,
-        (u32)height,
+        std::max(width >> tailMip, 1u),
+        std::max(height >> tailMip, 1u),
         1,
         format,
-        mips,
+        static_cast<u32>(levels.size()) - tailMip,
+        1,
+        vk::ImageUsage::SAMPLED | vk::ImageUsage::TRANSFER_DST});
+
+    for (u32 level = tailMip; level < levels.size(); level++)
+        stageMipLevel(*_engine, handle, file.data().subspan(levels[level].first, levels[level].second), level - tailMip);
+
+    if (tailMip > 0) {
+        _imageStreams.push_back({
+            handle,
+            std::move(file),
+            std::move(levels),
+            width,
+            height,
+            format,
+            tailMip,
+            tailMip,
+            tailMip,
+            tailMip,
+            tailMip,
+            _streamFrame,
+            _streamFrame,
+            {}
+        });
+    }
+    return handle;
+}
+
+u64 cala::AssetManager::resizeImageStream(ImageStream &stream, u32 baseMip) {
+    _retiredViews.push_back({ vk::FRAMES_IN_FLIGHT, std::move(stream.view) });
+    _engine->device().recreateImage(stream.image, {
+        std::max(stream.width >> baseMip, 1u),
+        std::max(stream.height >> baseMip, 1u),
         1,
-        vk::ImageUsage::SAMPLED | vk::ImageUsage::TRANSFER_DST | vk::ImageUsage::TRANSFER_SRC});
+        stream.format,
+        static_cast<u32>(stream.levels.size()) - baseMip,
+        1,
+        vk::ImageUsage::SAMPLED | vk::ImageUsage::TRANSFER_DST});
+
+    stream.baseMip = baseMip;
+    stream.residentMip = std::max(stream.residentMip, baseMip);
+    // force the view to be rebound to the new image
+    stream.viewMip = std::numeric_limits<u32>::max();
+
+    u64 staged = 0;
+    for (u32 level = stream.residentMip; level < stream.levels.size(); level++) {
+        auto [offset, size] = stream.levels[level];
+        stageMipLevel(*_engine, stream.image, stream.file.data().subspan(offset, size), level - baseMip);
+        staged += size;
+    }
+    return staged;
+}
+
+void cala::AssetManager::updateMipFeedback(std::span<const u32> requests) {
+    for (auto& stream : _imageStreams) {
+        u32 index = stream.image.index();
+        if (index >= requests.size() || requests[index] == 0)
+            continue;
+        // requests hold one more than log2 of the texels per uv unit sampled
+        u32 resolution = requests[index] - 1;
+        u32 fullResolution = std::floor(std::log2(std::max(stream.width, stream.height)));
+        u32 mip = std::min(fullResolution - std::min(resolution, fullResolution), static_cast<u32>(stream.levels.size()) - 1);
+        // more detailed levels are requested straight away, less detailed ones once the current level hasn't been
+        // needed for the residency delay so images aren't resized back and forth as the camera moves
+        if (mip <= stream.requestedMip || _streamFrame - stream.requestedFrame > _residencyDelay) {
+            stream.requestedMip = mip;
+            stream.requestedFrame = _streamFrame;
+        }
+    }
+}
+
+u64 cala::AssetManager::residentBytes() const {
+    u64 bytes = 0;
+    for (auto& stream : _imageStreams)
+        bytes += levelBytes(stream.levels, stream.baseMip);
+    return bytes;
+}
+
+u64 cala::AssetManager::requestedBytes() const {
+    u64 bytes = 0;
+    for (auto& stream : _imageStreams)
+        bytes += levelBytes(stream.levels, std::min(stream.requestedMip, stream.tailMip));
+    return bytes;
+}
 
-    _engine->device().deferred([handle](vk::CommandHandle cmd) {
-        handle->generateMips(cmd);
+u32 cala::AssetManager::streamingImages() const {
+    return std::count_if(_imageStreams.begin(), _imageStreams.end(), [](auto& stream) {
+        return stream.residentMip > stream.baseMip;
     });
+}
 
-    _engine->stageData(handle, std::span(data, length), {
-        0,
-        static_cast<u32>(width),
-        static_cast<u32>(height),
-        1,
-        vk::formatToSize(format)
+void cala::AssetManager::streamImages() {
+    PROFILE_NAMED("AssetManager::streamImages");
+    std::erase_if(_retiredViews, [](auto& retired) {
+        return retired.first-- == 0;
     });
 
-    stbi_image_free(data);
+    // levels each image should hold. images that haven't been sampled for the residency delay fall back to their tail
+    // and while over budget the most detailed level of the largest image is dropped
+    std::vector<u32> targetMips(_imageStreams.size());
+    u64 targetBytes = 0;
+    std::priority_queue<std::pair<u64, u32>> largest;
+    for (u32 i = 0; i < _imageStreams.size(); i++) {
+        auto& stream = _imageStreams[i];
+        targetMips[i] = _streamFrame - stream.requestedFrame > _residencyDelay ? stream.tailMip : std::min(stream.requestedMip, stream.tailMip);
+        targetBytes += levelBytes(stream.levels, targetMips[i]);
+        if (targetMips[i] < stream.tailMip)
+            largest.push({ stream.levels[targetMips[i]].second, i });
+    }
+    while (targetBytes > _residencyBudget && !largest.empty()) {
+        auto [size, i] = largest.top();
+        largest.pop();
+        targetBytes -= size;
+        targetMips[i]++;
+        if (targetMips[i] < _imageStreams[i].tailMip)
+            largest.push({ _imageStreams[i].levels[targetMips[i]].second, i });
+    }
 
-    auto& imageMetadata = _images[metadata.index];
-    imageMetadata.hash = hash;
-    imageMetadata.name = name;
-    imageMetadata.path = path;
-    imageMetadata.format = format;
-    imageMetadata.imageHandle = handle;
+    // shrink first to free memory for images that need to grow. streams created this frame still have their tail
+    // staged against the current image so are left until the next
+    u64 uploaded = 0;
+    for (u32 i = 0; i < _imageStreams.size(); i++) {
+        auto& stream = _imageStreams[i];
+        if (targetMips[i] > stream.baseMip && stream.createdFrame != _streamFrame)
+            uploaded += resizeImageStream(stream, targetMips[i]);
+    }
+    for (u32 i = 0; i < _imageStreams.size() && uploaded < _streamingBudget; i++) {
+        auto& stream = _imageStreams[i];
+        if (targetMips[i] < stream.baseMip && stream.createdFrame != _streamFrame)
+            uploaded += resizeImageStream(stream, targetMips[i]);
+    }
 
-    metadata.loaded = true;
+    // images advance one level at a time so they all sharpen together and the largest levels are uploaded last
+    bool progress = true;
+    while (progress && uploaded < _streamingBudget) {
+        progress = false;
+        for (auto& stream : _imageStreams) {
+            if (stream.residentMip == stream.baseMip || uploaded >= _streamingBudget)
+                continue;
+            u32 level = stream.residentMip - 1;
+            auto [offset, size] = stream.levels[level];
+            stageMipLevel(*_engine, stream.image, stream.file.data().subspan(offset, size), level - stream.baseMip);
+            uploaded += size;
+            stream.residentMip = level;
+            progress = true;
+        }
+    }
 
-    return imageMetadata.imageHandle;
+    // staged levels are flushed before the frame is submitted so views can include them now
+    for (auto& stream : _imageStreams) {
+        if (stream.residentMip == stream.viewMip)
+            continue;
+        _retiredViews.push_back({ vk::FRAMES_IN_FLIGHT, std::move(stream.view) });
+        if (stream.residentMip == stream.baseMip)
+            _engine->device().updateBindlessImage(stream.image.index(), stream.image->defaultView(), true, false);
+        else {
+            stream.view = stream.image->newView(stream.residentMip - stream.baseMip, stream.image->mips() - (stream.residentMip - stream.baseMip));
+            _engine->device().updateBindlessImage(stream.image.index(), stream.view, true, false);
+        }
+        stream.viewMip = stream.residentMip;
+    }
+    _streamFrame++;
+}
+
+std::optional<std::filesystem::path> cala::AssetManager::getImagePath(vk::ImageHandle handle) const {
+    for (auto& image : _images) {
+        if (image.imageHandle == handle)
+            return image.path;
+    }
+    return {};
 }
 
 cala::vk::ImageHandle cala::AssetManager::reloadImage(u32 hash) {
@@ -397,8 +850,488 @@ template <>
 struct fastgltf::ElementTraits<ende::math::Vec4f> : fastgltf::ElementTraitsBase<ende::math::Vec4f, AccessorType::Vec4, float> {};
 
 
-cala::AssetManager::Asset<cala::Model> cala::AssetManager::loadModel(const std::string &name, const std::filesystem::path &path, Material* material) {
+// bytes of a buffer held in memory by fastgltf, empty if the buffer wasn't loaded
+std::span<const u8> gltfBufferBytes(const fastgltf::Buffer& buffer) {
+    if (const auto* vector = std::get_if<fastgltf::sources::Vector>(&buffer.data); vector)
+        return { vector->bytes.data(), vector->bytes.size() };
+    if (const auto* view = std::get_if<fastgltf::sources::ByteView>(&buffer.data); view)
+        return { reinterpret_cast<const u8*>(view->bytes.data()), view->bytes.size() };
+    return {};
+}
+
+// header of cached model geometry, followed by the meshes, meshlets and meshlet nodes and then the meshopt encoded
+// vertex, meshlet index and meshlet primitive streams
+struct GeometryCacheHeader {
+    u32 magic = 0x314f4547; // "GEO1"
+    u32 version = 4; // increment when model processing changes to invalidate existing caches
+    u32 vertexSize = 0;
+    u32 vertexCount = 0;
+    u32 indexCount = 0;
+    u32 primitiveCount = 0;
+    u32 meshCount = 0;
+    u32 meshletCount = 0;
+    u32 nodeCount = 0;
+    u64 vertexStreamSize = 0;
+    u64 indexStreamSize = 0;
+    u64 primitiveStreamSize = 0;
+    i64 sourceTime = 0;
+};
+
+// primitives are encoded as a vertex stream of 4 byte vertices
+constexpr u32 primitiveStride = 4;
+
+std::optional<cala::AssetManager::CachedGeometry> cala::AssetManager::readGeometryCache(const std::filesystem::path &sourcePath, u32 hash, u32 vertexSize) {
+    std::error_code error;
+    auto sourceTime = std::filesystem::last_write_time(sourcePath, error);
+    if (error)
+        return {};
+
+    auto file = MappedFile::open(getCachePath() / std::format("{}.geometry", hash));
+    if (!file || file->size() < sizeof(GeometryCacheHeader))
+        return {};
+
+    GeometryCacheHeader header{};
+    std::memcpy(&header, file->data().data(), sizeof(header));
+    GeometryCacheHeader expected{};
+    if (header.magic != expected.magic || header.version != expected.version || header.vertexSize != vertexSize ||
+        header.sourceTime != sourceTime.time_since_epoch().count())
+        return {};
+
+    u64 meshesOffset = sizeof(header);
+    u64 meshletsOffset = meshesOffset + header.meshCount * sizeof(Model::Primitive);
+    u64 nodesOffset = meshletsOffset + header.meshletCount * sizeof(Meshlet);
+    u64 vertexStreamOffset = nodesOffset + header.nodeCount * sizeof(MeshletNode);
+    u64 indexStreamOffset = vertexStreamOffset + header.vertexStreamSize;
+    u64 primitiveStreamOffset = indexStreamOffset + header.indexStreamSize;
+    if (file->size() < primitiveStreamOffset + header.primitiveStreamSize)
+        return {};
+
+    // the mapping is shared with the decodes and unmapped once the last of them finishes
+    auto mapping = std::make_shared<MappedFile>(std::move(*file));
+    auto bytes = mapping->data();
+
+    CachedGeometry geometry;
+    geometry.vertices = _engine->threadPool().submit([mapping, header, stream = bytes.subspan(vertexStreamOffset, header.vertexStreamSize)] {
+        std::vector<u8> vertices(static_cast<u64>(header.vertexCount) * header.vertexSize);
+        if (meshopt_decodeVertexBuffer(vertices.data(), header.vertexCount, header.vertexSize, stream.data(), stream.size()) != 0)
+            vertices.clear();
+        return vertices;
+    });
+    geometry.indices = _engine->threadPool().submit([mapping, header, stream = bytes.subspan(indexStreamOffset, header.indexStreamSize)] {
+        std::vector<u32> indices(header.indexCount);
+        if (meshopt_decodeIndexSequence(indices.data(), header.indexCount, sizeof(u32), stream.data(), stream.size()) != 0)
+            indices.clear();
+        return indices;
+    });
+    geometry.primitives = _engine->threadPool().submit([mapping, header, stream = bytes.subspan(primitiveStreamOffset, header.primitiveStreamSize)] {
+        u32 primitiveVertexCount = (header.primitiveCount + primitiveStride - 1) / primitiveStride;
+        std::vector<u8> primitives(primitiveVertexCount * primitiveStride);
+        if (meshopt_decodeVertexBuffer(primitives.data(), primitiveVertexCount, primitiveStride, stream.data(), stream.size()) != 0)
+            primitives.clear();
+        primitives.resize(std::min<u64>(primitives.size(), header.primitiveCount));
+        return primitives;
+    });
+
+    geometry.meshes.resize(header.meshCount);
+    std::memcpy(geometry.meshes.data(), bytes.data() + meshesOffset, header.meshCount * sizeof(Model::Primitive));
+    geometry.meshlets.resize(header.meshletCount);
+    std::memcpy(geometry.meshlets.data(), bytes.data() + meshletsOffset, header.meshletCount * sizeof(Meshlet));
+    geometry.nodes.resize(header.nodeCount);
+    std::memcpy(geometry.nodes.data(), bytes.data() + nodesOffset, header.nodeCount * sizeof(MeshletNode));
+    return geometry;
+}
+
+void cala::AssetManager::writeGeometryCache(const std::filesystem::path &sourcePath, u32 hash, u32 vertexSize, std::span<const Model::Primitive> meshes, std::span<const Meshlet> meshlets, std::span<const MeshletNode> nodes, std::span<const u8> vertices, std::span<const u32> indices, std::span<const u8> primitives) {
+    std::error_code error;
+    auto sourceTime = std::filesystem::last_write_time(sourcePath, error);
+    if (error)
+        return;
+
+    GeometryCacheHeader header{};
+    header.vertexSize = vertexSize;
+    header.vertexCount = vertices.size() / vertexSize;
+    header.indexCount = indices.size();
+    header.primitiveCount = primitives.size();
+    header.meshCount = meshes.size();
+    header.meshletCount = meshlets.size();
+    header.nodeCount = nodes.size();
+    header.sourceTime = sourceTime.time_since_epoch().count();
+
+    std::vector<u8> vertexStream(meshopt_encodeVertexBufferBound(header.vertexCount, vertexSize));
+    vertexStream.resize(meshopt_encodeVertexBuffer(vertexStream.data(), vertexStream.size(), vertices.data(), header.vertexCount, vertexSize));
+
+    // meshlet indices are local to each primitive's vertices so the largest index bounds them all
+    u32 maxIndex = indices.empty() ? 0 : *std::max_element(indices.begin(), indices.end());
+    std::vector<u8> indexStream(meshopt_encodeIndexSequenceBound(indices.size(), maxIndex + 1));
+    indexStream.resize(meshopt_encodeIndexSequence(indexStream.data(), indexStream.size(), indices.data(), indices.size()));
+
+    std::vector<u8> paddedPrimitives(primitives.begin(), primitives.end());
+    paddedPrimitives.resize((primitives.size() + primitiveStride - 1) / primitiveStride * primitiveStride);
+    u32 primitiveVertexCount = paddedPrimitives.size() / primitiveStride;
+    std::vector<u8> primitiveStream(meshopt_encodeVertexBufferBound(primitiveVertexCount, primitiveStride));
+    primitiveStream.resize(meshopt_encodeVertexBuffer(primitiveStream.data(), primitiveStream.size(), paddedPrimitives.data(), primitiveVertexCount, primitiveStride));
+
+    if (vertexStream.empty() || indexStream.empty() || primitiveStream.empty())
+        return;
+    header.vertexStreamSize = vertexStream.size();
+    header.indexStreamSize = indexStream.size();
+    header.primitiveStreamSize = primitiveStream.size();
+
+    auto cacheFile = getCachePath() / std::format("{}.geometry", hash);
+    std::filesystem::create_directories(cacheFile.parent_path(), error);
+    std::ofstream cache(cacheFile, std::ios::binary | std::ios::trunc);
+    if (!cache) {
+        _engine->logger().warn("unable to write geometry cache: {}", cacheFile.string());
+        return;
+    }
+    cache.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    cache.write(reinterpret_cast<const char*>(meshes.data()), meshes.size() * sizeof(Model::Primitive));
+    cache.write(reinterpret_cast<const char*>(meshlets.data()), meshlets.size() * sizeof(Meshlet));
+    cache.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(MeshletNode));
+    cache.write(reinterpret_cast<const char*>(vertexStream.data()), vertexStream.size());
+    cache.write(reinterpret_cast<const char*>(indexStream.data()), indexStream.size());
+    cache.write(reinterpret_cast<const char*>(primitiveStream.data()), primitiveStream.size());
+}
+
+// meshlets of a primitive and the levels simplified from them. meshlet indices and primitives are appended after
+// indexOffset and primitiveOffset
+struct MeshletHierarchy {
+    std::vector<Meshlet> meshlets;
+    std::vector<u32> indices;
+    std::vector<u8> primitives;
+    std::vector<MeshletNode> nodes;
+    u32 levels = 0;
+    u32 rootCount = 0;
+};
+
+// 30 bit morton code of a position quantized to 10 bits per axis within min and max
+u32 mortonCode(const ende::math::Vec3f& position, const ende::math::Vec3f& min, const ende::math::Vec3f& max) {
+    const f32 positions[3] = { position.x(), position.y(), position.z() };
+    const f32 mins[3] = { min.x(), min.y(), min.z() };
+    const f32 maxs[3] = { max.x(), max.y(), max.z() };
+    u32 code = 0;
+    for (u32 axis = 0; axis < 3; axis++) {
+        f32 extent = maxs[axis] - mins[axis];
+        u32 quantized = extent > 0 ? static_cast<u32>((positions[axis] - mins[axis]) / extent * 1023.f) : 0;
+        for (u32 bit = 0; bit < 10; bit++)
+            code |= ((quantized >> bit) & 1) << (bit * 3 + axis);
+    }
+    return code;
+}
+
+// sphere centered on the average of spheres that encloses all of them
+ende::math::Vec4f encloseSpheres(std::span<const ende::math::Vec4f> spheres) {
+    ende::math::Vec3f center{ 0, 0, 0 };
+    for (auto& sphere : spheres)
+        center = center + ende::math::Vec3f{ sphere.x(), sphere.y(), sphere.z() } * (1.f / spheres.size());
+    f32 radius = 0;
+    for (auto& sphere : spheres) {
+        ende::math::Vec3f offset = ende::math::Vec3f{ sphere.x(), sphere.y(), sphere.z() } - center;
+        radius = std::max(radius, std::sqrt(offset.x() * offset.x() + offset.y() * offset.y() + offset.z() * offset.z()) + sphere.w());
+    }
+    return { center.x(), center.y(), center.z(), radius };
+}
+
+// node covering a run of contiguous nodes, their bounds are enclosed and the errors kept conservative for the cull
+MeshletNode mergeMeshletNodes(std::span<const MeshletNode> nodes) {
+    std::vector<ende::math::Vec4f> bounds;
+    std::vector<ende::math::Vec4f> lodBounds;
+    std::vector<ende::math::Vec4f> parentLodBounds;
+    MeshletNode merged{};
+    merged.minLodError = std::numeric_limits<f32>::max();
+    merged.meshletOffset = nodes.front().meshletOffset;
+    for (auto& node : nodes) {
+        bounds.push_back(node.bounds);
+        lodBounds.push_back(node.lodBounds);
+        parentLodBounds.push_back(node.parentLodBounds);
+        merged.minLodError = std::min(merged.minLodError, node.minLodError);
+        merged.maxParentLodError = std::max(merged.maxParentLodError, node.maxParentLodError);
+        merged.meshletCount += node.meshletCount;
+    }
+    merged.bounds = encloseSpheres(bounds);
+    merged.lodBounds = encloseSpheres(lodBounds);
+    merged.parentLodBounds = encloseSpheres(parentLodBounds);
+    return merged;
+}
+
+// bounding volume hierarchy over each level of a meshlet hierarchy so culling can reject whole regions of a level,
+// or a whole level, before testing its meshlets. a level is reordered along a morton curve so leaves are runs of
+// neighbouring meshlets, then runs of nodes are merged into parents until one root is left. the roots of every level
+// come first, meshlet and child offsets are relative to the primitive's first meshlet and node
+std::vector<MeshletNode> buildMeshletNodes(std::span<Meshlet> meshlets, std::span<const u32> levelOffsets) {
+    const u32 levelCount = levelOffsets.size() - 1;
+    std::vector<MeshletNode> nodes(levelCount);
+
+    for (u32 level = 0; level < levelCount; level++) {
+        auto levelMeshlets = meshlets.subspan(levelOffsets[level], levelOffsets[level + 1] - levelOffsets[level]);
+
+        // meshlets don't reference each other so are free to move within their level
+        ende::math::Vec3f minCenter = levelMeshlets.front().center;
+        ende::math::Vec3f maxCenter = minCenter;
+        for (auto& meshlet : levelMeshlets) {
+            auto& center = meshlet.center;
+            minCenter = { std::min(minCenter.x(), center.x()), std::min(minCenter.y(), center.y()), std::min(minCenter.z(), center.z()) };
+            maxCenter = { std::max(maxCenter.x(), center.x()), std::max(maxCenter.y(), center.y()), std::max(maxCenter.z(), center.z()) };
+        }
+        std::vector<u32> codes(levelMeshlets.size());
+        std::vector<u32> order(levelMeshlets.size());
+        for (u32 i = 0; i < levelMeshlets.size(); i++)
+            codes[i] = mortonCode(levelMeshlets[i].center, minCenter, maxCenter);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](u32 lhs, u32 rhs) { return codes[lhs] < codes[rhs]; });
+        std::vector<Meshlet> sorted(levelMeshlets.size());
+        for (u32 i = 0; i < order.size(); i++)
+            sorted[i] = levelMeshlets[order[i]];
+        std::copy(sorted.begin(), sorted.end(), levelMeshlets.begin());
+
+        std::vector<MeshletNode> meshletNodes(levelMeshlets.size());
+        for (u32 i = 0; i < levelMeshlets.size(); i++) {
+            auto& meshlet = levelMeshlets[i];
+            meshletNodes[i].bounds = { meshlet.center.x(), meshlet.center.y(), meshlet.center.z(), meshlet.radius };
+            meshletNodes[i].lodBounds = meshlet.lodBounds;
+            meshletNodes[i].parentLodBounds = meshlet.parentLodBounds;
+            meshletNodes[i].minLodError = meshlet.lodError;
+            meshletNodes[i].maxParentLodError = meshlet.parentLodError;
+            meshletNodes[i].meshletOffset = levelOffsets[level] + i;
+            meshletNodes[i].meshletCount = 1;
+        }
+
+        // layers of the level from the leaves up to its root
+        std::vector<std::vector<MeshletNode>> layers(1);
+        for (u32 first = 0; first < meshletNodes.size(); first += MESHLET_NODE_LEAF_SIZE) {
+            u32 count = std::min<u32>(MESHLET_NODE_LEAF_SIZE, meshletNodes.size() - first);
+            layers.back().push_back(mergeMeshletNodes(std::span(meshletNodes).subspan(first, count)));
+        }
+        while (layers.back().size() > 1) {
+            std::vector<MeshletNode> parents;
+            auto& children = layers.back();
+            for (u32 first = 0; first < children.size(); first += MESHLET_NODE_CHILDREN) {
+                u32 count = std::min<u32>(MESHLET_NODE_CHILDREN, children.size() - first);
+                auto parent = mergeMeshletNodes(std::span(children).subspan(first, count));
+                parent.childOffset = first;
+                parent.childCount = count;
+                parents.push_back(parent);
+            }
+            layers.push_back(std::move(parents));
+        }
+
+        // layers below the root are laid out top down so the children of a node are contiguous
+        std::vector<u32> layerOffsets(layers.size());
+        u32 offset = nodes.size();
+        for (u32 layer = layers.size() - 1; layer-- > 0;) {
+            layerOffsets[layer] = offset;
+            offset += layers[layer].size();
+        }
+        for (u32 layer = layers.size(); layer-- > 0;) {
+            for (auto node : layers[layer]) {
+                if (node.childCount > 0)
+                    node.childOffset += layerOffsets[layer - 1];
+                if (layer == layers.size() - 1)
+                    nodes[level] = node;
+                else
+                    nodes.push_back(node);
+            }
+        }
+    }
+    return nodes;
+}
+
+// spatially neighbouring meshlets are grouped and each group is simplified with its border locked into the meshlets
+// of the next level, so any cut through the levels is crack free. a group records its error and a sphere enclosing
+// the groups below it as the lod bounds of the meshlets it produced and the parent bounds of the meshlets it consumed.
+// groups that stop simplifying leave their meshlets as roots of the hierarchy
+MeshletHierarchy buildMeshletHierarchy(std::span<const Vertex> vertices, std::span<const u32> indices, u32 vertexOffset, u32 indexOffset, u32 primitiveOffset) {
+    const u32 maxVertices = 64;
+    const u32 maxTriangles = 64;
+    // trades some spatial locality for tighter normal cones so more meshlets can be backface culled
+    const f32 coneWeight = 0.25f;
+    const u32 groupSize = 4;
+    const u32 maxLevels = 16;
+    const f32 rootError = std::numeric_limits<f32>::max();
+
+    MeshletHierarchy hierarchy;
+    const f32 errorScale = meshopt_simplifyScale(reinterpret_cast<const f32*>(vertices.data()), vertices.size(), sizeof(Vertex));
+
+    // builds meshlets from triangles and returns the triangles of each as indices into vertices
+    const auto appendMeshlets = [&](std::span<const u32> triangles, const ende::math::Vec4f* bounds, f32 error) {
+        u32 maxMeshlets = meshopt_buildMeshletsBound(triangles.size(), maxVertices, maxTriangles);
+        std::vector<meshopt_Meshlet> meshMeshlets(maxMeshlets);
+        std::vector<u32> meshletVertices(maxMeshlets * maxVertices);
+        std::vector<u8> meshletTriangles(maxMeshlets * maxTriangles * 3);
+        u32 meshletCount = meshopt_buildMeshlets(meshMeshlets.data(), meshletVertices.data(), meshletTriangles.data(), triangles.data(), triangles.size(), reinterpret_cast<const f32*>(vertices.data()), vertices.size(), sizeof(Vertex), maxVertices, maxTriangles, coneWeight);
+
+        std::vector<std::vector<u32>> meshletIndices(meshletCount);
+        for (u32 i = 0; i < meshletCount; i++) {
+            auto& meshlet = meshMeshlets[i];
+            meshopt_Bounds meshletBounds = meshopt_computeMeshletBounds(&meshletVertices[meshlet.vertex_offset], &meshletTriangles[meshlet.triangle_offset], meshlet.triangle_count, reinterpret_cast<const f32*>(vertices.data()), vertices.size(), sizeof(Vertex));
+
+            ende::math::Vec3f center{ meshletBounds.center[0], meshletBounds.center[1], meshletBounds.center[2] };
+            ende::math::Vec3f coneApex{ meshletBounds.cone_apex[0], meshletBounds.cone_apex[1], meshletBounds.cone_apex[2] };
+            ende::math::Vec3f coneAxis{ meshletBounds.cone_axis[0], meshletBounds.cone_axis[1], meshletBounds.cone_axis[2] };
+            // source meshlets are their own lod bounds
+            ende::math::Vec4f lodBounds = bounds ? *bounds : ende::math::Vec4f{ center.x(), center.y(), center.z(), meshletBounds.radius };
+
+            hierarchy.meshlets.push_back({
+                vertexOffset,
+                static_cast<u32>(indexOffset + hierarchy.indices.size()),
+                meshlet.vertex_count,
+                static_cast<u32>(primitiveOffset + hierarchy.primitives.size()),
+                meshlet.triangle_count,
+                center,
+                meshletBounds.radius,
+                coneApex,
+                coneAxis,
+                meshletBounds.cone_cutoff,
+                lodBounds,
+                lodBounds,
+                error,
+                rootError
+            });
+            hierarchy.indices.insert(hierarchy.indices.end(), &meshletVertices[meshlet.vertex_offset], &meshletVertices[meshlet.vertex_offset] + meshlet.vertex_count);
+            hierarchy.primitives.insert(hierarchy.primitives.end(), &meshletTriangles[meshlet.triangle_offset], &meshletTriangles[meshlet.triangle_offset] + meshlet.triangle_count * 3);
+            hierarchy.primitives.resize((hierarchy.primitives.size() + 3) & ~3);
+
+            meshletIndices[i].reserve(meshlet.triangle_count * 3);
+            for (u32 j = 0; j < meshlet.triangle_count * 3; j++)
+                meshletIndices[i].push_back(meshletVertices[meshlet.vertex_offset + meshletTriangles[meshlet.triangle_offset + j]]);
+        }
+        return meshletIndices;
+    };
+
+    std::vector<std::vector<u32>> levelTriangles = appendMeshlets(indices, nullptr, 0);
+    std::vector<u32> level(hierarchy.meshlets.size());
+    std::iota(level.begin(), level.end(), 0);
+    hierarchy.levels = 1;
+    // meshlets are appended a level at a time, lone meshlets carried up stay in the level they were built in
+    std::vector<u32> levelOffsets = { 0, static_cast<u32>(hierarchy.meshlets.size()) };
+
+    while (level.size() > 1 && hierarchy.levels < maxLevels) {
+        // order the level along a morton curve of the meshlet centers so consecutive meshlets are neighbours
+        ende::math::Vec3f minCenter = hierarchy.meshlets[level.front()].center;
+        ende::math::Vec3f maxCenter = minCenter;
+        for (auto meshletIndex : level) {
+            auto& center = hierarchy.meshlets[meshletIndex].center;
+            minCenter = { std::min(minCenter.x(), center.x()), std::min(minCenter.y(), center.y()), std::min(minCenter.z(), center.z()) };
+            maxCenter = { std::max(maxCenter.x(), center.x()), std::max(maxCenter.y(), center.y()), std::max(maxCenter.z(), center.z()) };
+        }
+        std::vector<u32> order(level.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::vector<u32> codes(level.size());
+        for (u32 i = 0; i < level.size(); i++)
+            codes[i] = mortonCode(hierarchy.meshlets[level[i]].center, minCenter, maxCenter);
+        std::sort(order.begin(), order.end(), [&](u32 lhs, u32 rhs) { return codes[lhs] < codes[rhs]; });
+
+        std::vector<u32> nextLevel;
+        std::vector<std::vector<u32>> nextTriangles;
+        for (u32 first = 0; first < order.size(); first += groupSize) {
+            u32 last = std::min<u32>(first + groupSize, order.size());
+            // a lone meshlet has nothing to merge with so is carried into the next level
+            if (last - first == 1) {
+                nextLevel.push_back(level[order[first]]);
+                nextTriangles.push_back(std::move(levelTriangles[order[first]]));
+                continue;
+            }
+
+            std::vector<u32> groupTriangles;
+            f32 childError = 0;
+            ende::math::Vec3f groupCenter{ 0, 0, 0 };
+            for (u32 i = first; i < last; i++) {
+                auto& meshlet = hierarchy.meshlets[level[order[i]]];
+                groupTriangles.insert(groupTriangles.end(), levelTriangles[order[i]].begin(), levelTriangles[order[i]].end());
+                childError = std::max(childError, meshlet.lodError);
+                groupCenter = groupCenter + ende::math::Vec3f{ meshlet.lodBounds.x(), meshlet.lodBounds.y(), meshlet.lodBounds.z() } * (1.f / (last - first));
+            }
+
+            std::vector<u32> simplified(groupTriangles.size());
+            f32 simplifyError = 0;
+            u32 targetCount = (groupTriangles.size() / 2) / 3 * 3;
+            u32 simplifiedCount = meshopt_simplify(simplified.data(), groupTriangles.data(), groupTriangles.size(), reinterpret_cast<const f32*>(vertices.data()), vertices.size(), sizeof(Vertex), targetCount, 1.f, meshopt_SimplifyLockBorder, &simplifyError);
+            if (simplifiedCount == 0 || simplifiedCount > groupTriangles.size() * 0.85f)
+                continue;
+            simplified.resize(simplifiedCount);
+
+            // the group bounds enclose the lod bounds of its meshlets and its error is at least theirs, so parents
+            // never project smaller than their children
+            f32 groupRadius = 0;
+            for (u32 i = first; i < last; i++) {
+                auto& bounds = hierarchy.meshlets[level[order[i]]].lodBounds;
+                ende::math::Vec3f offset = ende::math::Vec3f{ bounds.x(), bounds.y(), bounds.z() } - groupCenter;
+                groupRadius = std::max(groupRadius, std::sqrt(offset.x() * offset.x() + offset.y() * offset.y() + offset.z() * offset.z()) + bounds.w());
+            }
+            ende::math::Vec4f groupBounds{ groupCenter.x(), groupCenter.y(), groupCenter.z(), groupRadius };
+            f32 groupError = childError + simplifyError * errorScale;
+
+            for (u32 i = first; i < last; i++) {
+                auto& meshlet = hierarchy.meshlets[level[order[i]]];
+                meshlet.parentLodBounds = groupBounds;
+                meshlet.parentLodError = groupError;
+            }
+
+            u32 firstNew = hierarchy.meshlets.size();
+            auto triangles = appendMeshlets(simplified, &groupBounds, groupError);
+            for (u32 i = 0; i < triangles.size(); i++) {
+                nextLevel.push_back(firstNew + i);
+                nextTriangles.push_back(std::move(triangles[i]));
+            }
+        }
+
+        if (hierarchy.meshlets.size() > levelOffsets.back())
+            levelOffsets.push_back(hierarchy.meshlets.size());
+        if (nextLevel.size() >= level.size())
+            break;
+        level = std::move(nextLevel);
+        levelTriangles = std::move(nextTriangles);
+        hierarchy.levels++;
+    }
+
+    if (!hierarchy.meshlets.empty()) {
+        hierarchy.nodes = buildMeshletNodes(hierarchy.meshlets, levelOffsets);
+        hierarchy.rootCount = levelOffsets.size() - 1;
+    }
+    return hierarchy;
+}
+
+// octahedral encoding of a unit vector into two snorm16
+u32 octahedralEncode(const ende::math::Vec3f& normal) {
+    f32 length = std::abs(normal.x()) + std::abs(normal.y()) + std::abs(normal.z());
+    if (length == 0)
+        return 0;
+    f32 x = normal.x() / length;
+    f32 y = normal.y() / length;
+    if (normal.z() < 0) {
+        f32 foldedX = (1 - std::abs(y)) * (x >= 0 ? 1 : -1);
+        f32 foldedY = (1 - std::abs(x)) * (y >= 0 ? 1 : -1);
+        x = foldedX;
+        y = foldedY;
+    }
+    u32 encodedX = static_cast<u16>(meshopt_quantizeSnorm(x, 16));
+    u32 encodedY = static_cast<u16>(meshopt_quantizeSnorm(y, 16));
+    return encodedX | (encodedY << 16);
+}
+
+// must match loadVertex in vertex.glsl
+CompactVertex compactVertex(const Vertex& vertex, const ende::math::Vec3f& min, const ende::math::Vec3f& max) {
+    const f32 positions[3] = { vertex.position.x(), vertex.position.y(), vertex.position.z() };
+    const f32 mins[3] = { min.x(), min.y(), min.z() };
+    const f32 maxs[3] = { max.x(), max.y(), max.z() };
+    u32 position[3] = {};
+    for (u32 axis = 0; axis < 3; axis++) {
+        f32 extent = maxs[axis] - mins[axis];
+        f32 normalised = extent > 0 ? (positions[axis] - mins[axis]) / extent : 0;
+        position[axis] = meshopt_quantizeUnorm(std::clamp(normalised, 0.f, 1.f), 16);
+    }
+    return {
+        position[0] | (position[1] << 16),
+        position[2],
+        octahedralEncode(vertex.normal),
+        static_cast<u32>(meshopt_quantizeHalf(vertex.texCoords.x())) | (static_cast<u32>(meshopt_quantizeHalf(vertex.texCoords.y())) << 16)
+    };
+}
+
+cala::AssetManager::Asset<cala::Model> cala::AssetManager::loadModel(const std::string &name, const std::filesystem::path &path, Material* material, Model::VertexFormat vertexFormat) {
     u32 hash = std::hash<std::filesystem::path>()(absolute(path));
+    // the same file can be loaded once in each vertex format
+    hash ^= static_cast<u32>(vertexFormat);
 
     i32 index = getAssetIndex(hash);
     if (index < 0)
@@ -414,9 +1347,17 @@ cala::AssetManager::Asset<cala::Model> cala::AssetManager::loadModel(const std::
 
     auto filePath = _rootAssetPath / path;
 
+    // the model is parsed from a mapping of the file rather than a copy of it. glb buffers and embedded images are
+    // read from the mapping so it has to outlive the parsed asset
+    auto file = MappedFile::open(filePath, fastgltf::getGltfBufferPadding());
+    if (!file) {
+        _engine->logger().warn("unable to open model: {}", path.string());
+        return { this, index };
+    }
+
     fastgltf::Parser parser;
     fastgltf::GltfDataBuffer data;
-    data.loadFromFile(filePath);
+    data.fromByteView(const_cast<u8*>(file->data().data()), file->size(), file->size() + fastgltf::getGltfBufferPadding());
 
     auto type = fastgltf::determineGltfFileType(&data);
     auto asset = type == fastgltf::GltfType::GLB ?
@@ -428,60 +1369,154 @@ cala::AssetManager::Asset<cala::Model> cala::AssetManager::loadModel(const std::
         return { this, index };
     }
 
-    // load images
-    std::vector<vk::ImageHandle> images;
+    // geometry processed by an earlier load is decoded on the thread pool while the images and materials load
+    const bool compact = vertexFormat == Model::VertexFormat::COMPACT;
+    const u32 vertexSize = compact ? sizeof(CompactVertex) : sizeof(Vertex);
+    auto cachedGeometry = _geometryCache ? readGeometryCache(filePath, hash, vertexSize) : std::nullopt;
+
+    // bc7 keeps albedo alpha, bc5 stores normal xy with z rebuilt in the shader and bc1 covers the rest
+    bool compress = _textureCompression && _engine->device().context().getEnabledFeatures().textureCompressionBC;
+    vk::Format albedoFormat = compress ? vk::Format::BC7_SRGB : vk::Format::RGBA8_SRGB;
+    vk::Format normalFormat = compress ? vk::Format::BC5_UNORM : vk::Format::RGBA8_UNORM;
+    vk::Format metallicRoughnessFormat = compress ? vk::Format::BC1_RGB_UNORM : vk::Format::RGBA8_UNORM;
+    vk::Format emissiveFormat = compress ? vk::Format::BC1_RGB_UNORM : vk::Format::RGBA8_UNORM;
+
+    // load images. every image referenced by the materials is decoded concurrently on the thread pool, images used by
+    // several materials are only decoded once
+    struct ImageLoad {
+        i32 assetIndex;
+        u32 hash;
+        std::string name;
+        std::filesystem::path path;
+        vk::Format format;
+        std::future<std::optional<DecodedImage>> decoded;
+        vk::ImageHandle handle;
+    };
+    std::vector<ImageLoad> imageLoads;
+    tsl::robin_map<u32, u32> imageLoadIndices;
+
+    auto requestImage = [&](u32 textureIndex, vk::Format format) -> i32 {
+        auto& texture = asset->textures[textureIndex];
+        if (!texture.imageIndex.has_value())
+            return -1;
+        auto& image = asset->images[texture.imageIndex.value()];
+        std::filesystem::path imagePath;
+        std::span<const u8> bytes;
+        if (const auto* uri = std::get_if<fastgltf::sources::URI>(&image.data); uri)
+            imagePath = path.parent_path() / uri->uri.path();
+        else {
+            if (const auto* view = std::get_if<fastgltf::sources::BufferView>(&image.data); view) {
+                auto& bufferView = asset->bufferViews[view->bufferViewIndex];
+                auto buffer = gltfBufferBytes(asset->buffers[bufferView.bufferIndex]);
+                if (bufferView.byteOffset + bufferView.byteLength <= buffer.size())
+                    bytes = buffer.subspan(bufferView.byteOffset, bufferView.byteLength);
+            } else if (const auto* vector = std::get_if<fastgltf::sources::Vector>(&image.data); vector)
+                bytes = { vector->bytes.data(), vector->bytes.size() };
+            if (bytes.empty()) {
+                _engine->logger().warn("unsupported source for image {} of model: {}", texture.imageIndex.value(), path.string());
+                return -1;
+            }
+            // embedded images are named by their index within the model
+            imagePath = path / std::format("image{}", texture.imageIndex.value());
+        }
+        u32 imageHash = std::hash<std::filesystem::path>()(absolute(imagePath));
+        if (auto it = imageLoadIndices.find(imageHash); it != imageLoadIndices.end())
+            return it->second;
+
+        i32 assetIndex = getAssetIndex(imageHash);
+        if (assetIndex < 0)
+            assetIndex = registerImage(image.name.c_str(), imagePath, imageHash);
+
+        u32 loadIndex = imageLoads.size();
+        imageLoadIndices.insert({ imageHash, loadIndex });
+        imageLoads.push_back({ assetIndex, imageHash, image.name.c_str(), imagePath, format });
+        auto& load = imageLoads.back();
+        if (_metadata[assetIndex].loaded)
+            load.handle = _images[_metadata[assetIndex].index].imageHandle;
+        else {
+            // embedded images are decoded from the mapped model, whose write time validates their cached encodes
+            auto sourcePath = bytes.empty() ? _rootAssetPath / imagePath : filePath;
+            load.decoded = _engine->threadPool().submit([this, sourcePath, imageHash, format, bytes] {
+                return decodeImage(sourcePath, imageHash, format, bytes);
+            });
+        }
+        return loadIndex;
+    };
+
+    struct MaterialImages {
+        i32 albedo = -1;
+        i32 normal = -1;
+        i32 metallicRoughness = -1;
+        i32 emissive = -1;
+    };
+    std::vector<MaterialImages> materialImages(asset->materials.size());
+    for (u32 i = 0; auto& modelMaterial : asset->materials) {
+        auto& images = materialImages[i++];
+        if (modelMaterial.pbrData.baseColorTexture.has_value())
+            images.albedo = requestImage(modelMaterial.pbrData.baseColorTexture->textureIndex, albedoFormat);
+        if (modelMaterial.normalTexture.has_value())
+            images.normal = requestImage(modelMaterial.normalTexture->textureIndex, normalFormat);
+        if (modelMaterial.pbrData.metallicRoughnessTexture.has_value())
+            images.metallicRoughness = requestImage(modelMaterial.pbrData.metallicRoughnessTexture->textureIndex, metallicRoughnessFormat);
+        if (modelMaterial.emissiveTexture.has_value())
+            images.emissive = requestImage(modelMaterial.emissiveTexture->textureIndex, emissiveFormat);
+    }
+
+    // upload images in the order they finish decoding so staging overlaps with the remaining decodes
+    u32 remaining = std::count_if(imageLoads.begin(), imageLoads.end(), [](auto& load) { return load.decoded.valid(); });
+    while (remaining > 0) {
+        bool uploaded = false;
+        for (auto& load : imageLoads) {
+            if (!load.decoded.valid() || load.decoded.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                continue;
+            load.handle = uploadImage(load.assetIndex, load.hash, load.name, load.path, load.format, load.decoded.get());
+            remaining--;
+            uploaded = true;
+        }
+        if (!uploaded) {
+            for (auto& load : imageLoads) {
+                if (load.decoded.valid()) {
+                    load.decoded.wait_for(std::chrono::milliseconds(1));
+                    break;
+                }
+            }
+        }
+    }
+
+    auto imageIndex = [&](i32 loadIndex) -> i32 {
+        if (loadIndex < 0 || !imageLoads[loadIndex].handle)
+            return -1;
+        return imageLoads[loadIndex].handle.index();
+    };
 
     // load materials
     std::vector<MaterialInstance> materials;
-    for (auto& modelMaterial : asset->materials) {
+    for (u32 i = 0; auto& modelMaterial : asset->materials) {
         MaterialInstance materialInstance = material->instance();
+        auto& images = materialImages[i++];
 
         if (modelMaterial.pbrData.baseColorTexture.has_value()) {
-            i32 textureIndex = modelMaterial.pbrData.baseColorTexture->textureIndex;
-            i32 imageIndex = asset->textures[textureIndex].imageIndex.value();
-            auto& image = asset->images[imageIndex];
-            if (const auto* filePath = std::get_if<fastgltf::sources::URI>(&image.data); filePath) {
-                images.push_back(loadImage(image.name.c_str(), path.parent_path() / filePath->uri.path(), vk::Format::RGBA8_SRGB));
-            }
-            if (!materialInstance.setParameter("albedoIndex", images.back().index()))
+            if (!materialInstance.setParameter("albedoIndex", imageIndex(images.albedo)))
                 _engine->logger().warn("tried to load \"albedoIndex\" but supplied material does not have appropriate parameter");
         } else
             materialInstance.setParameter("albedoIndex", -1);
 
 
         if (modelMaterial.normalTexture.has_value()) {
-            i32 textureIndex = modelMaterial.normalTexture->textureIndex;
-            i32 imageIndex = asset->textures[textureIndex].imageIndex.value();
-            auto& image = asset->images[imageIndex];
-            if (const auto* filePath = std::get_if<fastgltf::sources::URI>(&image.data); filePath) {
-                images.push_back(loadImage(image.name.c_str(), path.parent_path() / filePath->uri.path(), vk::Format::RGBA8_UNORM));
-            }
-            if (!materialInstance.setParameter("normalIndex", images.back().index()))
+            if (!materialInstance.setParameter("normalIndex", imageIndex(images.normal)))
                 _engine->logger().warn("tried to load \"normalIndex\" but supplied material does not have appropriate parameter");
         } else
             materialInstance.setParameter("normalIndex", -1);
 
 
         if (modelMaterial.pbrData.metallicRoughnessTexture.has_value()) {
-            i32 textureIndex = modelMaterial.pbrData.metallicRoughnessTexture->textureIndex;
-            i32 imageIndex = asset->textures[textureIndex].imageIndex.value();
-            auto& image = asset->images[imageIndex];
-            if (const auto* filePath = std::get_if<fastgltf::sources::URI>(&image.data); filePath) {
-                images.push_back(loadImage(image.name.c_str(), path.parent_path() / filePath->uri.path(), vk::Format::RGBA8_UNORM));
-            }
-            if (!materialInstance.setParameter("metallicRoughnessIndex", images.back().index()))
+            if (!materialInstance.setParameter("metallicRoughnessIndex", imageIndex(images.metallicRoughness)))
                 _engine->logger().warn("tried to load \"metallicRoughnessIndex\" but supplied material does not have appropriate parameter");
         } else
             materialInstance.setParameter("metallicRoughnessIndex", -1);
 
         if (modelMaterial.emissiveTexture.has_value()) {
-            i32 textureIndex = modelMaterial.emissiveTexture->textureIndex;
-            i32 imageIndex = asset->textures[textureIndex].imageIndex.value();
-            auto& image = asset->images[imageIndex];
-            if (const auto* filePath = std::get_if<fastgltf::sources::URI>(&image.data); filePath) {
-                images.push_back(loadImage(image.name.c_str(), path.parent_path() / filePath->uri.path(), vk::Format::RGBA8_UNORM));
-            }
-            if (!materialInstance.setParameter("emissiveIndex", images.back().index()))
+            if (!materialInstance.setParameter("emissiveIndex", imageIndex(images.emissive)))
                 _engine->logger().warn("tried to load \"emissiveIndex\" but supplied material does not have appropriate parameter");
         } else
             materialInstance.setParameter("emissiveIndex", -1);
@@ -501,12 +1536,35 @@ cala::AssetManager::Asset<cala::Model> cala::AssetManager::loadModel(const std::
     }
 
     std::vector<Vertex> vertices;
+    std::vector<CompactVertex> compactVertices;
     std::vector<u32> indices;
     std::vector<Meshlet> meshlets;
+    std::vector<MeshletNode> nodes;
     std::vector<u8> primitives;
 
     std::vector<Model::Primitive> meshes;
 
+    std::vector<u8> cachedVertices;
+    if (cachedGeometry) {
+        cachedVertices = cachedGeometry->vertices.get();
+        indices = cachedGeometry->indices.get();
+        primitives = cachedGeometry->primitives.get();
+        meshes = std::move(cachedGeometry->meshes);
+        meshlets = std::move(cachedGeometry->meshlets);
+        nodes = std::move(cachedGeometry->nodes);
+        if (cachedVertices.empty() || indices.empty() || primitives.empty()) {
+            _engine->logger().warn("unable to decode cached geometry of model: {}", path.string());
+            cachedGeometry.reset();
+            cachedVertices.clear();
+            indices.clear();
+            primitives.clear();
+            meshes.clear();
+            meshlets.clear();
+            nodes.clear();
+        }
+    }
+    u32 cachedMeshIndex = 0;
+
     Model result;
 
     struct NodeInfo {
@@ -570,12 +1628,17 @@ cala::AssetManager::Asset<cala::Model> cala::AssetManager::loadModel(const std::
         u32 meshIndex = assetNode.meshIndex.value();
         auto& assetMesh = asset->meshes[meshIndex];
         for (auto& primitive : assetMesh.primitives) {
+            // cached meshes are stored in the order they are visited
+            if (cachedGeometry) {
+                modelNode.primitives.push_back(cachedMeshIndex++);
+                continue;
+            }
 
             ende::math::Vec3f min = { 10000, 10000, 10000 };
             ende::math::Vec3f max = min * -1;
 
             u32 firstIndex = indices.size();
-            u32 firstVertex = vertices.size();
+            u32 firstVertex = compact ? compactVertices.size() : vertices.size();
             u32 firstMeshlet = meshlets.size();
             u32 firstPrimitive = primitives.size();
 
@@ -621,81 +1684,6 @@ cala::AssetManager::Asset<cala::Model> cala::AssetManager::loadModel(const std::
                 });
             }
 
-            struct MeshletLOD {
-                std::vector<u32> indices;
-                std::vector<Meshlet> meshlets;
-                std::vector<u32> meshletIndices;
-                std::vector<u8> primitives;
-            };
-
-            const auto generateMeshletLOD = [](const std::vector<Vertex>& vertices, const std::vector<u32>& indices, u32 vertexOffset, u32 indexOffset, u32 primitiveOffset, f32 threshold, f32 error) -> std::optional<MeshletLOD> {
-                const u32 maxVertices = 64;
-                const u32 maxTriangles = 64;
-                const f32 coneWeight = 0.f;
-
-                std::vector<u32> lodIndices = indices;
-                if (threshold < 1.f) {
-                    if (indices.size() < 1024)
-                        return {};
-                    lodIndices.clear();
-                    lodIndices.resize(indices.size());
-                    const u32 targetIndexCount = indices.size() * threshold;
-                    f32 lodError = 0.f;
-                    u32 lodIndexCount = meshopt_simplify(&lodIndices[0], indices.data(), indices.size(), (f32*)vertices.data(), vertices.size(), sizeof(Vertex), targetIndexCount, error, 0, &lodError);
-//                    u32 lodIndexCount = meshopt_simplifySloppy(&lodIndices[0], indices.data(), indices.size(), (f32*)vertices.data(), vertices.size(), sizeof(Vertex), targetIndexCount, error, &lodError);
-                    if (indices.size() == lodIndexCount)
-                        return {};
-                    lodIndices.resize(lodIndexCount);
-                    meshopt_optimizeVertexCache(lodIndices.data(), lodIndices.data(), lodIndices.size(), vertices.size());
-                }
-
-                u32 maxMeshlets = meshopt_buildMeshletsBound(lodIndices.size(), maxVertices, maxTriangles);
-                std::vector<meshopt_Meshlet> meshMeshlets(maxMeshlets);
-                std::vector<u32> meshletVertices(maxMeshlets * maxVertices);
-                std::vector<u8> meshletTriangles(maxMeshlets * maxTriangles * 3);
-
-                u32 meshletCount = meshopt_buildMeshlets(meshMeshlets.data(), meshletVertices.data(), meshletTriangles.data(), lodIndices.data(), lodIndices.size(), (f32*)vertices.data(), vertices.size(), sizeof(Vertex), maxVertices, maxTriangles, coneWeight);
-
-                auto& lastMeshlet = meshMeshlets[meshletCount - 1];
-                meshletVertices.resize(lastMeshlet.vertex_offset + lastMeshlet.vertex_count);
-                meshletTriangles.resize(lastMeshlet.triangle_offset + ((lastMeshlet.triangle_count * 3 + 3) & ~3));
-                meshMeshlets.resize(meshletCount);
-
-                std::vector<Meshlet> meshletsMesh;
-                meshletsMesh.reserve(meshletCount);
-
-                for (u32 i = 0; i < meshMeshlets.size(); i++) {
-                    auto& meshlet = meshMeshlets[i];
-                    meshopt_Bounds bounds = meshopt_computeMeshletBounds(&meshletVertices[meshlet.vertex_offset], &meshletTriangles[meshlet.triangle_offset], meshlet.triangle_count, (f32*)vertices.data(), vertices.size(), sizeof(Vertex));
-
-                    ende::math::Vec3f center{ bounds.center[0], bounds.center[1], bounds.center[2] };
-                    f32 radius = bounds.radius;
-                    ende::math::Vec3f coneApex{ bounds.cone_apex[0], bounds.cone_apex[1], bounds.cone_apex[2] };
-                    ende::math::Vec3f coneAxis{ bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2] };
-                    f32 coneCutoff = bounds.cone_cutoff;
-
-                    meshletsMesh.push_back({
-                        vertexOffset,
-                        meshlet.vertex_offset + indexOffset,
-                        meshlet.vertex_count,
-                        meshlet.triangle_offset + primitiveOffset,
-                        meshlet.triangle_count,
-                        center,
-                        radius,
-                        coneApex,
-                        coneAxis,
-                        coneCutoff
-                    });
-                }
-
-                return MeshletLOD{
-                    lodIndices,
-                    meshletsMesh,
-                    meshletVertices,
-                    meshletTriangles
-                };
-            };
-
             std::vector<unsigned int> remap(indexCount);
             size_t vertexCount = meshopt_generateVertexRemap(&remap[0], &meshIndices[0], indexCount, &meshVertices[0], meshVertices.size(), sizeof(Vertex));
 
@@ -709,37 +1697,15 @@ cala::AssetManager::Asset<cala::Model> cala::AssetManager::loadModel(const std::
             meshopt_optimizeOverdraw(&optimisedIndices[0], &optimisedIndices[0], indexCount, (f32*)&optimisedVertices[0], vertexCount, sizeof(Vertex), 1.05f);
             meshopt_optimizeVertexFetch(&optimisedVertices[0], &optimisedIndices[0], indexCount, &optimisedVertices[0], vertexCount, sizeof(Vertex));
 
-            auto lod0 = generateMeshletLOD(optimisedVertices, optimisedIndices, firstVertex, firstIndex, firstPrimitive, 1, 1e-2f).value();
-
-            meshlets.insert(meshlets.end(), lod0.meshlets.begin(), lod0.meshlets.end());
-            indices.insert(indices.end(), lod0.meshletIndices.begin(), lod0.meshletIndices.end());
-            primitives.insert(primitives.end(), lod0.primitives.begin(), lod0.primitives.end());
-
-            std::vector<MeshletLOD> lods;
-            lods.push_back(lod0);
-            u32 vertexOffset = firstVertex;
-            u32 indexOffset = firstIndex + lod0.meshletIndices.size();
-            u32 primitiveOffset = firstPrimitive + lod0.primitives.size();
-
-            u32 lodCount = 1;
-            for (u32 level = 1 ; level < MAX_LODS; level++) {
-                auto& previousLod = lods.back();
-                auto lodOptional = generateMeshletLOD(optimisedVertices, previousLod.indices, vertexOffset, indexOffset, primitiveOffset, 0.2, 1e-2f);
-                if (!lodOptional)
-                    break;
-
-                auto lod = lodOptional.value();
-
-                indexOffset += lod.meshletIndices.size();
-                primitiveOffset += lod.primitives.size();
+            auto hierarchy = buildMeshletHierarchy(optimisedVertices, optimisedIndices, firstVertex, firstIndex, firstPrimitive);
 
-                meshlets.insert(meshlets.end(), lod.meshlets.begin(), lod.meshlets.end());
-                indices.insert(indices.end(), lod.meshletIndices.begin(), lod.meshletIndices.end());
-                primitives.insert(primitives.end(), lod.primitives.begin(), lod.primitives.end());
-
-                lods.push_back(lod);
-                lodCount++;
-            }
+            u32 firstNode = nodes.size();
+            for (auto& node : hierarchy.nodes)
+                node.meshletOffset += firstMeshlet;
+            meshlets.insert(meshlets.end(), hierarchy.meshlets.begin(), hierarchy.meshlets.end());
+            nodes.insert(nodes.end(), hierarchy.nodes.begin(), hierarchy.nodes.end());
+            indices.insert(indices.end(), hierarchy.indices.begin(), hierarchy.indices.end());
+            primitives.insert(primitives.end(), hierarchy.primitives.begin(), hierarchy.primitives.end());
 
 //            std::for_each(std::execution::par, optimisedIndices.begin(), optimisedIndices.end(), [firstVertex](auto& index) {
 //                index += firstVertex;
@@ -747,24 +1713,27 @@ cala::AssetManager::Asset<cala::Model> cala::AssetManager::loadModel(const std::
             for (auto& index : optimisedIndices)
                 index += firstVertex;
 
-            vertices.insert(vertices.end(), optimisedVertices.begin(), optimisedVertices.end());
+            if (compact) {
+                for (auto& vertex : optimisedVertices)
+                    compactVertices.push_back(compactVertex(vertex, min, max));
+            } else
+                vertices.insert(vertices.end(), optimisedVertices.begin(), optimisedVertices.end());
 
             Model::Primitive mesh{};
             mesh.firstIndex = firstIndex;
             mesh.indexCount = indexCount;
             mesh.meshletIndex = firstMeshlet;
-            mesh.meshletCount = lod0.meshlets.size();
+            mesh.meshletCount = hierarchy.meshlets.size();
             mesh.materialIndex = primitive.materialIndex.has_value() ? primitive.materialIndex.value() : 0;
             mesh.aabb.min = min;
             mesh.aabb.max = max;
-            mesh.lodCount = lodCount;
-            u32 meshletOffset = firstMeshlet;
-            for (u32 level = 0; level < lodCount && level < MAX_LODS; level++) {
-                auto& lod = lods[level];
-                mesh.lods[level].meshletOffset = meshletOffset;
-                mesh.lods[level].meshletCount = lod.meshlets.size();
-                meshletOffset += lod.meshlets.size();
-            }
+            // every level of the hierarchy is a single lod, the cut through it is chosen per meshlet
+            mesh.lodCount = 1;
+            mesh.lods[0].meshletOffset = firstMeshlet;
+            mesh.lods[0].meshletCount = hierarchy.meshlets.size();
+            mesh.nodeOffset = firstNode;
+            mesh.rootCount = hierarchy.rootCount;
+            mesh.compactVertices = compact;
             modelNode.primitives.push_back(meshes.size());
             meshes.push_back(mesh);
         }
@@ -783,6 +1752,16 @@ cala::AssetManager::Asset<cala::Model> cala::AssetManager::loadModel(const std::
     };
 
     std::span<f32> vs(reinterpret_cast<f32*>(vertices.data()), vertices.size() * sizeof(Vertex) / sizeof(f32));
+    if (compact) {
+        // pad to a whole number of full vertices so offsets of later uploads stay addressable as Vertex
+        if (compactVertices.size() % 2 != 0)
+            compactVertices.push_back({});
+        vs = { reinterpret_cast<f32*>(compactVertices.data()), compactVertices.size() * sizeof(CompactVertex) / sizeof(f32) };
+    }
+    if (cachedGeometry)
+        vs = { reinterpret_cast<f32*>(cachedVertices.data()), cachedVertices.size() / sizeof(f32) };
+    else if (_geometryCache && !meshes.empty())
+        writeGeometryCache(filePath, hash, vertexSize, meshes, meshlets, nodes, { reinterpret_cast<const u8*>(vs.data()), vs.size() * sizeof(f32) }, indices, primitives);
     u32 vertexOffset = _engine->uploadVertexData(vs);
     u32 indexOffset = _engine->uploadIndexData(indices);
     u32 primitiveOffset = _engine->uploadPrimitiveData(primitives);
@@ -792,7 +1771,7 @@ cala::AssetManager::Asset<cala::Model> cala::AssetManager::loadModel(const std::
 //        meshlet.primitiveOffset += primitiveOffset / sizeof(u8);
 //    });
     for (auto& meshlet : meshlets) {
-        meshlet.vertexOffset += vertexOffset / sizeof(Vertex);
+        meshlet.vertexOffset += vertexOffset / vertexSize;
         meshlet.indexOffset += indexOffset / sizeof(u32);
         meshlet.primitiveOffset += primitiveOffset / sizeof(u8);
     }
@@ -802,18 +1781,28 @@ cala::AssetManager::Asset<cala::Model> cala::AssetManager::loadModel(const std::
 //        for (u32 level = 0; level < mesh.lodCount && level < MAX_LODS; level++)
 //            mesh.lods[level].meshletOffset += meshletOffset / sizeof(Meshlet);
 //    });
+    // child offsets are relative to the mesh's first node so only the meshlets need rebasing
+    for (auto& node : nodes)
+        node.meshletOffset += meshletOffset / sizeof(Meshlet);
+    u32 nodeOffset = _engine->uploadMeshletNodeData(nodes);
     for (auto& mesh : meshes) {
         mesh.meshletIndex += meshletOffset / sizeof(Meshlet);
         for (u32 level = 0; level < mesh.lodCount && level < MAX_LODS; level++)
             mesh.lods[level].meshletOffset += meshletOffset / sizeof(Meshlet);
+        mesh.nodeOffset += nodeOffset / sizeof(MeshletNode);
     }
 
 //    Model model;
     result.primitives = std::move(meshes);
-    result.images = images;
+    for (auto& load : imageLoads) {
+        if (load.handle)
+            result.images.push_back(load.handle);
+    }
     result.materials = std::move(materials);
     result._binding = binding;
     result._attributes = attributes;
+    result.vertexFormat = vertexFormat;
+    result.vertexDataSize = vs.size() * sizeof(f32);
 
     modelMetadata.hash = hash;
     modelMetadata.name = name;
@@ -839,6 +1828,8 @@ bool cala::AssetManager::isLoaded(const std::filesystem::path &path) {
 }
 
 void cala::AssetManager::clear() {
+    _retiredViews.clear();
+    _imageStreams.clear();
     _shaderModules.clear();
     _images.clear();
     _models.clear();
@@ -68,10 +68,10 @@ void cala::Camera::updateFrustum() {
     _frustum.update(viewProjection());
 }
 
-std::vector<ende::math::Vec4f> cala::Camera::getFrustumCorners() const {
+std::array<ende::math::Vec4f, 8> cala::Camera::getFrustumCorners() const {
     const auto inverseViewProjection = viewProjection().inverse();
 
-    std::vector<ende::math::Vec4f> corners;
+    std::array<ende::math::Vec4f, 8> corners;
     for (unsigned int x = 0; x < 2; ++x)
     {
         for (unsigned int y = 0; y < 2; ++y)
@@ -83,7 +83,7 @@ std::vector<ende::math::Vec4f> cala::Camera::getFrustumCorners() const {
                         2.0f * y - 1.0f,
                         2.0f * z - 1.0f,
                         1.0f});
-                corners.push_back(pt / pt.w());
+                corners[x * 4 + y * 2 + z] = pt / pt.w();
             }
         }
     }
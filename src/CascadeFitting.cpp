@@ -0,0 +1,78 @@
+#include <Cala/CascadeFitting.h>
+#include <algorithm>
+#include <cmath>
+
+static f32 lengthSquared(const ende::math::Vec3f& vec) {
+    return vec.x() * vec.x() + vec.y() * vec.y() + vec.z() * vec.z();
+}
+
+cala::CascadeSphere cala::cascadeSphere(const Camera& camera, f32 near, f32 far) {
+    Camera slice(camera.fov(), camera.width(), camera.height(), near, far, &camera.transform());
+    auto corners = slice.getFrustumCorners();
+
+    // corners alternate between the near and far plane
+    ende::math::Vec3f nearCenter = { 0, 0, 0 };
+    ende::math::Vec3f farCenter = { 0, 0, 0 };
+    for (u32 i = 0; i < 8; i += 2) {
+        nearCenter = nearCenter + corners[i].xyz();
+        farCenter = farCenter + corners[i + 1].xyz();
+    }
+    nearCenter = nearCenter / 4.f;
+    farCenter = farCenter / 4.f;
+
+    f32 depth = std::sqrt(lengthSquared(farCenter - nearCenter));
+    f32 nearRadius = lengthSquared(corners[0].xyz() - nearCenter);
+    f32 farRadius = lengthSquared(corners[1].xyz() - farCenter);
+
+    // point along the view axis equidistant to the near and far corners, clamped to the slice for wide frustums
+    f32 offset = std::clamp((depth * depth + farRadius - nearRadius) / (2 * depth), 0.f, depth);
+    f32 radius = std::sqrt(std::max(offset * offset + nearRadius, (depth - offset) * (depth - offset) + farRadius));
+    // round up so precision lost as the camera rotates doesn't resize the cascade
+    radius = std::ceil(radius * 16.f) / 16.f;
+
+    return {
+        nearCenter + (farCenter - nearCenter) * (offset / depth),
+        radius
+    };
+}
+
+GPUCamera cala::fitCascade(const CascadeSphere& sphere, const ende::math::Quaternion& direction, u32 resolution,
+                           const ende::math::Vec3f& casterMin, const ende::math::Vec3f& casterMax) {
+    Transform lightTransform({ 0, 0, 0 }, direction);
+    Camera lightCamera(ende::math::identity<4, f32>(), &lightTransform);
+    auto lightView = lightCamera.view();
+
+    // snap to texel increments in light space
+    f32 texelSize = sphere.radius * 2 / static_cast<f32>(std::max(resolution, 1u));
+    auto center = lightView.transform(ende::math::Vec4f{ sphere.center.x(), sphere.center.y(), sphere.center.z(), 1.f });
+    f32 x = std::floor(center.x() / texelSize) * texelSize;
+    f32 y = std::floor(center.y() / texelSize) * texelSize;
+
+    // extend depth towards the casters instead of scaling the range so the depth precision isn't wasted
+    f32 minZ = center.z() - sphere.radius;
+    f32 maxZ = center.z() + sphere.radius;
+    if (casterMin.x() <= casterMax.x()) {
+        for (u32 i = 0; i < 8; i++) {
+            auto corner = lightView.transform(ende::math::Vec4f{
+                i & 1 ? casterMax.x() : casterMin.x(),
+                i & 2 ? casterMax.y() : casterMin.y(),
+                i & 4 ? casterMax.z() : casterMin.z(),
+                1.f
+            });
+            minZ = std::min(minZ, corner.z());
+            maxZ = std::max(maxZ, corner.z());
+        }
+    }
+    minZ = std::floor(minZ / texelSize) * texelSize;
+    maxZ = std::ceil(maxZ / texelSize) * texelSize;
+
+    auto position = lightView.inverse().transform(ende::math::Vec4f{ x, y, 0.f, 1.f });
+    Transform cascadeTransform(position.xyz(), direction);
+    Camera cascadeCamera(ende::math::orthographic<f32>(-sphere.radius, sphere.radius, -sphere.radius, sphere.radius, minZ, maxZ), &cascadeTransform);
+
+    auto data = cascadeCamera.data();
+    data.near = minZ;
+    data.far = maxZ;
+    data.exposure = 1.f;
+    return data;
+}
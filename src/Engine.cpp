@@ -10,19 +10,135 @@
 #include <spdlog/sinks/basic_file_sink.h>
 #include <stb_image_write.h>
 #include <PoissonGenerator.h>
+#include <Cala/MappedFile.h>
+#include <fstream>
+#include <cstring>
+
+// sizes of the maps generated from sky light maps
+constexpr u32 skyCubeMapSize = 512;
+constexpr u32 skyIrradianceSize = 64;
+constexpr u32 skyPrefilterSize = 512;
+constexpr u32 skyMipLevels = 10;
+
+constexpr u32 brdfSize = 512;
+
+// header of cached sky light maps, followed by the cube map, irradiance and prefiltered maps
+struct SkyLightCacheHeader {
+    u32 magic = 0x314c4249; // "IBL1"
+    u32 version = 2; // increment when the filtering shaders or this header change to invalidate existing caches
+    u32 cubeMapSize = skyCubeMapSize;
+    u32 irradianceSize = skyIrradianceSize;
+    u32 prefilterSize = skyPrefilterSize;
+    u32 mips = skyMipLevels;
+    u64 sourceHash = 0; // fnv-1a of the source file so caches are portable between toolchains
+    u64 sourceSize = 0;
+};
 
-cala::vk::RenderPass::Attachment shadowPassAttachment {
-        cala::vk::Format::D32_SFLOAT,
-        VK_SAMPLE_COUNT_1_BIT,
-        cala::vk::LoadOp::CLEAR,
-        cala::vk::StoreOp::STORE,
-        cala::vk::LoadOp::CLEAR,
-        cala::vk::StoreOp::DONT_CARE,
-        cala::vk::ImageLayout::UNDEFINED,
-        cala::vk::ImageLayout::DEPTH_STENCIL_ATTACHMENT,
-        cala::vk::ImageLayout::DEPTH_STENCIL_ATTACHMENT
+// header of the cached brdf lut, followed by the lut
+struct BrdfCacheHeader {
+    u32 magic = 0x31465242; // "BRF1"
+    u32 version = 1; // increment when brdf.comp changes to invalidate existing caches
+    u32 size = brdfSize;
+    u32 format = static_cast<u32>(cala::vk::Format::RG16_SFLOAT);
 };
 
+// 64 bit fnv-1a, used over std::hash for cache keys as its result is the same for every standard library
+static u64 fnv1a(std::span<const u8> bytes) {
+    u64 hash = 0xcbf29ce484222325;
+    for (u8 byte : bytes) {
+        hash ^= byte;
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+static cala::vk::ImageHandle createSkyImage(cala::vk::Device& device, u32 size, u32 mips, const std::string& name) {
+    return device.createImage({
+        .width = size,
+        .height = size,
+        .depth = 1,
+        .format = cala::vk::Format::RGBA32_SFLOAT,
+        .mipLevels = mips,
+        .arrayLayers = 6,
+        .usage = cala::vk::ImageUsage::STORAGE | cala::vk::ImageUsage::SAMPLED | cala::vk::ImageUsage::TRANSFER_SRC | cala::vk::ImageUsage::TRANSFER_DST,
+        .name = name
+    });
+}
+
+// cached images hold each mip level in order with the layers of a level packed together
+static u64 mipBytes(cala::vk::ImageHandle image, u32 mip) {
+    u64 width = std::max(image->width() >> mip, 1u);
+    u64 height = std::max(image->height() >> mip, 1u);
+    return width * height * cala::vk::formatToSize(image->format());
+}
+
+static u64 imageBytes(cala::vk::ImageHandle image) {
+    u64 size = 0;
+    for (u32 mip = 0; mip < image->mips(); mip++)
+        size += mipBytes(image, mip) * image->layers();
+    return size;
+}
+
+static std::vector<u8> readbackImage(cala::vk::Device& device, cala::vk::ImageHandle image) {
+    auto buffer = device.createBuffer({
+        .size = static_cast<u32>(imageBytes(image)),
+        .usage = cala::vk::BufferUsage::TRANSFER_DST,
+        .memoryType = cala::vk::MemoryProperties::READBACK,
+        .persistentlyMapped = true
+    });
+    device.immediate([&](cala::vk::CommandHandle cmd) {
+        auto barrier = image->barrier(cala::vk::PipelineStage::COMPUTE_SHADER, cala::vk::PipelineStage::TRANSFER, cala::vk::Access::SHADER_WRITE, cala::vk::Access::TRANSFER_READ, cala::vk::ImageLayout::TRANSFER_SRC);
+        cmd->pipelineBarrier({ &barrier, 1 });
+
+        u64 offset = 0;
+        for (u32 mip = 0; mip < image->mips(); mip++) {
+            VkBufferImageCopy region{};
+            region.bufferOffset = offset;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = mip;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = image->layers();
+            region.imageExtent = { std::max(image->width() >> mip, 1u), std::max(image->height() >> mip, 1u), 1 };
+            vkCmdCopyImageToBuffer(cmd->buffer(), image->image(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer->buffer(), 1, &region);
+            offset += mipBytes(image, mip) * image->layers();
+        }
+
+        barrier = image->barrier(cala::vk::PipelineStage::TRANSFER, cala::vk::PipelineStage::FRAGMENT_SHADER | cala::vk::PipelineStage::COMPUTE_SHADER, cala::vk::Access::TRANSFER_READ, cala::vk::Access::SHADER_READ, cala::vk::ImageLayout::SHADER_READ_ONLY);
+        cmd->pipelineBarrier({ &barrier, 1 });
+    });
+    auto data = static_cast<const u8*>(buffer->persistentMapping());
+    return { data, data + imageBytes(image) };
+}
+
+static void stageImage(cala::Engine& engine, cala::vk::ImageHandle image, std::span<const u8> data) {
+    u64 offset = 0;
+    for (u32 mip = 0; mip < image->mips(); mip++) {
+        for (u32 layer = 0; layer < image->layers(); layer++) {
+            u64 size = mipBytes(image, mip);
+            engine.stageData(image, data.subspan(offset, size), {
+                .mipLevel = mip,
+                .width = std::max(image->width() >> mip, 1u),
+                .height = std::max(image->height() >> mip, 1u),
+                .depth = 1,
+                .format = cala::vk::formatToSize(image->format()),
+                .layer = layer
+            });
+            offset += size;
+        }
+    }
+}
+
+static bool writeImageCache(const std::filesystem::path& path, std::span<const u8> header, std::span<const std::vector<u8>> images) {
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    std::ofstream cache(path, std::ios::binary | std::ios::trunc);
+    if (!cache)
+        return false;
+    cache.write(reinterpret_cast<const char*>(header.data()), header.size());
+    for (auto& image : images)
+        cache.write(reinterpret_cast<const char*>(image.data()), image.size());
+    return static_cast<bool>(cache);
+}
 
 cala::Engine::Engine(vk::Platform &platform)
     : _logger("Cala", {
@@ -36,7 +152,6 @@ cala::Engine::Engine(vk::Platform &platform)
       }).value()),
       _assetManager(this),
       _startTime(std::chrono::system_clock::now()),
-      _shadowPass(*_device, {&shadowPassAttachment, 1 }),
       _lodSampler(_device->getSampler({
           .maxLod = 10
       })),
@@ -48,6 +163,7 @@ cala::Engine::Engine(vk::Platform &platform)
       _vertexOffset(0),
       _indexOffset(0),
       _meshletOffset(0),
+      _meshletNodeOffset(0),
       _primitiveOffset(0),
       _stagingSize(1 << 24), // 16mb
       _stagingOffset(0),
@@ -58,13 +174,13 @@ cala::Engine::Engine(vk::Platform &platform)
           .persistentlyMapped = true,
           .name = "StagingBuffer"
       })),
-      _shadowMapSize(0)
+      _shadowAtlas(0, 1024)
 {
     spdlog::flush_every(std::chrono::seconds(5));
     _device->setBindlessSetIndex(0);
     _assetManager.setAssetPath("../../res");
     _pointShadowProgram = loadProgram("pointShadowProgram", {
-        { "shaders/shadow/point_shadow.task", vk::ShaderStage::TASK },
+        { "shaders/shadow/shadow.task", vk::ShaderStage::TASK },
         { "shaders/shadow/point_shadow.mesh", vk::ShaderStage::MESH },
         { "shaders/shadow_point.frag", vk::ShaderStage::FRAGMENT }
     });
@@ -113,8 +229,8 @@ cala::Engine::Engine(vk::Platform &platform)
         { "shaders/shadow/cull_direct_shadow.comp", vk::ShaderStage::COMPUTE }
     });
     {
-        _createClustersProgram = loadProgram("createClustersProgram", {
-            { "shaders/create_clusters.comp", vk::ShaderStage::COMPUTE }
+        _binLightsProgram = loadProgram("binLightsProgram", {
+            { "shaders/bin_lights.comp", vk::ShaderStage::COMPUTE }
         });
     }
     {
@@ -135,7 +251,16 @@ cala::Engine::Engine(vk::Platform &platform)
         { "shaders/visibility_buffer/material_offset.comp", vk::ShaderStage::COMPUTE}
     });
     _visibilityPositionsProgram = loadProgram("visibilityPositionProgram", {
-            { "shaders/visibility_buffer/pixel_positions.comp", vk::ShaderStage::COMPUTE}
+            { "shaders/visibility_buffer/material_tiles.comp", vk::ShaderStage::COMPUTE}
+    });
+    _shadingRateProgram = loadProgram("shadingRateProgram", {
+            { "shaders/visibility_buffer/shading_rate.comp", vk::ShaderStage::COMPUTE}
+    });
+    _depthPyramidProgram = loadProgram("depthPyramidProgram", {
+        { "shaders/depth_pyramid.comp", vk::ShaderStage::COMPUTE }
+    });
+    _probeUpdateProgram = loadProgram("probeUpdateProgram", {
+        { "shaders/probe_update.comp", vk::ShaderStage::COMPUTE }
     });
 
     _meshletDebugProgram = loadProgram("debugMeshletProgram", {
@@ -190,6 +315,21 @@ cala::Engine::Engine(vk::Platform &platform)
     _bloomCompositeProgram = loadProgram("bloomCompositeProgram", {
         { "shaders/bloom_composite.comp", vk::ShaderStage::COMPUTE }
     });
+    _bloomDownsampleSpdProgram = loadProgram("bloomDownsampleSpdProgram", {
+        { "shaders/bloom_downsample_spd.comp", vk::ShaderStage::COMPUTE }
+    });
+    _bloomUpsampleChainProgram = loadProgram("bloomUpsampleChainProgram", {
+        { "shaders/bloom_upsample_chain.comp", vk::ShaderStage::COMPUTE }
+    });
+    _upscaleProgram = loadProgram("upscaleProgram", {
+        { "shaders/upscale.comp", vk::ShaderStage::COMPUTE }
+    });
+    _motionVectorsProgram = loadProgram("motionVectorsProgram", {
+        { "shaders/motion_vectors.comp", vk::ShaderStage::COMPUTE }
+    });
+    _taaProgram = loadProgram("taaProgram", {
+        { "shaders/taa.comp", vk::ShaderStage::COMPUTE }
+    });
     {
 //        _voxelVisualisationProgram = loadProgram({
 ////            { "shaders/fullscreen.vert", vk::ShaderModule::VERTEX },
@@ -219,30 +359,47 @@ cala::Engine::Engine(vk::Platform &platform)
     });
 
     _brdfImage = _device->createImage({
-        .width = 512,
-        .height = 512,
+        .width = brdfSize,
+        .height = brdfSize,
         .depth = 1,
         .format = vk::Format::RG16_SFLOAT,
         .mipLevels = 1,
         .arrayLayers = 1,
-        .usage = vk::ImageUsage::SAMPLED | vk::ImageUsage::STORAGE,
+        .usage = vk::ImageUsage::SAMPLED | vk::ImageUsage::STORAGE | vk::ImageUsage::TRANSFER_SRC | vk::ImageUsage::TRANSFER_DST,
         .name = "brdf"
     });
 
-    _device->immediate([&](vk::CommandHandle cmd) {
-        auto brdfBarrier = _brdfImage->barrier(vk::PipelineStage::TOP, vk::PipelineStage::COMPUTE_SHADER, vk::Access::NONE, vk::Access::SHADER_WRITE | vk::Access::SHADER_READ, vk::ImageLayout::GENERAL);
-        cmd->pipelineBarrier({ &brdfBarrier, 1 });
+    // the brdf lut doesn't depend on any content so is generated once and cached
+    auto brdfCacheFile = _assetManager.getCachePath() / "brdf.lut";
+    BrdfCacheHeader brdfHeader{};
+    bool brdfCached = false;
+    if (auto file = MappedFile::open(brdfCacheFile); file && file->size() == sizeof(brdfHeader) + imageBytes(_brdfImage)) {
+        brdfCached = std::memcmp(file->data().data(), &brdfHeader, sizeof(brdfHeader)) == 0;
+        if (brdfCached) {
+            stageImage(*this, _brdfImage, file->data().subspan(sizeof(brdfHeader)));
+            flushStagedData();
+        }
+    }
 
-        cmd->bindProgram(_brdfProgram);
-        cmd->bindImage(1, 0, _brdfImage->defaultView());
-        cmd->bindPipeline();
-        cmd->bindDescriptors();
-        cmd->dispatch(512, 512, 1);
+    if (!brdfCached) {
+        _device->immediate([&](vk::CommandHandle cmd) {
+            auto brdfBarrier = _brdfImage->barrier(vk::PipelineStage::TOP, vk::PipelineStage::COMPUTE_SHADER, vk::Access::NONE, vk::Access::SHADER_WRITE | vk::Access::SHADER_READ, vk::ImageLayout::GENERAL);
+            cmd->pipelineBarrier({ &brdfBarrier, 1 });
 
-        brdfBarrier = _brdfImage->barrier(vk::PipelineStage::COMPUTE_SHADER, vk::PipelineStage::FRAGMENT_SHADER, vk::Access::SHADER_READ | vk::Access::SHADER_WRITE, vk::Access::SHADER_READ, vk::ImageLayout::SHADER_READ_ONLY);
-        cmd->pipelineBarrier({ &brdfBarrier, 1 });
+            cmd->bindProgram(_brdfProgram);
+            cmd->bindImage(1, 0, _brdfImage->defaultView());
+            cmd->bindPipeline();
+            cmd->bindDescriptors();
+            cmd->dispatch(brdfSize, brdfSize, 1);
 
-    });
+            brdfBarrier = _brdfImage->barrier(vk::PipelineStage::COMPUTE_SHADER, vk::PipelineStage::FRAGMENT_SHADER, vk::Access::SHADER_READ | vk::Access::SHADER_WRITE, vk::Access::SHADER_READ, vk::ImageLayout::SHADER_READ_ONLY);
+            cmd->pipelineBarrier({ &brdfBarrier, 1 });
+
+        });
+        std::vector<u8> images[] = { readbackImage(*_device, _brdfImage) };
+        if (!writeImageCache(brdfCacheFile, { reinterpret_cast<const u8*>(&brdfHeader), sizeof(brdfHeader) }, images))
+            _logger.warn("unable to write brdf cache: {}", brdfCacheFile.string());
+    }
 
     _globalVertexBuffer = _device->createBuffer({
         .size = 1000000,
@@ -264,6 +421,13 @@ cala::Engine::Engine(vk::Platform &platform)
         .name = "globalMeshletBuffer"
     });
 
+    _globalMeshletNodeBuffer = _device->createBuffer({
+        .size = 1000000,
+        .usage = vk::BufferUsage::STORAGE | vk::BufferUsage::TRANSFER_DST,
+        .memoryType = vk::MemoryProperties::DEVICE,
+        .name = "globalMeshletNodeBuffer"
+    });
+
     _globalPrimitiveBuffer = _device->createBuffer({
         .size = 1000000,
         .usage = vk::BufferUsage::STORAGE | vk::BufferUsage::TRANSFER_DST,
@@ -275,7 +439,7 @@ cala::Engine::Engine(vk::Platform &platform)
 
     _materials.reserve(10);
 
-    setShadowMapSize(1024);
+    setShadowAtlasSize(4096);
 
 }
 
@@ -292,7 +456,7 @@ cala::Engine::~Engine() {
     _tonemapProgram = {};
     _pointShadowCullProgram = {};
     _directShadowCullProgram = {};
-    _createClustersProgram = {};
+    _binLightsProgram = {};
     _cullLightsProgram = {};
 
     _clusterDebugProgram = {};
@@ -312,30 +476,23 @@ cala::Engine::~Engine() {
     _brdfImage = {};
 
     _stagingBuffer = {};
-    _shadowMaps.clear();
+    _shadowAtlasImage = {};
+    _shadowCacheImage = {};
     delete _cube;
 }
 
 bool cala::Engine::gc() {
     PROFILE_NAMED("Engine::gc");
+    _assetManager.streamImages();
     flushStagedData();
 
     return _device->gc();
 }
 
 cala::vk::ImageHandle cala::Engine::convertToCubeMap(vk::ImageHandle equirectangular) {
-    auto cubeMap = _device->createImage({
-        .width = 512,
-        .height = 512,
-        .depth = 1,
-        .format = vk::Format::RGBA32_SFLOAT,
-        .mipLevels = 10,
-        .arrayLayers = 6,
-        .usage = vk::ImageUsage::STORAGE | vk::ImageUsage::SAMPLED | vk::ImageUsage::TRANSFER_SRC | vk::ImageUsage::TRANSFER_DST,
-        .name = "cubeMap"
-    });
+    auto cubeMap = createSkyImage(*_device, skyCubeMapSize, skyMipLevels, "cubeMap");
     auto equirectangularView = equirectangular->newView();
-    auto cubeView = cubeMap->newView(0, 10);
+    auto cubeView = cubeMap->newView(0, skyMipLevels);
     _device->immediate([&](vk::CommandHandle cmd) {
         auto envBarrier = cubeMap->barrier(vk::PipelineStage::TOP, vk::PipelineStage::COMPUTE_SHADER, vk::Access::NONE, vk::Access::SHADER_WRITE, vk::ImageLayout::GENERAL);
         cmd->pipelineBarrier({ &envBarrier, 1 });
@@ -350,7 +507,7 @@ cala::vk::ImageHandle cala::Engine::convertToCubeMap(vk::ImageHandle equirectang
         cmd->bindPipeline();
         cmd->bindDescriptors();
 
-        cmd->dispatch(512, 512, 6);
+        cmd->dispatch(skyCubeMapSize, skyCubeMapSize, 6);
 
 
         envBarrier = cubeMap->barrier(vk::PipelineStage::COMPUTE_SHADER, vk::PipelineStage::BOTTOM, vk::Access::SHADER_WRITE, vk::Access::NONE, vk::ImageLayout::TRANSFER_DST);
@@ -363,16 +520,7 @@ cala::vk::ImageHandle cala::Engine::convertToCubeMap(vk::ImageHandle equirectang
 }
 
 cala::vk::ImageHandle cala::Engine::generateIrradianceMap(vk::ImageHandle cubeMap) {
-    auto irradianceMap = _device->createImage({
-        .width = 64,
-        .height = 64,
-        .depth = 1,
-        .format = vk::Format::RGBA32_SFLOAT,
-        .mipLevels = 1,
-        .arrayLayers = 6,
-        .usage = vk::ImageUsage::STORAGE | vk::ImageUsage::SAMPLED | vk::ImageUsage::TRANSFER_DST,
-        .name = "irradianceMap"
-    });
+    auto irradianceMap = createSkyImage(*_device, skyIrradianceSize, 1, "irradianceMap");
     _device->immediate([&](vk::CommandHandle cmd) {
         auto irradianceBarrier = irradianceMap->barrier(vk::PipelineStage::TOP, vk::PipelineStage::COMPUTE_SHADER, vk::Access::NONE, vk::Access::SHADER_WRITE, vk::ImageLayout::GENERAL);
         cmd->pipelineBarrier({ &irradianceBarrier, 1 });
@@ -395,16 +543,7 @@ cala::vk::ImageHandle cala::Engine::generateIrradianceMap(vk::ImageHandle cubeMa
 }
 
 cala::vk::ImageHandle cala::Engine::generatePrefilteredIrradiance(vk::ImageHandle cubeMap) {
-    vk::ImageHandle prefilteredMap = _device->createImage({
-        .width = 512,
-        .height = 512,
-        .depth = 1,
-        .format = vk::Format::RGBA32_SFLOAT,
-        .mipLevels = 10,
-        .arrayLayers = 6,
-        .usage = vk::ImageUsage::STORAGE | vk::ImageUsage::SAMPLED | vk::ImageUsage::TRANSFER_DST,
-        .name = "prefilterMap"
-    });
+    vk::ImageHandle prefilteredMap = createSkyImage(*_device, skyPrefilterSize, skyMipLevels, "prefilterMap");
     vk::Image::View mipViews[10] = {
             prefilteredMap->newView(0),
             prefilteredMap->newView(1),
@@ -431,7 +570,7 @@ cala::vk::ImageHandle cala::Engine::generatePrefilteredIrradiance(vk::ImageHandl
             cmd->pushConstants(vk::ShaderStage::COMPUTE, roughness);
             cmd->bindPipeline();
             cmd->bindDescriptors();
-            f32 computeDim = 512.f * std::pow(0.5, mip);
+            f32 computeDim = static_cast<f32>(skyPrefilterSize) * std::pow(0.5, mip);
             cmd->dispatch(computeDim, computeDim, 6);
         }
 
@@ -441,89 +580,92 @@ cala::vk::ImageHandle cala::Engine::generatePrefilteredIrradiance(vk::ImageHandl
     return prefilteredMap;
 }
 
+cala::Engine::SkyLightMaps cala::Engine::loadSkyLightMaps(vk::ImageHandle equirectangular) {
+    PROFILE_NAMED("Engine::loadSkyLightMaps");
+    // images not loaded through the asset manager have no source to key the cache with so are always generated
+    std::filesystem::path cacheFile;
+    SkyLightCacheHeader expected{};
+    if (auto path = _assetManager.getImagePath(equirectangular); path) {
+        if (auto source = MappedFile::open(_assetManager.getAssetPath() / *path); source) {
+            auto bytes = source->data();
+            expected.sourceHash = fnv1a(bytes);
+            expected.sourceSize = bytes.size();
+            cacheFile = _assetManager.getCachePath() / std::format("{:016x}.ibl", expected.sourceHash);
+        }
+    }
 
-cala::vk::ImageHandle cala::Engine::getShadowMap(u32 index, bool point, cala::vk::CommandHandle cmd) {
-    if (index < _shadowMaps.size() && _shadowMaps[index]) {
-        if (!point && _shadowMaps[index]->layers() != 6)
-            return _shadowMaps[index];
-        if (point && _shadowMaps[index]->layers() == 6)
-            return _shadowMaps[index];
+    SkyLightMaps maps;
+    if (!cacheFile.empty()) {
+        if (auto file = MappedFile::open(cacheFile); file && file->size() >= sizeof(expected) &&
+                std::memcmp(file->data().data(), &expected, sizeof(expected)) == 0) {
+            maps.cubeMap = createSkyImage(*_device, skyCubeMapSize, skyMipLevels, "cubeMap");
+            maps.irradiance = createSkyImage(*_device, skyIrradianceSize, 1, "irradianceMap");
+            maps.prefiltered = createSkyImage(*_device, skyPrefilterSize, skyMipLevels, "prefilterMap");
+            u64 cubeMapOffset = sizeof(expected);
+            u64 irradianceOffset = cubeMapOffset + imageBytes(maps.cubeMap);
+            u64 prefilterOffset = irradianceOffset + imageBytes(maps.irradiance);
+            if (file->size() == prefilterOffset + imageBytes(maps.prefiltered)) {
+                stageImage(*this, maps.cubeMap, file->data().subspan(cubeMapOffset, irradianceOffset - cubeMapOffset));
+                stageImage(*this, maps.irradiance, file->data().subspan(irradianceOffset, prefilterOffset - irradianceOffset));
+                stageImage(*this, maps.prefiltered, file->data().subspan(prefilterOffset));
+                flushStagedData();
+                return maps;
+            }
+        }
     }
 
-    auto map = _device->createImage({
-        .width = _shadowMapSize,
-        .height = _shadowMapSize,
-        .depth = 1,
-        .format = vk::Format::D32_SFLOAT,
-        .mipLevels = 1,
-        .arrayLayers = point ? (u32)6 : (u32)1,
-        .usage = vk::ImageUsage::SAMPLED | vk::ImageUsage::DEPTH_STENCIL_ATTACHMENT | vk::ImageUsage::TRANSFER_DST,
-        .name = "ShadowMap: " + std::to_string(index)
-    });
-    if (index < _shadowMaps.size())
-        _shadowMaps[index] = map;
-    else
-        _shadowMaps.push_back(map);
-    if (cmd) {
-        auto cubeBarrier = map->barrier(vk::PipelineStage::TOP, vk::PipelineStage::TRANSFER, vk::Access::NONE, vk::Access::TRANSFER_WRITE, vk::ImageLayout::SHADER_READ_ONLY);
-        cmd->pipelineBarrier({ &cubeBarrier, 1 });
-    } else {
-        _device->immediate([&](vk::CommandHandle cmd) {
-            auto cubeBarrier = map->barrier(vk::PipelineStage::TOP, vk::PipelineStage::TRANSFER, vk::Access::NONE, vk::Access::TRANSFER_WRITE, vk::ImageLayout::SHADER_READ_ONLY);
-            cmd->pipelineBarrier({ &cubeBarrier, 1 });
-        });
+    // the source may still be waiting in the staging buffer
+    flushStagedData();
+    maps.cubeMap = convertToCubeMap(equirectangular);
+    maps.irradiance = generateIrradianceMap(maps.cubeMap);
+    maps.prefiltered = generatePrefilteredIrradiance(maps.cubeMap);
+
+    if (!cacheFile.empty()) {
+        std::vector<u8> images[] = {
+            readbackImage(*_device, maps.cubeMap),
+            readbackImage(*_device, maps.irradiance),
+            readbackImage(*_device, maps.prefiltered)
+        };
+        if (!writeImageCache(cacheFile, { reinterpret_cast<const u8*>(&expected), sizeof(expected) }, images))
+            _logger.warn("unable to write sky light cache: {}", cacheFile.string());
     }
-    return map;
+    return maps;
 }
 
+
 void cala::Engine::setShadowMapSize(u32 size) {
-    if (_shadowMapSize == size)
+    _shadowAtlas.setMaxTileSize(size);
+}
+
+void cala::Engine::setShadowAtlasSize(u32 size) {
+    if (_shadowAtlasImage && _shadowAtlas.size() == size)
         return;
 
-    _shadowMapSize = size;
-    _shadowMaps.clear();
-    _shadowTarget = device().createImage({
-        _shadowMapSize, _shadowMapSize, 1,
-        vk::Format::D32_SFLOAT,
-        1, 1,
-        vk::ImageUsage::SAMPLED | vk::ImageUsage::DEPTH_STENCIL_ATTACHMENT | vk::ImageUsage::TRANSFER_SRC
+    _shadowAtlas.resize(size);
+    _shadowAtlasImage = device().createImage({
+        .width = _shadowAtlas.size(),
+        .height = _shadowAtlas.size(),
+        .depth = 1,
+        .format = vk::Format::D32_SFLOAT,
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .usage = vk::ImageUsage::SAMPLED | vk::ImageUsage::DEPTH_STENCIL_ATTACHMENT | vk::ImageUsage::TRANSFER_DST,
+        .name = "ShadowAtlas"
+    });
+    _shadowCacheImage = device().createImage({
+        .width = _shadowAtlas.size(),
+        .height = _shadowAtlas.size(),
+        .depth = 1,
+        .format = vk::Format::D32_SFLOAT,
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .usage = vk::ImageUsage::DEPTH_STENCIL_ATTACHMENT | vk::ImageUsage::TRANSFER_SRC | vk::ImageUsage::TRANSFER_DST,
+        .name = "ShadowCache"
     });
     device().immediate([&](vk::CommandHandle cmd) {
-        auto targetBarrier = _shadowTarget->barrier(vk::PipelineStage::TOP, vk::PipelineStage::EARLY_FRAGMENT, vk::Access::NONE, vk::Access::DEPTH_STENCIL_WRITE | vk::Access::DEPTH_STENCIL_READ, vk::ImageLayout::DEPTH_STENCIL_ATTACHMENT);
-        cmd->pipelineBarrier({ &targetBarrier, 1 });
+        auto atlasBarrier = _shadowAtlasImage->barrier(vk::PipelineStage::TOP, vk::PipelineStage::FRAGMENT_SHADER | vk::PipelineStage::COMPUTE_SHADER, vk::Access::NONE, vk::Access::SHADER_READ, vk::ImageLayout::SHADER_READ_ONLY);
+        cmd->pipelineBarrier({ &atlasBarrier, 1 });
     });
-    vk::RenderPass::Attachment shadowAttachment = {
-            cala::vk::Format::D32_SFLOAT,
-            VK_SAMPLE_COUNT_1_BIT,
-            vk::LoadOp::CLEAR,
-            vk::StoreOp::STORE,
-            vk::LoadOp::DONT_CARE,
-            vk::StoreOp::DONT_CARE,
-            vk::ImageLayout::UNDEFINED,
-            vk::ImageLayout::DEPTH_STENCIL_ATTACHMENT,
-            vk::ImageLayout::DEPTH_STENCIL_ATTACHMENT
-    };
-    auto shadowRenderPass = device().getRenderPass({&shadowAttachment, 1 });
-    u32 h = _shadowTarget.index() * _shadowMapSize;
-    _shadowFramebuffer = device().getFramebuffer(shadowRenderPass, { &_shadowTarget->defaultView().view, 1 }, { &h, 1 }, _shadowMapSize, _shadowMapSize);
-}
-
-cala::vk::Framebuffer *cala::Engine::getShadowFramebuffer() {
-    vk::RenderPass::Attachment shadowAttachment = {
-            cala::vk::Format::D32_SFLOAT,
-            VK_SAMPLE_COUNT_1_BIT,
-            vk::LoadOp::CLEAR,
-            vk::StoreOp::STORE,
-            vk::LoadOp::DONT_CARE,
-            vk::StoreOp::DONT_CARE,
-            vk::ImageLayout::UNDEFINED,
-            vk::ImageLayout::DEPTH_STENCIL_ATTACHMENT,
-            vk::ImageLayout::DEPTH_STENCIL_ATTACHMENT
-    };
-    auto shadowRenderPass = device().getRenderPass({&shadowAttachment, 1 });
-    u32 h = _shadowTarget.index() * _shadowMapSize;
-    _shadowFramebuffer = device().getFramebuffer(shadowRenderPass, { &_shadowTarget->defaultView().view, 1 }, { &h, 1 }, _shadowMapSize, _shadowMapSize);
-    return _shadowFramebuffer;
 }
 
 void cala::Engine::updateMaterialdata() {
@@ -568,6 +710,17 @@ u32 cala::Engine::uploadMeshletData(std::span<Meshlet> data) {
     return currentOffset;
 }
 
+u32 cala::Engine::uploadMeshletNodeData(std::span<MeshletNode> data) {
+    u32 currentOffset = _meshletNodeOffset;
+    if (currentOffset + data.size() * sizeof(MeshletNode) >= _globalMeshletNodeBuffer->size()) {
+        flushStagedData();
+        _globalMeshletNodeBuffer = _device->resizeBuffer(_globalMeshletNodeBuffer, currentOffset + data.size() * sizeof(MeshletNode), true);
+    }
+    stageData(_globalMeshletNodeBuffer, data, currentOffset);
+    _meshletNodeOffset += data.size() * sizeof(MeshletNode);
+    return currentOffset;
+}
+
 u32 cala::Engine::uploadPrimitiveData(std::span<u8> data) {
     u32 currentOffset = _primitiveOffset;
     if (currentOffset + data.size() * sizeof(u8) >= _globalPrimitiveBuffer->size()) {
@@ -697,7 +850,19 @@ u32 cala::Engine::flushStagedData() {
                 bytesUploaded += staged.srcSize;
             }
             for (auto& staged : _pendingStagedImage) {
-                auto barrier = staged.dstImage->barrier(vk::PipelineStage::TOP, vk::PipelineStage::TRANSFER, vk::Access::NONE, vk::Access::TRANSFER_WRITE, vk::ImageLayout::TRANSFER_DST);
+                // only the level written leaves shader reads, the rest of a streamed image may still be sampled. an
+                // image never written has nothing to wait on and is transitioned whole so every level shares a layout
+                bool initial = staged.dstImage->layout() == vk::ImageLayout::UNDEFINED;
+                auto barrier = initial
+                        ? staged.dstImage->barrier(vk::PipelineStage::TOP, vk::PipelineStage::TRANSFER, vk::Access::NONE, vk::Access::TRANSFER_WRITE, vk::ImageLayout::TRANSFER_DST)
+                        : staged.dstImage->barrier(vk::PipelineStage::FRAGMENT_SHADER | vk::PipelineStage::COMPUTE_SHADER, vk::PipelineStage::TRANSFER, vk::Access::SHADER_READ, vk::Access::TRANSFER_WRITE, vk::ImageLayout::TRANSFER_DST);
+                if (!initial) {
+                    barrier.subresourceRange.baseMipLevel = staged.dstMipLevel;
+                    barrier.subresourceRange.levelCount = 1;
+                    barrier.subresourceRange.baseArrayLayer = staged.dstLayer;
+                    barrier.subresourceRange.layerCount = staged.dstLayerCount;
+                }
+                auto range = barrier.subresourceRange;
                 cmd->pipelineBarrier({ &barrier, 1 });
 
                 VkBufferImageCopy imageCopy{};
@@ -715,10 +880,20 @@ u32 cala::Engine::flushStagedData() {
                 imageCopy.imageOffset.x = staged.dstOffset.x();
                 imageCopy.imageOffset.y = staged.dstOffset.y();
                 imageCopy.imageOffset.z = staged.dstOffset.z();
+                // block compressed images are staged in 4x4 blocks, edge blocks are clamped to the mip size
+                if (vk::isBlockFormat(staged.dstImage->format())) {
+                    u32 mipWidth = std::max(staged.dstImage->width() >> staged.dstMipLevel, 1u);
+                    u32 mipHeight = std::max(staged.dstImage->height() >> staged.dstMipLevel, 1u);
+                    imageCopy.imageOffset.x *= 4;
+                    imageCopy.imageOffset.y *= 4;
+                    imageCopy.imageExtent.width = std::min(imageCopy.imageExtent.width * 4, mipWidth - imageCopy.imageOffset.x);
+                    imageCopy.imageExtent.height = std::min(imageCopy.imageExtent.height * 4, mipHeight - imageCopy.imageOffset.y);
+                }
 
                 vkCmdCopyBufferToImage(cmd->buffer(), _stagingBuffer->buffer(), staged.dstImage->image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageCopy);
 
                 barrier = staged.dstImage->barrier(vk::PipelineStage::TRANSFER, vk::PipelineStage::FRAGMENT_SHADER | vk::PipelineStage::COMPUTE_SHADER, vk::Access::TRANSFER_WRITE, vk::Access::SHADER_READ, vk::ImageLayout::SHADER_READ_ONLY);
+                barrier.subresourceRange = range;
                 cmd->pipelineBarrier({ &barrier, 1 });
                 bytesUploaded += staged.srcSize;
             }
@@ -1061,6 +1236,16 @@ const cala::vk::ShaderProgram& cala::Engine::getProgram(cala::Engine::ProgramTyp
             return _bloomUpsampleProgram;
         case ProgramType::BLOOM_COMPOSITE:
             return _bloomCompositeProgram;
+        case ProgramType::BLOOM_DOWNSAMPLE_SPD:
+            return _bloomDownsampleSpdProgram;
+        case ProgramType::BLOOM_UPSAMPLE_CHAIN:
+            return _bloomUpsampleChainProgram;
+        case ProgramType::UPSCALE:
+            return _upscaleProgram;
+        case ProgramType::MOTION_VECTORS:
+            return _motionVectorsProgram;
+        case ProgramType::TAA:
+            return _taaProgram;
         case ProgramType::CULL_MESH_SHADER:
             return _cullMeshShaderProgram;
         case ProgramType::CULL_POINT:
@@ -1069,8 +1254,8 @@ const cala::vk::ShaderProgram& cala::Engine::getProgram(cala::Engine::ProgramTyp
             return _directShadowCullProgram;
         case ProgramType::CULL_LIGHTS:
             return _cullLightsProgram;
-        case ProgramType::CREATE_CLUSTERS:
-            return _createClustersProgram;
+        case ProgramType::BIN_LIGHTS:
+            return _binLightsProgram;
         case ProgramType::VISIBILITY:
             return _visibilityBufferProgram;
         case ProgramType::VISIBILITY_COUNT:
@@ -1079,6 +1264,12 @@ const cala::vk::ShaderProgram& cala::Engine::getProgram(cala::Engine::ProgramTyp
             return _visibilityOffsetProgram;
         case ProgramType::VISIBILITY_POSITION:
             return _visibilityPositionsProgram;
+        case ProgramType::SHADING_RATE:
+            return _shadingRateProgram;
+        case ProgramType::DEPTH_PYRAMID:
+            return _depthPyramidProgram;
+        case ProgramType::PROBE_UPDATE:
+            return _probeUpdateProgram;
         case ProgramType::DEBUG_MESHLETS:
             return _meshletDebugProgram;
         case ProgramType::DEBUG_PRIMITIVES:
@@ -0,0 +1,123 @@
+#include <Cala/FramePacer.h>
+#include <Cala/vulkan/Swapchain.h>
+#include <Ende/profile/profile.h>
+#include <algorithm>
+#include <thread>
+
+static f32 millisecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    return std::chrono::duration<f32, std::milli>(end - start).count();
+}
+
+static std::chrono::steady_clock::duration fromMilliseconds(f64 milliseconds) {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<f64, std::milli>(milliseconds));
+}
+
+cala::FramePacer::FramePacer(vk::Device* device)
+    : _device(device)
+{}
+
+void cala::FramePacer::wait(vk::Swapchain* swapchain, f64 gpuTime) {
+    PROFILE_NAMED("FramePacer::wait");
+    auto start = Clock::now();
+    // frames are counted by the device which increments before the frame begins, so the frame about to be sampled
+    // is one past its count
+    const u64 frame = _device->frameCount() + 1;
+    const u32 framesInFlight = std::clamp(_settings.framesInFlight, 1u, vk::FRAMES_IN_FLIGHT);
+    const bool presentWait = usePresentWait(swapchain);
+
+    // pick up frames that finished since the last wait without blocking on them. frames older than the device's own
+    // wait have their slot reused so only know they finished, not when
+    for (auto& tracked : _records) {
+        if (!tracked.submitted || tracked.complete || tracked.frame >= frame)
+            continue;
+        if (tracked.frame + vk::FRAMES_IN_FLIGHT < frame) {
+            tracked.complete = true;
+            continue;
+        }
+        if (presentWait && tracked.presentId) {
+            auto presented = swapchain->waitForPresent(tracked.presentId, 0);
+            if (presented && presented.value())
+                complete(tracked, start);
+        } else if (_device->frameComplete(tracked.frame % vk::FRAMES_IN_FLIGHT))
+            complete(tracked, start);
+    }
+
+    // limit the queue depth by blocking on the oldest frame allowed in flight
+    if (frame > framesInFlight) {
+        const u64 oldestFrame = frame - framesInFlight;
+        auto& oldest = record(oldestFrame);
+        if (oldest.frame == oldestFrame && oldest.submitted && !oldest.complete) {
+            bool finished = false;
+            if (presentWait && oldest.presentId) {
+                auto presented = swapchain->waitForPresent(oldest.presentId, 1000000000);
+                finished = presented && presented.value();
+            } else
+                finished = _device->waitFrame(oldestFrame % vk::FRAMES_IN_FLIGHT, 1000000000, false).has_value();
+            if (finished)
+                complete(oldest, Clock::now());
+            else
+                oldest.complete = true;
+        }
+    }
+
+    // gpu work starts when it is submitted or when the previous frame finishes, whichever is later, and takes about
+    // gpuTime. sleep until the last queued frame is predicted to finish less the time the cpu needs to submit the next
+    if (_settings.adaptiveWait && gpuTime > 0) {
+        auto now = Clock::now();
+        Clock::time_point idle = {};
+        bool pending = false;
+        for (u64 previous = frame > vk::FRAMES_IN_FLIGHT ? frame - vk::FRAMES_IN_FLIGHT : 1; previous < frame; previous++) {
+            auto& queued = record(previous);
+            if (queued.frame != previous || !queued.submitted || queued.complete)
+                continue;
+            if (_device->frameComplete(previous % vk::FRAMES_IN_FLIGHT))
+                continue;
+            // a frame running over its prediction is assumed to be about to finish
+            idle = std::max(std::max(idle, queued.submitTime) + fromMilliseconds(gpuTime), now);
+            pending = true;
+        }
+        auto wakeUp = idle - fromMilliseconds(_stats.cpuTime + _settings.waitMargin);
+        if (pending && wakeUp > now)
+            std::this_thread::sleep_until(wakeUp);
+    }
+
+    // capping the frame rate from here rather than after the frame keeps input as fresh as the uncapped case
+    if (_settings.targetFrameTime > 0) {
+        auto target = _lastFrameStart + fromMilliseconds(_settings.targetFrameTime);
+        if (target > Clock::now())
+            std::this_thread::sleep_until(target);
+    }
+
+    auto end = Clock::now();
+    _lastFrameStart = end;
+    _currentFrame = frame;
+    record(frame) = FrameRecord{ .frame = frame, .inputTime = end };
+
+    _stats.waitTime = millisecondsBetween(start, end);
+    _stats.framesInFlight = framesInFlight;
+    _stats.presentWait = presentWait;
+    _waited = true;
+}
+
+void cala::FramePacer::submitted(u64 presentId) {
+    auto now = Clock::now();
+    auto& current = record(_currentFrame);
+    if (current.frame == _currentFrame && !current.submitted) {
+        current.presentId = presentId;
+        current.submitTime = now;
+        current.submitted = true;
+        f32 cpuTime = millisecondsBetween(current.inputTime, now);
+        _stats.cpuTime = _stats.cpuTime == 0 ? cpuTime : _stats.cpuTime * 0.9f + cpuTime * 0.1f;
+    }
+    _waited = false;
+}
+
+bool cala::FramePacer::usePresentWait(vk::Swapchain* swapchain) const {
+    return _settings.presentWait && swapchain && swapchain->presentWaitSupported();
+}
+
+void cala::FramePacer::complete(FrameRecord& record, Clock::time_point time) {
+    record.complete = true;
+    f32 latency = millisecondsBetween(record.inputTime, time);
+    _stats.latency = _stats.latency == 0 ? latency : _stats.latency * 0.9f + latency * 0.1f;
+}
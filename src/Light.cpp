@@ -52,13 +52,13 @@ GPULight cala::Light::data() const {
     };
 
     for (u32 cascade = 0; cascade < _cascadeCount - 1 && cascade < MAX_CASCADES; cascade++) {
-        data.cascades[cascade].shadowMapIndex = _cascadeMaps[cascade].index();
         data.cascades[cascade].distance = _cascadeSplits[cascade];
     }
     if (_cascadeCount > 0) {
-        data.cascades[_cascadeCount - 1].shadowMapIndex = _cascadeMaps[_cascadeCount - 1].index();
         data.cascades[_cascadeCount - 1].distance = getFar();
     }
+    for (u32 view = 0; view < MAX_CASCADES; view++)
+        data.shadowTiles[view] = _shadowTiles[view];
 
     if (_type == POINT)
         data.position = _position;
@@ -110,7 +110,8 @@ void cala::Light::setShadowMap(vk::ImageHandle shadowMap) {
     _dirty = true;
 }
 
-void cala::Light::setCascadeShadowMap(i32 cascade, vk::ImageHandle shadowMap) {
-    _cascadeMaps[cascade] = shadowMap;
+void cala::Light::setShadowTile(u32 view, const ende::math::Vec4f& tile) {
+    assert(view < MAX_CASCADES);
+    _shadowTiles[view] = tile;
     _dirty = true;
 }
\ No newline at end of file
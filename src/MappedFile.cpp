@@ -0,0 +1,60 @@
+#include <Cala/MappedFile.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utility>
+
+std::optional<cala::MappedFile> cala::MappedFile::open(const std::filesystem::path &path, u64 padding) {
+    i32 fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return {};
+
+    struct stat status{};
+    if (fstat(fd, &status) != 0 || status.st_size == 0) {
+        close(fd);
+        return {};
+    }
+
+    u64 mappedSize = status.st_size + padding;
+    void* data = MAP_FAILED;
+    if (padding > 0) {
+        // pages past the end of the file can't be read so reserve zeroed pages for the padding and map the file over
+        // the start of them
+        void* reserved = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (reserved != MAP_FAILED) {
+            data = mmap(reserved, status.st_size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+            if (data == MAP_FAILED)
+                munmap(reserved, mappedSize);
+        }
+    } else
+        data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // mapping stays valid after the descriptor is closed
+    close(fd);
+    if (data == MAP_FAILED)
+        return {};
+
+    MappedFile file;
+    file._data = static_cast<const u8*>(data);
+    file._size = status.st_size;
+    file._mappedSize = mappedSize;
+    return file;
+}
+
+cala::MappedFile::~MappedFile() {
+    if (_data)
+        munmap(const_cast<u8*>(_data), _mappedSize);
+}
+
+cala::MappedFile::MappedFile(MappedFile &&rhs) noexcept
+    : _data(std::exchange(rhs._data, nullptr)),
+    _size(std::exchange(rhs._size, 0)),
+    _mappedSize(std::exchange(rhs._mappedSize, 0))
+{}
+
+cala::MappedFile &cala::MappedFile::operator=(MappedFile &&rhs) noexcept {
+    std::swap(_data, rhs._data);
+    std::swap(_size, rhs._size);
+    std::swap(_mappedSize, rhs._mappedSize);
+    return *this;
+}
@@ -1,6 +1,7 @@
 #include <Cala/RenderGraph.h>
 #include <Ende/profile/profile.h>
 #include <Cala/vulkan/primitives.h>
+#include <algorithm>
 
 
 cala::RenderPass::RenderPass(cala::RenderGraph *graph, const char *label)
@@ -409,7 +410,8 @@ cala::Resource *cala::RenderPass::writes(cala::BufferIndex index, vk::Access acc
 
 
 cala::RenderGraph::RenderGraph(cala::Engine *engine)
-    : _engine(engine)
+    : _engine(engine),
+    _parallelRecording(false)
 {}
 
 cala::RenderPass &cala::RenderGraph::addPass(const char *label, RenderPass::Type type) {
@@ -562,6 +564,7 @@ cala::vk::BufferHandle cala::RenderGraph::getBuffer(cala::BufferIndex resourceIn
 bool cala::RenderGraph::compile() {
     PROFILE_NAMED("RenderGraph::compile");
     _orderedPasses.clear();
+    _timedPassCount[_engine->device().frameIndex()] = 0;
 
     tsl::robin_map<const char*, std::vector<u32>> outputs;
     for (u32 i = 0; i < _passes.size(); i++) {
@@ -597,6 +600,20 @@ bool cala::RenderGraph::compile() {
             return false;
     }
 
+    // writes to persistent images are read by later frames so keep those passes even if nothing reads them this frame
+    for (u32 i = 0; i < _passes.size(); i++) {
+        if (visited[i])
+            continue;
+        for (auto& output : _passes[i]._outputs) {
+            auto imageResource = dynamic_cast<ImageResource*>(_resources[output.index].get());
+            if (imageResource && imageResource->persistent) {
+                if (!dfs(i))
+                    return false;
+                break;
+            }
+        }
+    }
+
     buildBarriers();
 
     buildResources();
@@ -605,12 +622,15 @@ bool cala::RenderGraph::compile() {
 
 //    log();
 
+    _timedPassCount[_engine->device().frameIndex()] = _orderedPasses.size();
     return true;
 }
 
 bool cala::RenderGraph::execute(vk::CommandHandle cmd) {
     PROFILE_NAMED("RenderGraph::execute");
 
+    recordSecondaryBuffers();
+
     const char* currentDebugGroup = nullptr;
     for (u32 i = 0; i < _orderedPasses.size(); i++) {
         auto& pass = _orderedPasses[i];
@@ -642,7 +662,12 @@ bool cala::RenderGraph::execute(vk::CommandHandle cmd) {
             auto& barrier = pass->_barriers[barrierIndex];
             if (barrier.dstLayout != vk::ImageLayout::UNDEFINED) {
                 auto image = getImage(barrier.label);
-                imageBarriers[imageBarrierCount++] = image->barrier(barrier.srcStage, barrier.dstStage, barrier.srcAccess, barrier.dstAccess, barrier.srcLayout, barrier.dstLayout);
+                auto imageResource = getImageResource(barrier.label);
+                // transition persistent images from their tracked layout so their contents aren't discarded
+                if (barrier.srcLayout == vk::ImageLayout::UNDEFINED && imageResource && imageResource->persistent)
+                    imageBarriers[imageBarrierCount++] = image->barrier(vk::PipelineStage::ALL_COMMANDS, barrier.dstStage, barrier.srcAccess, barrier.dstAccess, barrier.dstLayout);
+                else
+                    imageBarriers[imageBarrierCount++] = image->barrier(barrier.srcStage, barrier.dstStage, barrier.srcAccess, barrier.dstAccess, barrier.srcLayout, barrier.dstLayout);
             } else {
                 auto buffer = getBuffer(barrier.label);
                 bufferBarriers[bufferBarrierCount++] = buffer->barrier(barrier.srcStage, barrier.dstStage, barrier.srcAccess, barrier.dstAccess);
@@ -651,9 +676,13 @@ bool cala::RenderGraph::execute(vk::CommandHandle cmd) {
         cmd->pipelineBarrier({ imageBarriers, imageBarrierCount });
         cmd->pipelineBarrier({ bufferBarriers, bufferBarrierCount });
 
+        auto& [recordingThread, secondary] = _secondaryBuffers[i];
         if (pass->_type == RenderPass::Type::GRAPHICS && pass->_framebuffer)
-            cmd->begin(*pass->_framebuffer);
-        if (pass->_function)
+            cmd->begin(*pass->_framebuffer, recordingThread >= 0);
+        if (recordingThread >= 0) {
+            _recordingTasks[recordingThread].wait();
+            cmd->executeCommands(secondary);
+        } else if (pass->_function)
             pass->_function(cmd, *this);
         if (pass->_type == RenderPass::Type::GRAPHICS && pass->_framebuffer)
             cmd->end(*pass->_framebuffer);
@@ -663,9 +692,58 @@ bool cala::RenderGraph::execute(vk::CommandHandle cmd) {
     }
     if (currentDebugGroup)
         cmd->popDebugLabel();
+
+    for (auto& task : _recordingTasks)
+        task.get();
+    _recordingTasks.clear();
     return true;
 }
 
+void cala::RenderGraph::recordSecondaryBuffers() {
+    PROFILE_NAMED("RenderGraph::recordSecondaryBuffers");
+    _secondaryBuffers.assign(_orderedPasses.size(), std::make_pair(-1, vk::CommandHandle{}));
+    _recordingTasks.clear();
+    if (!_parallelRecording)
+        return;
+
+    u32 parallelCount = 0;
+    for (auto& pass : _orderedPasses) {
+        if (pass->_parallelRecording && pass->_function)
+            parallelCount++;
+    }
+    auto& device = _engine->device();
+    u32 threadCount = std::min({ device.recordingThreadCount(), _engine->threadPool().threadCount(), parallelCount });
+    // not worth handing work to another thread if only one pass can be recorded
+    if (parallelCount < 2 || threadCount == 0)
+        return;
+
+    // split passes into contiguous chunks so the earliest passes are recorded first
+    u32 passesPerThread = (parallelCount + threadCount - 1) / threadCount;
+    u32 parallelIndex = 0;
+    for (u32 i = 0; i < _orderedPasses.size(); i++) {
+        auto& pass = _orderedPasses[i];
+        if (!pass->_parallelRecording || !pass->_function)
+            continue;
+        u32 thread = parallelIndex++ / passesPerThread;
+        _secondaryBuffers[i] = std::make_pair(thread, device.getSecondaryCommandBuffer(device.frameIndex(), thread));
+    }
+    threadCount = (parallelCount + passesPerThread - 1) / passesPerThread;
+
+    for (u32 thread = 0; thread < threadCount; thread++) {
+        _recordingTasks.push_back(_engine->threadPool().submit([this, thread] {
+            for (u32 i = 0; i < _orderedPasses.size(); i++) {
+                auto& [recordingThread, secondary] = _secondaryBuffers[i];
+                if (recordingThread != static_cast<i32>(thread))
+                    continue;
+                auto& pass = _orderedPasses[i];
+                secondary->beginSecondary(pass->_type == RenderPass::Type::GRAPHICS ? pass->_framebuffer : nullptr);
+                pass->_function(secondary, *this);
+                secondary->end();
+            }
+        }));
+    }
+}
+
 void cala::RenderGraph::reset() {
 //    _resources.clear();
     _passes.clear();
@@ -683,8 +761,9 @@ void cala::RenderGraph::buildResources() {
         auto& resource = _resources[i];
         if (auto imageResource = dynamic_cast<ImageResource*>(resource.get()); imageResource) {
             if (imageResource->matchSwapchain) {
-                imageResource->width = _backbufferWidth;
-                imageResource->height = _backbufferHeight;
+                auto dimensions = imageResource->scaled ? getScaledBackbufferDimensions() : getBackbufferDimensions();
+                imageResource->width = dimensions.x();
+                imageResource->height = dimensions.y();
                 imageResource->depth = 1;
             }
             imageResource->usage = imageResource->usage | vk::ImageUsage::TRANSFER_DST;
@@ -888,9 +967,9 @@ void cala::RenderGraph::buildRenderPasses() {
             attachment.format = image->format;
             attachment.samples = VK_SAMPLE_COUNT_1_BIT;
             // if first access clear otherwise load
-            attachment.loadOp = prevAccessPassIndex > -1 ? vk::LoadOp::LOAD : vk::LoadOp::CLEAR;
+            attachment.loadOp = prevAccessPassIndex > -1 || image->persistent ? vk::LoadOp::LOAD : vk::LoadOp::CLEAR;
             // if last access none otherwise store
-            attachment.storeOp = nextAccessPassIndex > -1 ? vk::StoreOp::STORE : vk::StoreOp::NONE;
+            attachment.storeOp = nextAccessPassIndex > -1 || image->persistent ? vk::StoreOp::STORE : vk::StoreOp::NONE;
             attachment.stencilLoadOp = vk::LoadOp::DONT_CARE;
             attachment.stencilStoreOp = vk::StoreOp::DONT_CARE;
             attachment.initialLayout = access.layout;
@@ -917,8 +996,8 @@ void cala::RenderGraph::buildRenderPasses() {
             vk::RenderPass::Attachment attachment{};
             attachment.format = depthResource->format;
             attachment.samples = VK_SAMPLE_COUNT_1_BIT;
-            attachment.loadOp = prevAccessPassIndex > -1 ? vk::LoadOp::LOAD : vk::LoadOp::CLEAR;
-            attachment.storeOp = nextAccessPassIndex > -1 ? vk::StoreOp::STORE : vk::StoreOp::NONE;
+            attachment.loadOp = prevAccessPassIndex > -1 || depthResource->persistent ? vk::LoadOp::LOAD : vk::LoadOp::CLEAR;
+            attachment.storeOp = nextAccessPassIndex > -1 || depthResource->persistent ? vk::StoreOp::STORE : vk::StoreOp::NONE;
             attachment.stencilLoadOp = vk::LoadOp::DONT_CARE;
             attachment.stencilStoreOp = vk::StoreOp::DONT_CARE;
             attachment.initialLayout = access.layout;
@@ -10,6 +10,35 @@
 #include "renderPasses/debugPasses.h"
 #include "renderPasses/shadowPasses.h"
 #include <Cala/vulkan/primitives.h>
+#include <bit>
+#include <numbers>
+
+// radical inverse of index in base, consecutive indices fill [0, 1) evenly
+static f32 halton(u32 index, u32 base) {
+    f32 result = 0.f;
+    f32 fraction = 1.f;
+    while (index > 0) {
+        fraction /= base;
+        result += fraction * (index % base);
+        index /= base;
+    }
+    return result;
+}
+
+// rebuilds the per mip views of a graph image when the graph hands back a different image. frames still in flight may
+// have bound the old views so they're retired for FRAMES_IN_FLIGHT frames rather than destroyed. returns true if the
+// views were rebuilt
+static bool updateMipViews(cala::vk::ImageHandle image, cala::vk::ImageHandle& current, std::vector<cala::vk::Image::View>& views, std::vector<std::pair<u32, cala::vk::Image::View>>& retired) {
+    if (image == current && views.size() == image->mips())
+        return false;
+    current = image;
+    for (auto& view : views)
+        retired.push_back({ cala::vk::FRAMES_IN_FLIGHT, std::move(view) });
+    views.clear();
+    for (u32 mip = 0; mip < image->mips(); mip++)
+        views.push_back(image->newView(mip));
+    return true;
+}
 
 cala::Renderer::Renderer(cala::Engine* engine, cala::Renderer::Settings settings)
     : _engine(engine),
@@ -17,7 +46,8 @@ cala::Renderer::Renderer(cala::Engine* engine, cala::Renderer::Settings settings
     _graph(engine),
     _renderSettings(settings),
     _randomGenerator(std::random_device()()),
-    _randomDistribution(0.0, 1.0)
+    _randomDistribution(0.0, 1.0),
+    _framePacer(&engine->device())
 {
     _engine->device().setBindlessSetIndex(0);
 
@@ -39,12 +69,42 @@ cala::Renderer::Renderer(cala::Engine* engine, cala::Renderer::Settings settings
             .name = "FeedbackBuffer: " + std::to_string(i++)
         });
     }
+    for (u32 i = 0; auto& buffer : _mipFeedbackBuffer) {
+        buffer = engine->device().createBuffer({
+            .size = static_cast<u32>(engine->device().context().getLimits().maxBindlessSampledImages * sizeof(u32)),
+            .usage = vk::BufferUsage::STORAGE,
+            .memoryType = vk::MemoryProperties::READBACK,
+            .persistentlyMapped = true,
+            .name = "MipFeedbackBuffer: " + std::to_string(i++)
+        });
+        std::memset(buffer->persistentMapping(), 0, buffer->size());
+    }
+}
+
+void cala::Renderer::waitForFrame(cala::vk::Swapchain* swapchain) {
+    auto& settings = _framePacer.settings();
+    settings.framesInFlight = std::clamp(_renderSettings.framesInFlight, 1, static_cast<i32>(vk::FRAMES_IN_FLIGHT));
+    settings.adaptiveWait = _renderSettings.adaptiveFrameWait;
+    settings.waitMargin = _renderSettings.frameWaitMargin;
+    settings.presentWait = _renderSettings.presentWait;
+    settings.targetFrameTime = _renderSettings.boundedFrameTime ? _renderSettings.millisecondTarget : 0;
+    _framePacer.wait(swapchain, _gpuTime);
+
+    auto pacerStats = _framePacer.stats();
+    _stats.inputLatency = pacerStats.latency;
+    _stats.frameWaitTime = pacerStats.waitTime;
+    _stats.presentLatency = pacerStats.presentWait;
 }
 
 bool cala::Renderer::beginFrame(cala::vk::Swapchain* swapchain) {
     _swapchain = swapchain;
     assert(_swapchain);
+    if (!_framePacer.waited())
+        waitForFrame(_swapchain);
     auto beginResult = _engine->device().beginFrame();
+    std::erase_if(_retiredViews, [](auto& retired) {
+        return retired.first-- == 0;
+    });
 
     if (_feedbackBuffer[_engine->device().frameIndex()] && _feedbackBuffer[_engine->device().frameIndex()]->persistentlyMapped()) {
         std::memcpy(&_feedbackInfo, _feedbackBuffer[_engine->device().frameIndex()]->persistentMapping(), sizeof(FeedbackInfo));
@@ -52,19 +112,62 @@ bool cala::Renderer::beginFrame(cala::vk::Swapchain* swapchain) {
         _stats.drawnMeshlets = _feedbackInfo.drawnMeshlets;
         _stats.culledMeshes = _feedbackInfo.totalMeshes - _feedbackInfo.drawnMeshes;
         _stats.culledMeshlets = _feedbackInfo.totalMeshlets - _feedbackInfo.drawnMeshlets;
+        _stats.coneCulledMeshlets = _feedbackInfo.coneCulledMeshlets;
+        _stats.smallCulledMeshlets = _feedbackInfo.smallCulledMeshlets;
+        _stats.occludedMeshlets = _feedbackInfo.occludedMeshlets;
         _stats.drawnTriangles = _feedbackInfo.drawnTriangles;
         _stats.currentMeshlet = _feedbackInfo.meshletID;
         _stats.currentMesh = _feedbackInfo.meshID;
+        _stats.droppedLightIndices = _feedbackInfo.droppedLightIndices;
+        _stats.shadedPixelRatio = _feedbackInfo.coveredPixels > 0 ? static_cast<f32>(_feedbackInfo.shadedPixels) / static_cast<f32>(_feedbackInfo.coveredPixels) : 1.f;
+        _stats.visitedNodes = _feedbackInfo.visitedNodes;
+        _stats.droppedDrawCommands = _feedbackInfo.droppedDrawCommands;
+        if (_feedbackInfo.requiredLightIndices > _lightIndexCapacity)
+            _lightIndexCapacity = std::bit_ceil(_feedbackInfo.requiredLightIndices);
+        if (_feedbackInfo.requiredDrawCommands > _drawCommandCapacity)
+            _drawCommandCapacity = std::bit_ceil(_feedbackInfo.requiredDrawCommands);
+        if (_feedbackInfo.requiredShadowDrawCommands > _shadowDrawCommandCapacity)
+            _shadowDrawCommandCapacity = std::bit_ceil(_feedbackInfo.requiredShadowDrawCommands);
         std::memset(_feedbackBuffer[_engine->device().frameIndex()]->persistentMapping(), 0, sizeof(FeedbackInfo));
     }
 
-    if (_renderSettings.boundedFrameTime) {
-        f64 frameTime = _engine->device().milliseconds();
-        f64 frameTimeDiff = frameTime - _renderSettings.millisecondTarget;
-        if (frameTimeDiff < 0)
-            usleep(-frameTimeDiff * 1000);
+    if (_mipFeedbackBuffer[_engine->device().frameIndex()] && _mipFeedbackBuffer[_engine->device().frameIndex()]->persistentlyMapped()) {
+        auto& buffer = _mipFeedbackBuffer[_engine->device().frameIndex()];
+        _engine->assetManager()->updateMipFeedback({ static_cast<const u32*>(buffer->persistentMapping()), buffer->size() / sizeof(u32) });
+        std::memset(buffer->persistentMapping(), 0, buffer->size());
     }
 
+    // timers for this frame index were last written FRAMES_IN_FLIGHT frames ago and are ready now the frame has waited.
+    // the graph reports as many as it ordered when compiled on this index, not the count of the last graph compiled
+    f64 gpuTime = 0;
+    for (auto& timer : timers())
+        gpuTime += timer.second.result() / 1e6;
+    _gpuTime = _gpuTime * 0.9 + gpuTime * 0.1;
+    _stats.gpuTime = _gpuTime;
+
+    if (_renderSettings.dynamicResolution) {
+        // every scaled target is reallocated when the scale changes so it moves in steps, then waits for the smoothed
+        // time to catch up before moving again. gpu time mostly follows pixel count so drops go by the square root
+        // of how far over target the frame is, and increases only happen one step at a time with clear headroom
+        constexpr f32 scaleStep = 0.05f;
+        f32 minScale = std::min(_renderSettings.minRenderScale, _renderSettings.maxRenderScale);
+        f32 maxScale = _renderSettings.maxRenderScale;
+        f32 scale = _renderScale;
+        if (_renderScaleCooldown > 0)
+            _renderScaleCooldown--;
+        else if (_gpuTime > _renderSettings.gpuTimeTarget) {
+            f32 ideal = _renderScale * std::sqrt(_renderSettings.gpuTimeTarget / _gpuTime);
+            scale = std::min(std::floor(ideal / scaleStep) * scaleStep, _renderScale - scaleStep);
+        } else if (_gpuTime < _renderSettings.gpuTimeTarget * 0.85)
+            scale = _renderScale + scaleStep;
+        scale = std::clamp(scale, minScale, maxScale);
+        if (scale != _renderScale) {
+            _renderScale = scale;
+            _renderScaleCooldown = 30;
+        }
+    } else
+        _renderScale = _renderSettings.renderScale;
+
     auto result = _swapchain->nextImage();
     if (!beginResult || !result) {
         //TODO deal with actual error, don't just assume device lost
@@ -109,6 +212,7 @@ f64 cala::Renderer::endFrame() {
         _engine->device().printMarkers();
         return false;
     });
+    _framePacer.submitted(_swapchain->lastPresentId());
     _engine->device().endFrame();
 
     _stats.drawCallCount = _frameInfo.cmd->drawCalls();
@@ -127,6 +231,9 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
     bool debugViewEnabled = overlayDebug || fullscreenDebug;
 
     _stats.sceneMeshlets = scene._totalMeshlets;
+    _stats.shadowViewsRefreshed = _engine->shadowAtlas().refreshedViews();
+    _stats.shadowViewsComposited = _engine->shadowAtlas().compositedViews();
+    _stats.shadowViewsReused = _engine->shadowAtlas().reusedViews();
 
     vk::CommandHandle cmd = _frameInfo.cmd;
 
@@ -134,36 +241,103 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
 
     _graph.reset();
 
+    // the scene renders at the scaled backbuffer size and is upscaled before tonemapping. debug views and a skybox
+    // drawn straight into the backbuffer mix both sizes so render at full size for those
+    bool skyboxToBackbuffer = _renderSettings.skybox && scene._skyLightMap && !(scene._hdrSkyLight && _renderSettings.tonemap);
+    bool scaledRendering = _renderSettings.tonemap && !debugViewEnabled && !skyboxToBackbuffer;
+    _stats.renderScale = scaledRendering ? _renderScale : 1.f;
+    _graph.setBackbufferDimensions(_swapchain->extent().width, _swapchain->extent().height);
+    _graph.setRenderScale(_stats.renderScale);
+    auto renderSize = _graph.getScaledBackbufferDimensions();
+    bool upscale = renderSize.x() != _swapchain->extent().width || renderSize.y() != _swapchain->extent().height;
+    // taa takes over upscaling, accumulating jittered frames at the scaled size into a history at the backbuffer size
+    bool taa = _renderSettings.taa && scaledRendering;
+    if (!taa) {
+        _taaHistoryValid = false;
+        _previousTransformsValid = false;
+    }
+
     // Register resources used by graph
     ImageResource visibilityAttachment;
     visibilityAttachment.format = vk::Format::RG32_UINT;
+    visibilityAttachment.scaled = true;
     auto visibilityImageIndex = _graph.addImageResource("visibility", visibilityAttachment);
 
+    // materials are resolved in tiles, each tile keeps a bit for every material it covers
+    u32 tilesX = std::ceil(static_cast<f32>(renderSize.x()) / MATERIAL_TILE_SIZE);
+    u32 tilesY = std::ceil(static_cast<f32>(renderSize.y()) / MATERIAL_TILE_SIZE);
+    u32 tileMaskWords = (_engine->materialCount() + 31) / 32;
+
     BufferResource visibilityMaterialResource;
-    visibilityMaterialResource.size = _engine->materialCount() * sizeof(u32) * 2;
+    visibilityMaterialResource.size = sizeof(u32) + _engine->materialCount() * sizeof(u32) * 2;
     auto materialCountBufferIndex = _graph.addBufferResource("materialCount", visibilityMaterialResource);
 
-//    BufferResource visibilityPixelPositions;
-//    visibilityPixelPositions.size = _swapchain->extent().width * _swapchain->extent().height * sizeof(i32) * 2;
-//    auto pixelPositionsBufferIndex = _graph.addBufferResource("pixelPositions", visibilityPixelPositions);
+    BufferResource tileMasksResource;
+    tileMasksResource.size = std::max(tilesX * tilesY * tileMaskWords * sizeof(u32), sizeof(u32));
+    auto tileMasksBufferIndex = _graph.addBufferResource("materialTileMasks", tileMasksResource);
 
-    ImageResource visibilityPixelPositions;
-    visibilityPixelPositions.format = vk::Format::RG16_SINT;
-    visibilityPixelPositions.matchSwapchain = false;
+    // a tile is listed once for each material in it, so no more than min(materials, pixels per tile) times
+    ImageResource visibilityMaterialTiles;
+    visibilityMaterialTiles.format = vk::Format::RG16_SINT;
+    visibilityMaterialTiles.matchSwapchain = false;
     {
-        u32 pixelCount = (_swapchain->extent().width * _swapchain->extent().height);
-        visibilityPixelPositions.width = _engine->device().context().getLimits().maxImageDimensions1D;
-        visibilityPixelPositions.height = std::ceil(static_cast<f32>(pixelCount) / static_cast<f32>(_engine->device().context().getLimits().maxImageDimensions1D));
+        u32 tileEntries = tilesX * tilesY * std::clamp(_engine->materialCount(), 1u, static_cast<u32>(MATERIAL_TILE_SIZE * MATERIAL_TILE_SIZE));
+        visibilityMaterialTiles.width = std::min(tileEntries, _engine->device().context().getLimits().maxImageDimensions1D);
+        visibilityMaterialTiles.height = std::ceil(static_cast<f32>(tileEntries) / static_cast<f32>(_engine->device().context().getLimits().maxImageDimensions1D));
     }
-    auto pixelPositionsImageIndex = _graph.addImageResource("pixelPositions", visibilityPixelPositions);
+    auto materialTilesImageIndex = _graph.addImageResource("materialTiles", visibilityMaterialTiles);
 
     BufferResource visibilityDispatchCommands;
     visibilityDispatchCommands.size = _engine->materialCount() * sizeof(DispatchCommand);
     auto visibilityDispatchBufferIndex = _graph.addBufferResource("dispatchCommands", visibilityDispatchCommands);
 
+    // variable rate shading and the gi probes both read last frame's lit image, so hdr is kept between frames and read
+    // through an alias that doesn't depend on this frame's resolve
+    bool variableRate = _renderSettings.variableRateShading && _renderSettings.tonemap && !fullscreenDebug;
+    bool probeGI = _renderSettings.probeGI && _renderSettings.tonemap && !fullscreenDebug &&
+            scene._casterMin.x() <= scene._casterMax.x();
+    bool hdrHistory = variableRate || probeGI;
+    if (!hdrHistory)
+        _hdrHistory = {};
+
     ImageResource colourAttachment;
     colourAttachment.format = vk::Format::RGBA32_SFLOAT;
+    colourAttachment.scaled = true;
+    colourAttachment.persistent = hdrHistory;
     auto hdrImageIndex = _graph.addImageResource("hdr", colourAttachment);
+    if (hdrHistory)
+        _graph.addAlias("hdr", "hdrHistory");
+
+    BufferResource shadingRatesResource;
+    shadingRatesResource.size = std::max(tilesX * tilesY * sizeof(u32), sizeof(u32));
+    auto shadingRatesIndex = _graph.addBufferResource("shadingRates", shadingRatesResource);
+
+    // the probe grid is fit around the shadow casters and only refit once they leave it, so moving objects don't throw
+    // the probes away
+    if (probeGI) {
+        ende::math::Vec<3, u32> gridSize = {
+            static_cast<u32>(std::clamp(_renderSettings.probeGridSize[0], 2, 64)),
+            static_cast<u32>(std::clamp(_renderSettings.probeGridSize[1], 2, 64)),
+            static_cast<u32>(std::clamp(_renderSettings.probeGridSize[2], 2, 64))
+        };
+        bool contained = true;
+        bool sizeChanged = false;
+        for (u32 axis = 0; axis < 3; axis++) {
+            contained = contained && scene._casterMin[axis] >= _probeGridMin[axis] && scene._casterMax[axis] <= _probeGridMax[axis];
+            sizeChanged = sizeChanged || gridSize[axis] != _probeGridSize[axis];
+        }
+        if (!contained || sizeChanged) {
+            _probeGridMin = scene._casterMin;
+            _probeGridMax = scene._casterMax;
+            _probeGridSize = gridSize;
+            _probeGridValid = false;
+        }
+    } else
+        _probeBuffer = {};
+
+    BufferResource probesResource;
+    probesResource.size = (probeGI ? _probeGridSize.x() * _probeGridSize.y() * _probeGridSize.z() : 1) * sizeof(IrradianceProbe);
+    auto probesIndex = _graph.addBufferResource("probes", probesResource);
 
     ImageResource backbufferAttachment;
     backbufferAttachment.format = vk::Format::RGBA8_UNORM;
@@ -172,23 +346,37 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
 
     ImageResource depthAttachment;
     depthAttachment.format = vk::Format::D32_SFLOAT;
+    depthAttachment.scaled = true;
     auto depthIndex = _graph.addImageResource("depth", depthAttachment);
 
-    BufferResource clustersResource;
-    clustersResource.size = sizeof(ende::math::Vec4f) * 2 * 16 * 9 * 24;
-    auto clustersIndex = _graph.addBufferResource("clusters", clustersResource);
-
+    // max depth pyramid rebuilt from the depth buffer after the visibility pass and kept for the next frame to cull
+    // against. the visibility pass reads it through an alias so it doesn't depend on the pass writing it
+    ImageResource depthPyramidResource;
+    depthPyramidResource.format = vk::Format::R32_SFLOAT;
+    depthPyramidResource.matchSwapchain = false;
+    depthPyramidResource.width = std::bit_floor(renderSize.x());
+    depthPyramidResource.height = std::bit_floor(renderSize.y());
+    depthPyramidResource.mipLevels = std::bit_width(std::max(depthPyramidResource.width, depthPyramidResource.height));
+    depthPyramidResource.persistent = true;
+    if (_renderSettings.occlusionCulling) {
+        _graph.addImageResource("depthPyramid", depthPyramidResource);
+        _graph.addAlias("depthPyramid", "depthPyramidHistory");
+    } else
+        _depthPyramidValid = false;
+
+    // the cull emits a command per range of the meshlet hierarchy that survives node culling, so the commands start
+    // at one per instance and grow whenever the gpu reports they overflowed
+    _drawCommandCapacity = std::max({ _drawCommandCapacity, scene.instanceCount(), 1u });
+    _stats.drawCommandCapacity = _drawCommandCapacity;
     BufferResource drawCommandsResource;
-    drawCommandsResource.size = std::max(scene.meshCount() * sizeof(MeshTaskCommand), 1ul);
+    drawCommandsResource.size = _drawCommandCapacity * sizeof(MeshTaskCommand);
     drawCommandsResource.usage = vk::BufferUsage::INDIRECT | vk::BufferUsage::STORAGE;
     auto drawCommandsIndex = _graph.addBufferResource("drawCommands", drawCommandsResource);
-    auto shadowDrawCommandsIndex = _graph.addBufferResource("shadowDrawCommands", drawCommandsResource);
 
     BufferResource drawCountResource;
     drawCountResource.size = sizeof(u32);
     drawCountResource.usage = vk::BufferUsage::INDIRECT | vk::BufferUsage::STORAGE;
     auto drawCountIndex = _graph.addBufferResource("drawCount", drawCountResource);
-    auto shadowDrawCountIndex = _graph.addBufferResource("shadowDrawCount", drawCountResource);
 
 
 //    ImageResource directDepth;
@@ -212,6 +400,11 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
     meshDataResource.usage = scene._meshDataBuffer[_engine->device().frameIndex()]->usage();
     auto meshDataIndex = _graph.addBufferResource("meshData", meshDataResource, scene._meshDataBuffer[_engine->device().frameIndex()]);
 
+    BufferResource instancesResource;
+    instancesResource.size = scene._instanceBuffer[_engine->device().frameIndex()]->size();
+    instancesResource.usage = scene._instanceBuffer[_engine->device().frameIndex()]->usage();
+    auto instancesIndex = _graph.addBufferResource("instances", instancesResource, scene._instanceBuffer[_engine->device().frameIndex()]);
+
     BufferResource vertexBufferResource;
     vertexBufferResource.size = _engine->_globalVertexBuffer->size();
     vertexBufferResource.usage = _engine->_globalVertexBuffer->usage();
@@ -237,96 +430,135 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
     feedbackResource.usage = _feedbackBuffer[_engine->device().frameIndex()]->usage();
     auto feedbackBufferIndex = _graph.addBufferResource("feedback", feedbackResource, _feedbackBuffer[_engine->device().frameIndex()]);
 
-    if (camera->isDirty()) {
-        auto& createClusters = _graph.addPass("create_clusters", RenderPass::Type::COMPUTE);
+    BufferResource mipFeedbackResource;
+    mipFeedbackResource.size = _mipFeedbackBuffer[_engine->device().frameIndex()]->size();
+    mipFeedbackResource.usage = _mipFeedbackBuffer[_engine->device().frameIndex()]->usage();
+    auto mipFeedbackBufferIndex = _graph.addBufferResource("mipFeedback", mipFeedbackResource, _mipFeedbackBuffer[_engine->device().frameIndex()]);
+
+    // lights are binned into screen tiles and depth slices then each cluster gathers the lights in both. the index
+    // list is sized from the light count and grows whenever the gpu reports it overflowed
+    constexpr u32 clusterCount = LIGHT_TILES_X * LIGHT_TILES_Y * LIGHT_SLICES;
+    u32 lightCount = scene.lightCount();
+    u32 lightMaskWords = std::max((lightCount + 31) / 32, 1u);
+    {
+        constexpr u32 estimatedClustersPerLight = 32;
+        u32 directionalCount = std::count_if(scene._lights.begin(), scene._lights.end(), [](const Light& light) {
+            return light.type() == Light::DIRECTIONAL;
+        });
+        u32 estimate = directionalCount * clusterCount + (lightCount - directionalCount) * estimatedClustersPerLight;
+        _lightIndexCapacity = std::max({ _lightIndexCapacity, estimate, 1u });
+        _stats.lightIndexCapacity = _lightIndexCapacity;
+    }
+
+    BufferResource lightGridResource;
+    lightGridResource.size = sizeof(LightGrid) * clusterCount;
+    auto lightGridIndex = _graph.addBufferResource("lightGrid", lightGridResource);
+
+    BufferResource lightIndicesResource;
+    lightIndicesResource.size = sizeof(u32) * _lightIndexCapacity;
+    auto lightIndicesIndex = _graph.addBufferResource("lightIndices", lightIndicesResource);
 
-        createClusters.addStorageBufferWrite("clusters", vk::PipelineStage::COMPUTE_SHADER);
-        createClusters.addStorageBufferRead("camera", vk::PipelineStage::COMPUTE_SHADER);
+    BufferResource lightMasksResource;
+    lightMasksResource.size = sizeof(u32) * (LIGHT_TILES_X * LIGHT_TILES_Y + LIGHT_SLICES) * lightMaskWords;
+    auto lightMasksIndex = _graph.addBufferResource("lightMasks", lightMasksResource);
+
+    BufferResource lightIndexAllocatorResource;
+    lightIndexAllocatorResource.size = sizeof(u32);
+    auto lightIndexAllocatorIndex = _graph.addBufferResource("lightIndexAllocator", lightIndexAllocatorResource);
+
+    // the grid is kept from the last frame it was culled in as long as the lights, cameras and buffers it was built
+    // with haven't changed
+    bool cullLightsRequired = scene._lightsChanged || scene._camerasChanged ||
+            !(_graph.getBuffer(lightGridIndex) == _culledLightGrid) ||
+            !_culledLightIndices || !(_graph.getBuffer(lightIndicesIndex) == _culledLightIndices) ||
+            _culledLightIndices->size() < lightIndicesResource.size ||
+            _culledLightsSize.x() != renderSize.x() || _culledLightsSize.y() != renderSize.y() ||
+            _culledLightsCamera != scene.getMainCameraIndex();
+
+    if (cullLightsRequired) {
+        auto& binLights = _graph.addPass("bin_lights", RenderPass::Type::COMPUTE);
+        binLights.setDebugGroup("culling");
+
+        binLights.addUniformBufferRead(globalIndex, vk::PipelineStage::COMPUTE_SHADER);
+        binLights.addStorageBufferRead(lightBufferIndex, vk::PipelineStage::COMPUTE_SHADER);
+        binLights.addStorageBufferRead(cameraBufferIndex, vk::PipelineStage::COMPUTE_SHADER);
+        binLights.addStorageBufferWrite(lightMasksIndex, vk::PipelineStage::COMPUTE_SHADER);
+        binLights.addStorageBufferWrite(lightIndexAllocatorIndex, vk::PipelineStage::COMPUTE_SHADER);
+
+        binLights.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph& graph) {
+            auto global = graph.getBuffer(globalIndex);
+            auto lightMasks = graph.getBuffer(lightMasksIndex);
+            auto lightIndexAllocator = graph.getBuffer(lightIndexAllocatorIndex);
+
+            cmd->clearBuffer(lightMasks);
+            cmd->clearBuffer(lightIndexAllocator);
+            vk::Buffer::Barrier clearBarriers[] = {
+                lightMasks->barrier(vk::PipelineStage::TRANSFER, vk::PipelineStage::COMPUTE_SHADER,
+                                    vk::Access::TRANSFER_WRITE,
+                                    vk::Access::SHADER_READ | vk::Access::SHADER_WRITE),
+                lightIndexAllocator->barrier(vk::PipelineStage::TRANSFER, vk::PipelineStage::COMPUTE_SHADER,
+                                             vk::Access::TRANSFER_WRITE,
+                                             vk::Access::SHADER_READ | vk::Access::SHADER_WRITE)
+            };
+            cmd->pipelineBarrier(clearBarriers);
 
-        createClusters.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph& graph) {
-            auto clusters = graph.getBuffer("clusters");
             cmd->clearDescriptors();
-            cmd->bindProgram(_engine->getProgram(Engine::ProgramType::CREATE_CLUSTERS));
+            cmd->bindProgram(_engine->getProgram(Engine::ProgramType::BIN_LIGHTS));
             cmd->bindBindings({});
             cmd->bindAttributes({});
-            struct ClusterPush {
-                ende::math::Mat4f inverseProjection;
-                ende::math::Vec<4, u32> tileSizes;
-                ende::math::Vec<2, u32> screenSize;
-                f32 near;
-                f32 far;
+            cmd->bindBuffer(1, 0, global);
+            cmd->bindBuffer(1, 1, lightMasks, true);
+            cmd->pushConstants(vk::ShaderStage::COMPUTE, lightMaskWords);
+            cmd->bindPipeline();
+            cmd->bindDescriptors();
+            cmd->dispatchWorkgroups((lightCount + 63) / 64, 1, 1);
+        });
+
+        auto& cullLights = _graph.addPass("cull_lights", RenderPass::Type::COMPUTE);
+        cullLights.setDebugGroup("culling");
+
+        cullLights.addUniformBufferRead(globalIndex, vk::PipelineStage::COMPUTE_SHADER);
+        cullLights.addStorageBufferRead(lightMasksIndex, vk::PipelineStage::COMPUTE_SHADER);
+        cullLights.addStorageBufferWrite(lightIndexAllocatorIndex, vk::PipelineStage::COMPUTE_SHADER);
+        cullLights.addStorageBufferWrite(lightGridIndex, vk::PipelineStage::COMPUTE_SHADER);
+        cullLights.addStorageBufferWrite(lightIndicesIndex, vk::PipelineStage::COMPUTE_SHADER);
+        cullLights.addStorageBufferWrite(feedbackBufferIndex, vk::PipelineStage::COMPUTE_SHADER);
+
+        cullLights.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph& graph) {
+            auto global = graph.getBuffer(globalIndex);
+            auto lightMasks = graph.getBuffer(lightMasksIndex);
+            auto lightIndexAllocator = graph.getBuffer(lightIndexAllocatorIndex);
+            auto lightGrid = graph.getBuffer(lightGridIndex);
+            auto lightIndices = graph.getBuffer(lightIndicesIndex);
+            _culledLightGrid = lightGrid;
+            _culledLightIndices = lightIndices;
+            _culledLightsSize = renderSize;
+            _culledLightsCamera = scene.getMainCameraIndex();
+            cmd->clearDescriptors();
+            cmd->bindProgram(_engine->getProgram(Engine::ProgramType::CULL_LIGHTS));
+            cmd->bindBindings({});
+            cmd->bindAttributes({});
+            struct CullPush {
+                u64 lightGridBuffer;
+                u64 lightIndicesBuffer;
+                u32 maskWords;
+                u32 indexCapacity;
             } push;
-            push.inverseProjection = camera->projection().inverse();
-            push.tileSizes = { 16, 9, 24, (u32)std::ceil((f32)_swapchain->extent().width / (f32)16.f) };
-            push.screenSize = { _swapchain->extent().width, _swapchain->extent().height };
-            push.near = camera->near();
-            push.far = camera->far();
+            push.lightGridBuffer = lightGrid->address();
+            push.lightIndicesBuffer = lightIndices->address();
+            push.maskWords = lightMaskWords;
+            push.indexCapacity = lightIndices->size() / sizeof(u32);
 
             cmd->pushConstants(vk::ShaderStage::COMPUTE, push);
-            cmd->bindBuffer(1, 0, clusters, true);
+            cmd->bindBuffer(1, 0, global);
+            cmd->bindBuffer(1, 1, lightMasks, true);
+            cmd->bindBuffer(1, 2, lightIndexAllocator, true);
             cmd->bindPipeline();
             cmd->bindDescriptors();
-            cmd->dispatchWorkgroups(16, 9, 24);
+            cmd->dispatchWorkgroups(clusterCount, 1, 1);
         });
-        camera->setDirty(false);
     }
 
-    BufferResource lightGridResource;
-    lightGridResource.size = sizeof(u32) * 2 * 16 * 9 * 24;
-    auto lightGridIndex = _graph.addBufferResource("lightGrid", lightGridResource);
-
-    BufferResource lightIndicesResource;
-    lightIndicesResource.size = sizeof(u32) * 16 * 9 * 24 * 100;
-    auto lightIndicesIndex = _graph.addBufferResource("lightIndices", lightIndicesResource);
-
-    BufferResource lightGlobalIndexResource;
-    lightGlobalIndexResource.size = sizeof(u32);
-    auto lightGlobalResource = _graph.addBufferResource("lightGlobalResource", lightGlobalIndexResource);
-
-    auto& cullLights = _graph.addPass("cull_lights", RenderPass::Type::COMPUTE);
-    cullLights.setDebugGroup("culling");
-
-    cullLights.addUniformBufferRead("global", vk::PipelineStage::COMPUTE_SHADER);
-    cullLights.addStorageBufferRead("clusters", vk::PipelineStage::COMPUTE_SHADER);
-    cullLights.addStorageBufferWrite("lightGrid", vk::PipelineStage::COMPUTE_SHADER);
-    cullLights.addStorageBufferWrite("lightIndices", vk::PipelineStage::COMPUTE_SHADER);
-    cullLights.addStorageBufferRead("lights", vk::PipelineStage::COMPUTE_SHADER);
-    cullLights.addStorageBufferWrite("lightGlobalResource", vk::PipelineStage::COMPUTE_SHADER);
-    cullLights.addStorageBufferRead("camera", vk::PipelineStage::COMPUTE_SHADER);
-
-    cullLights.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph& graph) {
-        auto global = graph.getBuffer("global");
-        auto clusters = graph.getBuffer("clusters");
-        auto lightGrid = graph.getBuffer("lightGrid");
-        auto lightIndices = graph.getBuffer("lightIndices");
-        auto lightGlobalIndex = graph.getBuffer("lightGlobalResource");
-        cmd->clearDescriptors();
-        cmd->bindProgram(_engine->getProgram(Engine::ProgramType::CULL_LIGHTS));
-        cmd->bindBindings({});
-        cmd->bindAttributes({});
-        struct ClusterPush {
-            ende::math::Mat4f inverseProjection;
-            f32 near;
-            f32 far;
-            u64 lightGridBuffer;
-            u64 lightIndicesBuffer;
-        } push;
-        push.inverseProjection = camera->projection().inverse();
-        push.near = camera->near();
-        push.far = camera->far();
-        push.lightGridBuffer = lightGrid->address();
-        push.lightIndicesBuffer = lightIndices->address();
-
-        cmd->pushConstants(vk::ShaderStage::COMPUTE, push);
-        cmd->bindBuffer(1, 0, global);
-        cmd->bindBuffer(1, 1, clusters, true);
-        cmd->bindBuffer(1, 2, lightGlobalIndex, true);
-//        cmd->bindBuffer(1, 3, scene._lightCountBuffer[_engine->device().frameIndex()], true);
-        cmd->bindPipeline();
-        cmd->bindDescriptors();
-        cmd->dispatchWorkgroups(1, 1, 6);
-    });
-
     if (_renderSettings.debugClusters) {
         debugClusters(_graph, *_engine, *_swapchain, {
             .backbufferDebug = {},
@@ -344,10 +576,11 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
             .visbility = visibilityImageIndex,
             .global = globalIndex,
             .materialCount = materialCountBufferIndex,
-            .pixelPositions = pixelPositionsImageIndex,
+            .materialTiles = materialTilesImageIndex,
             .dispatchBuffer = visibilityDispatchBufferIndex,
             .camera = cameraBufferIndex,
             .meshData = meshDataIndex,
+            .instances = instancesIndex,
             .transforms = transformsIndex,
             .vertexBuffer = vertexBufferIndex,
             .indexBuffer = indexBufferIndex
@@ -361,10 +594,11 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
             .visbility = visibilityImageIndex,
             .global = globalIndex,
             .materialCount = materialCountBufferIndex,
-            .pixelPositions = pixelPositionsImageIndex,
+            .materialTiles = materialTilesImageIndex,
             .dispatchBuffer = visibilityDispatchBufferIndex,
             .camera = cameraBufferIndex,
             .meshData = meshDataIndex,
+            .instances = instancesIndex,
             .transforms = transformsIndex,
             .vertexBuffer = vertexBufferIndex,
             .indexBuffer = indexBufferIndex
@@ -378,10 +612,11 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
             .visbility = visibilityImageIndex,
             .global = globalIndex,
             .materialCount = materialCountBufferIndex,
-            .pixelPositions = pixelPositionsImageIndex,
+            .materialTiles = materialTilesImageIndex,
             .dispatchBuffer = visibilityDispatchBufferIndex,
             .camera = cameraBufferIndex,
             .meshData = meshDataIndex,
+            .instances = instancesIndex,
             .transforms = transformsIndex,
             .vertexBuffer = vertexBufferIndex,
             .indexBuffer = indexBufferIndex
@@ -395,10 +630,11 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
             .visbility = visibilityImageIndex,
             .global = globalIndex,
             .materialCount = materialCountBufferIndex,
-            .pixelPositions = pixelPositionsImageIndex,
+            .materialTiles = materialTilesImageIndex,
             .dispatchBuffer = visibilityDispatchBufferIndex,
             .camera = cameraBufferIndex,
             .meshData = meshDataIndex,
+            .instances = instancesIndex,
             .transforms = transformsIndex,
             .vertexBuffer = vertexBufferIndex,
             .indexBuffer = indexBufferIndex
@@ -412,10 +648,11 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
             .visbility = visibilityImageIndex,
             .global = globalIndex,
             .materialCount = materialCountBufferIndex,
-            .pixelPositions = pixelPositionsImageIndex,
+            .materialTiles = materialTilesImageIndex,
             .dispatchBuffer = visibilityDispatchBufferIndex,
             .camera = cameraBufferIndex,
             .meshData = meshDataIndex,
+            .instances = instancesIndex,
             .transforms = transformsIndex,
             .vertexBuffer = vertexBufferIndex,
             .indexBuffer = indexBufferIndex
@@ -429,6 +666,7 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
             .global = globalIndex,
             .camera = cameraBufferIndex,
             .meshData = meshDataIndex,
+            .instances = instancesIndex,
             .transforms = transformsIndex,
             .vertexBuffer = vertexBufferIndex,
             .indexBuffer = indexBufferIndex
@@ -473,7 +711,7 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
     }
 
 
-    shadowPoint(_graph, *_engine, scene);
+    shadowPoint(_graph, *_engine, scene, _shadowDrawCommandCapacity);
 
 
 
@@ -483,6 +721,7 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
     cullPass.addUniformBufferRead(globalIndex, vk::PipelineStage::COMPUTE_SHADER);
     cullPass.addStorageBufferRead(transformsIndex, vk::PipelineStage::COMPUTE_SHADER);
     cullPass.addStorageBufferRead(meshDataIndex, vk::PipelineStage::COMPUTE_SHADER);
+    cullPass.addStorageBufferRead(instancesIndex, vk::PipelineStage::COMPUTE_SHADER);
     cullPass.addStorageBufferWrite(drawCountIndex, vk::PipelineStage::COMPUTE_SHADER);
     cullPass.addStorageBufferWrite(drawCommandsIndex, vk::PipelineStage::COMPUTE_SHADER);
     cullPass.addStorageBufferRead(cameraBufferIndex, vk::PipelineStage::COMPUTE_SHADER);
@@ -494,6 +733,13 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
         auto global = graph.getBuffer(globalIndex);
         auto drawCount = graph.getBuffer(drawCountIndex);
         auto drawCommands = graph.getBuffer(drawCommandsIndex);
+
+        // workgroups of every instance append to the count so it is cleared before any of them start
+        cmd->clearBuffer(drawCount);
+        auto barrier = drawCount->barrier(vk::PipelineStage::TRANSFER, vk::PipelineStage::COMPUTE_SHADER,
+                                          vk::Access::TRANSFER_WRITE, vk::Access::SHADER_READ | vk::Access::SHADER_WRITE);
+        cmd->pipelineBarrier({ &barrier, 1 });
+
         cmd->clearDescriptors();
         cmd->bindProgram(_engine->getProgram(Engine::ProgramType::CULL_MESH_SHADER));
         cmd->bindBindings({});
@@ -503,7 +749,11 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
         cmd->bindBuffer(2, 1, drawCount, true);
         cmd->bindPipeline();
         cmd->bindDescriptors();
-        cmd->dispatch(scene.meshCount(), 1, 1);
+
+        // a workgroup traverses the meshlet hierarchy of each instance, wrapped into y past the dispatch limit
+        constexpr u32 maxWorkgroups = 65535;
+        u32 instanceCount = scene.instanceCount();
+        cmd->dispatchWorkgroups(std::min(instanceCount, maxWorkgroups), (instanceCount + maxWorkgroups - 1) / maxWorkgroups, 1);
     });
 
     {
@@ -516,12 +766,15 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
         visibilityPass.addStorageBufferRead(drawCommandsIndex, vk::PipelineStage::TASK_SHADER);
         visibilityPass.addIndirectRead(drawCountIndex);
         visibilityPass.addStorageBufferRead(meshDataIndex, vk::PipelineStage::TASK_SHADER | vk::PipelineStage::MESH_SHADER);
+        visibilityPass.addStorageBufferRead(instancesIndex, vk::PipelineStage::TASK_SHADER | vk::PipelineStage::MESH_SHADER);
 //        visibilityPass.addStorageBufferRead("meshlets", vk::PipelineStage::TASK_SHADER | vk::PipelineStage::MESH_SHADER);
         visibilityPass.addStorageBufferRead(transformsIndex, vk::PipelineStage::TASK_SHADER | vk::PipelineStage::MESH_SHADER);
         visibilityPass.addStorageBufferRead(vertexBufferIndex, vk::PipelineStage::TASK_SHADER | vk::PipelineStage::MESH_SHADER);
         visibilityPass.addStorageBufferRead(indexBufferIndex, vk::PipelineStage::TASK_SHADER | vk::PipelineStage::MESH_SHADER);
 
         visibilityPass.addStorageBufferWrite(feedbackBufferIndex, vk::PipelineStage::TASK_SHADER | vk::PipelineStage::MESH_SHADER);
+        if (_renderSettings.occlusionCulling)
+            visibilityPass.addSampledImageRead("depthPyramidHistory", vk::PipelineStage::TASK_SHADER);
 
         visibilityPass.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph& graph) {
             auto global = graph.getBuffer(globalIndex);
@@ -529,7 +782,7 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
             auto drawCount = graph.getBuffer(drawCountIndex);
 
             cmd->clearDescriptors();
-            if (scene.meshCount() == 0)
+            if (scene.instanceCount() == 0)
                 return;
 
             cmd->bindBuffer(1, 0, global);
@@ -537,6 +790,21 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
 
             cmd->bindProgram(_engine->getProgram(Engine::ProgramType::VISIBILITY));
 
+            struct Push {
+                ende::math::Mat4f occlusionViewProjection;
+                ende::math::Vec<2, u32> depthPyramidSize;
+                i32 depthPyramidIndex;
+                u32 depthPyramidLevels;
+            } push;
+            push.occlusionViewProjection = _depthPyramidViewProjection;
+            push.depthPyramidSize = { depthPyramidResource.width, depthPyramidResource.height };
+            push.depthPyramidIndex = -1;
+            push.depthPyramidLevels = depthPyramidResource.mipLevels;
+            // last frame's pyramid is only usable if the graph hasn't reallocated it since
+            if (_renderSettings.occlusionCulling && _depthPyramidValid)
+                push.depthPyramidIndex = _depthPyramid.index();
+            cmd->pushConstants(vk::ShaderStage::TASK, push);
+
             cmd->bindRasterState({ .cullMode = vk::CullMode::BACK });
             cmd->bindDepthState({ true, true, vk::CompareOp::LESS });
 
@@ -546,6 +814,56 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
             cmd->drawMeshTasksIndirectCount(drawCommands, 0, drawCount, 0, sizeof(MeshTaskCommand));
         });
 
+        if (_renderSettings.occlusionCulling) {
+            auto& depthPyramidPass = _graph.addPass("depth_pyramid", RenderPass::Type::COMPUTE);
+            depthPyramidPass.setDebugGroup("culling");
+
+            depthPyramidPass.addUniformBufferRead(globalIndex, vk::PipelineStage::COMPUTE_SHADER);
+            depthPyramidPass.addSampledImageRead(depthIndex, vk::PipelineStage::COMPUTE_SHADER);
+            depthPyramidPass.addStorageImageWrite("depthPyramid", vk::PipelineStage::COMPUTE_SHADER);
+
+            depthPyramidPass.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph& graph) {
+                auto global = graph.getBuffer(globalIndex);
+                auto depth = graph.getImage(depthIndex);
+                auto pyramid = graph.getImage("depthPyramid");
+
+                cmd->clearDescriptors();
+                cmd->bindProgram(_engine->getProgram(Engine::ProgramType::DEPTH_PYRAMID));
+                cmd->bindBuffer(1, 0, global);
+
+                for (u32 mip = 0; mip < pyramid->mips(); mip++) {
+                    struct Push {
+                        ende::math::Vec<2, u32> inputSize;
+                        i32 depthIndex;
+                        u32 level;
+                    } push;
+                    push.inputSize = mip == 0
+                            ? ende::math::Vec<2, u32>{ depth->width(), depth->height() }
+                            : ende::math::Vec<2, u32>{ std::max(pyramid->width() >> (mip - 1), 1u), std::max(pyramid->height() >> (mip - 1), 1u) };
+                    push.depthIndex = depth.index();
+                    push.level = mip;
+                    cmd->pushConstants(vk::ShaderStage::COMPUTE, push);
+
+                    // the first level has no previous level so binds its own view as the unused input
+                    cmd->bindImage(1, 1, _depthPyramidViews[mip == 0 ? 0 : mip - 1]);
+                    cmd->bindImage(1, 2, _depthPyramidViews[mip]);
+                    cmd->bindPipeline();
+                    cmd->bindDescriptors();
+                    cmd->dispatch(std::max(pyramid->width() >> mip, 1u), std::max(pyramid->height() >> mip, 1u), 1);
+
+                    if (mip + 1 < pyramid->mips()) {
+                        auto barrier = pyramid->barrier(vk::PipelineStage::COMPUTE_SHADER, vk::PipelineStage::COMPUTE_SHADER, vk::Access::SHADER_WRITE, vk::Access::SHADER_READ, vk::ImageLayout::GENERAL, vk::ImageLayout::GENERAL);
+                        barrier.subresourceRange.baseMipLevel = mip;
+                        barrier.subresourceRange.levelCount = 1;
+                        cmd->pipelineBarrier({ &barrier, 1 });
+                    }
+                }
+
+                _depthPyramidViewProjection = camera->viewProjection();
+                _depthPyramidValid = true;
+            });
+        }
+
 
         {
             auto &visibilityCountPass = _graph.addPass("visibility_count_pass", RenderPass::Type::COMPUTE);
@@ -553,8 +871,10 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
 
             visibilityCountPass.addUniformBufferRead(globalIndex, vk::PipelineStage::COMPUTE_SHADER);
             visibilityCountPass.addStorageBufferRead(meshDataIndex, vk::PipelineStage::COMPUTE_SHADER);
+            visibilityCountPass.addStorageBufferRead(instancesIndex, vk::PipelineStage::COMPUTE_SHADER);
             visibilityCountPass.addStorageBufferWrite(materialCountBufferIndex, vk::PipelineStage::COMPUTE_SHADER);
-            visibilityCountPass.addStorageImageWrite(pixelPositionsImageIndex, vk::PipelineStage::COMPUTE_SHADER);
+            visibilityCountPass.addStorageBufferWrite(tileMasksBufferIndex, vk::PipelineStage::COMPUTE_SHADER);
+            visibilityCountPass.addStorageImageWrite(materialTilesImageIndex, vk::PipelineStage::COMPUTE_SHADER);
             visibilityCountPass.addStorageBufferWrite(visibilityDispatchBufferIndex, vk::PipelineStage::COMPUTE_SHADER);
             visibilityCountPass.addStorageBufferWrite(feedbackBufferIndex, vk::PipelineStage::COMPUTE_SHADER);
 
@@ -562,19 +882,28 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
                 auto global = graph.getBuffer(globalIndex);
                 auto visibilityImage = graph.getImage(visibilityImageIndex);
                 auto materialCounts = graph.getBuffer(materialCountBufferIndex);
-                auto pixelPositions = graph.getImage(pixelPositionsImageIndex);
+                auto tileMasks = graph.getBuffer(tileMasksBufferIndex);
+                auto materialTiles = graph.getImage(materialTilesImageIndex);
                 auto dispatchCommands = graph.getBuffer(visibilityDispatchBufferIndex);
 
                 cmd->clearBuffer(materialCounts);
-                auto barrier = materialCounts->barrier(vk::PipelineStage::TRANSFER, vk::PipelineStage::COMPUTE_SHADER,
-                                                       vk::Access::TRANSFER_WRITE,
-                                                       vk::Access::SHADER_READ | vk::Access::SHADER_WRITE);
-                cmd->pipelineBarrier({&barrier, 1});
+                cmd->clearBuffer(tileMasks);
+                vk::Buffer::Barrier clearBarriers[] = {
+                    materialCounts->barrier(vk::PipelineStage::TRANSFER, vk::PipelineStage::COMPUTE_SHADER,
+                                            vk::Access::TRANSFER_WRITE,
+                                            vk::Access::SHADER_READ | vk::Access::SHADER_WRITE),
+                    tileMasks->barrier(vk::PipelineStage::TRANSFER, vk::PipelineStage::COMPUTE_SHADER,
+                                       vk::Access::TRANSFER_WRITE,
+                                       vk::Access::SHADER_READ | vk::Access::SHADER_WRITE)
+                };
+                cmd->pipelineBarrier(clearBarriers);
 
                 cmd->clearDescriptors();
 
+                // mark the materials covering each tile and count the tiles of each material
                 cmd->bindBuffer(1, 0, global);
                 cmd->bindBuffer(1, 1, materialCounts, true);
+                cmd->bindBuffer(1, 2, tileMasks, true);
                 cmd->bindProgram(_engine->getProgram(Engine::ProgramType::VISIBILITY_COUNT));
 
                 struct CountPush {
@@ -590,12 +919,13 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
 
                 cmd->dispatch(visibilityImage->width(), visibilityImage->height(), 1);
 
-                barrier = materialCounts->barrier(vk::PipelineStage::COMPUTE_SHADER, vk::PipelineStage::COMPUTE_SHADER,
-                                                  vk::Access::SHADER_READ | vk::Access::SHADER_WRITE,
-                                                  vk::Access::SHADER_READ | vk::Access::SHADER_WRITE);
+                auto barrier = materialCounts->barrier(vk::PipelineStage::COMPUTE_SHADER, vk::PipelineStage::COMPUTE_SHADER,
+                                                       vk::Access::SHADER_READ | vk::Access::SHADER_WRITE,
+                                                       vk::Access::SHADER_READ | vk::Access::SHADER_WRITE);
                 cmd->pipelineBarrier({&barrier, 1});
                 cmd->clearDescriptors();
 
+                // scan tile counts into offsets and write a dispatch per material
                 cmd->bindBuffer(1, 1, materialCounts, true);
                 cmd->bindBuffer(1, 2, dispatchCommands, true);
                 cmd->bindProgram(_engine->getProgram(Engine::ProgramType::VISIBILITY_OFFSET));
@@ -609,34 +939,187 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
                 cmd->bindPipeline();
                 cmd->bindDescriptors();
 
-                cmd->dispatchWorkgroups(1, 1, 1);
+                cmd->dispatch(_engine->materialCount(), 1, 1);
 
-                barrier = materialCounts->barrier(vk::PipelineStage::COMPUTE_SHADER, vk::PipelineStage::COMPUTE_SHADER,
-                                                  vk::Access::SHADER_READ | vk::Access::SHADER_WRITE,
-                                                  vk::Access::SHADER_READ | vk::Access::SHADER_WRITE);
-                cmd->pipelineBarrier({&barrier, 1});
+                vk::Buffer::Barrier offsetBarriers[] = {
+                    materialCounts->barrier(vk::PipelineStage::COMPUTE_SHADER, vk::PipelineStage::COMPUTE_SHADER,
+                                            vk::Access::SHADER_READ | vk::Access::SHADER_WRITE,
+                                            vk::Access::SHADER_READ | vk::Access::SHADER_WRITE),
+                    tileMasks->barrier(vk::PipelineStage::COMPUTE_SHADER, vk::PipelineStage::COMPUTE_SHADER,
+                                       vk::Access::SHADER_READ | vk::Access::SHADER_WRITE,
+                                       vk::Access::SHADER_READ)
+                };
+                cmd->pipelineBarrier(offsetBarriers);
 
                 cmd->clearDescriptors();
 
-                cmd->bindBuffer(1, 0, global);
+                // list each tile under every material it covers
                 cmd->bindBuffer(1, 1, materialCounts, true);
-//                cmd->bindBuffer(1, 2, pixelPositions, true);
+                cmd->bindBuffer(1, 2, tileMasks, true);
                 cmd->bindProgram(_engine->getProgram(Engine::ProgramType::VISIBILITY_POSITION));
 
-                struct PixelPush {
-                    i32 visibilityImageIndex;
+                struct TilesPush {
                     u32 materialCount;
-                    i32 pixelPositionsIndex;
-                } pixelPush;
-                pixelPush.visibilityImageIndex = visibilityImage.index();
-                pixelPush.materialCount = _engine->materialCount();
-                pixelPush.pixelPositionsIndex = pixelPositions.index();
-                cmd->pushConstants(vk::ShaderStage::COMPUTE, pixelPush);
+                    u32 tilesX;
+                    u32 tileCount;
+                    i32 materialTilesIndex;
+                } tilesPush;
+                tilesPush.materialCount = _engine->materialCount();
+                tilesPush.tilesX = tilesX;
+                tilesPush.tileCount = tilesX * tilesY;
+                tilesPush.materialTilesIndex = materialTiles.index();
+                cmd->pushConstants(vk::ShaderStage::COMPUTE, tilesPush);
 
                 cmd->bindPipeline();
                 cmd->bindDescriptors();
 
-                cmd->dispatch(visibilityImage->width(), visibilityImage->height(), 1);
+                cmd->dispatch(tilesX * tilesY, 1, 1);
+            });
+        }
+
+        if (variableRate) {
+            auto& shadingRatePass = _graph.addPass("shading_rate", RenderPass::Type::COMPUTE);
+
+            shadingRatePass.addStorageImageRead(visibilityImageIndex, vk::PipelineStage::COMPUTE_SHADER);
+            shadingRatePass.addSampledImageRead(depthIndex, vk::PipelineStage::COMPUTE_SHADER);
+            shadingRatePass.addSampledImageRead("hdrHistory", vk::PipelineStage::COMPUTE_SHADER);
+            shadingRatePass.addUniformBufferRead(globalIndex, vk::PipelineStage::COMPUTE_SHADER);
+            shadingRatePass.addStorageBufferRead(cameraBufferIndex, vk::PipelineStage::COMPUTE_SHADER);
+            shadingRatePass.addStorageBufferWrite(shadingRatesIndex, vk::PipelineStage::COMPUTE_SHADER);
+            shadingRatePass.addStorageBufferWrite(feedbackBufferIndex, vk::PipelineStage::COMPUTE_SHADER);
+
+            shadingRatePass.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph& graph) {
+                auto global = graph.getBuffer(globalIndex);
+                auto visibilityImage = graph.getImage(visibilityImageIndex);
+                auto depth = graph.getImage(depthIndex);
+                auto hdr = graph.getImage(hdrImageIndex);
+                auto shadingRates = graph.getBuffer(shadingRatesIndex);
+
+                cmd->clearDescriptors();
+                cmd->bindProgram(_engine->getProgram(Engine::ProgramType::SHADING_RATE));
+                cmd->bindBindings({});
+                cmd->bindAttributes({});
+                cmd->bindBuffer(1, 0, global);
+                cmd->bindBuffer(1, 1, shadingRates, true);
+
+                struct ShadingRatePush {
+                    ende::math::Mat4f historyViewProjection;
+                    ende::math::Vec<2, f32> historyJitter;
+                    i32 visibilityImageIndex;
+                    i32 depthIndex;
+                    i32 historyIndex;
+                    u32 tilesX;
+                    f32 varianceThreshold;
+                    f32 depthThreshold;
+                } push;
+                push.historyViewProjection = _hdrHistoryViewProjection;
+                push.historyJitter = _hdrHistoryJitter;
+                push.visibilityImageIndex = visibilityImage.index();
+                push.depthIndex = depth.index();
+                // a recreated image holds nothing from last frame, tiles are shaded fully until it does
+                push.historyIndex = hdr == _hdrHistory ? hdr.index() : -1;
+                push.tilesX = tilesX;
+                push.varianceThreshold = _renderSettings.shadingRateThreshold;
+                push.depthThreshold = _renderSettings.shadingRateDepthThreshold;
+                cmd->pushConstants(vk::ShaderStage::COMPUTE, push);
+
+                cmd->bindPipeline();
+                cmd->bindDescriptors();
+                cmd->dispatchWorkgroups(tilesX, tilesY, 1);
+            });
+        }
+
+        if (probeGI) {
+            auto& probeUpdatePass = _graph.addPass("probe_update", RenderPass::Type::COMPUTE);
+
+            probeUpdatePass.addSampledImageRead(depthIndex, vk::PipelineStage::COMPUTE_SHADER);
+            probeUpdatePass.addSampledImageRead("hdrHistory", vk::PipelineStage::COMPUTE_SHADER);
+            probeUpdatePass.addUniformBufferRead(globalIndex, vk::PipelineStage::COMPUTE_SHADER);
+            probeUpdatePass.addStorageBufferRead(cameraBufferIndex, vk::PipelineStage::COMPUTE_SHADER);
+            probeUpdatePass.addStorageBufferWrite(probesIndex, vk::PipelineStage::COMPUTE_SHADER);
+
+            probeUpdatePass.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph& graph) {
+                auto global = graph.getBuffer(globalIndex);
+                auto depth = graph.getImage(depthIndex);
+                auto hdr = graph.getImage(hdrImageIndex);
+                auto probes = graph.getBuffer(probesIndex);
+
+                if (!_probeGridValid || !(probes == _probeBuffer)) {
+                    cmd->clearBuffer(probes);
+                    auto barrier = probes->barrier(vk::PipelineStage::TRANSFER, vk::PipelineStage::COMPUTE_SHADER,
+                                                   vk::Access::TRANSFER_WRITE,
+                                                   vk::Access::SHADER_READ | vk::Access::SHADER_WRITE);
+                    cmd->pipelineBarrier({ &barrier, 1 });
+                    _probeBuffer = probes;
+                    _probeGridValid = true;
+                    _probeCursor = 0;
+                }
+
+                // a recreated hdr image holds no lighting to trace against yet
+                if (!(hdr == _hdrHistory))
+                    return;
+
+                // only probes within the bounds of the camera frustum can be traced, so the budget is spent there
+                ende::math::Vec3f frustumMin = { std::numeric_limits<f32>::max(), std::numeric_limits<f32>::max(), std::numeric_limits<f32>::max() };
+                ende::math::Vec3f frustumMax = { std::numeric_limits<f32>::lowest(), std::numeric_limits<f32>::lowest(), std::numeric_limits<f32>::lowest() };
+                for (auto& corner : camera->getFrustumCorners()) {
+                    frustumMin = { std::min(frustumMin.x(), corner.x()), std::min(frustumMin.y(), corner.y()), std::min(frustumMin.z(), corner.z()) };
+                    frustumMax = { std::max(frustumMax.x(), corner.x()), std::max(frustumMax.y(), corner.y()), std::max(frustumMax.z(), corner.z()) };
+                }
+                ende::math::Vec<3, u32> regionOffset = { 0, 0, 0 };
+                ende::math::Vec<3, u32> regionSize = { 0, 0, 0 };
+                for (u32 axis = 0; axis < 3; axis++) {
+                    f32 spacing = _globalData.probeGridSpacing[axis];
+                    f32 first = std::floor((frustumMin[axis] - _globalData.probeGridOrigin[axis]) / spacing);
+                    f32 last = std::ceil((frustumMax[axis] - _globalData.probeGridOrigin[axis]) / spacing);
+                    first = std::clamp(first, 0.f, static_cast<f32>(_probeGridSize[axis]));
+                    last = std::clamp(last + 1, 0.f, static_cast<f32>(_probeGridSize[axis]));
+                    regionOffset[axis] = static_cast<u32>(first);
+                    regionSize[axis] = static_cast<u32>(std::max(last - first, 0.f));
+                }
+                u32 regionCount = regionSize.x() * regionSize.y() * regionSize.z();
+                u32 updates = std::min(static_cast<u32>(std::max(_renderSettings.probeUpdateBudget, 0)), regionCount);
+                if (updates == 0)
+                    return;
+
+                cmd->clearDescriptors();
+                cmd->bindProgram(_engine->getProgram(Engine::ProgramType::PROBE_UPDATE));
+                cmd->bindBindings({});
+                cmd->bindAttributes({});
+                cmd->bindBuffer(1, 0, global);
+
+                struct ProbeUpdatePush {
+                    ende::math::Vec4f rotation;
+                    ende::math::Vec<4, u32> regionOffset;
+                    ende::math::Vec<4, u32> regionSize;
+                    i32 depthIndex;
+                    i32 historyIndex;
+                    f32 hysteresis;
+                    f32 thickness;
+                } push;
+                // uniformly random rotation so each update traces a different set of directions
+                f32 u1 = _randomDistribution(_randomGenerator);
+                f32 u2 = _randomDistribution(_randomGenerator) * 2 * std::numbers::pi;
+                f32 u3 = _randomDistribution(_randomGenerator) * 2 * std::numbers::pi;
+                push.rotation = {
+                    std::sqrt(1 - u1) * std::sin(u2),
+                    std::sqrt(1 - u1) * std::cos(u2),
+                    std::sqrt(u1) * std::sin(u3),
+                    std::sqrt(u1) * std::cos(u3)
+                };
+                push.regionOffset = { regionOffset.x(), regionOffset.y(), regionOffset.z(), _probeCursor % regionCount };
+                push.regionSize = { regionSize.x(), regionSize.y(), regionSize.z(), regionCount };
+                push.depthIndex = depth.index();
+                push.historyIndex = hdr.index();
+                push.hysteresis = _renderSettings.probeHysteresis;
+                push.thickness = std::max({ _globalData.probeGridSpacing.x(), _globalData.probeGridSpacing.y(), _globalData.probeGridSpacing.z() });
+                cmd->pushConstants(vk::ShaderStage::COMPUTE, push);
+
+                cmd->bindPipeline();
+                cmd->bindDescriptors();
+                cmd->dispatchWorkgroups(updates, 1, 1);
+
+                _probeCursor = (_probeCursor % regionCount + updates) % regionCount;
             });
         }
 
@@ -652,20 +1135,26 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
             visibilityMaterialPass.addStorageImageRead(visibilityImageIndex, vk::PipelineStage::COMPUTE_SHADER);
             visibilityMaterialPass.addSampledImageRead(depthIndex, vk::PipelineStage::COMPUTE_SHADER);
 
-            visibilityMaterialPass.addSampledImageRead("pointDepth", vk::PipelineStage::COMPUTE_SHADER);
+            visibilityMaterialPass.addSampledImageRead("shadowAtlas", vk::PipelineStage::COMPUTE_SHADER);
 
             visibilityMaterialPass.addUniformBufferRead(globalIndex, vk::PipelineStage::COMPUTE_SHADER);
             visibilityMaterialPass.addStorageBufferRead(vertexBufferIndex, vk::PipelineStage::COMPUTE_SHADER);
             visibilityMaterialPass.addStorageBufferRead(indexBufferIndex, vk::PipelineStage::COMPUTE_SHADER);
             visibilityMaterialPass.addStorageBufferRead(meshDataIndex, vk::PipelineStage::COMPUTE_SHADER);
+            visibilityMaterialPass.addStorageBufferRead(instancesIndex, vk::PipelineStage::COMPUTE_SHADER);
             visibilityMaterialPass.addStorageBufferRead(transformsIndex, vk::PipelineStage::COMPUTE_SHADER);
             visibilityMaterialPass.addStorageBufferRead(lightIndicesIndex, vk::PipelineStage::COMPUTE_SHADER);
             visibilityMaterialPass.addStorageBufferRead(lightGridIndex, vk::PipelineStage::COMPUTE_SHADER);
             visibilityMaterialPass.addStorageBufferRead(lightBufferIndex, vk::PipelineStage::COMPUTE_SHADER);
             visibilityMaterialPass.addStorageBufferRead(cameraBufferIndex, vk::PipelineStage::COMPUTE_SHADER);
+            visibilityMaterialPass.addStorageBufferWrite(mipFeedbackBufferIndex, vk::PipelineStage::COMPUTE_SHADER);
 
-            visibilityMaterialPass.addStorageImageRead(pixelPositionsImageIndex, vk::PipelineStage::COMPUTE_SHADER);
+            visibilityMaterialPass.addStorageImageRead(materialTilesImageIndex, vk::PipelineStage::COMPUTE_SHADER);
             visibilityMaterialPass.addIndirectRead(visibilityDispatchBufferIndex);
+            if (variableRate)
+                visibilityMaterialPass.addStorageBufferRead(shadingRatesIndex, vk::PipelineStage::COMPUTE_SHADER);
+            if (probeGI)
+                visibilityMaterialPass.addStorageBufferRead(probesIndex, vk::PipelineStage::COMPUTE_SHADER);
 
             visibilityMaterialPass.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph& graph) {
                 auto global = graph.getBuffer(globalIndex);
@@ -677,7 +1166,7 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
                     image = graph.getImage(backbufferIndex);
                 auto depth = graph.getImage(depthIndex);
                 auto materialCounts = graph.getBuffer(materialCountBufferIndex);
-                auto pixelPositions = graph.getImage(pixelPositionsImageIndex);
+                auto materialTiles = graph.getImage(materialTilesImageIndex);
                 auto dispatchCommands = graph.getBuffer(visibilityDispatchBufferIndex);
 
                 cmd->clearImage(image);
@@ -690,11 +1179,12 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
                 cmd->clearDescriptors();
                 cmd->bindBuffer(1, 0, global);
                 cmd->bindBuffer(1, 1, materialCounts, true);
-//                cmd->bindBuffer(1, 2, pixelPositions, true);
 
                 for (u32 i = 0; i < _engine->materialCount(); i++) {
                     Material* material = &_engine->_materials[i];
-                    if (!material)
+                    // materials without instances can't cover a tile so aren't bound at all, the rest get an empty
+                    // dispatch when none of their tiles are on screen
+                    if (!material || !scene.materialInUse(i))
                         continue;
                     cmd->bindProgram(material->getVariant(Material::Variant::LIT));
 
@@ -705,13 +1195,17 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
                         i32 backbufferIndex;
                         i32 depthIndex;
                         u32 materialIndex;
-                        i32 pixelPositionsIndex;
+                        i32 materialTilesIndex;
+                        u32 tilesX;
+                        u64 shadingRatesBuffer;
                     } push;
                     push.visibilityImageIndex = visibilityImage.index();
                     push.backbufferIndex = image.index();
                     push.depthIndex = depth.index();
                     push.materialIndex = i;
-                    push.pixelPositionsIndex = pixelPositions.index();
+                    push.materialTilesIndex = materialTiles.index();
+                    push.tilesX = variableRate ? tilesX : 0;
+                    push.shadingRatesBuffer = variableRate ? graph.getBuffer(shadingRatesIndex)->address() : 0;
 
                     cmd->pushConstants(vk::ShaderStage::COMPUTE, push);
 
@@ -721,216 +1215,362 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
                     u32 dispatchOffset = i * sizeof(DispatchCommand);
                     cmd->dispatchIndirect(dispatchCommands, dispatchOffset);
                 }
-
             });
         }
     }
 
     if (_renderSettings.bloom && !fullscreenDebug) {
-        {
-            /*
-                TODO: need better way to handle mip maps and binding them etc
-                might need to allocate ranges of indices in bindless table for
-                mip maps
-            */
-            ImageResource bloomDownsampleImage;
-            bloomDownsampleImage.matchSwapchain = false;
-            bloomDownsampleImage.format = vk::Format::RGBA32_SFLOAT;
-            bloomDownsampleImage.width = _swapchain->extent().width / 2;
-            bloomDownsampleImage.height = _swapchain->extent().height / 2;
-            _graph.addImageResource("bloomDownsample-0", bloomDownsampleImage);
-            bloomDownsampleImage.width = bloomDownsampleImage.width / 2;
-            bloomDownsampleImage.height = bloomDownsampleImage.height / 2;
-            _graph.addImageResource("bloomDownsample-1", bloomDownsampleImage);
-            bloomDownsampleImage.width = bloomDownsampleImage.width / 2;
-            bloomDownsampleImage.height = bloomDownsampleImage.height / 2;
-            _graph.addImageResource("bloomDownsample-2", bloomDownsampleImage);
-            bloomDownsampleImage.width = bloomDownsampleImage.width / 2;
-            bloomDownsampleImage.height = bloomDownsampleImage.height / 2;
-            _graph.addImageResource("bloomDownsample-3", bloomDownsampleImage);
-            bloomDownsampleImage.width = bloomDownsampleImage.width / 2;
-            bloomDownsampleImage.height = bloomDownsampleImage.height / 2;
-            _graph.addImageResource("bloomDownsample-4", bloomDownsampleImage);
-            bloomDownsampleImage.width = bloomDownsampleImage.width / 2;
-            bloomDownsampleImage.height = bloomDownsampleImage.height / 2;
-
-            ImageResource bloomUpsampleImage;
-            bloomUpsampleImage.matchSwapchain = false;
-            bloomUpsampleImage.format = vk::Format::RGBA32_SFLOAT;
-            bloomUpsampleImage.width = _swapchain->extent().width;
-            bloomUpsampleImage.height = _swapchain->extent().height;
-            _graph.addImageResource("bloomUpsample-0", bloomUpsampleImage);
-            bloomUpsampleImage.width = bloomUpsampleImage.width / 2;
-            bloomUpsampleImage.height = bloomUpsampleImage.height / 2;
-            _graph.addImageResource("bloomUpsample-1", bloomUpsampleImage);
-            bloomUpsampleImage.width = bloomUpsampleImage.width / 2;
-            bloomUpsampleImage.height = bloomUpsampleImage.height / 2;
-            _graph.addImageResource("bloomUpsample-2", bloomUpsampleImage);
-            bloomUpsampleImage.width = bloomUpsampleImage.width / 2;
-            bloomUpsampleImage.height = bloomUpsampleImage.height / 2;
-            _graph.addImageResource("bloomUpsample-3", bloomUpsampleImage);
-            bloomUpsampleImage.width = bloomUpsampleImage.width / 2;
-            bloomUpsampleImage.height = bloomUpsampleImage.height / 2;
-            _graph.addImageResource("bloomUpsample-4", bloomUpsampleImage); // downsample-4 -> upsample-4
-
-            ImageResource bloomFinalImage;
-            bloomFinalImage.format = vk::Format::RGBA32_SFLOAT;
-            _graph.addImageResource("bloomFinal", bloomFinalImage);
-        }
-
-
-        {
-            auto &bloomDownsamplePass = _graph.addPass("bloom-downsample", RenderPass::Type::COMPUTE);
-            bloomDownsamplePass.setDebugGroup("bloom");
-
-            bloomDownsamplePass.addUniformBufferRead("global", vk::PipelineStage::COMPUTE_SHADER);
-            bloomDownsamplePass.addSampledImageRead("hdr", vk::PipelineStage::COMPUTE_SHADER);
-            bloomDownsamplePass.addStorageImageWrite("bloomDownsample-0", vk::PipelineStage::COMPUTE_SHADER);
-            bloomDownsamplePass.addStorageImageWrite("bloomDownsample-1", vk::PipelineStage::COMPUTE_SHADER);
-            bloomDownsamplePass.addStorageImageWrite("bloomDownsample-2", vk::PipelineStage::COMPUTE_SHADER);
-            bloomDownsamplePass.addStorageImageWrite("bloomDownsample-3", vk::PipelineStage::COMPUTE_SHADER);
-            bloomDownsamplePass.addStorageImageWrite("bloomDownsample-4", vk::PipelineStage::COMPUTE_SHADER);
-
-            bloomDownsamplePass.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph &graph) {
-                auto global = graph.getBuffer("global");
-                auto hdrImage = graph.getImage("hdr");
-                vk::ImageHandle downsample[5] = {
-                        graph.getImage("bloomDownsample-0"),
-                        graph.getImage("bloomDownsample-1"),
-                        graph.getImage("bloomDownsample-2"),
-                        graph.getImage("bloomDownsample-3"),
-                        graph.getImage("bloomDownsample-4")
-                };
+        // composite only reads the full resolution upsample so either chain works
+        const char* bloomUpsampleLabel = _renderSettings.compactBloom ? "bloomUpsampleChain" : "bloomUpsample-0";
+        if (_renderSettings.compactBloom) {
+            {
+                // the downsample chain is rebuilt from hdr every frame so half floats are plenty. the upsample chain
+                // drops to 32 bits a texel when the device can write B10G11R11 from shaders
+                ImageResource bloomDownsampleImage;
+                bloomDownsampleImage.matchSwapchain = false;
+                bloomDownsampleImage.format = vk::Format::RGBA16_SFLOAT;
+                bloomDownsampleImage.width = renderSize.x() / 2;
+                bloomDownsampleImage.height = renderSize.y() / 2;
+                bloomDownsampleImage.mipLevels = 5;
+                _graph.addImageResource("bloomDownsampleChain", bloomDownsampleImage);
+
+                bool packedSupported = _engine->device().context().formatSupported(vk::Format::B10G11R11_UFLOAT,
+                        VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+                ImageResource bloomUpsampleImage;
+                bloomUpsampleImage.matchSwapchain = false;
+                bloomUpsampleImage.format = packedSupported ? vk::Format::B10G11R11_UFLOAT : vk::Format::RGBA16_SFLOAT;
+                bloomUpsampleImage.width = renderSize.x();
+                bloomUpsampleImage.height = renderSize.y();
+                bloomUpsampleImage.mipLevels = 5;
+                _graph.addImageResource("bloomUpsampleChain", bloomUpsampleImage);
+
+                ImageResource bloomFinalImage;
+                bloomFinalImage.format = vk::Format::RGBA32_SFLOAT;
+                bloomFinalImage.scaled = true;
+                _graph.addImageResource("bloomFinal", bloomFinalImage);
+            }
+            {
+                auto& bloomDownsamplePass = _graph.addPass("bloom-downsample", RenderPass::Type::COMPUTE);
+                bloomDownsamplePass.setDebugGroup("bloom");
+                bloomDownsamplePass.setParallelRecording(true);
 
-                cmd->clearDescriptors();
+                bloomDownsamplePass.addUniformBufferRead("global", vk::PipelineStage::COMPUTE_SHADER);
+                bloomDownsamplePass.addSampledImageRead("hdr", vk::PipelineStage::COMPUTE_SHADER);
+                bloomDownsamplePass.addStorageImageWrite("bloomDownsampleChain", vk::PipelineStage::COMPUTE_SHADER);
 
-                cmd->bindProgram(_engine->getProgram(Engine::ProgramType::BLOOM_DOWNSAMPLE));
-                cmd->bindBuffer(1, 0, global);
+                bloomDownsamplePass.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph& graph) {
+                    auto global = graph.getBuffer("global");
+                    auto hdrImage = graph.getImage("hdr");
+                    auto chain = graph.getImage("bloomDownsampleChain");
 
+                    cmd->clearDescriptors();
 
-                for (i32 mip = 0; mip < 5; mip++) {
-                    vk::ImageHandle inputImage;
-                    if (mip == 0)
-                        inputImage = hdrImage;
-                    else
-                        inputImage = downsample[mip - 1];
-                    vk::ImageHandle outputImage = downsample[mip];
+                    cmd->bindProgram(_engine->getProgram(Engine::ProgramType::BLOOM_DOWNSAMPLE_SPD));
+                    cmd->bindBuffer(1, 0, global);
+                    for (u32 mip = 0; mip < _bloomDownsampleViews.size(); mip++)
+                        cmd->bindImage(1, mip + 1, _bloomDownsampleViews[mip]);
 
                     struct Push {
                         i32 inputIndex;
-                        i32 outputIndex;
                         i32 bilinearSampler;
-                        i32 mipLevel;
                     } push;
-                    push.inputIndex = inputImage.index();
-                    push.outputIndex = outputImage.index();
+                    push.inputIndex = hdrImage.index();
                     push.bilinearSampler = _engine->device().getSampler({
                         .filter = VK_FILTER_LINEAR,
                         .addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE
                     }).index();
-                    push.mipLevel = mip;
                     cmd->pushConstants(vk::ShaderStage::COMPUTE, push);
 
                     cmd->bindPipeline();
                     cmd->bindDescriptors();
-                    cmd->dispatch(inputImage->width(), inputImage->height(), 1);
+                    // every workgroup reduces a 64x64 tile of the first mip through all five mips
+                    cmd->dispatchWorkgroups((chain->width() + 63) / 64, (chain->height() + 63) / 64, 1);
+                });
+            }
+            {
+                auto& bloomUpsamplePass = _graph.addPass("bloom-upsample", RenderPass::Type::COMPUTE);
+                bloomUpsamplePass.setDebugGroup("bloom");
+                bloomUpsamplePass.setParallelRecording(true);
 
-                    if (mip != 4) {
-                        auto outputBarrier = outputImage->barrier(vk::PipelineStage::COMPUTE_SHADER, vk::PipelineStage::COMPUTE_SHADER, vk::Access::SHADER_WRITE, vk::Access::SHADER_READ, vk::ImageLayout::SHADER_READ_ONLY);
-                        cmd->pipelineBarrier({ &outputBarrier, 1 });
-                    }
-                }
+                bloomUpsamplePass.addUniformBufferRead("global", vk::PipelineStage::COMPUTE_SHADER);
+                bloomUpsamplePass.addSampledImageRead("bloomDownsampleChain", vk::PipelineStage::COMPUTE_SHADER);
+                bloomUpsamplePass.addStorageImageWrite("bloomUpsampleChain", vk::PipelineStage::COMPUTE_SHADER);
 
-            });
-        }
-        {
-            auto& bloomUpsamplePass = _graph.addPass("bloom-upsample", RenderPass::Type::COMPUTE);
-            bloomUpsamplePass.setDebugGroup("bloom");
-
-            bloomUpsamplePass.addUniformBufferRead("global", vk::PipelineStage::COMPUTE_SHADER);
-
-            bloomUpsamplePass.addSampledImageRead("bloomDownsample-4", vk::PipelineStage::COMPUTE_SHADER);
-
-            bloomUpsamplePass.addStorageImageWrite("bloomUpsample-0", vk::PipelineStage::COMPUTE_SHADER);
-            bloomUpsamplePass.addStorageImageWrite("bloomUpsample-1", vk::PipelineStage::COMPUTE_SHADER);
-            bloomUpsamplePass.addStorageImageWrite("bloomUpsample-2", vk::PipelineStage::COMPUTE_SHADER);
-            bloomUpsamplePass.addStorageImageWrite("bloomUpsample-3", vk::PipelineStage::COMPUTE_SHADER);
-            bloomUpsamplePass.addStorageImageWrite("bloomUpsample-4", vk::PipelineStage::COMPUTE_SHADER);
-
-            bloomUpsamplePass.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph& graph) {
-                auto global = graph.getBuffer("global");
-                vk::ImageHandle downsample[5] = {
-                        graph.getImage("bloomDownsample-0"),
-                        graph.getImage("bloomDownsample-1"),
-                        graph.getImage("bloomDownsample-2"),
-                        graph.getImage("bloomDownsample-3"),
-                        graph.getImage("bloomDownsample-4")
-                };
-                vk::ImageHandle upsample[5] = {
-                        graph.getImage("bloomUpsample-0"),
-                        graph.getImage("bloomUpsample-1"),
-                        graph.getImage("bloomUpsample-2"),
-                        graph.getImage("bloomUpsample-3"),
-                        graph.getImage("bloomUpsample-4")
-                };
+                bloomUpsamplePass.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph& graph) {
+                    auto global = graph.getBuffer("global");
+                    auto downsample = graph.getImage("bloomDownsampleChain");
+                    auto upsample = graph.getImage("bloomUpsampleChain");
 
-                cmd->clearDescriptors();
+                    cmd->clearDescriptors();
 
-                cmd->bindProgram(_engine->getProgram(Engine::ProgramType::BLOOM_UPSAMPLE));
-                cmd->bindBuffer(1, 0, global);
+                    cmd->bindProgram(_engine->getProgram(Engine::ProgramType::BLOOM_UPSAMPLE_CHAIN));
+                    cmd->bindBuffer(1, 0, global);
 
-                for (i32 mip = 4; mip > -1; mip--) {
-                    vk::ImageHandle inputImage;
-                    vk::ImageHandle sumImage;
-                    if (mip == 4) {
-                        inputImage = downsample[4];
-                        sumImage = {};
-                    } else {
-                        inputImage = upsample[mip + 1];
-                        sumImage = downsample[mip];
+                    auto bilinearSampler = _engine->device().getSampler({
+                        .filter = VK_FILTER_LINEAR,
+                        .addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE
+                    });
+
+                    i32 lastMip = upsample->mips() - 1;
+                    for (i32 mip = lastMip; mip > -1; mip--) {
+                        struct Push {
+                            i32 inputIndex;
+                            i32 sumIndex;
+                            i32 bilinearSampler;
+                            f32 inputLod;
+                            f32 sumLod;
+                        } push;
+                        // the smallest upsample mip starts from the smallest downsample mip, the rest add the
+                        // downsample mip of their size to the upsample mip below
+                        if (mip == lastMip) {
+                            push.inputIndex = downsample.index();
+                            push.sumIndex = -1;
+                            push.inputLod = mip;
+                        } else {
+                            push.inputIndex = upsample.index();
+                            push.sumIndex = downsample.index();
+                            push.inputLod = mip + 1;
+                        }
+                        push.bilinearSampler = bilinearSampler.index();
+                        push.sumLod = mip;
+                        cmd->pushConstants(vk::ShaderStage::COMPUTE, push);
+
+                        cmd->bindImage(1, 1, _bloomUpsampleViews[mip]);
+                        cmd->bindPipeline();
+                        cmd->bindDescriptors();
+                        cmd->dispatch(std::max(upsample->width() >> mip, 1u), std::max(upsample->height() >> mip, 1u), 1);
+
+                        if (mip != 0) {
+                            auto outputBarrier = upsample->barrier(vk::PipelineStage::COMPUTE_SHADER, vk::PipelineStage::COMPUTE_SHADER, vk::Access::SHADER_WRITE, vk::Access::SHADER_READ, vk::ImageLayout::GENERAL, vk::ImageLayout::SHADER_READ_ONLY);
+                            outputBarrier.subresourceRange.baseMipLevel = mip;
+                            outputBarrier.subresourceRange.levelCount = 1;
+                            cmd->pipelineBarrier({ &outputBarrier, 1 });
+                        }
                     }
-                    vk::ImageHandle outputImage = upsample[mip];
 
-                    struct Push {
-                        i32 inputIndex;
-                        i32 sumIndex;
-                        i32 outputIndex;
-                        i32 bilinearSampler;
-                    } push;
-                    push.inputIndex = inputImage.index();
-                    push.sumIndex = sumImage.index();
-                    push.outputIndex = outputImage.index();
-                    push.bilinearSampler = _engine->device().getSampler({
+                    // the graph tracks the chain as a whole so the mips read along the way go back to general
+                    if (lastMip > 0) {
+                        auto layoutBarrier = upsample->barrier(vk::PipelineStage::COMPUTE_SHADER, vk::PipelineStage::COMPUTE_SHADER, vk::Access::SHADER_READ, vk::Access::SHADER_READ, vk::ImageLayout::SHADER_READ_ONLY, vk::ImageLayout::GENERAL);
+                        layoutBarrier.subresourceRange.baseMipLevel = 1;
+                        layoutBarrier.subresourceRange.levelCount = lastMip;
+                        cmd->pipelineBarrier({ &layoutBarrier, 1 });
+                    }
+                });
+            }
+        } else {
+            {
+                /*
+                    TODO: need better way to handle mip maps and binding them etc
+                    might need to allocate ranges of indices in bindless table for
+                    mip maps
+                */
+                ImageResource bloomDownsampleImage;
+                bloomDownsampleImage.matchSwapchain = false;
+                bloomDownsampleImage.format = vk::Format::RGBA32_SFLOAT;
+                bloomDownsampleImage.width = renderSize.x() / 2;
+                bloomDownsampleImage.height = renderSize.y() / 2;
+                _graph.addImageResource("bloomDownsample-0", bloomDownsampleImage);
+                bloomDownsampleImage.width = bloomDownsampleImage.width / 2;
+                bloomDownsampleImage.height = bloomDownsampleImage.height / 2;
+                _graph.addImageResource("bloomDownsample-1", bloomDownsampleImage);
+                bloomDownsampleImage.width = bloomDownsampleImage.width / 2;
+                bloomDownsampleImage.height = bloomDownsampleImage.height / 2;
+                _graph.addImageResource("bloomDownsample-2", bloomDownsampleImage);
+                bloomDownsampleImage.width = bloomDownsampleImage.width / 2;
+                bloomDownsampleImage.height = bloomDownsampleImage.height / 2;
+                _graph.addImageResource("bloomDownsample-3", bloomDownsampleImage);
+                bloomDownsampleImage.width = bloomDownsampleImage.width / 2;
+                bloomDownsampleImage.height = bloomDownsampleImage.height / 2;
+                _graph.addImageResource("bloomDownsample-4", bloomDownsampleImage);
+                bloomDownsampleImage.width = bloomDownsampleImage.width / 2;
+                bloomDownsampleImage.height = bloomDownsampleImage.height / 2;
+
+                ImageResource bloomUpsampleImage;
+                bloomUpsampleImage.matchSwapchain = false;
+                bloomUpsampleImage.format = vk::Format::RGBA32_SFLOAT;
+                bloomUpsampleImage.width = renderSize.x();
+                bloomUpsampleImage.height = renderSize.y();
+                _graph.addImageResource("bloomUpsample-0", bloomUpsampleImage);
+                bloomUpsampleImage.width = bloomUpsampleImage.width / 2;
+                bloomUpsampleImage.height = bloomUpsampleImage.height / 2;
+                _graph.addImageResource("bloomUpsample-1", bloomUpsampleImage);
+                bloomUpsampleImage.width = bloomUpsampleImage.width / 2;
+                bloomUpsampleImage.height = bloomUpsampleImage.height / 2;
+                _graph.addImageResource("bloomUpsample-2", bloomUpsampleImage);
+                bloomUpsampleImage.width = bloomUpsampleImage.width / 2;
+                bloomUpsampleImage.height = bloomUpsampleImage.height / 2;
+                _graph.addImageResource("bloomUpsample-3", bloomUpsampleImage);
+                bloomUpsampleImage.width = bloomUpsampleImage.width / 2;
+                bloomUpsampleImage.height = bloomUpsampleImage.height / 2;
+                _graph.addImageResource("bloomUpsample-4", bloomUpsampleImage); // downsample-4 -> upsample-4
+
+                ImageResource bloomFinalImage;
+                bloomFinalImage.format = vk::Format::RGBA32_SFLOAT;
+                bloomFinalImage.scaled = true;
+                _graph.addImageResource("bloomFinal", bloomFinalImage);
+            }
+
+
+            {
+                auto &bloomDownsamplePass = _graph.addPass("bloom-downsample", RenderPass::Type::COMPUTE);
+                bloomDownsamplePass.setDebugGroup("bloom");
+                bloomDownsamplePass.setParallelRecording(true);
+
+                bloomDownsamplePass.addUniformBufferRead("global", vk::PipelineStage::COMPUTE_SHADER);
+                bloomDownsamplePass.addSampledImageRead("hdr", vk::PipelineStage::COMPUTE_SHADER);
+                bloomDownsamplePass.addStorageImageWrite("bloomDownsample-0", vk::PipelineStage::COMPUTE_SHADER);
+                bloomDownsamplePass.addStorageImageWrite("bloomDownsample-1", vk::PipelineStage::COMPUTE_SHADER);
+                bloomDownsamplePass.addStorageImageWrite("bloomDownsample-2", vk::PipelineStage::COMPUTE_SHADER);
+                bloomDownsamplePass.addStorageImageWrite("bloomDownsample-3", vk::PipelineStage::COMPUTE_SHADER);
+                bloomDownsamplePass.addStorageImageWrite("bloomDownsample-4", vk::PipelineStage::COMPUTE_SHADER);
+
+                bloomDownsamplePass.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph &graph) {
+                    auto global = graph.getBuffer("global");
+                    auto hdrImage = graph.getImage("hdr");
+                    vk::ImageHandle downsample[5] = {
+                            graph.getImage("bloomDownsample-0"),
+                            graph.getImage("bloomDownsample-1"),
+                            graph.getImage("bloomDownsample-2"),
+                            graph.getImage("bloomDownsample-3"),
+                            graph.getImage("bloomDownsample-4")
+                    };
+
+                    cmd->clearDescriptors();
+
+                    cmd->bindProgram(_engine->getProgram(Engine::ProgramType::BLOOM_DOWNSAMPLE));
+                    cmd->bindBuffer(1, 0, global);
+
+                    auto bilinearSampler = _engine->device().getSampler({
                         .filter = VK_FILTER_LINEAR,
                         .addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE
-                    }).index();
-                    cmd->pushConstants(vk::ShaderStage::COMPUTE, push);
-
-                    cmd->bindPipeline();
-                    cmd->bindDescriptors();
-                    cmd->dispatch(outputImage->width(), outputImage->height(), 1);
+                    });
+
+
+                    for (i32 mip = 0; mip < 5; mip++) {
+                        vk::ImageHandle inputImage;
+                        if (mip == 0)
+                            inputImage = hdrImage;
+                        else
+                            inputImage = downsample[mip - 1];
+                        vk::ImageHandle outputImage = downsample[mip];
+
+                        struct Push {
+                            i32 inputIndex;
+                            i32 outputIndex;
+                            i32 bilinearSampler;
+                            i32 mipLevel;
+                        } push;
+                        push.inputIndex = inputImage.index();
+                        push.outputIndex = outputImage.index();
+                        push.bilinearSampler = bilinearSampler.index();
+                        push.mipLevel = mip;
+                        cmd->pushConstants(vk::ShaderStage::COMPUTE, push);
+
+                        cmd->bindPipeline();
+                        cmd->bindDescriptors();
+                        cmd->dispatch(inputImage->width(), inputImage->height(), 1);
+
+                        if (mip != 4) {
+                            auto outputBarrier = outputImage->barrier(vk::PipelineStage::COMPUTE_SHADER, vk::PipelineStage::COMPUTE_SHADER, vk::Access::SHADER_WRITE, vk::Access::SHADER_READ, vk::ImageLayout::GENERAL, vk::ImageLayout::SHADER_READ_ONLY);
+                            cmd->pipelineBarrier({ &outputBarrier, 1 });
+                        }
+                    }
 
-                    if (mip != 0) {
-                        auto outputBarrier = outputImage->barrier(vk::PipelineStage::COMPUTE_SHADER, vk::PipelineStage::COMPUTE_SHADER, vk::Access::SHADER_WRITE, vk::Access::SHADER_READ, vk::ImageLayout::SHADER_READ_ONLY);
-                        cmd->pipelineBarrier({ &outputBarrier, 1 });
+                });
+            }
+            {
+                auto& bloomUpsamplePass = _graph.addPass("bloom-upsample", RenderPass::Type::COMPUTE);
+                bloomUpsamplePass.setDebugGroup("bloom");
+                bloomUpsamplePass.setParallelRecording(true);
+
+                bloomUpsamplePass.addUniformBufferRead("global", vk::PipelineStage::COMPUTE_SHADER);
+
+                bloomUpsamplePass.addSampledImageRead("bloomDownsample-4", vk::PipelineStage::COMPUTE_SHADER);
+
+                bloomUpsamplePass.addStorageImageWrite("bloomUpsample-0", vk::PipelineStage::COMPUTE_SHADER);
+                bloomUpsamplePass.addStorageImageWrite("bloomUpsample-1", vk::PipelineStage::COMPUTE_SHADER);
+                bloomUpsamplePass.addStorageImageWrite("bloomUpsample-2", vk::PipelineStage::COMPUTE_SHADER);
+                bloomUpsamplePass.addStorageImageWrite("bloomUpsample-3", vk::PipelineStage::COMPUTE_SHADER);
+                bloomUpsamplePass.addStorageImageWrite("bloomUpsample-4", vk::PipelineStage::COMPUTE_SHADER);
+
+                bloomUpsamplePass.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph& graph) {
+                    auto global = graph.getBuffer("global");
+                    vk::ImageHandle downsample[5] = {
+                            graph.getImage("bloomDownsample-0"),
+                            graph.getImage("bloomDownsample-1"),
+                            graph.getImage("bloomDownsample-2"),
+                            graph.getImage("bloomDownsample-3"),
+                            graph.getImage("bloomDownsample-4")
+                    };
+                    vk::ImageHandle upsample[5] = {
+                            graph.getImage("bloomUpsample-0"),
+                            graph.getImage("bloomUpsample-1"),
+                            graph.getImage("bloomUpsample-2"),
+                            graph.getImage("bloomUpsample-3"),
+                            graph.getImage("bloomUpsample-4")
+                    };
+
+                    cmd->clearDescriptors();
+
+                    cmd->bindProgram(_engine->getProgram(Engine::ProgramType::BLOOM_UPSAMPLE));
+                    cmd->bindBuffer(1, 0, global);
+
+                    auto bilinearSampler = _engine->device().getSampler({
+                        .filter = VK_FILTER_LINEAR,
+                        .addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE
+                    });
+
+                    for (i32 mip = 4; mip > -1; mip--) {
+                        vk::ImageHandle inputImage;
+                        vk::ImageHandle sumImage;
+                        if (mip == 4) {
+                            inputImage = downsample[4];
+                            sumImage = {};
+                        } else {
+                            inputImage = upsample[mip + 1];
+                            sumImage = downsample[mip];
+                        }
+                        vk::ImageHandle outputImage = upsample[mip];
+
+                        struct Push {
+                            i32 inputIndex;
+                            i32 sumIndex;
+                            i32 outputIndex;
+                            i32 bilinearSampler;
+                        } push;
+                        push.inputIndex = inputImage.index();
+                        push.sumIndex = sumImage.index();
+                        push.outputIndex = outputImage.index();
+                        push.bilinearSampler = bilinearSampler.index();
+                        cmd->pushConstants(vk::ShaderStage::COMPUTE, push);
+
+                        cmd->bindPipeline();
+                        cmd->bindDescriptors();
+                        cmd->dispatch(outputImage->width(), outputImage->height(), 1);
+
+                        if (mip != 0) {
+                            auto outputBarrier = outputImage->barrier(vk::PipelineStage::COMPUTE_SHADER, vk::PipelineStage::COMPUTE_SHADER, vk::Access::SHADER_WRITE, vk::Access::SHADER_READ, vk::ImageLayout::GENERAL, vk::ImageLayout::SHADER_READ_ONLY);
+                            cmd->pipelineBarrier({ &outputBarrier, 1 });
+                        }
                     }
-                }
 
-            });
+                });
+            }
         }
         {
             auto& bloomCompositePass = _graph.addPass("bloom-composite", RenderPass::Type::COMPUTE);
             bloomCompositePass.setDebugGroup("bloom");
+            bloomCompositePass.setParallelRecording(true);
 
             bloomCompositePass.addUniformBufferRead(globalIndex, vk::PipelineStage::COMPUTE_SHADER);
 
             bloomCompositePass.addStorageImageRead(hdrImageIndex, vk::PipelineStage::COMPUTE_SHADER);
-            bloomCompositePass.addStorageImageRead("bloomUpsample-0", vk::PipelineStage::COMPUTE_SHADER);
+            bloomCompositePass.addSampledImageRead(bloomUpsampleLabel, vk::PipelineStage::COMPUTE_SHADER);
             bloomCompositePass.addStorageImageWrite("bloomFinal", vk::PipelineStage::COMPUTE_SHADER);
 
             bloomCompositePass.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph& graph) {
                 auto global = graph.getBuffer(globalIndex);
-                auto upsample = graph.getImage("bloomUpsample-0");
+                auto upsample = graph.getImage(bloomUpsampleLabel);
                 auto hdr = graph.getImage(hdrImageIndex);
                 auto final = graph.getImage("bloomFinal");
 
@@ -956,6 +1596,182 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
         }
     }
 
+    // a scaled scene is brought up to the backbuffer size before tonemapping
+    const char* sceneOutput = _renderSettings.bloom ? "bloomFinal" : "hdr";
+    const char* historyRead = _taaFrame % 2 == 0 ? "taaHistoryA" : "taaHistoryB";
+    const char* historyWrite = _taaFrame % 2 == 0 ? "taaHistoryB" : "taaHistoryA";
+    const char* tonemapInput = taa ? historyWrite : upscale ? "hdrUpscaled" : sceneOutput;
+    if (taa) {
+        auto& transforms = scene._meshTransformsBuffer[_engine->device().frameIndex()];
+        if (!_previousTransforms || _previousTransforms->size() < transforms->size()) {
+            _previousTransforms = _engine->device().createBuffer({
+                .size = transforms->size(),
+                .usage = vk::BufferUsage::STORAGE | vk::BufferUsage::TRANSFER_DST,
+                .name = "PreviousTransforms"
+            });
+            _previousTransformsValid = false;
+        }
+
+        BufferResource previousTransformsResource;
+        previousTransformsResource.size = _previousTransforms->size();
+        previousTransformsResource.usage = _previousTransforms->usage();
+        _graph.addBufferResource("previousTransforms", previousTransformsResource, _previousTransforms);
+
+        ImageResource motionAttachment;
+        motionAttachment.format = vk::Format::RG16_SFLOAT;
+        motionAttachment.scaled = true;
+        _graph.addImageResource("motion", motionAttachment);
+
+        ImageResource historyImage;
+        historyImage.format = vk::Format::RGBA32_SFLOAT;
+        historyImage.persistent = true;
+        _graph.addImageResource("taaHistoryA", historyImage);
+        _graph.addImageResource("taaHistoryB", historyImage);
+
+        // motion is rebuilt from depth and the visibility buffer rather than written by every material
+        auto& motionPass = _graph.addPass("motion_vectors", RenderPass::Type::COMPUTE);
+
+        motionPass.addUniformBufferRead(globalIndex, vk::PipelineStage::COMPUTE_SHADER);
+        motionPass.addStorageBufferRead(cameraBufferIndex, vk::PipelineStage::COMPUTE_SHADER);
+        motionPass.addStorageBufferRead(transformsIndex, vk::PipelineStage::COMPUTE_SHADER);
+        motionPass.addStorageBufferWrite("previousTransforms", vk::PipelineStage::COMPUTE_SHADER);
+        motionPass.addStorageImageRead(visibilityImageIndex, vk::PipelineStage::COMPUTE_SHADER);
+        motionPass.addSampledImageRead(depthIndex, vk::PipelineStage::COMPUTE_SHADER);
+        motionPass.addStorageImageWrite("motion", vk::PipelineStage::COMPUTE_SHADER);
+
+        motionPass.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph& graph) {
+            auto global = graph.getBuffer(globalIndex);
+            auto currentTransforms = graph.getBuffer(transformsIndex);
+            auto previousTransforms = graph.getBuffer("previousTransforms");
+            auto visibility = graph.getImage(visibilityImageIndex);
+            auto depth = graph.getImage(depthIndex);
+            auto motion = graph.getImage("motion");
+
+            cmd->clearDescriptors();
+            cmd->bindProgram(_engine->getProgram(Engine::ProgramType::MOTION_VECTORS));
+            cmd->bindBuffer(1, 0, global);
+            // a new copy holds nothing from last frame so everything is treated as static until it is filled
+            cmd->bindBuffer(1, 1, _previousTransformsValid ? previousTransforms : currentTransforms, true);
+
+            struct Push {
+                ende::math::Mat4f previousViewProjection;
+                i32 visibilityImageIndex;
+                i32 depthIndex;
+                i32 motionIndex;
+            } push;
+            push.previousViewProjection = _previousTransformsValid ? _previousViewProjection : camera->viewProjection();
+            push.visibilityImageIndex = visibility.index();
+            push.depthIndex = depth.index();
+            push.motionIndex = motion.index();
+            cmd->pushConstants(vk::ShaderStage::COMPUTE, push);
+
+            cmd->bindPipeline();
+            cmd->bindDescriptors();
+            cmd->dispatch(motion->width(), motion->height(), 1);
+
+            // keep this frame's transforms for the next once the dispatch is done reading last frame's
+            auto barrier = previousTransforms->barrier(vk::PipelineStage::COMPUTE_SHADER, vk::PipelineStage::TRANSFER, vk::Access::SHADER_READ, vk::Access::TRANSFER_WRITE);
+            cmd->pipelineBarrier({ &barrier, 1 });
+            VkBufferCopy bufferCopy{};
+            bufferCopy.size = currentTransforms->size();
+            vkCmdCopyBuffer(cmd->buffer(), currentTransforms->buffer(), previousTransforms->buffer(), 1, &bufferCopy);
+            barrier = previousTransforms->barrier(vk::PipelineStage::TRANSFER, vk::PipelineStage::COMPUTE_SHADER, vk::Access::TRANSFER_WRITE, vk::Access::SHADER_READ);
+            cmd->pipelineBarrier({ &barrier, 1 });
+
+            _previousViewProjection = camera->viewProjection();
+            _previousTransformsValid = true;
+        });
+
+        auto& taaPass = _graph.addPass("taa", RenderPass::Type::COMPUTE);
+
+        taaPass.addUniformBufferRead(globalIndex, vk::PipelineStage::COMPUTE_SHADER);
+        taaPass.addSampledImageRead(sceneOutput, vk::PipelineStage::COMPUTE_SHADER);
+        taaPass.addSampledImageRead(depthIndex, vk::PipelineStage::COMPUTE_SHADER);
+        taaPass.addSampledImageRead("motion", vk::PipelineStage::COMPUTE_SHADER);
+        taaPass.addSampledImageRead(historyRead, vk::PipelineStage::COMPUTE_SHADER);
+        taaPass.addStorageImageWrite(historyWrite, vk::PipelineStage::COMPUTE_SHADER);
+
+        taaPass.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph& graph) {
+            auto global = graph.getBuffer(globalIndex);
+            auto input = graph.getImage(sceneOutput);
+            auto depth = graph.getImage(depthIndex);
+            auto motion = graph.getImage("motion");
+            auto history = graph.getImage(historyRead);
+            auto output = graph.getImage(historyWrite);
+
+            cmd->clearDescriptors();
+            cmd->bindProgram(_engine->getProgram(Engine::ProgramType::TAA));
+            cmd->bindBuffer(1, 0, global);
+
+            struct Push {
+                i32 inputIndex;
+                i32 depthIndex;
+                i32 motionIndex;
+                i32 historyIndex;
+                i32 outputIndex;
+                i32 bilinearSampler;
+                f32 blendFactor;
+                f32 clampScale;
+            } push;
+            push.inputIndex = input.index();
+            push.depthIndex = depth.index();
+            push.motionIndex = motion.index();
+            push.historyIndex = _taaHistoryValid && history == _taaHistory ? history.index() : -1;
+            push.outputIndex = output.index();
+            push.bilinearSampler = _engine->device().getSampler({
+                .filter = VK_FILTER_LINEAR,
+                .addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE
+            }).index();
+            push.blendFactor = _renderSettings.taaBlendFactor;
+            push.clampScale = 1.25f;
+            cmd->pushConstants(vk::ShaderStage::COMPUTE, push);
+
+            cmd->bindPipeline();
+            cmd->bindDescriptors();
+            cmd->dispatch(output->width(), output->height(), 1);
+
+            _taaHistory = output;
+            _taaHistoryValid = true;
+        });
+    } else if (upscale) {
+        ImageResource upscaledImage;
+        upscaledImage.format = vk::Format::RGBA32_SFLOAT;
+        _graph.addImageResource("hdrUpscaled", upscaledImage);
+
+        auto& upscalePass = _graph.addPass("upscale", RenderPass::Type::COMPUTE);
+
+        upscalePass.addUniformBufferRead(globalIndex, vk::PipelineStage::COMPUTE_SHADER);
+        upscalePass.addSampledImageRead(sceneOutput, vk::PipelineStage::COMPUTE_SHADER);
+        upscalePass.addStorageImageWrite("hdrUpscaled", vk::PipelineStage::COMPUTE_SHADER);
+
+        upscalePass.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph& graph) {
+            auto global = graph.getBuffer(globalIndex);
+            auto input = graph.getImage(sceneOutput);
+            auto output = graph.getImage("hdrUpscaled");
+
+            cmd->clearDescriptors();
+            cmd->bindProgram(_engine->getProgram(Engine::ProgramType::UPSCALE));
+            cmd->bindBuffer(1, 0, global);
+
+            struct Push {
+                i32 inputIndex;
+                i32 outputIndex;
+                i32 bilinearSampler;
+            } push;
+            push.inputIndex = input.index();
+            push.outputIndex = output.index();
+            push.bilinearSampler = _engine->device().getSampler({
+                .filter = VK_FILTER_LINEAR,
+                .addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE
+            }).index();
+            cmd->pushConstants(vk::ShaderStage::COMPUTE, push);
+
+            cmd->bindPipeline();
+            cmd->bindDescriptors();
+            cmd->dispatch(output->width(), output->height(), 1);
+        });
+    }
+
     if (_renderSettings.tonemap && !fullscreenDebug) {
         auto& tonemapPass = _graph.addPass("tonemap", RenderPass::Type::COMPUTE);
 
@@ -965,10 +1781,7 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
         else
             tonemapPass.addStorageImageWrite(backbufferIndex, vk::PipelineStage::COMPUTE_SHADER);
 
-        if (_renderSettings.bloom)
-            tonemapPass.addStorageImageRead("bloomFinal", vk::PipelineStage::COMPUTE_SHADER);
-        else
-            tonemapPass.addStorageImageRead(hdrImageIndex, vk::PipelineStage::COMPUTE_SHADER);
+        tonemapPass.addStorageImageRead(tonemapInput, vk::PipelineStage::COMPUTE_SHADER);
 
 
         tonemapPass.addStorageImageRead("bloomUpsample-0", vk::PipelineStage::COMPUTE_SHADER);
@@ -976,11 +1789,7 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
         tonemapPass.setDebugColour({0.1, 0.4, 0.7, 1});
         tonemapPass.setExecuteFunction([&](vk::CommandHandle cmd, RenderGraph& graph) {
             auto global = graph.getBuffer(globalIndex);
-            vk::ImageHandle hdrImage;
-            if (_renderSettings.bloom)
-                hdrImage = graph.getImage("bloomFinal");
-            else
-                hdrImage = graph.getImage(hdrImageIndex);
+            auto hdrImage = graph.getImage(tonemapInput);
             auto backbuffer = graph.getImage(backbufferIndex);
             cmd->clearDescriptors();
             cmd->bindProgram(_engine->getProgram(Engine::ProgramType::TONEMAP));
@@ -1052,9 +1861,9 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
     }
 
 
-    _graph.setBackbufferDimensions(_swapchain->extent().width, _swapchain->extent().height);
 //    _graph.setBackbuffer("backbuffer");
     _graph.setBackbuffer("final-swapchain");
+    _graph.setParallelRecording(_renderSettings.parallelRecording);
     {
         ImageResource backbufferAttachment;
         backbufferAttachment.format = vk::Format::RGBA8_UNORM;
@@ -1076,14 +1885,43 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
     if (!_graph.compile())
         throw std::runtime_error("cyclical graph found");
 
+    // images are allocated by the compile, their per mip views are made here as the passes binding them are recorded
+    // on worker threads
+    if (_renderSettings.occlusionCulling) {
+        // a reallocated pyramid holds nothing from last frame to cull against
+        if (updateMipViews(_graph.getImage("depthPyramid"), _depthPyramid, _depthPyramidViews, _retiredViews))
+            _depthPyramidValid = false;
+    }
+    if (_renderSettings.bloom && _renderSettings.compactBloom && !fullscreenDebug) {
+        updateMipViews(_graph.getImage("bloomDownsampleChain"), _bloomDownsampleChain, _bloomDownsampleViews, _retiredViews);
+        updateMipViews(_graph.getImage("bloomUpsampleChain"), _bloomUpsampleChain, _bloomUpsampleViews, _retiredViews);
+    }
+
 
 
-    _globalData.maxDrawCount = scene.meshCount();
+    _globalData.maxDrawCount = scene.instanceCount();
     _globalData.gpuCulling = _renderSettings.gpuCulling;
-    _globalData.tileSizes = { 16, 9, 24, (u32)std::ceil((f32)_swapchain->extent().width / (f32)16.f) };
-    _globalData.swapchainSize = { _swapchain->extent().width, _swapchain->extent().height };
-    _globalData.cursorPos = _cursorPos;
+    _globalData.coneCulling = _renderSettings.coneCulling;
+    _globalData.shadowConeCulling = _renderSettings.shadowConeCulling;
+    _globalData.smallPrimitiveCulling = _renderSettings.smallPrimitiveCulling;
+    // shaders only see the size the scene is rendered at
+    _globalData.tileSizes = { LIGHT_TILES_X, LIGHT_TILES_Y, LIGHT_SLICES, (u32)std::ceil((f32)renderSize.x() / (f32)LIGHT_TILES_X) };
+    _globalData.swapchainSize = renderSize;
+    _globalData.cursorPos = {
+        static_cast<u32>(static_cast<f32>(_cursorPos.x()) * _graph.getRenderScale()),
+        static_cast<u32>(static_cast<f32>(_cursorPos.y()) * _graph.getRenderScale())
+    };
     _globalData.randomOffset = { static_cast<f32>(_randomDistribution(_randomGenerator)), static_cast<f32>(_randomDistribution(_randomGenerator)) };
+    if (taa) {
+        // lower scales walk more of the sequence so every output pixel still gets several samples
+        u32 phases = std::ceil(8.f / (_graph.getRenderScale() * _graph.getRenderScale()));
+        u32 index = _taaFrame++ % phases + 1;
+        _globalData.jitter = {
+            (halton(index, 2) - 0.5f) * 2.f / static_cast<f32>(renderSize.x()),
+            (halton(index, 3) - 0.5f) * 2.f / static_cast<f32>(renderSize.y())
+        };
+    } else
+        _globalData.jitter = { 0, 0 };
     _globalData.poissonIndex = _engine->_poissonImage.index();
     _globalData.bloomStrength = _renderSettings.bloomStrength;
     _globalData.shadowMode = _renderSettings.shadowMode;
@@ -1091,6 +1929,7 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
     _globalData.blockerSamples = _renderSettings.blockerSamples;
     _globalData.lodTransitionBase = _renderSettings.lodTransitionBase;
     _globalData.lodTransitionStep = _renderSettings.lodTransitionStep;
+    _globalData.lodErrorThreshold = _renderSettings.lodErrorThreshold;
     _globalData.lodBias = _renderSettings.lodBias;
     _globalData.shadowLodBias = _renderSettings.shadowLodBias;
 
@@ -1133,15 +1972,32 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
     _globalData.vertexBuffer = _engine->vertexBuffer()->address();
     _globalData.indexBuffer = _engine->indexBuffer()->address();
     _globalData.meshletBuffer = _engine->meshletBuffer()->address();
+    _globalData.meshletNodeBuffer = _engine->meshletNodeBuffer()->address();
 //    _globalData.meshletIndexBuffer = _engine->meshletIndexBuffer()->address();
     _globalData.primitiveBuffer = _engine->primitiveBuffer()->address();
     _globalData.meshBuffer = scene._meshDataBuffer[_engine->device().frameIndex()]->address();
+    _globalData.instanceBuffer = scene._instanceBuffer[_engine->device().frameIndex()]->address();
     _globalData.transformsBuffer = scene._meshTransformsBuffer[_engine->device().frameIndex()]->address();
     _globalData.cameraBuffer = scene._cameraBuffer[_engine->device().frameIndex()]->address();
     _globalData.lightBuffer = scene._lightBuffer[_engine->device().frameIndex()]->address();
     _globalData.lightGridBuffer = _graph.getBuffer("lightGrid")->address();
     _globalData.lightIndicesBuffer = _graph.getBuffer("lightIndices")->address();
     _globalData.feedbackBuffer = _feedbackBuffer[_engine->device().frameIndex()]->address();
+    _globalData.mipFeedbackBuffer = _mipFeedbackBuffer[_engine->device().frameIndex()]->address();
+    if (probeGI) {
+        _globalData.probeGridOrigin = { _probeGridMin.x(), _probeGridMin.y(), _probeGridMin.z(), 0 };
+        _globalData.probeGridSpacing = {
+            std::max((_probeGridMax.x() - _probeGridMin.x()) / (_probeGridSize.x() - 1), 0.01f),
+            std::max((_probeGridMax.y() - _probeGridMin.y()) / (_probeGridSize.y() - 1), 0.01f),
+            std::max((_probeGridMax.z() - _probeGridMin.z()) / (_probeGridSize.z() - 1), 0.01f),
+            0
+        };
+        _globalData.probeGridSize = { _probeGridSize.x(), _probeGridSize.y(), _probeGridSize.z(), 0 };
+        _globalData.probeBuffer = _graph.getBuffer(probesIndex)->address();
+    } else {
+        _globalData.probeGridSize = { 0, 0, 0, 0 };
+        _globalData.probeBuffer = 0;
+    }
 
     _globalDataBuffer[_engine->device().frameIndex()]->data(_globalData);
 //    _engine->stageData(_globalDataBuffer[_engine->device().frameIndex()], _globalData);
@@ -1149,5 +2005,11 @@ void cala::Renderer::render(cala::Scene &scene, ImGuiContext* imGui) {
     cmd->startPipelineStatistics();
     _graph.execute(cmd);
     cmd->stopPipelineStatistics();
+    // passes may be recorded in parallel so the history they compared against is only replaced once they all have
+    if (hdrHistory) {
+        _hdrHistory = _graph.getImage(hdrImageIndex);
+        _hdrHistoryViewProjection = camera->viewProjection();
+        _hdrHistoryJitter = _globalData.jitter;
+    }
 
 }
\ No newline at end of file
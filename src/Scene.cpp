@@ -1,13 +1,16 @@
 #include <Cala/Scene.h>
 #include <algorithm>
+#include <bit>
+#include <cstring>
 #include <Ende/thread/thread.h>
 #include <Cala/Material.h>
+#include <Cala/CascadeFitting.h>
 #include <Ende/profile/profile.h>
 
 cala::Scene::Scene(cala::Engine* engine, u32 count, u32 lightCount)
     : _engine(engine),
     _directionalLightCount(0),
-    _lightsDirtyFrame(2)
+    _lightsDirtyFrame(vk::FRAMES_IN_FLIGHT)
 {
     for (u32 i = 0; i < vk::FRAMES_IN_FLIGHT; i++) {
         _meshDataBuffer[i] = engine->device().createBuffer({
@@ -18,10 +21,19 @@ cala::Scene::Scene(cala::Engine* engine, u32 count, u32 lightCount)
             .name = "MeshDataBuffer: " + std::to_string(i)
         });
     }
+    for (u32 i = 0; i < vk::FRAMES_IN_FLIGHT; i++) {
+        _instanceBuffer[i] = engine->device().createBuffer({
+            .size = (u32)(count * sizeof(GPUInstance)),
+            .usage = vk::BufferUsage::STORAGE,
+            .memoryType = vk::MemoryProperties::STAGING,
+            .persistentlyMapped = true,
+            .name = "InstanceBuffer: " + std::to_string(i)
+        });
+    }
     for (u32 i = 0; i < vk::FRAMES_IN_FLIGHT; i++) {
         _meshTransformsBuffer[i] = engine->device().createBuffer({
             .size = (u32)(count * sizeof(ende::math::Mat4f)),
-            .usage = vk::BufferUsage::UNIFORM | vk::BufferUsage::STORAGE,
+            .usage = vk::BufferUsage::UNIFORM | vk::BufferUsage::STORAGE | vk::BufferUsage::TRANSFER_SRC,
             .memoryType = vk::MemoryProperties::STAGING,
             .persistentlyMapped = true,
             .name = "ModelBuffer: " + std::to_string(i)
@@ -51,71 +63,272 @@ cala::Scene::Scene(cala::Engine* engine, u32 count, u32 lightCount)
 
 void cala::Scene::addSkyLightMap(vk::ImageHandle skyLightMap, bool equirectangular, bool hdr) {
     if (equirectangular) {
-        _skyLightMap = _engine->convertToCubeMap(skyLightMap);
-    } else
+        // equirectangular skies loaded from disk are read back from the sky light cache when possible
+        auto maps = _engine->loadSkyLightMaps(skyLightMap);
+        _skyLightMap = maps.cubeMap;
+        _skyLightIrradiance = maps.irradiance;
+        _skyLightPrefilter = maps.prefiltered;
+    } else {
         _skyLightMap = skyLightMap;
+        _skyLightIrradiance = _engine->generateIrradianceMap(_skyLightMap);
+        _skyLightPrefilter = _engine->generatePrefilteredIrradiance(_skyLightMap);
+    }
 
     _skyLightMapView = _skyLightMap->newView(0, 10);
-    _skyLightIrradiance = _engine->generateIrradianceMap(_skyLightMap);
-    _skyLightPrefilter = _engine->generatePrefilteredIrradiance(_skyLightMap);
     _hdrSkyLight = hdr;
 }
 
-void traverseNode(cala::Scene::SceneNode* node, ende::math::Mat4f worldTransform, std::vector<ende::math::Mat4f>& meshTransforms) {
+void traverseNode(cala::Scene::SceneNode* node, ende::math::Mat4f worldTransform, std::vector<ende::math::Mat4f>& meshTransforms, std::vector<u32>& movedMeshes) {
     if (node->transform.isDirty()) {
         node->worldTransform = worldTransform * node->transform.local();
     }
 
-    if (auto meshNode = dynamic_cast<cala::Scene::MeshNode*>(node); meshNode && node->transform.isDirty())
+    if (auto meshNode = dynamic_cast<cala::Scene::MeshNode*>(node); meshNode && node->transform.isDirty()) {
         meshTransforms[meshNode->index] = node->worldTransform;
+        movedMeshes.push_back(meshNode->index);
+    }
+    if (auto instancesNode = dynamic_cast<cala::Scene::InstancesNode*>(node); instancesNode && node->transform.isDirty()) {
+        for (u32 i = 0; i < instancesNode->transforms.size(); i++) {
+            meshTransforms[instancesNode->firstInstance + i] = node->worldTransform * instancesNode->transforms[i];
+            movedMeshes.push_back(instancesNode->firstInstance + i);
+        }
+    }
 
     for (auto& child : node->children) {
         if (node->transform.isDirty())
             child->transform.setDirty(node->transform.isDirty());
-        traverseNode(child.get(), node->worldTransform, meshTransforms);
+        traverseNode(child.get(), node->worldTransform, meshTransforms, movedMeshes);
     }
     node->transform.setDirty(false);
 }
 
+// meshes must stay still for this many frames before they are drawn into the static shadow cache
+constexpr u32 shadowSettleFrames = 30;
+
+// bounding sphere of the transformed mesh aabb
+ende::math::Vec4f meshBounds(const GPUMesh& mesh, const ende::math::Mat4f& transform) {
+    ende::math::Vec4f corners[8];
+    ende::math::Vec3f center = { 0, 0, 0 };
+    for (u32 i = 0; i < 8; i++) {
+        corners[i] = transform.transform(ende::math::Vec4f{
+            i & 1 ? mesh.max.x() : mesh.min.x(),
+            i & 2 ? mesh.max.y() : mesh.min.y(),
+            i & 4 ? mesh.max.z() : mesh.min.z(),
+            1.f
+        });
+        center = center + corners[i].xyz();
+    }
+    center = center / 8.f;
+
+    f32 radius = 0;
+    for (auto& corner : corners) {
+        auto offset = corner.xyz() - center;
+        radius = std::max(radius, offset.x() * offset.x() + offset.y() * offset.y() + offset.z() * offset.z());
+    }
+    return { center.x(), center.y(), center.z(), std::sqrt(radius) };
+}
+
+bool intersectsFrustum(const Frustum& frustum, const ende::math::Vec4f& sphere) {
+    for (auto& plane : frustum.planes) {
+        if (sphere.x() * plane.x() + sphere.y() * plane.y() + sphere.z() * plane.z() + plane.w() + sphere.w() < 0)
+            return false;
+    }
+    return true;
+}
+
+// largest distance in normalised device coordinates the corners of the cached camera move when projected by the current camera
+f32 projectionDrift(const GPUCamera& cached, const GPUCamera& current) {
+    auto cachedViewProjection = cached.projection * cached.view;
+    auto currentViewProjection = current.projection * current.view;
+    f32 drift = 0;
+    for (auto& corner : cached.frustum.corners) {
+        auto cachedPos = cachedViewProjection.transform(corner);
+        auto currentPos = currentViewProjection.transform(corner);
+        cachedPos = cachedPos / cachedPos.w();
+        currentPos = currentPos / currentPos.w();
+        drift = std::max({
+            drift,
+            std::abs(cachedPos.x() - currentPos.x()),
+            std::abs(cachedPos.y() - currentPos.y()),
+            std::abs(cachedPos.z() - currentPos.z())
+        });
+    }
+    return drift;
+}
+
 void cala::Scene::prepare() {
     PROFILE_NAMED("Scene::prepare");
     u32 frame = _engine->device().frameIndex();
 
     u32 meshCount = _meshData.size();
+    u32 instanceCount = _instances.size();
     // resize buffers to fit and update persistent mappings
     if (meshCount * sizeof(GPUMesh) >= _meshDataBuffer[frame]->size()) {
         _meshDataBuffer[frame] = _engine->device().resizeBuffer(_meshDataBuffer[frame], meshCount * sizeof(GPUMesh) * 2);
     }
-    if (meshCount * sizeof(ende::math::Mat4f) >= _meshTransformsBuffer[frame]->size()) {
-        _meshTransformsBuffer[frame] = _engine->device().resizeBuffer(_meshTransformsBuffer[frame], meshCount * sizeof(ende::math::Mat4f) * 2);
+    if (instanceCount * sizeof(GPUInstance) >= _instanceBuffer[frame]->size()) {
+        _instanceBuffer[frame] = _engine->device().resizeBuffer(_instanceBuffer[frame], instanceCount * sizeof(GPUInstance) * 2);
+    }
+    if (instanceCount * sizeof(ende::math::Mat4f) >= _meshTransformsBuffer[frame]->size()) {
+        _meshTransformsBuffer[frame] = _engine->device().resizeBuffer(_meshTransformsBuffer[frame], instanceCount * sizeof(ende::math::Mat4f) * 2);
     }
     if (_lights.size() * sizeof(GPULight) >= _lightBuffer[frame]->size()) {
         _lightBuffer[frame] = _engine->device().resizeBuffer(_lightBuffer[frame], _lights.size() * sizeof(GPULight) * 2 + sizeof(u32));
+        _lightsDirtyFrame = vk::FRAMES_IN_FLIGHT;
     }
 
     // update transforms
-    traverseNode(_root.get(), ende::math::identity<4, f32>(), _meshTransforms);
+    _movedMeshes.clear();
+    traverseNode(_root.get(), ende::math::identity<4, f32>(), _meshTransforms, _movedMeshes);
+
+    // recently moved meshes are dynamic shadow casters drawn on top of the cached static shadows. casters entering
+    // or leaving the cache invalidate the cached shadow views they overlap
+    for (u32 instanceIndex = _meshShadowStates.size(); instanceIndex < instanceCount; instanceIndex++)
+        _movedMeshes.push_back(instanceIndex);
+    _meshShadowStates.resize(instanceCount);
+    std::erase_if(_dynamicMeshes, [&](u32 instanceIndex) {
+        if (++_meshShadowStates[instanceIndex].staticFrames < shadowSettleFrames)
+            return false;
+        _instances[instanceIndex].flags &= ~CALA_INSTANCE_DYNAMIC;
+        _instancesDirtyFrame = vk::FRAMES_IN_FLIGHT;
+        return true;
+    });
+    for (auto instanceIndex : _movedMeshes) {
+        _meshShadowStates[instanceIndex].staticFrames = 0;
+        if ((_instances[instanceIndex].flags & CALA_INSTANCE_DYNAMIC) == 0) {
+            _instances[instanceIndex].flags |= CALA_INSTANCE_DYNAMIC;
+            _dynamicMeshes.push_back(instanceIndex);
+        }
+    }
+    if (!_movedMeshes.empty())
+        _instancesDirtyFrame = vk::FRAMES_IN_FLIGHT;
+    for (u32 instanceIndex = 0; instanceIndex < instanceCount; instanceIndex++) {
+        auto& state = _meshShadowStates[instanceIndex];
+        bool cached = (_instances[instanceIndex].flags & (CALA_INSTANCE_ENABLED | CALA_INSTANCE_CAST_SHADOWS | CALA_INSTANCE_DYNAMIC)) == (CALA_INSTANCE_ENABLED | CALA_INSTANCE_CAST_SHADOWS);
+        if (cached != state.cached) {
+            _shadowInvalidations.push_back(state.bounds);
+            state.cached = cached;
+        }
+    }
+    for (auto instanceIndex : _movedMeshes)
+        _meshShadowStates[instanceIndex].bounds = meshBounds(_meshData[_instances[instanceIndex].meshIndex], _meshTransforms[instanceIndex]);
+
+    // world space bounds of all shadow casters, used to fit the depth range of cascades
+    ende::math::Vec3f casterMin = { std::numeric_limits<f32>::max(), std::numeric_limits<f32>::max(), std::numeric_limits<f32>::max() };
+    ende::math::Vec3f casterMax = { std::numeric_limits<f32>::lowest(), std::numeric_limits<f32>::lowest(), std::numeric_limits<f32>::lowest() };
+    for (u32 instanceIndex = 0; instanceIndex < instanceCount; instanceIndex++) {
+        if ((_instances[instanceIndex].flags & (CALA_INSTANCE_ENABLED | CALA_INSTANCE_CAST_SHADOWS)) != (CALA_INSTANCE_ENABLED | CALA_INSTANCE_CAST_SHADOWS))
+            continue;
+        auto& bounds = _meshShadowStates[instanceIndex].bounds;
+        casterMin = {
+                std::min(casterMin.x(), bounds.x() - bounds.w()),
+                std::min(casterMin.y(), bounds.y() - bounds.w()),
+                std::min(casterMin.z(), bounds.z() - bounds.w())
+        };
+        casterMax = {
+                std::max(casterMax.x(), bounds.x() + bounds.w()),
+                std::max(casterMax.y(), bounds.y() + bounds.w()),
+                std::max(casterMax.z(), bounds.z() + bounds.w())
+        };
+    }
 
-    _meshDataBuffer[frame]->data(_meshData);
-//    _engine->stageData(_meshDataBuffer[frame], _meshData);
-    _meshTransformsBuffer[frame]->data(_meshTransforms);
-//    _engine->stageData(_meshTransformsBuffer[frame], _meshTransforms);
+    // each frame in flight has its own copy so changes are uploaded until every copy has them
+    if (_instancesDirtyFrame > 0) {
+        _meshDataBuffer[frame]->data(_meshData);
+//        _engine->stageData(_meshDataBuffer[frame], _meshData);
+        _instanceBuffer[frame]->data(_instances);
+        _meshTransformsBuffer[frame]->data(_meshTransforms);
+//        _engine->stageData(_meshTransformsBuffer[frame], _meshTransforms);
+        _instancesDirtyFrame--;
+    }
 
-    _cameraData.clear();
     auto mainCamera = getMainCamera();
     mainCamera->updateFrustum();
     if (_updateCullingCamera) {
         _cullingCameraData = mainCamera->data();
     }
-    _cameraData.push_back(_cullingCameraData);
+    _sceneCameraData.clear();
+    _sceneCameraData.push_back(_cullingCameraData);
     for (u32 cameraIndex = 0; cameraIndex < _cameras.size(); cameraIndex++) {
         _cameras[cameraIndex].updateFrustum();
         auto cameraData = _cameras[cameraIndex].data();
-        _cameraData.push_back(cameraData);
+        _sceneCameraData.push_back(cameraData);
     }
-
-    _lightData.clear();
+    // shadow cameras are stored after the scene cameras so the light data pointing at them moves if the count changes
+    bool cameraCountChanged = _sceneCameraData.size() != _sceneCameraCount || _cameraData.size() < _sceneCameraData.size();
+    _camerasChanged = cameraCountChanged || std::memcmp(_cameraData.data(), _sceneCameraData.data(), _sceneCameraData.size() * sizeof(GPUCamera)) != 0;
+    _sceneCameraCount = _sceneCameraData.size();
+
+    // assign shadow atlas tiles. directional cascades get the largest tiles while point light faces are sized by
+    // their approximate screen coverage. tiles are packed largest first to keep the atlas from fragmenting and are
+    // only repacked when the requests change so cached shadows keep their tiles
+    auto& shadowAtlas = _engine->shadowAtlas();
+    _shadowRequests.clear();
     for (u32 lightIndex = 0; lightIndex < _lights.size(); lightIndex++) {
+        auto& light = _lights[lightIndex];
+        if (!light.shadowing())
+            continue;
+        u32 size = shadowAtlas.maxTileSize();
+        if (light.type() == Light::POINT) {
+            auto lightToCamera = light.getPosition() - mainCamera->transform().pos();
+            f32 distance = std::sqrt(lightToCamera.x() * lightToCamera.x() + lightToCamera.y() * lightToCamera.y() + lightToCamera.z() * lightToCamera.z());
+            f32 coverage = std::min(1.f, light.getFar() / std::max(distance, 1.f));
+            size = static_cast<u32>(static_cast<f32>(shadowAtlas.maxTileSize() / 2) * coverage);
+        }
+        _shadowRequests.push_back({ lightIndex, std::bit_floor(std::max(size, shadowAtlas.minTileSize())) });
+    }
+    std::stable_sort(_shadowRequests.begin(), _shadowRequests.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.size > rhs.size;
+    });
+    bool repack = !std::equal(_shadowRequests.begin(), _shadowRequests.end(), _packedShadowRequests.begin(), _packedShadowRequests.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.lightIndex == rhs.lightIndex && lhs.size == rhs.size;
+    }) || (shadowAtlas.views().empty() && !_shadowRequests.empty());
+    if (repack) {
+        shadowAtlas.clear();
+        for (auto& light : _lights) {
+            if (!light.shadowing())
+                light.setShadowMap({});
+        }
+        for (auto& request : _shadowRequests) {
+            auto& light = _lights[request.lightIndex];
+            u32 viewCount = light.type() == Light::DIRECTIONAL ? light.getCascadeCount() : 6;
+            light.setShadowMap(_engine->getShadowAtlasImage());
+            for (u32 viewIndex = 0; viewIndex < viewCount; viewIndex++) {
+                auto tile = shadowAtlas.allocate(request.size);
+                light.setShadowTile(viewIndex, shadowAtlas.tileCoords(tile));
+                if (tile.size > 0)
+                    shadowAtlas.addView({ request.lightIndex, viewIndex, tile });
+            }
+        }
+        _packedShadowRequests = _shadowRequests;
+        _shadowViewCache.assign(shadowAtlas.views().size(), {});
+    }
+
+    // light data and shadow cameras are only rebuilt when a light changes or, for cascades, when the camera or the
+    // casters they are fit around move
+    _lightsChanged = repack || cameraCountChanged || _lightData.size() != _lights.size();
+    bool directionalLights = false;
+    for (auto& light : _lights) {
+        _lightsChanged |= light.isDirty();
+        directionalLights |= light.type() == Light::DIRECTIONAL;
+    }
+    bool casterBoundsChanged = std::memcmp(&casterMin, &_casterMin, sizeof(casterMin)) != 0 || std::memcmp(&casterMax, &_casterMax, sizeof(casterMax)) != 0;
+    _casterMin = casterMin;
+    _casterMax = casterMax;
+    bool refitCascades = directionalLights && (_camerasChanged || casterBoundsChanged);
+
+    if (_lightsChanged || refitCascades) {
+        _cameraData = _sceneCameraData;
+        _lightData.clear();
+        if (_lightsChanged)
+            _lightsDirtyFrame = vk::FRAMES_IN_FLIGHT;
+        _camerasDirtyFrame = vk::FRAMES_IN_FLIGHT;
+    } else if (_camerasChanged) {
+        std::copy(_sceneCameraData.begin(), _sceneCameraData.end(), _cameraData.begin());
+        _camerasDirtyFrame = vk::FRAMES_IN_FLIGHT;
+    }
+
+    for (u32 lightIndex = 0; (_lightsChanged || refitCascades) && lightIndex < _lights.size(); lightIndex++) {
         auto& light = _lights[lightIndex];
         auto data = light.data();
 
@@ -133,6 +346,13 @@ void cala::Scene::prepare() {
                 if (cascadeIndex < light.getCascadeCount() - 1)
                     far = light.getCascadeSplit(cascadeIndex);
 
+                if (shadowAtlas.stableCascades()) {
+                    auto tile = light.getShadowTile(cascadeIndex);
+                    u32 resolution = static_cast<u32>(tile.z() * static_cast<f32>(shadowAtlas.size()));
+                    _cameraData.push_back(fitCascade(cascadeSphere(*mainCamera, near, far), light.getDirection(), resolution, casterMin, casterMax));
+                    continue;
+                }
+
                 Camera cascadeCamera(mainCamera->fov(), mainCamera->width(), mainCamera->height(), near, far, &mainCamera->transform());
                 auto frustumCorners = cascadeCamera.getFrustumCorners();
 
@@ -180,21 +400,94 @@ void cala::Scene::prepare() {
                 _cameraData.push_back(cascadeCamera.data());
 
             }
+        } else if (light.type() == Light::POINT && light.shadowing()) {
+
+            u32 cameraIndex = _cameraData.size();
+            data.cameraIndex = cameraIndex;
+            light.setCameraIndex(cameraIndex);
+
+            Transform shadowTransform(light.getPosition());
+            Camera shadowCamera(ende::math::rad(90.f), 1, 1, light.getNear(), light.getFar(), &shadowTransform);
+            for (u32 face = 0; face < 6; face++) {
+                switch (face) {
+                    case 0:
+                        shadowTransform.rotate({0, 1, 0}, ende::math::rad(90));
+                        break;
+                    case 1:
+                        shadowTransform.rotate({0, 1, 0}, ende::math::rad(180));
+                        break;
+                    case 2:
+                        shadowTransform.rotate({0, 1, 0}, ende::math::rad(90));
+                        shadowTransform.rotate({1, 0, 0}, ende::math::rad(90));
+                        break;
+                    case 3:
+                        shadowTransform.rotate({1, 0, 0}, ende::math::rad(180));
+                        break;
+                    case 4:
+                        shadowTransform.rotate({1, 0, 0}, ende::math::rad(90));
+                        break;
+                    case 5:
+                        shadowTransform.rotate({0, 1, 0}, ende::math::rad(180));
+                        break;
+                }
+                shadowCamera.updateFrustum();
+                _cameraData.push_back(shadowCamera.data());
+            }
         }
 
         _lightData.push_back(data);
     }
-    _lightBuffer[frame]->data(_lightData, sizeof(u32));
-//    _engine->stageData(_lightBuffer[frame], _lightData, sizeof(u32));
-    u32 totalLightCount = _lights.size();
-    _lightBuffer[frame]->data(totalLightCount);
-//    _engine->stageData(_lightBuffer[frame], totalLightCount);
+    // decide which shadow views are refreshed. reused views keep the camera they were rendered with so the cached
+    // tile still matches and views overlapped by dynamic casters are composited from the cache
+    for (u32 viewIndex = 0; viewIndex < shadowAtlas.views().size(); viewIndex++) {
+        auto& view = shadowAtlas.view(viewIndex);
+        auto& cache = _shadowViewCache[viewIndex];
+        auto& light = _lights[view.lightIndex];
+        auto& camera = _cameraData[light.getCameraIndex() + view.viewIndex];
+
+        bool refresh = !shadowAtlas.caching() || !cache.valid || light.isDirty() ||
+                projectionDrift(cache.camera, camera) * static_cast<f32>(view.tile.size) * 0.5f > shadowAtlas.cacheThreshold();
+        for (u32 i = 0; !refresh && i < _shadowInvalidations.size(); i++)
+            refresh = intersectsFrustum(cache.camera.frustum, _shadowInvalidations[i]);
+        if (refresh) {
+            cache.camera = camera;
+            cache.valid = true;
+        } else
+            camera = cache.camera;
+
+        bool dynamic = false;
+        for (u32 i = 0; !dynamic && i < _dynamicMeshes.size(); i++) {
+            u32 flags = _instances[_dynamicMeshes[i]].flags;
+            dynamic = (flags & CALA_INSTANCE_ENABLED) && (flags & CALA_INSTANCE_CAST_SHADOWS) && intersectsFrustum(cache.camera.frustum, _meshShadowStates[_dynamicMeshes[i]].bounds);
+        }
+        view.refresh = refresh;
+        // views that had dynamic casters last frame are composited once more to remove them
+        view.composite = refresh || dynamic || cache.dynamic;
+        cache.dynamic = dynamic;
+    }
+    _shadowInvalidations.clear();
+    for (auto& light : _lights)
+        light.setDirty(false);
+
+    // like instances each frame in flight has its own copy, so changes are uploaded until every copy has them
+    if (_lightsDirtyFrame > 0) {
+        _lightBuffer[frame]->data(_lightData, sizeof(u32));
+//        _engine->stageData(_lightBuffer[frame], _lightData, sizeof(u32));
+        u32 totalLightCount = _lights.size();
+        _lightBuffer[frame]->data(totalLightCount);
+//        _engine->stageData(_lightBuffer[frame], totalLightCount);
+        _lightsDirtyFrame--;
+    }
 
     if (_cameraData.size() * sizeof(GPUCamera) >= _cameraBuffer[frame]->size()) {
         _cameraBuffer[frame] = _engine->device().resizeBuffer(_cameraBuffer[frame], _cameraData.size() * sizeof(GPUCamera) * 2);
+        _camerasDirtyFrame = vk::FRAMES_IN_FLIGHT;
+    }
+    if (_camerasDirtyFrame > 0) {
+        _cameraBuffer[frame]->data(_cameraData);
+//        _engine->stageData(_cameraBuffer[frame], _cameraData);
+        _camerasDirtyFrame--;
     }
-    _cameraBuffer[frame]->data(_cameraData);
-//    _engine->stageData(_cameraBuffer[frame], _cameraData);
 
 
     _engine->updateMaterialdata();
@@ -216,26 +509,31 @@ cala::Scene::SceneNode* cala::Scene::addNode(const std::string& name, const cala
     }
 }
 
+cala::Mesh modelPrimitiveMesh(cala::Model& model, cala::Model::Primitive& primitive) {
+    cala::Mesh mesh = {
+        primitive.firstIndex,
+        primitive.indexCount,
+        primitive.meshletIndex,
+        primitive.meshletCount,
+        &model.materials[primitive.materialIndex],
+        { primitive.aabb.min.x(), primitive.aabb.min.y(), primitive.aabb.min.z(), 1.0 },
+        { primitive.aabb.max.x(), primitive.aabb.max.y(), primitive.aabb.max.z(), 1.0 }
+    };
+    for (u32 level = 0; level < MAX_LODS; level++) {
+        mesh.lods[level].meshletOffset = primitive.lods[level].meshletOffset;
+        mesh.lods[level].meshletCount = primitive.lods[level].meshletCount;
+        mesh.lodCount = primitive.lodCount;
+    }
+    mesh.nodeOffset = primitive.nodeOffset;
+    mesh.rootCount = primitive.rootCount;
+    mesh.compactVertices = primitive.compactVertices;
+    return mesh;
+}
+
 cala::Scene::SceneNode* addModelNode(const std::string& name, cala::Scene& scene, cala::Model& model, cala::Model::Node& node, const cala::Transform& transform, cala::Scene::SceneNode* parent) {
     auto sceneNode = scene.addNode(node.name.empty() ? name : node.name, transform, parent);
-    for (auto primitiveIndex : node.primitives) {
-        auto& primitive = model.primitives[primitiveIndex];
-        cala::Mesh mesh = {
-            primitive.firstIndex,
-            primitive.indexCount,
-            primitive.meshletIndex,
-            primitive.meshletCount,
-            &model.materials[primitive.materialIndex],
-            { primitive.aabb.min.x(), primitive.aabb.min.y(), primitive.aabb.min.z(), 1.0 },
-            { primitive.aabb.max.x(), primitive.aabb.max.y(), primitive.aabb.max.z(), 1.0 }
-        };
-        for (u32 level = 0; level < MAX_LODS; level++) {
-            mesh.lods[level].meshletOffset = primitive.lods[level].meshletOffset;
-            mesh.lods[level].meshletCount = primitive.lods[level].meshletCount;
-            mesh.lodCount = primitive.lodCount;
-        }
-        scene.addMesh(mesh, cala::Transform(), nullptr, sceneNode);
-    }
+    for (auto primitiveIndex : node.primitives)
+        scene.addMesh(modelPrimitiveMesh(model, model.primitives[primitiveIndex]), cala::Transform(), nullptr, sceneNode);
 
     for (auto& child : node.children) {
         auto& modelNode = model.nodes[child];
@@ -244,6 +542,21 @@ cala::Scene::SceneNode* addModelNode(const std::string& name, cala::Scene& scene
     return sceneNode;
 }
 
+// model node transforms are folded into each instance transform so every primitive gets a flat instances node
+void addModelNodeInstances(cala::Scene& scene, cala::Model& model, cala::Model::Node& node, const ende::math::Mat4f& nodeTransform, std::span<const ende::math::Mat4f> transforms, std::vector<ende::math::Mat4f>& instanceTransforms, cala::MaterialInstance* materialInstance, cala::Scene::SceneNode* parent) {
+    ende::math::Mat4f localTransform = nodeTransform * node.transform.local();
+    if (!node.primitives.empty()) {
+        instanceTransforms.clear();
+        for (auto& transform : transforms)
+            instanceTransforms.push_back(transform * localTransform);
+        for (auto primitiveIndex : node.primitives)
+            scene.addInstances(modelPrimitiveMesh(model, model.primitives[primitiveIndex]), instanceTransforms, materialInstance, parent);
+    }
+
+    for (auto& child : node.children)
+        addModelNodeInstances(scene, model, model.nodes[child], localTransform, transforms, instanceTransforms, materialInstance, parent);
+}
+
 cala::Scene::SceneNode *cala::Scene::addModel(const std::string& name, cala::Model &model, const cala::Transform& transform, cala::Scene::SceneNode *parent) {
     if (model.nodes.size() > 1) {
         auto rootNode = addNode(name, transform, parent);
@@ -254,29 +567,64 @@ cala::Scene::SceneNode *cala::Scene::addModel(const std::string& name, cala::Mod
     return addModelNode(name, *this, model, model.nodes.front(), transform, parent);
 }
 
-cala::Scene::SceneNode *cala::Scene::addMesh(const cala::Mesh &mesh, const cala::Transform &transform, cala::MaterialInstance *materialInstance, cala::Scene::SceneNode *parent) {
-    MaterialInstance* instance = materialInstance ? materialInstance : mesh.materialInstance;
-    i32 index = _meshData.size();
+cala::Scene::SceneNode *cala::Scene::addModelInstances(const std::string &name, cala::Model &model, std::span<const ende::math::Mat4f> transforms, cala::MaterialInstance *materialInstance, cala::Scene::SceneNode *parent) {
+    auto rootNode = addNode(name, Transform(), parent);
+    std::vector<ende::math::Mat4f> instanceTransforms;
+    instanceTransforms.reserve(transforms.size());
+    // model nodes hold every node of the hierarchy so only start from the ones that aren't another node's child
+    std::vector<bool> isChild(model.nodes.size(), false);
+    for (auto& node : model.nodes) {
+        for (auto& child : node.children)
+            isChild[child] = true;
+    }
+    for (u32 nodeIndex = 0; nodeIndex < model.nodes.size(); nodeIndex++) {
+        if (!isChild[nodeIndex])
+            addModelNodeInstances(*this, model, model.nodes[nodeIndex], ende::math::identity<4, f32>(), transforms, instanceTransforms, materialInstance, rootNode);
+    }
+    return rootNode;
+}
+
+u32 cala::Scene::addMeshData(const cala::Mesh &mesh) {
+    u64 key = static_cast<u64>(mesh.firstIndex) << 32 | mesh.lods[0].meshletOffset;
+    if (auto it = _meshLookup.find(key); it != _meshLookup.end())
+        return it->second;
+
+    u32 index = _meshData.size();
     _meshData.push_back(GPUMesh{
-        instance->material()->id(),
-        instance->getIndex(),
         mesh.min,
         mesh.max,
-        true,
-        true,
-        mesh.lodCount
+        mesh.lodCount,
+        mesh.compactVertices,
+        mesh.nodeOffset,
+        mesh.rootCount
     });
     for (u32 level = 0; level < MAX_LODS; level++) {
         _meshData.back().lods[level].meshletOffset = mesh.lods[level].meshletOffset;
         _meshData.back().lods[level].meshletCount = mesh.lods[level].meshletCount;
     }
     _meshes.push_back(mesh);
-    // materialInstance can be changed by the parameter passed to function
-    _meshes.back().materialInstance = instance;
-    _meshTransforms.push_back(transform.local());
-    assert(_meshData.size() == _meshTransforms.size());
-    assert(_meshData.size() == _meshes.size());
+    _meshLookup.emplace(key, index);
+    return index;
+}
 
+u32 cala::Scene::addInstance(u32 meshIndex, cala::MaterialInstance *materialInstance, const ende::math::Mat4f &transform) {
+    u32 index = _instances.size();
+    _instances.push_back(GPUInstance{
+        meshIndex,
+        materialInstance->material()->id(),
+        materialInstance->getIndex(),
+        CALA_INSTANCE_ENABLED | CALA_INSTANCE_CAST_SHADOWS
+    });
+    _instanceMaterials.push_back(materialInstance);
+    _meshTransforms.push_back(transform);
+    u32 materialID = materialInstance->material()->id();
+    if (materialID >= _materialInstanceCounts.size())
+        _materialInstanceCounts.resize(materialID + 1);
+    _materialInstanceCounts[materialID]++;
+    assert(_instances.size() == _meshTransforms.size());
+    _instancesDirtyFrame = vk::FRAMES_IN_FLIGHT;
+
+    auto& mesh = _meshData[meshIndex];
     _min = {
             std::min(_min.x(), mesh.min.x()),
             std::min(_min.y(), mesh.min.y()),
@@ -288,7 +636,14 @@ cala::Scene::SceneNode *cala::Scene::addMesh(const cala::Mesh &mesh, const cala:
             std::max(_max.z(), mesh.max.z())
     };
 
-    _totalMeshlets += _meshData.back().lods[0].meshletCount;
+    _totalMeshlets += mesh.lods[0].meshletCount;
+    return index;
+}
+
+cala::Scene::SceneNode *cala::Scene::addMesh(const cala::Mesh &mesh, const cala::Transform &transform, cala::MaterialInstance *materialInstance, cala::Scene::SceneNode *parent) {
+    // materialInstance can be changed by the parameter passed to function
+    MaterialInstance* instance = materialInstance ? materialInstance : mesh.materialInstance;
+    i32 index = addInstance(addMeshData(mesh), instance, transform.local());
 
     auto node = std::make_unique<MeshNode>();
     node->index = index;
@@ -306,6 +661,31 @@ cala::Scene::SceneNode *cala::Scene::addMesh(const cala::Mesh &mesh, const cala:
     }
 }
 
+cala::Scene::SceneNode *cala::Scene::addInstances(const cala::Mesh &mesh, std::span<const ende::math::Mat4f> transforms, cala::MaterialInstance *materialInstance, cala::Scene::SceneNode *parent) {
+    MaterialInstance* instance = materialInstance ? materialInstance : mesh.materialInstance;
+    u32 meshIndex = addMeshData(mesh);
+
+    auto node = std::make_unique<InstancesNode>();
+    node->firstInstance = _instances.size();
+    node->type = NodeType::INSTANCES;
+    node->transforms.assign(transforms.begin(), transforms.end());
+    _instances.reserve(_instances.size() + transforms.size());
+    _instanceMaterials.reserve(_instanceMaterials.size() + transforms.size());
+    _meshTransforms.reserve(_meshTransforms.size() + transforms.size());
+    for (auto& transform : transforms)
+        addInstance(meshIndex, instance, transform);
+
+    if (parent) {
+        node->parent = parent;
+        parent->children.push_back(std::move(node));
+        return parent->children.back().get();
+    } else { // add to root
+        node->parent = _root.get();
+        _root->children.push_back(std::move(node));
+        return _root->children.back().get();
+    }
+}
+
 cala::Scene::SceneNode *cala::Scene::addLight(const cala::Light &light, const cala::Transform &transform, cala::Scene::SceneNode *parent) {
     i32 index = _lights.size();
     _lights.push_back(light);
@@ -345,15 +725,44 @@ cala::Scene::SceneNode *cala::Scene::addCamera(const cala::Camera &camera, const
     }
 }
 
-void traverseNodeUpdateMeshIndices(cala::Scene::SceneNode* node, u32 meshIndex) {
+void traverseNodeUpdateMeshIndices(cala::Scene::SceneNode* node, u32 firstInstance, u32 count) {
     if (node->type == cala::Scene::NodeType::MESH) {
         auto meshNode = dynamic_cast<cala::Scene::MeshNode*>(node);
-        if (meshNode->index > meshIndex) {
-            meshNode->index--;
+        if (meshNode->index >= firstInstance + count) {
+            meshNode->index -= count;
         }
+    } else if (node->type == cala::Scene::NodeType::INSTANCES) {
+        auto instancesNode = dynamic_cast<cala::Scene::InstancesNode*>(node);
+        if (instancesNode->firstInstance >= firstInstance + count)
+            instancesNode->firstInstance -= count;
     }
     for (auto& child : node->children)
-        traverseNodeUpdateMeshIndices(child.get(), meshIndex);
+        traverseNodeUpdateMeshIndices(child.get(), firstInstance, count);
+}
+
+void cala::Scene::removeInstances(u32 firstInstance, u32 count) {
+    u32 lastInstance = firstInstance + count;
+    for (u32 instanceIndex = firstInstance; instanceIndex < lastInstance; instanceIndex++) {
+        if (instanceIndex < _meshShadowStates.size() && _meshShadowStates[instanceIndex].cached)
+            _shadowInvalidations.push_back(_meshShadowStates[instanceIndex].bounds);
+        _totalMeshlets -= _meshData[_instances[instanceIndex].meshIndex].lods[0].meshletCount;
+        _materialInstanceCounts[_instances[instanceIndex].materialID]--;
+    }
+    if (firstInstance < _meshShadowStates.size())
+        _meshShadowStates.erase(_meshShadowStates.begin() + firstInstance, _meshShadowStates.begin() + std::min<u32>(lastInstance, _meshShadowStates.size()));
+    std::erase_if(_dynamicMeshes, [&](u32 instanceIndex) {
+        return instanceIndex >= firstInstance && instanceIndex < lastInstance;
+    });
+    for (auto& dynamicIndex : _dynamicMeshes) {
+        if (dynamicIndex >= lastInstance)
+            dynamicIndex -= count;
+    }
+    // mesh data stays stored for later placements of the same mesh
+    _instances.erase(_instances.begin() + firstInstance, _instances.begin() + lastInstance);
+    _instanceMaterials.erase(_instanceMaterials.begin() + firstInstance, _instanceMaterials.begin() + lastInstance);
+    _meshTransforms.erase(_meshTransforms.begin() + firstInstance, _meshTransforms.begin() + lastInstance);
+    _instancesDirtyFrame = vk::FRAMES_IN_FLIGHT;
+    traverseNodeUpdateMeshIndices(_root.get(), firstInstance, count);
 }
 
 void cala::Scene::removeChildNode(cala::Scene::SceneNode *parent, u32 childIndex) {
@@ -363,11 +772,10 @@ void cala::Scene::removeChildNode(cala::Scene::SceneNode *parent, u32 childIndex
     auto child = parent->children[childIndex].get();
     if (child->type == NodeType::MESH) {
         auto meshNode = dynamic_cast<MeshNode*>(child);
-        _meshData[meshNode->index].enabled = false;
-        _meshes.erase(_meshes.begin() + meshNode->index);
-        _meshData.erase(_meshData.begin() + meshNode->index);
-        _meshTransforms.erase(_meshTransforms.begin() + meshNode->index);
-        traverseNodeUpdateMeshIndices(_root.get(), meshNode->index);
+        removeInstances(meshNode->index, 1);
+    } else if (child->type == NodeType::INSTANCES) {
+        auto instancesNode = dynamic_cast<InstancesNode*>(child);
+        removeInstances(instancesNode->firstInstance, instancesNode->transforms.size());
     }
 
     while (!child->children.empty())
@@ -0,0 +1,81 @@
+#include <Cala/ShadowAtlas.h>
+#include <algorithm>
+#include <bit>
+
+cala::ShadowAtlas::ShadowAtlas(u32 size, u32 maxTileSize, u32 minTileSize)
+    : _size(std::bit_floor(size)),
+    _maxTileSize(std::bit_floor(maxTileSize)),
+    _minTileSize(std::bit_floor(minTileSize))
+{
+    clear();
+}
+
+void cala::ShadowAtlas::resize(u32 size) {
+    _size = std::bit_floor(size);
+    clear();
+}
+
+void cala::ShadowAtlas::setMaxTileSize(u32 size) {
+    _maxTileSize = std::bit_floor(size);
+}
+
+void cala::ShadowAtlas::clear() {
+    _freeTiles.resize(levelOf(std::min(_minTileSize, _size)) + 1);
+    for (auto& level : _freeTiles)
+        level.clear();
+    _freeTiles.front().push_back({ 0, 0, _size });
+    _views.clear();
+}
+
+cala::ShadowAtlas::Tile cala::ShadowAtlas::allocate(u32 size) {
+    size = std::bit_floor(std::clamp(size, _minTileSize, std::min(_maxTileSize, _size)));
+    for (; size >= _minTileSize; size /= 2) {
+        i32 level = levelOf(size);
+        i32 parent = level;
+        while (parent >= 0 && _freeTiles[parent].empty())
+            parent--;
+        if (parent < 0)
+            continue;
+
+        Tile tile = _freeTiles[parent].back();
+        _freeTiles[parent].pop_back();
+        // split down to the requested size keeping the top left quadrant, pushed in reverse so the next
+        // allocation from each level continues in scanline order
+        while (parent < level) {
+            u32 half = tile.size / 2;
+            parent++;
+            _freeTiles[parent].push_back({ tile.x + half, tile.y + half, half });
+            _freeTiles[parent].push_back({ tile.x, tile.y + half, half });
+            _freeTiles[parent].push_back({ tile.x + half, tile.y, half });
+            tile.size = half;
+        }
+        return tile;
+    }
+    return {};
+}
+
+ende::math::Vec4f cala::ShadowAtlas::tileCoords(const Tile &tile) const {
+    f32 size = _size;
+    return {
+        static_cast<f32>(tile.x) / size,
+        static_cast<f32>(tile.y) / size,
+        static_cast<f32>(tile.size) / size,
+        static_cast<f32>(tile.size) / size
+    };
+}
+
+u32 cala::ShadowAtlas::refreshedViews() const {
+    return std::count_if(_views.begin(), _views.end(), [](const View& view) { return view.refresh; });
+}
+
+u32 cala::ShadowAtlas::compositedViews() const {
+    return std::count_if(_views.begin(), _views.end(), [](const View& view) { return view.composite; });
+}
+
+u32 cala::ShadowAtlas::reusedViews() const {
+    return _views.size() - refreshedViews();
+}
+
+u32 cala::ShadowAtlas::levelOf(u32 size) const {
+    return std::countr_zero(_size) - std::countr_zero(size);
+}
@@ -0,0 +1,582 @@
+#include <Cala/TextureCompression.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <array>
+#include <limits>
+
+// principal axis of the block colours found with power iteration. returns the mean in mean
+template <u32 N>
+std::array<f32, N> principalAxis(const u8* texels, std::array<f32, N>& mean) {
+    mean = {};
+    for (u32 i = 0; i < 16; i++) {
+        for (u32 c = 0; c < N; c++)
+            mean[c] += texels[i * 4 + c];
+    }
+    for (auto& value : mean)
+        value /= 16.f;
+
+    f32 covariance[N][N] = {};
+    for (u32 i = 0; i < 16; i++) {
+        for (u32 a = 0; a < N; a++) {
+            for (u32 b = a; b < N; b++)
+                covariance[a][b] += (texels[i * 4 + a] - mean[a]) * (texels[i * 4 + b] - mean[b]);
+        }
+    }
+    for (u32 a = 0; a < N; a++) {
+        for (u32 b = 0; b < a; b++)
+            covariance[a][b] = covariance[b][a];
+    }
+
+    std::array<f32, N> axis;
+    axis.fill(1.f);
+    for (u32 iteration = 0; iteration < 8; iteration++) {
+        std::array<f32, N> next = {};
+        for (u32 a = 0; a < N; a++) {
+            for (u32 b = 0; b < N; b++)
+                next[a] += covariance[a][b] * axis[b];
+        }
+        f32 length = 0;
+        for (auto value : next)
+            length = std::max(length, std::abs(value));
+        if (length < 1e-6f)
+            break;
+        for (u32 c = 0; c < N; c++)
+            axis[c] = next[c] / length;
+    }
+    return axis;
+}
+
+// endpoints at the extremes of the block projected onto its principal axis, inset slightly to reduce the error
+// of the texels between them
+template <u32 N>
+void fitEndpoints(const u8* texels, f32 (&endpoints)[2][N]) {
+    std::array<f32, N> mean;
+    auto axis = principalAxis<N>(texels, mean);
+
+    f32 minProjection = std::numeric_limits<f32>::max();
+    f32 maxProjection = std::numeric_limits<f32>::lowest();
+    for (u32 i = 0; i < 16; i++) {
+        f32 projection = 0;
+        for (u32 c = 0; c < N; c++)
+            projection += (texels[i * 4 + c] - mean[c]) * axis[c];
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+    f32 inset = (maxProjection - minProjection) / 32.f;
+    minProjection += inset;
+    maxProjection -= inset;
+
+    for (u32 c = 0; c < N; c++) {
+        endpoints[0][c] = std::clamp(mean[c] + axis[c] * maxProjection, 0.f, 255.f);
+        endpoints[1][c] = std::clamp(mean[c] + axis[c] * minProjection, 0.f, 255.f);
+    }
+}
+
+template <u32 N>
+u32 closestIndex(const u8* texel, const u8 (*palette)[4], u32 paletteSize, u32* squaredError = nullptr) {
+    u32 best = 0;
+    u32 bestError = std::numeric_limits<u32>::max();
+    for (u32 i = 0; i < paletteSize; i++) {
+        u32 error = 0;
+        for (u32 c = 0; c < N; c++) {
+            i32 difference = static_cast<i32>(texel[c]) - palette[i][c];
+            error += difference * difference;
+        }
+        if (error < bestError) {
+            bestError = error;
+            best = i;
+        }
+    }
+    if (squaredError)
+        *squaredError += bestError;
+    return best;
+}
+
+// least squares fit of endpoints to texels interpolated by the given weight of the first endpoint. fails if the
+// weights don't separate the endpoints
+template <u32 N>
+bool refineEndpoints(const u8* texels, const f32* weights, f32 (&endpoints)[2][N]) {
+    f32 aa = 0, ab = 0, bb = 0;
+    f32 ax[N] = {}, bx[N] = {};
+    for (u32 i = 0; i < 16; i++) {
+        f32 a = weights[i];
+        f32 b = 1.f - a;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (u32 c = 0; c < N; c++) {
+            ax[c] += a * texels[i * 4 + c];
+            bx[c] += b * texels[i * 4 + c];
+        }
+    }
+    f32 determinant = aa * bb - ab * ab;
+    if (std::abs(determinant) < 1e-6f)
+        return false;
+    for (u32 c = 0; c < N; c++) {
+        endpoints[0][c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.f, 255.f);
+        endpoints[1][c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.f, 255.f);
+    }
+    return true;
+}
+
+u16 packRGB565(const f32* colour) {
+    u16 r = static_cast<u16>(std::lround(colour[0] * 31.f / 255.f));
+    u16 g = static_cast<u16>(std::lround(colour[1] * 63.f / 255.f));
+    u16 b = static_cast<u16>(std::lround(colour[2] * 31.f / 255.f));
+    return (r << 11) | (g << 5) | b;
+}
+
+void unpackRGB565(u16 colour, u8* rgba) {
+    u8 r = (colour >> 11) & 31;
+    u8 g = (colour >> 5) & 63;
+    u8 b = colour & 31;
+    rgba[0] = (r << 3) | (r >> 2);
+    rgba[1] = (g << 2) | (g >> 4);
+    rgba[2] = (b << 3) | (b >> 2);
+    rgba[3] = 255;
+}
+
+void bc1Palette(u16 colour0, u16 colour1, u8 (*palette)[4]) {
+    unpackRGB565(colour0, palette[0]);
+    unpackRGB565(colour1, palette[1]);
+    for (u32 c = 0; c < 3; c++) {
+        if (colour0 > colour1) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        } else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    palette[2][3] = 255;
+    palette[3][3] = colour0 > colour1 ? 255 : 0;
+}
+
+// chooses the closest palette colour for each texel and returns the total squared error
+u32 bc1Indices(const u8* texels, u16 colour0, u16 colour1, u32& indices) {
+    u8 palette[4][4];
+    bc1Palette(colour0, colour1, palette);
+    u32 error = 0;
+    indices = 0;
+    for (u32 i = 0; i < 16; i++)
+        indices |= closestIndex<3>(&texels[i * 4], palette, 4, &error) << (i * 2);
+    return error;
+}
+
+void cala::bc::encodeBC1(const u8* texels, u8* block) {
+    f32 endpoints[2][3];
+    fitEndpoints<3>(texels, endpoints);
+
+    u16 colour0 = packRGB565(endpoints[0]);
+    u16 colour1 = packRGB565(endpoints[1]);
+    // keep four colour mode, a block of a single colour uses index 0 everywhere
+    if (colour0 < colour1)
+        std::swap(colour0, colour1);
+
+    u32 indices = 0;
+    if (colour0 != colour1) {
+        u32 error = bc1Indices(texels, colour0, colour1, indices);
+
+        // refit the endpoints to the chosen indices, kept if it reduces the error
+        constexpr f32 paletteWeights[4] = { 1.f, 0.f, 2.f / 3.f, 1.f / 3.f };
+        f32 weights[16];
+        for (u32 i = 0; i < 16; i++)
+            weights[i] = paletteWeights[(indices >> (i * 2)) & 3];
+        f32 refined[2][3];
+        if (refineEndpoints<3>(texels, weights, refined)) {
+            u16 refined0 = packRGB565(refined[0]);
+            u16 refined1 = packRGB565(refined[1]);
+            if (refined0 < refined1)
+                std::swap(refined0, refined1);
+            u32 refinedIndices = 0;
+            if (refined0 != refined1 && bc1Indices(texels, refined0, refined1, refinedIndices) < error) {
+                colour0 = refined0;
+                colour1 = refined1;
+                indices = refinedIndices;
+            }
+        }
+    }
+
+    std::memcpy(block, &colour0, 2);
+    std::memcpy(block + 2, &colour1, 2);
+    std::memcpy(block + 4, &indices, 4);
+}
+
+void bc4Palette(u8 value0, u8 value1, u8* palette) {
+    palette[0] = value0;
+    palette[1] = value1;
+    if (value0 > value1) {
+        for (u32 i = 1; i < 7; i++)
+            palette[i + 1] = ((7 - i) * value0 + i * value1) / 7;
+    } else {
+        for (u32 i = 1; i < 5; i++)
+            palette[i + 1] = ((5 - i) * value0 + i * value1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+void cala::bc::encodeBC4(const u8* texels, u8* block, u32 channel) {
+    u8 minValue = 255;
+    u8 maxValue = 0;
+    for (u32 i = 0; i < 16; i++) {
+        minValue = std::min(minValue, texels[i * 4 + channel]);
+        maxValue = std::max(maxValue, texels[i * 4 + channel]);
+    }
+
+    u64 indices = 0;
+    if (minValue != maxValue) {
+        u8 palette[8];
+        bc4Palette(maxValue, minValue, palette);
+        for (u32 i = 0; i < 16; i++) {
+            u8 value = texels[i * 4 + channel];
+            u64 best = 0;
+            for (u32 j = 1; j < 8; j++) {
+                if (std::abs(value - palette[j]) < std::abs(value - palette[best]))
+                    best = j;
+            }
+            indices |= best << (i * 3);
+        }
+    }
+
+    block[0] = maxValue;
+    block[1] = minValue;
+    for (u32 i = 0; i < 6; i++)
+        block[i + 2] = (indices >> (i * 8)) & 0xFF;
+}
+
+void cala::bc::encodeBC5(const u8* texels, u8* block) {
+    encodeBC4(texels, block, 0);
+    encodeBC4(texels, block + 8, 1);
+}
+
+constexpr u32 bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct BitWriter {
+    u8* data;
+    u32 offset = 0;
+
+    void write(u32 value, u32 bits) {
+        for (u32 i = 0; i < bits; i++, offset++) {
+            if (value & (1 << i))
+                data[offset / 8] |= 1 << (offset % 8);
+        }
+    }
+};
+
+struct BitReader {
+    const u8* data;
+    u32 offset = 0;
+
+    u32 read(u32 bits) {
+        u32 value = 0;
+        for (u32 i = 0; i < bits; i++, offset++)
+            value |= ((data[offset / 8] >> (offset % 8)) & 1) << i;
+        return value;
+    }
+};
+
+// quantises an endpoint to 7 bits per channel choosing the shared p-bit with the least error
+void quantiseBC7Endpoint(const f32* endpoint, u8* quantised, u8& pBit) {
+    f32 bestError = std::numeric_limits<f32>::max();
+    for (u8 p = 0; p < 2; p++) {
+        u8 candidate[4];
+        f32 error = 0;
+        for (u32 c = 0; c < 4; c++) {
+            candidate[c] = static_cast<u8>(std::clamp<f32>(std::round((endpoint[c] - p) / 2.f), 0.f, 127.f));
+            f32 difference = endpoint[c] - static_cast<f32>((candidate[c] << 1) | p);
+            error += difference * difference;
+        }
+        if (error < bestError) {
+            bestError = error;
+            pBit = p;
+            std::memcpy(quantised, candidate, 4);
+        }
+    }
+}
+
+void bc7Palette(const u8 (*endpoints)[4], const u8* pBits, u8 (*palette)[4]) {
+    for (u32 i = 0; i < 16; i++) {
+        for (u32 c = 0; c < 4; c++) {
+            u32 value0 = (endpoints[0][c] << 1) | pBits[0];
+            u32 value1 = (endpoints[1][c] << 1) | pBits[1];
+            palette[i][c] = ((64 - bc7Weights[i]) * value0 + bc7Weights[i] * value1 + 32) >> 6;
+        }
+    }
+}
+
+// quantises the endpoints and chooses the closest palette entry for each texel, returns the total squared error
+u32 bc7Indices(const u8* texels, const f32 (*endpoints)[4], u8 (*quantised)[4], u8* pBits, u32* indices) {
+    quantiseBC7Endpoint(endpoints[0], quantised[0], pBits[0]);
+    quantiseBC7Endpoint(endpoints[1], quantised[1], pBits[1]);
+
+    u8 palette[16][4];
+    bc7Palette(quantised, pBits, palette);
+
+    u32 error = 0;
+    for (u32 i = 0; i < 16; i++)
+        indices[i] = closestIndex<4>(&texels[i * 4], palette, 16, &error);
+    return error;
+}
+
+void cala::bc::encodeBC7(const u8* texels, u8* block) {
+    f32 endpoints[2][4];
+    fitEndpoints<4>(texels, endpoints);
+
+    u8 quantised[2][4];
+    u8 pBits[2];
+    u32 indices[16];
+    u32 error = bc7Indices(texels, endpoints, quantised, pBits, indices);
+
+    // refit the endpoints to the chosen indices, kept if it reduces the error
+    f32 weights[16];
+    for (u32 i = 0; i < 16; i++)
+        weights[i] = 1.f - static_cast<f32>(bc7Weights[indices[i]]) / 64.f;
+    f32 refined[2][4];
+    u8 refinedQuantised[2][4];
+    u8 refinedPBits[2];
+    u32 refinedIndices[16];
+    if (refineEndpoints<4>(texels, weights, refined) && bc7Indices(texels, refined, refinedQuantised, refinedPBits, refinedIndices) < error) {
+        std::memcpy(quantised, refinedQuantised, sizeof(quantised));
+        std::memcpy(pBits, refinedPBits, sizeof(pBits));
+        std::memcpy(indices, refinedIndices, sizeof(indices));
+    }
+
+    // the first index is stored without its high bit so swap endpoints to keep it clear
+    if (indices[0] & 8) {
+        std::swap(quantised[0], quantised[1]);
+        std::swap(pBits[0], pBits[1]);
+        for (auto& index : indices)
+            index = 15 - index;
+    }
+
+    std::memset(block, 0, 16);
+    BitWriter writer{ block };
+    writer.write(1 << 6, 7);
+    for (u32 c = 0; c < 4; c++) {
+        writer.write(quantised[0][c], 7);
+        writer.write(quantised[1][c], 7);
+    }
+    writer.write(pBits[0], 1);
+    writer.write(pBits[1], 1);
+    writer.write(indices[0], 3);
+    for (u32 i = 1; i < 16; i++)
+        writer.write(indices[i], 4);
+}
+
+void cala::bc::decodeBC1(const u8* block, u8* texels) {
+    u16 colour0, colour1;
+    u32 indices;
+    std::memcpy(&colour0, block, 2);
+    std::memcpy(&colour1, block + 2, 2);
+    std::memcpy(&indices, block + 4, 4);
+
+    u8 palette[4][4];
+    bc1Palette(colour0, colour1, palette);
+    for (u32 i = 0; i < 16; i++)
+        std::memcpy(&texels[i * 4], palette[(indices >> (i * 2)) & 3], 4);
+}
+
+void cala::bc::decodeBC4(const u8* block, u8* texels, u32 channel) {
+    u8 palette[8];
+    bc4Palette(block[0], block[1], palette);
+
+    u64 indices = 0;
+    for (u32 i = 0; i < 6; i++)
+        indices |= static_cast<u64>(block[i + 2]) << (i * 8);
+    for (u32 i = 0; i < 16; i++)
+        texels[i * 4 + channel] = palette[(indices >> (i * 3)) & 7];
+}
+
+void cala::bc::decodeBC5(const u8* block, u8* texels) {
+    for (u32 i = 0; i < 16; i++) {
+        texels[i * 4 + 2] = 0;
+        texels[i * 4 + 3] = 255;
+    }
+    decodeBC4(block, texels, 0);
+    decodeBC4(block + 8, texels, 1);
+}
+
+void cala::bc::decodeBC7(const u8* block, u8* texels) {
+    BitReader reader{ block };
+    if (reader.read(7) != 1 << 6) {
+        std::memset(texels, 0, 64);
+        return;
+    }
+
+    u8 endpoints[2][4];
+    for (u32 c = 0; c < 4; c++) {
+        endpoints[0][c] = reader.read(7);
+        endpoints[1][c] = reader.read(7);
+    }
+    u8 pBits[2];
+    pBits[0] = reader.read(1);
+    pBits[1] = reader.read(1);
+
+    u8 palette[16][4];
+    bc7Palette(endpoints, pBits, palette);
+    for (u32 i = 0; i < 16; i++)
+        std::memcpy(&texels[i * 4], palette[reader.read(i == 0 ? 3 : 4)], 4);
+}
+
+u32 cala::bc::blockCount(u32 width, u32 height) {
+    return ((width + 3) / 4) * ((height + 3) / 4);
+}
+
+std::vector<u8> cala::bc::encode(vk::Format format, std::span<const u8> texels, u32 width, u32 height) {
+    u32 blockSize = vk::formatToSize(format);
+    u32 blocksX = (width + 3) / 4;
+    u32 blocksY = (height + 3) / 4;
+    std::vector<u8> blocks(blocksX * blocksY * blockSize);
+
+    u8 blockTexels[16 * 4];
+    for (u32 blockY = 0; blockY < blocksY; blockY++) {
+        for (u32 blockX = 0; blockX < blocksX; blockX++) {
+            for (u32 y = 0; y < 4; y++) {
+                for (u32 x = 0; x < 4; x++) {
+                    u32 texelX = std::min(blockX * 4 + x, width - 1);
+                    u32 texelY = std::min(blockY * 4 + y, height - 1);
+                    std::memcpy(&blockTexels[(y * 4 + x) * 4], &texels[(texelY * width + texelX) * 4], 4);
+                }
+            }
+            u8* block = &blocks[(blockY * blocksX + blockX) * blockSize];
+            switch (format) {
+                case vk::Format::BC1_RGB_UNORM:
+                case vk::Format::BC1_RGB_SRGB:
+                    encodeBC1(blockTexels, block);
+                    break;
+                case vk::Format::BC4_UNORM:
+                    encodeBC4(blockTexels, block);
+                    break;
+                case vk::Format::BC5_UNORM:
+                    encodeBC5(blockTexels, block);
+                    break;
+                case vk::Format::BC7_UNORM:
+                case vk::Format::BC7_SRGB:
+                    encodeBC7(blockTexels, block);
+                    break;
+                default:
+                    return {};
+            }
+        }
+    }
+    return blocks;
+}
+
+std::vector<u8> cala::bc::decode(vk::Format format, std::span<const u8> blocks, u32 width, u32 height) {
+    u32 blockSize = vk::formatToSize(format);
+    u32 blocksX = (width + 3) / 4;
+    u32 blocksY = (height + 3) / 4;
+    std::vector<u8> texels(width * height * 4);
+
+    u8 blockTexels[16 * 4];
+    for (u32 blockY = 0; blockY < blocksY; blockY++) {
+        for (u32 blockX = 0; blockX < blocksX; blockX++) {
+            const u8* block = &blocks[(blockY * blocksX + blockX) * blockSize];
+            switch (format) {
+                case vk::Format::BC1_RGB_UNORM:
+                case vk::Format::BC1_RGB_SRGB:
+                    decodeBC1(block, blockTexels);
+                    break;
+                case vk::Format::BC4_UNORM:
+                    std::memset(blockTexels, 255, sizeof(blockTexels));
+                    decodeBC4(block, blockTexels);
+                    break;
+                case vk::Format::BC5_UNORM:
+                    decodeBC5(block, blockTexels);
+                    break;
+                case vk::Format::BC7_UNORM:
+                case vk::Format::BC7_SRGB:
+                    decodeBC7(block, blockTexels);
+                    break;
+                default:
+                    return {};
+            }
+            for (u32 y = 0; y < 4 && blockY * 4 + y < height; y++) {
+                for (u32 x = 0; x < 4 && blockX * 4 + x < width; x++)
+                    std::memcpy(&texels[((blockY * 4 + y) * width + blockX * 4 + x) * 4], &blockTexels[(y * 4 + x) * 4], 4);
+            }
+        }
+    }
+    return texels;
+}
+
+f32 srgbToLinear(u8 value) {
+    f32 colour = value / 255.f;
+    return colour <= 0.04045f ? colour / 12.92f : std::pow((colour + 0.055f) / 1.055f, 2.4f);
+}
+
+u8 linearToSrgb(f32 colour) {
+    colour = colour <= 0.0031308f ? colour * 12.92f : 1.055f * std::pow(colour, 1.f / 2.4f) - 0.055f;
+    return static_cast<u8>(std::clamp(std::lround(colour * 255.f), 0l, 255l));
+}
+
+std::vector<u8> cala::bc::downsample(std::span<const u8> texels, u32 width, u32 height, MipFilter filter) {
+    u32 mipWidth = std::max(width / 2, 1u);
+    u32 mipHeight = std::max(height / 2, 1u);
+    std::vector<u8> mip(mipWidth * mipHeight * 4);
+
+    std::array<f32, 256> srgbTable;
+    if (filter == MipFilter::SRGB) {
+        for (u32 i = 0; i < 256; i++)
+            srgbTable[i] = srgbToLinear(i);
+    }
+
+    for (u32 y = 0; y < mipHeight; y++) {
+        for (u32 x = 0; x < mipWidth; x++) {
+            f32 sum[4] = {};
+            for (u32 sample = 0; sample < 4; sample++) {
+                u32 sampleX = std::min(x * 2 + (sample & 1), width - 1);
+                u32 sampleY = std::min(y * 2 + (sample >> 1), height - 1);
+                const u8* texel = &texels[(sampleY * width + sampleX) * 4];
+                for (u32 c = 0; c < 4; c++) {
+                    if (filter == MipFilter::SRGB && c < 3)
+                        sum[c] += srgbTable[texel[c]];
+                    else if (filter == MipFilter::NORMAL && c < 3)
+                        sum[c] += texel[c] / 255.f * 2.f - 1.f;
+                    else
+                        sum[c] += texel[c] / 255.f;
+                }
+            }
+
+            u8* result = &mip[(y * mipWidth + x) * 4];
+            if (filter == MipFilter::NORMAL) {
+                f32 nx = sum[0] / 4.f;
+                f32 ny = sum[1] / 4.f;
+                f32 nz = sum[2] / 4.f;
+                f32 length = std::sqrt(nx * nx + ny * ny + nz * nz);
+                if (length > 1e-6f) {
+                    nx /= length;
+                    ny /= length;
+                    nz /= length;
+                }
+                result[0] = static_cast<u8>(std::lround((nx * 0.5f + 0.5f) * 255.f));
+                result[1] = static_cast<u8>(std::lround((ny * 0.5f + 0.5f) * 255.f));
+                result[2] = static_cast<u8>(std::lround((nz * 0.5f + 0.5f) * 255.f));
+                result[3] = static_cast<u8>(std::lround(sum[3] / 4.f * 255.f));
+                continue;
+            }
+            for (u32 c = 0; c < 4; c++) {
+                if (filter == MipFilter::SRGB && c < 3)
+                    result[c] = linearToSrgb(sum[c] / 4.f);
+                else
+                    result[c] = static_cast<u8>(std::lround(sum[c] / 4.f * 255.f));
+            }
+        }
+    }
+    return mip;
+}
+
+cala::bc::MipFilter cala::bc::mipFilter(vk::Format format) {
+    switch (format) {
+        case vk::Format::RGBA8_SRGB:
+        case vk::Format::BC1_RGB_SRGB:
+        case vk::Format::BC7_SRGB:
+            return MipFilter::SRGB;
+        case vk::Format::BC5_UNORM:
+            return MipFilter::NORMAL;
+        default:
+            return MipFilter::LINEAR;
+    }
+}
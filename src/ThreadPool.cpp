@@ -0,0 +1,34 @@
+#include <Cala/ThreadPool.h>
+
+cala::ThreadPool::ThreadPool(u32 threadCount)
+    : _stop(false)
+{
+    _threads.reserve(threadCount);
+    for (u32 i = 0; i < threadCount; i++)
+        _threads.emplace_back(&ThreadPool::run, this);
+}
+
+cala::ThreadPool::~ThreadPool() {
+    {
+        std::unique_lock lock(_mutex);
+        _stop = true;
+    }
+    _condition.notify_all();
+    for (auto& thread : _threads)
+        thread.join();
+}
+
+void cala::ThreadPool::run() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(_mutex);
+            _condition.wait(lock, [this] { return _stop || !_tasks.empty(); });
+            if (_stop && _tasks.empty())
+                return;
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+        task();
+    }
+}
@@ -4,6 +4,7 @@
 using namespace cala;
 void debugClusters(cala::RenderGraph& graph, cala::Engine& engine, cala::vk::Swapchain& swapchain, ClusterDebugInput input) {
     auto& debugClusters = graph.addPass("debug_clusters");
+    debugClusters.setParallelRecording(true);
 
     debugClusters.addColourRead("backbuffer-debug");
     debugClusters.addColourWrite(input.backbuffer);
@@ -37,6 +38,7 @@ void debugClusters(cala::RenderGraph& graph, cala::Engine& engine, cala::vk::Swa
 
 void debugNormalPass(cala::RenderGraph& graph, cala::Engine& engine, NormalDebugInput input) {
     auto& normalsPass = graph.addPass("debug_normals", RenderPass::Type::COMPUTE);
+    normalsPass.setParallelRecording(true);
 
     normalsPass.addStorageImageWrite(input.backbuffer, vk::PipelineStage::COMPUTE_SHADER);
 
@@ -47,9 +49,10 @@ void debugNormalPass(cala::RenderGraph& graph, cala::Engine& engine, NormalDebug
     normalsPass.addStorageBufferRead(input.indexBuffer, vk::PipelineStage::COMPUTE_SHADER);
     normalsPass.addStorageBufferRead(input.transforms, vk::PipelineStage::COMPUTE_SHADER);
     normalsPass.addStorageBufferRead(input.meshData, vk::PipelineStage::COMPUTE_SHADER);
+    normalsPass.addStorageBufferRead(input.instances, vk::PipelineStage::COMPUTE_SHADER);
     normalsPass.addStorageBufferRead(input.camera, vk::PipelineStage::COMPUTE_SHADER);
 
-    normalsPass.addStorageImageRead(input.pixelPositions, vk::PipelineStage::COMPUTE_SHADER);
+    normalsPass.addStorageImageRead(input.materialTiles, vk::PipelineStage::COMPUTE_SHADER);
     normalsPass.addIndirectRead(input.dispatchBuffer);
 
     normalsPass.setExecuteFunction([&, input](vk::CommandHandle cmd, RenderGraph& graph) {
@@ -58,13 +61,12 @@ void debugNormalPass(cala::RenderGraph& graph, cala::Engine& engine, NormalDebug
         vk::ImageHandle image = graph.getImage(input.backbuffer);
         auto depth = graph.getImage(input.depth);
         auto materialCounts = graph.getBuffer(input.materialCount);
-        auto pixelPositions = graph.getImage(input.pixelPositions);
+        auto materialTiles = graph.getImage(input.materialTiles);
         auto dispatchCommands = graph.getBuffer(input.dispatchBuffer);
 
         cmd->clearDescriptors();
         cmd->bindBuffer(1, 0, global);
         cmd->bindBuffer(1, 1, materialCounts, true);
-//        cmd->bindBuffer(1, 2, pixelPositions, true);
 
         for (u32 i = 0; i < engine.materialCount(); i++) {
             Material* material = engine.getMaterial(i);
@@ -79,13 +81,15 @@ void debugNormalPass(cala::RenderGraph& graph, cala::Engine& engine, NormalDebug
                 i32 backbufferIndex;
                 i32 depthIndex;
                 u32 materialIndex;
-                i32 pixelPositionsIndex;
+                i32 materialTilesIndex;
+                u32 tilesX = 0;
+                u64 shadingRatesBuffer = 0;
             } push;
             push.visibilityImageIndex = visibilityImage.index();
             push.backbufferIndex = image.index();
             push.depthIndex = depth.index();
             push.materialIndex = i;
-            push.pixelPositionsIndex = pixelPositions.index();
+            push.materialTilesIndex = materialTiles.index();
 
             cmd->pushConstants(vk::ShaderStage::COMPUTE, push);
 
@@ -101,6 +105,7 @@ void debugNormalPass(cala::RenderGraph& graph, cala::Engine& engine, NormalDebug
 
 void debugRoughnessPass(cala::RenderGraph& graph, cala::Engine& engine, RoughnessDebugInput input) {
     auto& debugRoughness = graph.addPass("debug_roughness", RenderPass::Type::COMPUTE);
+    debugRoughness.setParallelRecording(true);
 
     debugRoughness.addStorageImageWrite(input.backbuffer, vk::PipelineStage::COMPUTE_SHADER);
 
@@ -111,9 +116,10 @@ void debugRoughnessPass(cala::RenderGraph& graph, cala::Engine& engine, Roughnes
     debugRoughness.addStorageBufferRead(input.indexBuffer, vk::PipelineStage::COMPUTE_SHADER);
     debugRoughness.addStorageBufferRead(input.transforms, vk::PipelineStage::COMPUTE_SHADER);
     debugRoughness.addStorageBufferRead(input.meshData, vk::PipelineStage::COMPUTE_SHADER);
+    debugRoughness.addStorageBufferRead(input.instances, vk::PipelineStage::COMPUTE_SHADER);
     debugRoughness.addStorageBufferRead(input.camera, vk::PipelineStage::COMPUTE_SHADER);
 
-    debugRoughness.addStorageImageRead(input.pixelPositions, vk::PipelineStage::COMPUTE_SHADER);
+    debugRoughness.addStorageImageRead(input.materialTiles, vk::PipelineStage::COMPUTE_SHADER);
     debugRoughness.addIndirectRead(input.dispatchBuffer);
 
     debugRoughness.setExecuteFunction([&, input](vk::CommandHandle cmd, RenderGraph& graph) {
@@ -122,13 +128,12 @@ void debugRoughnessPass(cala::RenderGraph& graph, cala::Engine& engine, Roughnes
         vk::ImageHandle image = graph.getImage(input.backbuffer);
         auto depth = graph.getImage(input.depth);
         auto materialCounts = graph.getBuffer(input.materialCount);
-        auto pixelPositions = graph.getImage(input.pixelPositions);
+        auto materialTiles = graph.getImage(input.materialTiles);
         auto dispatchCommands = graph.getBuffer(input.dispatchBuffer);
 
         cmd->clearDescriptors();
         cmd->bindBuffer(1, 0, global);
         cmd->bindBuffer(1, 1, materialCounts, true);
-//        cmd->bindBuffer(1, 2, pixelPositions, true);
 
         for (u32 i = 0; i < engine.materialCount(); i++) {
             Material* material = engine.getMaterial(i);
@@ -143,13 +148,15 @@ void debugRoughnessPass(cala::RenderGraph& graph, cala::Engine& engine, Roughnes
                 i32 backbufferIndex;
                 i32 depthIndex;
                 u32 materialIndex;
-                i32 pixelPositionsIndex;
+                i32 materialTilesIndex;
+                u32 tilesX = 0;
+                u64 shadingRatesBuffer = 0;
             } push;
             push.visibilityImageIndex = visibilityImage.index();
             push.backbufferIndex = image.index();
             push.depthIndex = depth.index();
             push.materialIndex = i;
-            push.pixelPositionsIndex = pixelPositions.index();
+            push.materialTilesIndex = materialTiles.index();
 
             cmd->pushConstants(vk::ShaderStage::COMPUTE, push);
 
@@ -165,6 +172,7 @@ void debugRoughnessPass(cala::RenderGraph& graph, cala::Engine& engine, Roughnes
 
 void debugMetallicPass(cala::RenderGraph& graph, cala::Engine& engine, MetallicDebugInput input) {
     auto& debugMetallic = graph.addPass("debug_metallic", RenderPass::Type::COMPUTE);
+    debugMetallic.setParallelRecording(true);
 
     debugMetallic.addStorageImageWrite(input.backbuffer, vk::PipelineStage::COMPUTE_SHADER);
 
@@ -175,9 +183,10 @@ void debugMetallicPass(cala::RenderGraph& graph, cala::Engine& engine, MetallicD
     debugMetallic.addStorageBufferRead(input.indexBuffer, vk::PipelineStage::COMPUTE_SHADER);
     debugMetallic.addStorageBufferRead(input.transforms, vk::PipelineStage::COMPUTE_SHADER);
     debugMetallic.addStorageBufferRead(input.meshData, vk::PipelineStage::COMPUTE_SHADER);
+    debugMetallic.addStorageBufferRead(input.instances, vk::PipelineStage::COMPUTE_SHADER);
     debugMetallic.addStorageBufferRead(input.camera, vk::PipelineStage::COMPUTE_SHADER);
 
-    debugMetallic.addStorageImageRead(input.pixelPositions, vk::PipelineStage::COMPUTE_SHADER);
+    debugMetallic.addStorageImageRead(input.materialTiles, vk::PipelineStage::COMPUTE_SHADER);
     debugMetallic.addIndirectRead(input.dispatchBuffer);
 
     debugMetallic.setExecuteFunction([&, input](vk::CommandHandle cmd, RenderGraph& graph) {
@@ -186,13 +195,12 @@ void debugMetallicPass(cala::RenderGraph& graph, cala::Engine& engine, MetallicD
         vk::ImageHandle image = graph.getImage(input.backbuffer);
         auto depth = graph.getImage(input.depth);
         auto materialCounts = graph.getBuffer(input.materialCount);
-        auto pixelPositions = graph.getImage(input.pixelPositions);
+        auto materialTiles = graph.getImage(input.materialTiles);
         auto dispatchCommands = graph.getBuffer(input.dispatchBuffer);
 
         cmd->clearDescriptors();
         cmd->bindBuffer(1, 0, global);
         cmd->bindBuffer(1, 1, materialCounts, true);
-//        cmd->bindBuffer(1, 2, pixelPositions, true);
 
         for (u32 i = 0; i < engine.materialCount(); i++) {
             Material* material = engine.getMaterial(i);
@@ -207,13 +215,15 @@ void debugMetallicPass(cala::RenderGraph& graph, cala::Engine& engine, MetallicD
                 i32 backbufferIndex;
                 i32 depthIndex;
                 u32 materialIndex;
-                i32 pixelPositionsIndex;
+                i32 materialTilesIndex;
+                u32 tilesX = 0;
+                u64 shadingRatesBuffer = 0;
             } push;
             push.visibilityImageIndex = visibilityImage.index();
             push.backbufferIndex = image.index();
             push.depthIndex = depth.index();
             push.materialIndex = i;
-            push.pixelPositionsIndex = pixelPositions.index();
+            push.materialTilesIndex = materialTiles.index();
 
             cmd->pushConstants(vk::ShaderStage::COMPUTE, push);
 
@@ -229,6 +239,7 @@ void debugMetallicPass(cala::RenderGraph& graph, cala::Engine& engine, MetallicD
 
 void debugUnlitPass(cala::RenderGraph& graph, cala::Engine& engine, UnlitDebugInput input) {
     auto& debugUnlit = graph.addPass("debug_unlit", RenderPass::Type::COMPUTE);
+    debugUnlit.setParallelRecording(true);
 
     debugUnlit.addStorageImageWrite(input.backbuffer, vk::PipelineStage::COMPUTE_SHADER);
 
@@ -239,9 +250,10 @@ void debugUnlitPass(cala::RenderGraph& graph, cala::Engine& engine, UnlitDebugIn
     debugUnlit.addStorageBufferRead(input.indexBuffer, vk::PipelineStage::COMPUTE_SHADER);
     debugUnlit.addStorageBufferRead(input.transforms, vk::PipelineStage::COMPUTE_SHADER);
     debugUnlit.addStorageBufferRead(input.meshData, vk::PipelineStage::COMPUTE_SHADER);
+    debugUnlit.addStorageBufferRead(input.instances, vk::PipelineStage::COMPUTE_SHADER);
     debugUnlit.addStorageBufferRead(input.camera, vk::PipelineStage::COMPUTE_SHADER);
 
-    debugUnlit.addStorageImageRead(input.pixelPositions, vk::PipelineStage::COMPUTE_SHADER);
+    debugUnlit.addStorageImageRead(input.materialTiles, vk::PipelineStage::COMPUTE_SHADER);
     debugUnlit.addIndirectRead(input.dispatchBuffer);
 
     debugUnlit.setExecuteFunction([&, input](vk::CommandHandle cmd, RenderGraph& graph) {
@@ -250,13 +262,12 @@ void debugUnlitPass(cala::RenderGraph& graph, cala::Engine& engine, UnlitDebugIn
         vk::ImageHandle image = graph.getImage(input.backbuffer);
         auto depth = graph.getImage(input.depth);
         auto materialCounts = graph.getBuffer(input.materialCount);
-        auto pixelPositions = graph.getImage(input.pixelPositions);
+        auto materialTiles = graph.getImage(input.materialTiles);
         auto dispatchCommands = graph.getBuffer(input.dispatchBuffer);
 
         cmd->clearDescriptors();
         cmd->bindBuffer(1, 0, global);
         cmd->bindBuffer(1, 1, materialCounts, true);
-//        cmd->bindBuffer(1, 2, pixelPositions, true);
 
         for (u32 i = 0; i < engine.materialCount(); i++) {
             Material* material = engine.getMaterial(i);
@@ -271,13 +282,15 @@ void debugUnlitPass(cala::RenderGraph& graph, cala::Engine& engine, UnlitDebugIn
                 i32 backbufferIndex;
                 i32 depthIndex;
                 u32 materialIndex;
-                i32 pixelPositionsIndex;
+                i32 materialTilesIndex;
+                u32 tilesX = 0;
+                u64 shadingRatesBuffer = 0;
             } push;
             push.visibilityImageIndex = visibilityImage.index();
             push.backbufferIndex = image.index();
             push.depthIndex = depth.index();
             push.materialIndex = i;
-            push.pixelPositionsIndex = pixelPositions.index();
+            push.materialTilesIndex = materialTiles.index();
 
             cmd->pushConstants(vk::ShaderStage::COMPUTE, push);
 
@@ -293,6 +306,7 @@ void debugUnlitPass(cala::RenderGraph& graph, cala::Engine& engine, UnlitDebugIn
 
 void debugWorldPositionPass(cala::RenderGraph& graph, cala::Engine& engine, WorldPosDebugInput input) {
     auto& debugWorldPos = graph.addPass("debug_worldPos", RenderPass::Type::COMPUTE);
+    debugWorldPos.setParallelRecording(true);
 
     debugWorldPos.addStorageImageWrite(input.backbuffer, vk::PipelineStage::COMPUTE_SHADER);
 
@@ -303,6 +317,7 @@ void debugWorldPositionPass(cala::RenderGraph& graph, cala::Engine& engine, Worl
     debugWorldPos.addStorageBufferRead(input.indexBuffer, vk::PipelineStage::COMPUTE_SHADER);
     debugWorldPos.addStorageBufferRead(input.transforms, vk::PipelineStage::COMPUTE_SHADER);
     debugWorldPos.addStorageBufferRead(input.meshData, vk::PipelineStage::COMPUTE_SHADER);
+    debugWorldPos.addStorageBufferRead(input.instances, vk::PipelineStage::COMPUTE_SHADER);
     debugWorldPos.addStorageBufferRead(input.camera, vk::PipelineStage::COMPUTE_SHADER);
 
     debugWorldPos.addIndirectRead(input.dispatchBuffer);
@@ -338,6 +353,7 @@ void debugWorldPositionPass(cala::RenderGraph& graph, cala::Engine& engine, Worl
 
 void debugWireframePass(cala::RenderGraph& graph, cala::Engine& engine, cala::Renderer::Settings settings, WireframeDebugInput input) {
     auto& debugWireframe = graph.addPass("debug_wireframe", RenderPass::Type::COMPUTE);
+    debugWireframe.setParallelRecording(true);
 
     debugWireframe.addStorageImageWrite(input.backbuffer, vk::PipelineStage::COMPUTE_SHADER);
 
@@ -348,6 +364,7 @@ void debugWireframePass(cala::RenderGraph& graph, cala::Engine& engine, cala::Re
     debugWireframe.addStorageBufferRead(input.indexBuffer, vk::PipelineStage::COMPUTE_SHADER);
     debugWireframe.addStorageBufferRead(input.transforms, vk::PipelineStage::COMPUTE_SHADER);
     debugWireframe.addStorageBufferRead(input.meshData, vk::PipelineStage::COMPUTE_SHADER);
+    debugWireframe.addStorageBufferRead(input.instances, vk::PipelineStage::COMPUTE_SHADER);
     debugWireframe.addStorageBufferRead(input.camera, vk::PipelineStage::COMPUTE_SHADER);
 
     debugWireframe.setExecuteFunction([&, input](vk::CommandHandle cmd, RenderGraph& graph) {
@@ -422,6 +439,7 @@ void debugWireframePass(cala::RenderGraph& graph, cala::Engine& engine, cala::Re
 
 void debugFrustum(cala::RenderGraph& graph, cala::Engine& engine, cala::Renderer::Settings settings, FrustumDebugInput input) {
     auto& debugFrustum = graph.addPass("debug_frustums");
+    debugFrustum.setParallelRecording(true);
 
     debugFrustum.addColourRead("backbuffer-debug");
     debugFrustum.addColourWrite(input.backbuffer);
@@ -459,6 +477,7 @@ void debugFrustum(cala::RenderGraph& graph, cala::Engine& engine, cala::Renderer
 
 void debugDepthPass(cala::RenderGraph& graph, cala::Engine& engine, DepthDebugInput input) {
     auto& debugDepth = graph.addPass("debug_depth");
+    debugDepth.setParallelRecording(true);
 
     debugDepth.addColourWrite(input.backbuffer);
     debugDepth.addSampledImageRead(input.depth, vk::PipelineStage::FRAGMENT_SHADER);
@@ -486,6 +505,7 @@ void debugDepthPass(cala::RenderGraph& graph, cala::Engine& engine, DepthDebugIn
 
 void debugMeshletPass(cala::RenderGraph& graph, cala::Engine& engine, MeshletDebugInput input) {
     auto& debugMeshlet = graph.addPass("debug_meshlet", RenderPass::Type::COMPUTE);
+    debugMeshlet.setParallelRecording(true);
 
     debugMeshlet.addStorageImageWrite(input.backbuffer, vk::PipelineStage::COMPUTE_SHADER);
 
@@ -520,6 +540,7 @@ void debugMeshletPass(cala::RenderGraph& graph, cala::Engine& engine, MeshletDeb
 
 void debugPrimitivePass(cala::RenderGraph& graph, cala::Engine& engine, PrimitiveDebugInput input) {
     auto& debugPrimitive = graph.addPass("debug_primitive", RenderPass::Type::COMPUTE);
+    debugPrimitive.setParallelRecording(true);
 
     debugPrimitive.addStorageImageWrite(input.backbuffer, vk::PipelineStage::COMPUTE_SHADER);
 
@@ -591,6 +612,7 @@ void debugPrimitivePass(cala::RenderGraph& graph, cala::Engine& engine, Primitiv
 
 void debugVxgi(cala::RenderGraph& graph, cala::Engine& engine) {
     auto& debugVoxel = graph.addPass("voxelVisualisation", RenderPass::Type::COMPUTE);
+    debugVoxel.setParallelRecording(true);
 
     debugVoxel.addStorageImageWrite("backbuffer", vk::PipelineStage::COMPUTE_SHADER);
 //    debugVoxel.addStorageImageRead("voxelGrid", vk::PipelineStage::COMPUTE_SHADER);
@@ -20,10 +20,11 @@ struct NormalDebugInput {
     cala::ImageIndex visbility;
     cala::BufferIndex global;
     cala::BufferIndex materialCount;
-    cala::ImageIndex pixelPositions;
+    cala::ImageIndex materialTiles;
     cala::BufferIndex dispatchBuffer;
     cala::BufferIndex camera;
     cala::BufferIndex meshData;
+    cala::BufferIndex instances;
     cala::BufferIndex transforms;
     cala::BufferIndex vertexBuffer;
     cala::BufferIndex indexBuffer;
@@ -36,10 +37,11 @@ struct RoughnessDebugInput {
     cala::ImageIndex visbility;
     cala::BufferIndex global;
     cala::BufferIndex materialCount;
-    cala::ImageIndex pixelPositions;
+    cala::ImageIndex materialTiles;
     cala::BufferIndex dispatchBuffer;
     cala::BufferIndex camera;
     cala::BufferIndex meshData;
+    cala::BufferIndex instances;
     cala::BufferIndex transforms;
     cala::BufferIndex vertexBuffer;
     cala::BufferIndex indexBuffer;
@@ -52,10 +54,11 @@ struct MetallicDebugInput {
     cala::ImageIndex visbility;
     cala::BufferIndex global;
     cala::BufferIndex materialCount;
-    cala::ImageIndex pixelPositions;
+    cala::ImageIndex materialTiles;
     cala::BufferIndex dispatchBuffer;
     cala::BufferIndex camera;
     cala::BufferIndex meshData;
+    cala::BufferIndex instances;
     cala::BufferIndex transforms;
     cala::BufferIndex vertexBuffer;
     cala::BufferIndex indexBuffer;
@@ -68,10 +71,11 @@ struct UnlitDebugInput {
     cala::ImageIndex visbility;
     cala::BufferIndex global;
     cala::BufferIndex materialCount;
-    cala::ImageIndex pixelPositions;
+    cala::ImageIndex materialTiles;
     cala::BufferIndex dispatchBuffer;
     cala::BufferIndex camera;
     cala::BufferIndex meshData;
+    cala::BufferIndex instances;
     cala::BufferIndex transforms;
     cala::BufferIndex vertexBuffer;
     cala::BufferIndex indexBuffer;
@@ -84,10 +88,11 @@ struct WorldPosDebugInput {
     cala::ImageIndex visbility;
     cala::BufferIndex global;
     cala::BufferIndex materialCount;
-    cala::ImageIndex pixelPositions;
+    cala::ImageIndex materialTiles;
     cala::BufferIndex dispatchBuffer;
     cala::BufferIndex camera;
     cala::BufferIndex meshData;
+    cala::BufferIndex instances;
     cala::BufferIndex transforms;
     cala::BufferIndex vertexBuffer;
     cala::BufferIndex indexBuffer;
@@ -100,6 +105,7 @@ struct WireframeDebugInput {
     cala::BufferIndex global;
     cala::BufferIndex camera;
     cala::BufferIndex meshData;
+    cala::BufferIndex instances;
     cala::BufferIndex transforms;
     cala::BufferIndex vertexBuffer;
     cala::BufferIndex indexBuffer;
@@ -1,231 +1,258 @@
 #include "shadowPasses.h"
 
-void shadowPoint(cala::RenderGraph& graph, cala::Engine& engine, cala::Scene& scene) {
+// the views of a light are contiguous in the atlas and are culled in one dispatch and drawn in one draw per layer.
+// layer 0 holds static casters rendered into the shadow cache and layer 1 dynamic casters drawn over the atlas
+struct ShadowBatch {
+    u32 lightIndex = 0;
+    u32 firstView = 0;
+    u32 viewCount = 0;
+    u32 viewMasks[2] = {};
+    u32 commandsSize = 0;
+    u32 commandsOffset[2] = {};
+    u32 countOffset[2] = {};
+};
+
+void drawShadowBatches(cala::vk::CommandHandle cmd, cala::RenderGraph& graph, cala::Engine& engine, cala::Scene& scene, std::span<const ShadowBatch> batches, u32 layer) {
+    auto global = graph.getBuffer("global");
+    auto drawCommands = graph.getBuffer("shadowDrawCommands");
+    auto drawCount = graph.getBuffer("shadowDrawCount");
+    auto views = engine.shadowAtlas().views();
+
+    cmd->clearDescriptors();
+    cmd->bindRasterState({ cala::vk::CullMode::NONE });
+    cmd->bindDepthState({
+        true, true,
+        cala::vk::CompareOp::LESS_EQUAL
+    });
+
+    for (auto& batch : batches) {
+        if (batch.viewMasks[layer] == 0)
+            continue;
+        auto& light = scene._lights[batch.lightIndex];
+
+        // each view renders to its own viewport covering its tile, selected per primitive by the mesh shader
+        cala::vk::ViewPort viewPorts[MAX_CASCADES] = {};
+        for (u32 i = 0; i < batch.viewCount; i++) {
+            auto& tile = views[batch.firstView + i].tile;
+            viewPorts[i] = {
+                static_cast<f32>(tile.x), static_cast<f32>(tile.y),
+                static_cast<f32>(tile.size), static_cast<f32>(tile.size)
+            };
+            if (layer == 0 && (batch.viewMasks[layer] & (1u << i)))
+                cmd->clearDepthAttachment(viewPorts[i]);
+        }
+        cmd->bindViewPorts({ viewPorts, batch.viewCount });
+
+        if (light.type() == cala::Light::LightType::DIRECTIONAL) {
+            cmd->bindProgram(engine.getProgram(cala::Engine::ProgramType::SHADOW_DIRECT));
+        } else {
+            cmd->bindProgram(engine.getProgram(cala::Engine::ProgramType::SHADOW_POINT));
+            cmd->bindBuffer(3, 0, scene._lightBuffer[engine.device().frameIndex()],
+                            sizeof(GPULight) * batch.lightIndex + sizeof(u32), sizeof(GPULight), true);
+        }
+
+        cmd->pushConstants(cala::vk::ShaderStage::TASK | cala::vk::ShaderStage::MESH, static_cast<u32>(light.getCameraIndex()));
+        cmd->bindBuffer(1, 0, global);
+        cmd->bindBuffer(1, 1, drawCommands, batch.commandsOffset[layer], batch.commandsSize, true);
+
+        cmd->bindPipeline();
+        cmd->bindDescriptors();
+        cmd->drawMeshTasksIndirectCount(drawCommands, batch.commandsOffset[layer], drawCount, batch.countOffset[layer], sizeof(MeshTaskCommand));
+    }
+}
+
+void shadowPoint(cala::RenderGraph& graph, cala::Engine& engine, cala::Scene& scene, u32 drawCommandCapacity) {
+    auto atlasImage = engine.getShadowAtlasImage();
+    auto cacheImage = engine.getShadowCacheImage();
+    auto& atlas = engine.shadowAtlas();
+
+    {
+        cala::ImageResource shadowAtlas;
+        shadowAtlas.format = cala::vk::Format::D32_SFLOAT;
+        shadowAtlas.matchSwapchain = false;
+        shadowAtlas.width = atlasImage->width();
+        shadowAtlas.height = atlasImage->height();
+        shadowAtlas.usage = atlasImage->usage();
+        shadowAtlas.persistent = true;
+        graph.addImageResource("shadowAtlas", shadowAtlas, atlasImage);
+    }
+
+    // views whose static casters and the dynamic casters around them are unchanged keep last frame's atlas tile
+    if (atlas.compositedViews() == 0)
+        return;
+
+    // group views by light and give each batch its own regions of the draw buffers, regions are aligned so they can
+    // be bound as storage buffers
+    u32 alignment = std::max(engine.device().context().getLimits().minStorageBufferOffsetAlignment, 1u);
+    auto align = [alignment](u32 size) {
+        return (size + alignment - 1) / alignment * alignment;
+    };
+    std::vector<ShadowBatch> batches;
+    u32 commandsSize = 0;
+    u32 countSize = 0;
+    auto views = atlas.views();
+    for (u32 i = 0; i < views.size(); i++) {
+        auto& view = views[i];
+        if (scene._lights[view.lightIndex].getCameraIndex() < 0)
+            continue;
+        if (batches.empty() || batches.back().lightIndex != view.lightIndex)
+            batches.push_back({ view.lightIndex, i });
+        auto& batch = batches.back();
+        assert(view.viewIndex == batch.viewCount);
+        batch.viewCount++;
+        batch.viewMasks[0] |= view.refresh ? 1u << view.viewIndex : 0;
+        batch.viewMasks[1] |= view.composite ? 1u << view.viewIndex : 0;
+    }
+    for (auto& batch : batches) {
+        assert(batch.viewCount <= engine.device().context().getLimits().maxViewports);
+        batch.commandsSize = std::max({ scene.instanceCount() * batch.viewCount, drawCommandCapacity, 1u }) * static_cast<u32>(sizeof(MeshTaskCommand));
+        for (u32 layer = 0; layer < 2; layer++) {
+            batch.commandsOffset[layer] = commandsSize;
+            commandsSize += align(batch.commandsSize);
+            batch.countOffset[layer] = countSize;
+            countSize += align(sizeof(u32));
+        }
+    }
+
     {
-        cala::ImageResource pointDepth;
-        pointDepth.format = cala::vk::Format::RGBA8_UNORM;
-        pointDepth.matchSwapchain = false;
-        pointDepth.width = 10;
-        pointDepth.height = 10;
-        graph.addImageResource("pointDepth", pointDepth);
+        cala::ImageResource shadowCache;
+        shadowCache.format = cala::vk::Format::D32_SFLOAT;
+        shadowCache.matchSwapchain = false;
+        shadowCache.width = cacheImage->width();
+        shadowCache.height = cacheImage->height();
+        shadowCache.usage = cacheImage->usage();
+        shadowCache.persistent = true;
+        graph.addImageResource("shadowCache", shadowCache, cacheImage);
+
+        cala::BufferResource drawCommands;
+        drawCommands.size = std::max(commandsSize, 1u);
+        drawCommands.usage = cala::vk::BufferUsage::INDIRECT | cala::vk::BufferUsage::STORAGE;
+        graph.addBufferResource("shadowDrawCommands", drawCommands);
+
+        cala::BufferResource drawCount;
+        drawCount.size = std::max(countSize, 1u);
+        drawCount.usage = cala::vk::BufferUsage::INDIRECT | cala::vk::BufferUsage::STORAGE;
+        graph.addBufferResource("shadowDrawCount", drawCount);
     }
 
-    auto& pointShadows = graph.addPass("point_shadows", cala::RenderPass::Type::COMPUTE);
+    auto& shadowCull = graph.addPass("shadow_cull", cala::RenderPass::Type::COMPUTE);
+    shadowCull.setDebugGroup("shadows");
 
-    pointShadows.addUniformBufferRead("global", cala::vk::PipelineStage::COMPUTE_SHADER | cala::vk::PipelineStage::TASK_SHADER | cala::vk::PipelineStage::MESH_SHADER | cala::vk::PipelineStage::FRAGMENT_SHADER);
-    pointShadows.addStorageImageWrite("pointDepth", cala::vk::PipelineStage::FRAGMENT_SHADER);
-    pointShadows.addStorageBufferRead("transforms", cala::vk::PipelineStage::COMPUTE_SHADER | cala::vk::PipelineStage::TASK_SHADER | cala::vk::PipelineStage::MESH_SHADER);
-//    pointShadows.addStorageBufferRead("meshData", vk::PipelineStage::VERTEX_SHADER);
-    pointShadows.addVertexRead("vertexBuffer");
-    pointShadows.addIndexRead("indexBuffer");
-    pointShadows.addIndirectRead("shadowDrawCommands");
-    pointShadows.addStorageBufferRead("shadowDrawCommands", cala::vk::PipelineStage::TASK_SHADER | cala::vk::PipelineStage::COMPUTE_SHADER);
-    pointShadows.addStorageBufferWrite("shadowDrawCount", cala::vk::PipelineStage::COMPUTE_SHADER);
+    shadowCull.addUniformBufferRead("global", cala::vk::PipelineStage::COMPUTE_SHADER);
+    shadowCull.addStorageBufferRead("transforms", cala::vk::PipelineStage::COMPUTE_SHADER);
+    shadowCull.addStorageBufferRead("meshData", cala::vk::PipelineStage::COMPUTE_SHADER);
+    shadowCull.addStorageBufferRead("instances", cala::vk::PipelineStage::COMPUTE_SHADER);
+    shadowCull.addStorageBufferRead("camera", cala::vk::PipelineStage::COMPUTE_SHADER);
+    shadowCull.addStorageBufferWrite("shadowDrawCommands", cala::vk::PipelineStage::COMPUTE_SHADER);
+    shadowCull.addStorageBufferWrite("shadowDrawCount", cala::vk::PipelineStage::COMPUTE_SHADER);
 
-    pointShadows.setExecuteFunction([&engine, &scene](cala::vk::CommandHandle cmd, cala::RenderGraph& graph) {
+    shadowCull.setExecuteFunction([&engine, &scene, batches](cala::vk::CommandHandle cmd, cala::RenderGraph& graph) {
         auto global = graph.getBuffer("global");
         auto drawCommands = graph.getBuffer("shadowDrawCommands");
         auto drawCount = graph.getBuffer("shadowDrawCount");
-        u32 shadowIndex = 0;
-        for (u32 i = 0; i < scene._lights.size(); i++) {
-            auto& light = scene._lights[i];
-            if (light.shadowing()) {
-                switch (light.type()) {
-                    case cala::Light::LightType::DIRECTIONAL:
-                    {
-                        if (light.getCameraIndex() < 0)
-                            continue;
-                        auto directionalShadowMap = engine.getShadowMap(shadowIndex++, false, cmd);
-                        light.setShadowMap(directionalShadowMap);
-                        for (u32 cascadeIndex = 0; cascadeIndex < light.getCascadeCount(); cascadeIndex++) {
-                            light.setCascadeShadowMap(cascadeIndex, directionalShadowMap);
-                            cmd->clearDescriptors();
-                            cmd->bindProgram(engine.getProgram(cala::Engine::ProgramType::CULL_DIRECT));
-                            cmd->bindBindings({});
-                            cmd->bindAttributes({});
-                            cmd->pushConstants(cala::vk::ShaderStage::COMPUTE, light.getCameraIndex() + cascadeIndex);
-                            cmd->bindBuffer(1, 0, global);
-                            cmd->bindBuffer(2, 0, drawCommands, true);
-                            cmd->bindBuffer(2, 1, drawCount, true);
-                            cmd->bindPipeline();
-                            cmd->bindDescriptors();
-                            cmd->dispatch(scene.meshCount(), 1, 1);
-
-                            auto drawCommandBarrier = drawCommands->barrier(cala::vk::PipelineStage::COMPUTE_SHADER,
-                                                                            cala::vk::PipelineStage::TASK_SHADER | cala::vk::PipelineStage::DRAW_INDIRECT,
-                                                                            cala::vk::Access::SHADER_WRITE,
-                                                                            cala::vk::Access::SHADER_READ | cala::vk::Access::INDIRECT_READ);
-                            cmd->pipelineBarrier({ &drawCommandBarrier, 1 });
-
-                            cmd->begin(*engine.getShadowFramebuffer());
-
-                            cmd->clearDescriptors();
-                            cmd->bindRasterState({
-                                cala::vk::CullMode::NONE
-                            });
-                            cmd->bindDepthState({
-                                true, true,
-                                cala::vk::CompareOp::LESS_EQUAL
-                            });
-
-                            cmd->bindProgram(engine.getProgram(cala::Engine::ProgramType::SHADOW_DIRECT));
-
-                            cmd->pushConstants(cala::vk::ShaderStage::TASK | cala::vk::ShaderStage::MESH, light.getCameraIndex() + cascadeIndex);
-                            cmd->bindBuffer(1, 0, global);
-                            cmd->bindBuffer(1, 1, drawCommands, true);
-
-                            cmd->bindPipeline();
-                            cmd->bindDescriptors();
-                            cmd->drawMeshTasksIndirectCount(drawCommands, 0, drawCount, 0, sizeof(MeshTaskCommand));
-
-                            cmd->end(*engine.getShadowFramebuffer());
-
-                            auto srcBarrier = engine.getShadowTarget()->barrier(cala::vk::PipelineStage::LATE_FRAGMENT,
-                                                                                cala::vk::PipelineStage::TRANSFER,
-                                                                                cala::vk::Access::DEPTH_STENCIL_WRITE,
-                                                                                cala::vk::Access::TRANSFER_READ,
-                                                                                cala::vk::ImageLayout::TRANSFER_SRC);
-                            auto dstBarrier = directionalShadowMap->barrier(cala::vk::PipelineStage::FRAGMENT_SHADER,
-                                                                            cala::vk::PipelineStage::TRANSFER,
-                                                                            cala::vk::Access::SHADER_READ,
-                                                                            cala::vk::Access::TRANSFER_WRITE,
-                                                                            cala::vk::ImageLayout::TRANSFER_DST);
-                            cmd->pipelineBarrier({&srcBarrier, 1});
-                            cmd->pipelineBarrier({&dstBarrier, 1});
-
-                            engine.getShadowTarget()->copy(cmd, *directionalShadowMap, 0);
-                            srcBarrier = engine.getShadowTarget()->barrier(cala::vk::PipelineStage::TRANSFER,
-                                                                           cala::vk::PipelineStage::EARLY_FRAGMENT,
-                                                                           cala::vk::Access::TRANSFER_READ,
-                                                                           cala::vk::Access::DEPTH_STENCIL_WRITE,
-                                                                           cala::vk::ImageLayout::DEPTH_STENCIL_ATTACHMENT);
-                            dstBarrier = directionalShadowMap->barrier(cala::vk::PipelineStage::TRANSFER,
-                                                                       cala::vk::PipelineStage::FRAGMENT_SHADER,
-                                                                       cala::vk::Access::TRANSFER_WRITE,
-                                                                       cala::vk::Access::SHADER_READ,
-                                                                       cala::vk::ImageLayout::SHADER_READ_ONLY);
-                            cmd->pipelineBarrier({&srcBarrier, 1});
-                            cmd->pipelineBarrier({&dstBarrier, 1});
-
-                            directionalShadowMap = engine.getShadowMap(shadowIndex++, false, cmd);
-                        }
-                    }
-                        break;
-                    case cala::Light::LightType::POINT:
-                    {
-                        cala::Transform shadowTransform(light.getPosition());
-                        cala::Camera shadowCam(ende::math::rad(90.f), engine.getShadowMapSize(), engine.getShadowMapSize(), light.getNear(), light.getFar(), &shadowTransform);
-                        auto shadowMap = engine.getShadowMap(shadowIndex++, true, cmd);
-                        light.setShadowMap(shadowMap);
-
-                        for (u32 face = 0; face < 6; face++) {
-                            switch (face) {
-                                case 0:
-                                    shadowTransform.rotate({0, 1, 0}, ende::math::rad(90));
-                                    break;
-                                case 1:
-                                    shadowTransform.rotate({0, 1, 0}, ende::math::rad(180));
-                                    break;
-                                case 2:
-                                    shadowTransform.rotate({0, 1, 0}, ende::math::rad(90));
-                                    shadowTransform.rotate({1, 0, 0}, ende::math::rad(90));
-                                    break;
-                                case 3:
-                                    shadowTransform.rotate({1, 0, 0}, ende::math::rad(180));
-                                    break;
-                                case 4:
-                                    shadowTransform.rotate({1, 0, 0}, ende::math::rad(90));
-                                    break;
-                                case 5:
-                                    shadowTransform.rotate({0, 1, 0}, ende::math::rad(180));
-                                    break;
-                            }
-                            shadowCam.updateFrustum();
-                            ende::math::Frustum shadowFrustum = shadowCam.frustum();
-
-                            cmd->clearDescriptors();
-                            cmd->bindProgram(engine.getProgram(cala::Engine::ProgramType::CULL_POINT));
-                            cmd->bindBindings({});
-                            cmd->bindAttributes({});
-                            cmd->pushConstants(cala::vk::ShaderStage::COMPUTE, shadowFrustum);
-                            cmd->bindBuffer(1, 0, global);
-                            cmd->bindBuffer(2, 0, drawCommands, true);
-                            cmd->bindBuffer(2, 1, drawCount, true);
-                            cmd->bindPipeline();
-                            cmd->bindDescriptors();
-                            cmd->dispatch(scene.meshCount(), 1, 1);
-
-                            auto drawCommandBarrier = drawCommands->barrier(cala::vk::PipelineStage::COMPUTE_SHADER,
-                                                                            cala::vk::PipelineStage::TASK_SHADER | cala::vk::PipelineStage::DRAW_INDIRECT,
-                                                                            cala::vk::Access::SHADER_WRITE,
-                                                                            cala::vk::Access::SHADER_READ | cala::vk::Access::INDIRECT_READ);
-                            cmd->pipelineBarrier({ &drawCommandBarrier, 1 });
-
-
-                            cmd->begin(*engine.getShadowFramebuffer());
-
-                            cmd->clearDescriptors();
-                            cmd->bindRasterState({ cala::vk::CullMode::NONE });
-                            cmd->bindDepthState({
-                                true, true,
-                                cala::vk::CompareOp::LESS_EQUAL
-                            });
-
-                            cmd->bindProgram(engine.getProgram(cala::Engine::ProgramType::SHADOW_POINT));
-
-                            cmd->bindBuffer(3, 0, scene._lightBuffer[engine.device().frameIndex()],
-                                            sizeof(GPULight) * i + sizeof(u32), sizeof(GPULight), true);
-
-                            struct ShadowData {
-                                ende::math::Mat4f viewProjection;
-                            };
-                            ShadowData shadowData{
-                                    shadowCam.viewProjection()
-                            };
-                            cmd->pushConstants(cala::vk::ShaderStage::TASK, shadowFrustum);
-                            cmd->pushConstants(cala::vk::ShaderStage::MESH, shadowData, 96);
-                            cmd->bindBuffer(1, 0, global);
-                            cmd->bindBuffer(1, 1, drawCommands, true);
-
-                            cmd->bindPipeline();
-                            cmd->bindDescriptors();
-                            cmd->drawMeshTasksIndirectCount(drawCommands, 0, drawCount, 0, sizeof(MeshTaskCommand));
-
-                            cmd->end(*engine.getShadowFramebuffer());
-
-                            auto srcBarrier = engine.getShadowTarget()->barrier(cala::vk::PipelineStage::LATE_FRAGMENT,
-                                                              cala::vk::PipelineStage::TRANSFER,
-                                                              cala::vk::Access::DEPTH_STENCIL_WRITE,
-                                                              cala::vk::Access::TRANSFER_READ,
-                                                              cala::vk::ImageLayout::TRANSFER_SRC);
-                            auto dstBarrier = shadowMap->barrier(cala::vk::PipelineStage::FRAGMENT_SHADER,
-                                                                 cala::vk::PipelineStage::TRANSFER,
-                                                                 cala::vk::Access::SHADER_READ,
-                                                                 cala::vk::Access::TRANSFER_WRITE,
-                                                                 cala::vk::ImageLayout::TRANSFER_DST, face);
-                            cmd->pipelineBarrier({&srcBarrier, 1});
-                            cmd->pipelineBarrier({&dstBarrier, 1});
-
-                            engine.getShadowTarget()->copy(cmd, *shadowMap, 0, face);
-                            srcBarrier = engine.getShadowTarget()->barrier(cala::vk::PipelineStage::TRANSFER,
-                                                         cala::vk::PipelineStage::EARLY_FRAGMENT,
-                                                         cala::vk::Access::TRANSFER_READ,
-                                                         cala::vk::Access::DEPTH_STENCIL_WRITE,
-                                                         cala::vk::ImageLayout::DEPTH_STENCIL_ATTACHMENT);
-                            dstBarrier = shadowMap->barrier(cala::vk::PipelineStage::TRANSFER,
-                                                            cala::vk::PipelineStage::FRAGMENT_SHADER,
-                                                            cala::vk::Access::TRANSFER_WRITE,
-                                                            cala::vk::Access::SHADER_READ,
-                                                            cala::vk::ImageLayout::SHADER_READ_ONLY, face);
-                            cmd->pipelineBarrier({&srcBarrier, 1});
-                            cmd->pipelineBarrier({&dstBarrier, 1});
-                        }
-                    }
-                        break;
-                }
-            } else {
-                light.setShadowMap({});
+
+        // views of a batch share a draw count so it is cleared up front rather than by the first invocation
+        cmd->clearBuffer(drawCount);
+        auto barrier = drawCount->barrier(cala::vk::PipelineStage::TRANSFER, cala::vk::PipelineStage::COMPUTE_SHADER,
+                                          cala::vk::Access::TRANSFER_WRITE,
+                                          cala::vk::Access::SHADER_READ | cala::vk::Access::SHADER_WRITE);
+        cmd->pipelineBarrier({ &barrier, 1 });
+
+        for (auto& batch : batches) {
+            auto& light = scene._lights[batch.lightIndex];
+
+            for (u32 layer = 0; layer < 2; layer++) {
+                if (batch.viewMasks[layer] == 0)
+                    continue;
+
+                cmd->clearDescriptors();
+                if (light.type() == cala::Light::LightType::DIRECTIONAL)
+                    cmd->bindProgram(engine.getProgram(cala::Engine::ProgramType::CULL_DIRECT));
+                else
+                    cmd->bindProgram(engine.getProgram(cala::Engine::ProgramType::CULL_POINT));
+                cmd->bindBindings({});
+                cmd->bindAttributes({});
+                struct Push {
+                    u32 cameraIndex;
+                    u32 dynamicCasters;
+                    u32 viewMask;
+                } push;
+                push.cameraIndex = light.getCameraIndex();
+                push.dynamicCasters = layer;
+                push.viewMask = batch.viewMasks[layer];
+                cmd->pushConstants(cala::vk::ShaderStage::COMPUTE, push);
+                cmd->bindBuffer(1, 0, global);
+                cmd->bindBuffer(2, 0, drawCommands, batch.commandsOffset[layer], batch.commandsSize, true);
+                cmd->bindBuffer(2, 1, drawCount, batch.countOffset[layer], sizeof(u32), true);
+                cmd->bindPipeline();
+                cmd->bindDescriptors();
+                // a workgroup traverses the meshlet hierarchy of each instance and view, wrapped into z past the
+                // dispatch limit
+                constexpr u32 maxWorkgroups = 65535;
+                u32 instanceCount = scene.instanceCount();
+                cmd->dispatchWorkgroups(std::min(instanceCount, maxWorkgroups), batch.viewCount, (instanceCount + maxWorkgroups - 1) / maxWorkgroups);
             }
         }
     });
-}
\ No newline at end of file
+
+    if (atlas.refreshedViews() > 0) {
+        auto& cachePass = graph.addPass("shadow_cache");
+        cachePass.setDebugGroup("shadows");
+        cachePass.setDimensions(cacheImage->width(), cacheImage->height());
+
+        cachePass.addDepthWrite("shadowCache");
+        cachePass.addUniformBufferRead("global", cala::vk::PipelineStage::TASK_SHADER | cala::vk::PipelineStage::MESH_SHADER | cala::vk::PipelineStage::FRAGMENT_SHADER);
+        cachePass.addStorageBufferRead("transforms", cala::vk::PipelineStage::TASK_SHADER | cala::vk::PipelineStage::MESH_SHADER);
+        cachePass.addStorageBufferRead("meshData", cala::vk::PipelineStage::TASK_SHADER);
+        cachePass.addStorageBufferRead("instances", cala::vk::PipelineStage::TASK_SHADER);
+        cachePass.addStorageBufferRead("camera", cala::vk::PipelineStage::TASK_SHADER | cala::vk::PipelineStage::MESH_SHADER);
+        cachePass.addStorageBufferRead("vertexBuffer", cala::vk::PipelineStage::MESH_SHADER);
+        cachePass.addStorageBufferRead("indexBuffer", cala::vk::PipelineStage::MESH_SHADER);
+        cachePass.addIndirectRead("shadowDrawCommands");
+        cachePass.addStorageBufferRead("shadowDrawCommands", cala::vk::PipelineStage::TASK_SHADER);
+        cachePass.addIndirectRead("shadowDrawCount");
+
+        // refreshed views clear their tile and render static casters into the cache, other tiles are left untouched
+        cachePass.setExecuteFunction([&engine, &scene, batches](cala::vk::CommandHandle cmd, cala::RenderGraph& graph) {
+            drawShadowBatches(cmd, graph, engine, scene, batches, 0);
+        });
+    }
+
+    auto& compositePass = graph.addPass("shadow_composite", cala::RenderPass::Type::TRANSFER);
+    compositePass.setDebugGroup("shadows");
+
+    compositePass.addTransferRead("shadowCache");
+    compositePass.addTransferWrite("shadowAtlas");
+
+    compositePass.setExecuteFunction([&engine](cala::vk::CommandHandle cmd, cala::RenderGraph& graph) {
+        auto cache = graph.getImage("shadowCache");
+        auto atlas = graph.getImage("shadowAtlas");
+        for (auto& view : engine.shadowAtlas().views()) {
+            if (!view.composite)
+                continue;
+            VkOffset3D offset = { static_cast<i32>(view.tile.x), static_cast<i32>(view.tile.y), 0 };
+            cache->copy(cmd, *atlas, offset, offset, { view.tile.size, view.tile.size, 1 });
+        }
+    });
+
+    auto& shadowPass = graph.addPass("shadows");
+    shadowPass.setDebugGroup("shadows");
+    shadowPass.setDimensions(atlasImage->width(), atlasImage->height());
+
+    shadowPass.addDepthWrite("shadowAtlas");
+    shadowPass.addUniformBufferRead("global", cala::vk::PipelineStage::TASK_SHADER | cala::vk::PipelineStage::MESH_SHADER | cala::vk::PipelineStage::FRAGMENT_SHADER);
+    shadowPass.addStorageBufferRead("transforms", cala::vk::PipelineStage::TASK_SHADER | cala::vk::PipelineStage::MESH_SHADER);
+    shadowPass.addStorageBufferRead("meshData", cala::vk::PipelineStage::TASK_SHADER);
+    shadowPass.addStorageBufferRead("instances", cala::vk::PipelineStage::TASK_SHADER);
+    shadowPass.addStorageBufferRead("camera", cala::vk::PipelineStage::TASK_SHADER | cala::vk::PipelineStage::MESH_SHADER);
+    shadowPass.addStorageBufferRead("vertexBuffer", cala::vk::PipelineStage::MESH_SHADER);
+    shadowPass.addStorageBufferRead("indexBuffer", cala::vk::PipelineStage::MESH_SHADER);
+    shadowPass.addIndirectRead("shadowDrawCommands");
+    shadowPass.addStorageBufferRead("shadowDrawCommands", cala::vk::PipelineStage::TASK_SHADER);
+    shadowPass.addIndirectRead("shadowDrawCount");
+
+    // dynamic casters are drawn over the static shadows copied from the cache
+    shadowPass.setExecuteFunction([&engine, &scene, batches](cala::vk::CommandHandle cmd, cala::RenderGraph& graph) {
+        drawShadowBatches(cmd, graph, engine, scene, batches, 1);
+    });
+}
@@ -5,6 +5,7 @@
 #include <Cala/Scene.h>
 #include <Cala/Renderer.h>
 
-void shadowPoint(cala::RenderGraph& graph, cala::Engine& engine, cala::Scene& scene);
+// drawCommandCapacity is the meshlet range commands each light's views are given, at least one per instance and view
+void shadowPoint(cala::RenderGraph& graph, cala::Engine& engine, cala::Scene& scene, u32 drawCommandCapacity);
 
 #endif //CALA_SHADOWPASSES_H
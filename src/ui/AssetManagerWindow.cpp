@@ -63,12 +63,17 @@ void cala::ui::AssetManagerWindow::render() {
         if (ImGui::TreeNode("Images")) {
             ImGui::Separator();
             u32 imageID = 0;
+            f64 totalDecodeTime = 0;
+            for (auto& imageMetadata : _assetManager->_images)
+                totalDecodeTime += imageMetadata.decodeTime;
+            ImGui::Text("Total Decode Time: %.2f ms", totalDecodeTime);
             _assetViews.resize(_assetManager->_images.size(), ImageView(_context, &_assetManager->_engine->device()));
             for (u32 i = 0; i < _assetManager->_images.size(); i++) {
                 auto& imageMetadata = _assetManager->_images[i];
                 ImGui::Text("Name: %s", imageMetadata.name.c_str());
                 ImGui::Text("Path: %s", imageMetadata.path.c_str());
                 ImGui::Text("\tHandle: %i, Count: %i", imageMetadata.imageHandle.index(), imageMetadata.imageHandle.count());
+                ImGui::Text("\tDecode Time: %.2f ms", imageMetadata.decodeTime);
                 std::string label = std::format("Image##{}", i);
                 if (ImGui::TreeNode(label.c_str())) {
                     auto availSize = ImGui::GetContentRegionAvail();
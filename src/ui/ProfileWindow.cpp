@@ -85,6 +85,8 @@ void cala::ui::ProfileWindow::render() {
         it.value()[_frameOffset] = time / 1e6;
     }
     _gpuTimes[_frameOffset] = totalGPUTime / 1e6;
+    auto rendererStats = _renderer->stats();
+    _latencies[_frameOffset] = rendererStats.inputLatency;
 
     // cpu average
     f32 cpuTotal = 0;
@@ -139,6 +141,17 @@ void cala::ui::ProfileWindow::render() {
             ImGui::TableNextRow();
             ImGui::TableSetColumnIndex(0);
 
+            // measured from input sampling, to presentation with present wait or gpu completion as an estimate
+            ImGui::Text("%s Latency: %f", rendererStats.presentLatency ? "Input To Present" : "Input To GPU", rendererStats.inputLatency);
+            ImGui::Text("Frame Wait: %f", rendererStats.frameWaitTime);
+
+            ImGui::TableNextColumn();
+
+            simplePlotGraph(std::format("{} ms", rendererStats.inputLatency).c_str(), _latencies, _frameOffset, 30.f);
+
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+
             ImGui::Text("CPU Times:");
             ImGui::TableNextRow();
             ImGui::TableSetColumnIndex(0);
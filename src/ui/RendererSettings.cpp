@@ -18,10 +18,75 @@ void cala::ui::RendererSettingsWindow::render() {
         if (ImGui::TreeNode("Shadows")) {
             const char* sizeStrings[] = { "256", "512", "1024", "2048", "4096" };
             u32 sizes[] = { 256, 512, 1024, 2048, 4096 };
-            static int sizeIndex = 0;
-            if (ImGui::Combo("ShadowMap Size", &sizeIndex, sizeStrings, 5)) {
+            static int sizeIndex = 2;
+            if (ImGui::Combo("Max ShadowMap Size", &sizeIndex, sizeStrings, 5)) {
                 _engine->setShadowMapSize(sizes[sizeIndex]);
             }
+            const char* atlasSizeStrings[] = { "2048", "4096", "8192" };
+            u32 atlasSizes[] = { 2048, 4096, 8192 };
+            static int atlasSizeIndex = 1;
+            if (ImGui::Combo("Shadow Atlas Size", &atlasSizeIndex, atlasSizeStrings, 3)) {
+                _engine->device().wait();
+                _engine->setShadowAtlasSize(atlasSizes[atlasSizeIndex]);
+            }
+            bool cacheShadows = _engine->shadowAtlas().caching();
+            if (ImGui::Checkbox("Cache Shadows", &cacheShadows))
+                _engine->shadowAtlas().setCaching(cacheShadows);
+            f32 cacheThreshold = _engine->shadowAtlas().cacheThreshold();
+            if (ImGui::SliderFloat("Cache Threshold (texels)", &cacheThreshold, 0.f, 8.f))
+                _engine->shadowAtlas().setCacheThreshold(cacheThreshold);
+            bool stableCascades = _engine->shadowAtlas().stableCascades();
+            if (ImGui::Checkbox("Stable Cascades", &stableCascades))
+                _engine->shadowAtlas().setStableCascades(stableCascades);
+            if (ImGui::TreeNode("Shadow Atlas")) {
+                auto& atlas = _engine->shadowAtlas();
+                auto views = atlas.views();
+
+                // draw tile layout scaled to fit the window width
+                f32 canvasSize = std::min(ImGui::GetContentRegionAvail().x, 512.f);
+                f32 scale = canvasSize / static_cast<f32>(atlas.size());
+                ImVec2 origin = ImGui::GetCursorScreenPos();
+                auto drawList = ImGui::GetWindowDrawList();
+                drawList->AddRectFilled(origin, { origin.x + canvasSize, origin.y + canvasSize }, IM_COL32(30, 30, 30, 255));
+                for (auto& view : views) {
+                    ImVec2 min = { origin.x + view.tile.x * scale, origin.y + view.tile.y * scale };
+                    ImVec2 max = { min.x + view.tile.size * scale, min.y + view.tile.size * scale };
+                    u32 hue = (view.lightIndex * 67) % 256;
+                    drawList->AddRectFilled(min, max, IM_COL32(hue, 255 - hue, 128, 160));
+                    drawList->AddRect(min, max, IM_COL32(255, 255, 255, 255));
+                }
+                ImGui::Dummy({ canvasSize, canvasSize });
+
+                u32 usedTexels = 0;
+                for (auto& view : views)
+                    usedTexels += view.tile.size * view.tile.size;
+                ImGui::Text("Views: %lu, Usage: %.1f%%", views.size(), 100.f * static_cast<f32>(usedTexels) / static_cast<f32>(atlas.size() * atlas.size()));
+                ImGui::Text("Refreshed: %d, Composited: %d, Reused: %d", atlas.refreshedViews(), atlas.compositedViews(), atlas.reusedViews());
+
+                if (ImGui::BeginTable("Tiles", 5)) {
+                    ImGui::TableSetupColumn("Light");
+                    ImGui::TableSetupColumn("View");
+                    ImGui::TableSetupColumn("Offset");
+                    ImGui::TableSetupColumn("Size");
+                    ImGui::TableSetupColumn("State");
+                    ImGui::TableHeadersRow();
+                    for (auto& view : views) {
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%d", view.lightIndex);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%d", view.viewIndex);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("(%d, %d)", view.tile.x, view.tile.y);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%d", view.tile.size);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%s", view.refresh ? "Refreshed" : view.composite ? "Composited" : "Reused");
+                    }
+                    ImGui::EndTable();
+                }
+                ImGui::TreePop();
+            }
             const char* modeStrings[] = { "PCSS", "PCF", "HARD" };
             static int modeIndex = 0;
             if (ImGui::Combo("Shadow Mode", &modeIndex, modeStrings, 3))
@@ -46,19 +111,52 @@ void cala::ui::RendererSettingsWindow::render() {
             ImGui::Checkbox("Bloom", &rendererSettings.bloom);
             if (rendererSettings.bloom) {
                 ImGui::SliderFloat("Bloom Strength", &rendererSettings.bloomStrength, 0, 1);
+                ImGui::Checkbox("Compact Bloom", &rendererSettings.compactBloom);
             }
             ImGui::TreePop();
         }
         ImGui::Checkbox("Freeze Frustum,", &rendererSettings.freezeFrustum);
         ImGui::Checkbox("IBL,", &rendererSettings.ibl);
         ImGui::Checkbox("GPU Culling", &rendererSettings.gpuCulling);
+        ImGui::Checkbox("Cone Culling", &rendererSettings.coneCulling);
+        ImGui::Checkbox("Shadow Cone Culling", &rendererSettings.shadowConeCulling);
+        ImGui::Checkbox("Small Primitive Culling", &rendererSettings.smallPrimitiveCulling);
+        ImGui::Checkbox("Occlusion Culling", &rendererSettings.occlusionCulling);
+        ImGui::Checkbox("Parallel Recording", &rendererSettings.parallelRecording);
         ImGui::SliderFloat("LOD Transition Base", &rendererSettings.lodTransitionBase, 1, 100);
         ImGui::SliderFloat("LOD Transition Step", &rendererSettings.lodTransitionStep, 1, 20);
+        ImGui::SliderFloat("LOD Error Threshold", &rendererSettings.lodErrorThreshold, 0.25, 16);
         ImGui::SliderInt("LOD bias", &rendererSettings.lodBias, 0, MAX_LODS - 1);
         ImGui::SliderInt("Shadow LOD bias", &rendererSettings.shadowLodBias, 0, MAX_LODS - 1);
         ImGui::Checkbox("Bounded FrameTime", &rendererSettings.boundedFrameTime);
         ImGui::SliderInt("Target FPS", &_targetFPS, 5, 240);
         rendererSettings.millisecondTarget = 1000.f / _targetFPS;
+        ImGui::SliderInt("Frames In Flight", &rendererSettings.framesInFlight, 1, vk::FRAMES_IN_FLIGHT);
+        ImGui::Checkbox("Adaptive Frame Wait", &rendererSettings.adaptiveFrameWait);
+        if (rendererSettings.adaptiveFrameWait)
+            ImGui::SliderFloat("Frame Wait Margin", &rendererSettings.frameWaitMargin, 0, 5);
+        ImGui::Checkbox("Present Wait", &rendererSettings.presentWait);
+        ImGui::Checkbox("Dynamic Resolution", &rendererSettings.dynamicResolution);
+        if (rendererSettings.dynamicResolution) {
+            ImGui::SliderFloat("GPU Time Target", &rendererSettings.gpuTimeTarget, 1, 100);
+            ImGui::SliderFloat("Min Render Scale", &rendererSettings.minRenderScale, 0.25, 1);
+            ImGui::SliderFloat("Max Render Scale", &rendererSettings.maxRenderScale, 0.25, 1);
+        } else
+            ImGui::SliderFloat("Render Scale", &rendererSettings.renderScale, 0.25, 1);
+        ImGui::Checkbox("TAA", &rendererSettings.taa);
+        if (rendererSettings.taa)
+            ImGui::SliderFloat("TAA Blend Factor", &rendererSettings.taaBlendFactor, 0.01, 1);
+        ImGui::Checkbox("Variable Rate Shading", &rendererSettings.variableRateShading);
+        if (rendererSettings.variableRateShading) {
+            ImGui::SliderFloat("Shading Rate Threshold", &rendererSettings.shadingRateThreshold, 0, 0.5);
+            ImGui::SliderFloat("Shading Rate Depth Threshold", &rendererSettings.shadingRateDepthThreshold, 0, 0.5);
+        }
+        ImGui::Checkbox("Probe GI", &rendererSettings.probeGI);
+        if (rendererSettings.probeGI) {
+            ImGui::SliderInt3("Probe Grid Size", rendererSettings.probeGridSize.data(), 2, 64);
+            ImGui::SliderInt("Probe Update Budget", &rendererSettings.probeUpdateBudget, 1, 4096);
+            ImGui::SliderFloat("Probe Hysteresis", &rendererSettings.probeHysteresis, 0, 0.99);
+        }
 
         const char* modes[] = { "FIFO", "MAILBOX", "IMMEDIATE" };
         static int modeIndex = 0;
@@ -56,15 +56,19 @@ void traverseSceneNode(cala::Scene::SceneNode* node, cala::Scene* scene, u32 sel
                         ImGui::PopID();
                         continue;
                     }
-                    auto& meshInfo = scene->_meshes[meshNode->index];
-                    auto& meshData = scene->_meshData[meshNode->index];
+                    auto& instance = scene->_instances[meshNode->index];
+                    auto& meshInfo = scene->_meshes[instance.meshIndex];
 
-                    bool enabled = meshData.enabled;
-                    if (ImGui::Checkbox("Enabled", &enabled))
-                        meshData.enabled = enabled;
-                    bool castShadows = meshData.castShadows;
-                    if (ImGui::Checkbox("Cast Shadows", &castShadows))
-                        meshData.castShadows = castShadows;
+                    bool enabled = instance.flags & CALA_INSTANCE_ENABLED;
+                    if (ImGui::Checkbox("Enabled", &enabled)) {
+                        instance.flags ^= CALA_INSTANCE_ENABLED;
+                        scene->_instancesDirtyFrame = cala::vk::FRAMES_IN_FLIGHT;
+                    }
+                    bool castShadows = instance.flags & CALA_INSTANCE_CAST_SHADOWS;
+                    if (ImGui::Checkbox("Cast Shadows", &castShadows)) {
+                        instance.flags ^= CALA_INSTANCE_CAST_SHADOWS;
+                        scene->_instancesDirtyFrame = cala::vk::FRAMES_IN_FLIGHT;
+                    }
 
                     ImGui::Text("First Index: %u", meshInfo.firstIndex);
                     ImGui::Text("Index Count: %u", meshInfo.indexCount);
@@ -97,7 +101,7 @@ void traverseSceneNode(cala::Scene::SceneNode* node, cala::Scene* scene, u32 sel
                         meshNode->transform.setScale(scale);
                     }
 
-                    auto materialInstance = meshInfo.materialInstance;
+                    auto materialInstance = scene->_instanceMaterials[meshNode->index];
                     auto& litVariant = materialInstance->material()->getVariant(cala::Material::Variant::LIT);
                     auto parameters = litVariant.interface().getBindingMemberList(2, 0);
 
@@ -253,6 +257,32 @@ void traverseSceneNode(cala::Scene::SceneNode* node, cala::Scene* scene, u32 sel
                 }
             }
                 break;
+            case cala::Scene::NodeType::INSTANCES:
+            {
+                auto instancesNode = dynamic_cast<cala::Scene::InstancesNode*>(child.get());
+                auto label = std::format("Instances: {} - {}", instancesNode->firstInstance, instancesNode->firstInstance + instancesNode->transforms.size());
+                if (ImGui::TreeNode(label.c_str())) {
+                    if (ImGui::Button("Delete")) {
+                        scene->removeChildNode(node, childIndex--);
+                        ImGui::TreePop();
+                        ImGui::PopID();
+                        continue;
+                    }
+                    ImGui::Text("Instance Count: %lu", instancesNode->transforms.size());
+                    if (!instancesNode->transforms.empty()) {
+                        auto& meshInfo = scene->_meshes[scene->_instances[instancesNode->firstInstance].meshIndex];
+                        ImGui::Text("First Meshlet: %u", meshInfo.meshletIndex);
+                        ImGui::Text("Meshlet Count: %u", meshInfo.meshletCount);
+                    }
+                    auto position = child->transform.pos();
+                    if (ImGui::DragFloat3("Position", &position[0], 0.1)) {
+                        child->transform.setPos(position);
+                    }
+                    traverseSceneNode(child.get(), scene, selectedMesh);
+                    ImGui::TreePop();
+                }
+            }
+                break;
         }
         ImGui::PopID();
 //        childIndex++;
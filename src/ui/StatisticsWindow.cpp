@@ -45,7 +45,16 @@ void cala::ui::StatisticsWindow::render() {
             if (rendererStats.drawnMeshlets + rendererStats.culledMeshlets == 0)
                 culledMeshletRatio = 0;
             ImGui::Text("Culled meshlet ratio: %.0f%%", culledMeshletRatio);
+            ImGui::Text("Cone Culled Meshlets: %d", rendererStats.coneCulledMeshlets);
+            ImGui::Text("Small Culled Meshlets: %d", rendererStats.smallCulledMeshlets);
+            ImGui::Text("Occluded Meshlets: %d", rendererStats.occludedMeshlets);
             ImGui::Text("Drawn Triangles %d", rendererStats.drawnTriangles);
+            ImGui::Text("Light Index Capacity: %d", rendererStats.lightIndexCapacity);
+            ImGui::Text("Dropped Light Indices: %d", rendererStats.droppedLightIndices);
+            ImGui::Text("Visited Meshlet Nodes: %d", rendererStats.visitedNodes);
+            ImGui::Text("Draw Command Capacity: %d", rendererStats.drawCommandCapacity);
+            ImGui::Text("Dropped Draw Commands: %d", rendererStats.droppedDrawCommands);
+            ImGui::Text("Shaded pixel ratio: %.0f%%", rendererStats.shadedPixelRatio * 100);
         } else {
             ImGui::Text("Total Meshlets: %s", numberToWord(rendererStats.sceneMeshlets).c_str());
             ImGui::Text("Total Indices: %s", numberToWord(rendererStats.sceneIndices).c_str());
@@ -63,7 +72,16 @@ void cala::ui::StatisticsWindow::render() {
             if (rendererStats.drawnMeshlets + rendererStats.culledMeshlets == 0)
                 culledMeshletRatio = 0;
             ImGui::Text("Culled meshlet ratio: %.0f%%", culledMeshletRatio);
+            ImGui::Text("Cone Culled Meshlets: %s", numberToWord(rendererStats.coneCulledMeshlets).c_str());
+            ImGui::Text("Small Culled Meshlets: %s", numberToWord(rendererStats.smallCulledMeshlets).c_str());
+            ImGui::Text("Occluded Meshlets: %s", numberToWord(rendererStats.occludedMeshlets).c_str());
             ImGui::Text("Drawn Triangles %s", numberToWord(rendererStats.drawnTriangles).c_str());
+            ImGui::Text("Light Index Capacity: %s", numberToWord(rendererStats.lightIndexCapacity).c_str());
+            ImGui::Text("Dropped Light Indices: %s", numberToWord(rendererStats.droppedLightIndices).c_str());
+            ImGui::Text("Visited Meshlet Nodes: %s", numberToWord(rendererStats.visitedNodes).c_str());
+            ImGui::Text("Draw Command Capacity: %s", numberToWord(rendererStats.drawCommandCapacity).c_str());
+            ImGui::Text("Dropped Draw Commands: %s", numberToWord(rendererStats.droppedDrawCommands).c_str());
+            ImGui::Text("Shaded pixel ratio: %.0f%%", rendererStats.shadedPixelRatio * 100);
         }
 
         ImGui::Separator();
@@ -76,6 +94,28 @@ void cala::ui::StatisticsWindow::render() {
 
         ImGui::Separator();
 
+        ImGui::Text("Shadow Views Refreshed: %d", rendererStats.shadowViewsRefreshed);
+        ImGui::Text("Shadow Views Composited: %d", rendererStats.shadowViewsComposited);
+        ImGui::Text("Shadow Views Reused: %d", rendererStats.shadowViewsReused);
+
+        ImGui::Separator();
+
+        ImGui::Text("GPU Time: %.3f ms", rendererStats.gpuTime);
+        ImGui::Text("Render Scale: %.2f", rendererStats.renderScale);
+
+        ImGui::Separator();
+
+        auto assetManager = _engine->assetManager();
+        f32 residentMB = static_cast<f32>(assetManager->residentBytes()) / 1000000.f;
+        f32 budgetMB = static_cast<f32>(assetManager->residencyBudget()) / 1000000.f;
+        ImGui::Text("Texture Residency: %.1f / %.1f mb", residentMB, budgetMB);
+        ImGui::ProgressBar(budgetMB > 0 ? residentMB / budgetMB : 0.f);
+        ImGui::Text("Requested Textures: %.1f mb", static_cast<f32>(assetManager->requestedBytes()) / 1000000.f);
+        ImGui::Text("Streamed Images: %d", assetManager->streamedImages());
+        ImGui::Text("Images Streaming: %d", assetManager->streamingImages());
+
+        ImGui::Separator();
+
         auto pipelineStats = _engine->device().context().getPipelineStatistics();
 
         ImGui::Text("Input Assembly Vertices: %lu", pipelineStats.inputAssemblyVertices);
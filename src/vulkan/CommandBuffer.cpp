@@ -9,6 +9,7 @@ cala::vk::CommandBuffer::CommandBuffer(Device& device, VkQueue queue, VkCommandB
     _buffer(buffer),
     _queue(queue),
     _active(false),
+    _secondary(false),
     _indexBuffer{},
     _currentPipeline(VK_NULL_HANDLE),
     _currentSets{VK_NULL_HANDLE},
@@ -17,7 +18,6 @@ cala::vk::CommandBuffer::CommandBuffer(Device& device, VkQueue queue, VkCommandB
     _descriptorDirty(true)
 {
     memset(&_pipelineKey, 0, sizeof(PipelineKey));
-    _pipelineKey.viewPort.maxDepth = 1.f;
 }
 
 cala::vk::CommandBuffer::~CommandBuffer() {}
@@ -27,6 +27,7 @@ cala::vk::CommandBuffer::CommandBuffer(CommandBuffer &&rhs) noexcept
     _buffer(VK_NULL_HANDLE),
     _queue(VK_NULL_HANDLE),
     _active(false),
+    _secondary(false),
     _indexBuffer{},
     _boundProgram(nullptr),
     _pipelineKey(),
@@ -36,6 +37,8 @@ cala::vk::CommandBuffer::CommandBuffer(CommandBuffer &&rhs) noexcept
     std::swap(_buffer, rhs._buffer);
     std::swap(_queue, rhs._queue);
     std::swap(_active, rhs._active);
+    std::swap(_secondary, rhs._secondary);
+    std::swap(_pendingLayouts, rhs._pendingLayouts);
     std::swap(_indexBuffer, rhs._indexBuffer);
     std::swap(_boundProgram, rhs._boundProgram);
     std::swap(_pipelineKey, rhs._pipelineKey);
@@ -54,6 +57,8 @@ cala::vk::CommandBuffer &cala::vk::CommandBuffer::operator=(CommandBuffer &&rhs)
     std::swap(_buffer, rhs._buffer);
     std::swap(_queue, rhs._queue);
     std::swap(_active, rhs._active);
+    std::swap(_secondary, rhs._secondary);
+    std::swap(_pendingLayouts, rhs._pendingLayouts);
     std::swap(_indexBuffer, rhs._indexBuffer);
     std::swap(_boundProgram, rhs._boundProgram);
     std::swap(_pipelineKey, rhs._pipelineKey);
@@ -74,10 +79,40 @@ bool cala::vk::CommandBuffer::begin() {
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     _active = vkBeginCommandBuffer(_buffer, &beginInfo) == VK_SUCCESS;
+    _secondary = false;
     _drawCallCount = 0;
     return _active;
 }
 
+bool cala::vk::CommandBuffer::beginSecondary(Framebuffer* framebuffer) {
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    if (framebuffer) {
+        inheritanceInfo.renderPass = framebuffer->renderPass().renderPass();
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = framebuffer->framebuffer();
+    }
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (framebuffer)
+        beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    _active = vkBeginCommandBuffer(_buffer, &beginInfo) == VK_SUCCESS;
+    _secondary = true;
+    _pendingLayouts.clear();
+    _drawCallCount = 0;
+    // secondary buffers inherit no state so everything must be rebound
+    _currentPipeline = VK_NULL_HANDLE;
+    _pipelineKey.framebuffer = framebuffer;
+    _pipelineDirty = true;
+    _descriptorDirty = true;
+    if (_active && framebuffer)
+        bindViewPort({ 0, 0, static_cast<f32>(framebuffer->extent().first), static_cast<f32>(framebuffer->extent().second) });
+    return _active;
+}
+
 bool cala::vk::CommandBuffer::end() {
     if (!_active)
         return false;
@@ -99,7 +134,7 @@ bool cala::vk::CommandBuffer::end() {
     return res;
 }
 
-void cala::vk::CommandBuffer::begin(RenderPass &renderPass, VkFramebuffer framebuffer, std::pair<u32, u32> extent) {
+void cala::vk::CommandBuffer::begin(RenderPass &renderPass, VkFramebuffer framebuffer, std::pair<u32, u32> extent, bool secondaryContents) {
 
     VkRenderPassBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -112,11 +147,14 @@ void cala::vk::CommandBuffer::begin(RenderPass &renderPass, VkFramebuffer frameb
     beginInfo.clearValueCount = clearValues.size();
     beginInfo.pClearValues = clearValues.data();
 
-    vkCmdBeginRenderPass(_buffer, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(_buffer, &beginInfo, secondaryContents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+    // commands can't be recorded inline when contents are in secondaries
+    if (!secondaryContents)
+        bindViewPort({ 0, 0, static_cast<f32>(extent.first), static_cast<f32>(extent.second) });
 }
 
-void cala::vk::CommandBuffer::begin(Framebuffer &framebuffer) {
-    begin(framebuffer.renderPass(), framebuffer.framebuffer(), framebuffer.extent());
+void cala::vk::CommandBuffer::begin(Framebuffer &framebuffer, bool secondaryContents) {
+    begin(framebuffer.renderPass(), framebuffer.framebuffer(), framebuffer.extent(), secondaryContents);
     _pipelineKey.framebuffer = &framebuffer;
 }
 
@@ -219,15 +257,29 @@ void cala::vk::CommandBuffer::bindVertexArray(std::span<VkVertexInputBindingDesc
 }
 
 void cala::vk::CommandBuffer::bindViewPort(const ViewPort &viewport) {
-    if (_pipelineKey.viewPort.x != viewport.x ||
-        _pipelineKey.viewPort.y != viewport.y ||
-        _pipelineKey.viewPort.width != viewport.width ||
-        _pipelineKey.viewPort.height != viewport.height ||
-        _pipelineKey.viewPort.minDepth != viewport.minDepth ||
-        _pipelineKey.viewPort.maxDepth != viewport.maxDepth) {
-        _pipelineKey.viewPort = viewport;
-        _pipelineDirty = true;
+    bindViewPorts({ &viewport, 1 });
+}
+
+void cala::vk::CommandBuffer::bindViewPorts(std::span<const ViewPort> viewports) {
+    VkViewport vkViewports[viewports.size()];
+    VkRect2D scissors[viewports.size()];
+    for (u32 i = 0; i < viewports.size(); i++) {
+        auto& viewport = viewports[i];
+        vkViewports[i] = {};
+        vkViewports[i].x = viewport.x;
+        vkViewports[i].y = viewport.y;
+        vkViewports[i].width = viewport.width;
+        vkViewports[i].height = viewport.height;
+        vkViewports[i].minDepth = viewport.minDepth;
+        vkViewports[i].maxDepth = viewport.maxDepth;
+
+        scissors[i] = {};
+        scissors[i].offset = { static_cast<i32>(viewport.x), static_cast<i32>(viewport.y) };
+        scissors[i].extent = { static_cast<u32>(viewport.width), static_cast<u32>(viewport.height) };
     }
+
+    vkCmdSetViewportWithCount(_buffer, viewports.size(), vkViewports);
+    vkCmdSetScissorWithCount(_buffer, viewports.size(), scissors);
 }
 
 void cala::vk::CommandBuffer::bindRasterState(RasterState state) {
@@ -510,6 +562,20 @@ void cala::vk::CommandBuffer::clearBuffer(cala::vk::BufferHandle buffer, u32 cle
     vkCmdFillBuffer(_buffer, buffer->buffer(), 0, buffer->size(), clearValue);
 }
 
+void cala::vk::CommandBuffer::clearDepthAttachment(const ViewPort& region, f32 depth) {
+    VkClearAttachment attachment{};
+    attachment.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    attachment.clearValue.depthStencil = { depth, 0 };
+
+    VkClearRect rect{};
+    rect.rect.offset = { static_cast<i32>(region.x), static_cast<i32>(region.y) };
+    rect.rect.extent = { static_cast<u32>(region.width), static_cast<u32>(region.height) };
+    rect.baseArrayLayer = 0;
+    rect.layerCount = 1;
+
+    vkCmdClearAttachments(_buffer, 1, &attachment, 1, &rect);
+}
+
 void cala::vk::CommandBuffer::pipelineBarrier(std::span<VkBufferMemoryBarrier2> bufferBarriers, std::span<VkImageMemoryBarrier2> imageBarriers) {
     VkDependencyInfo info{};
     info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
@@ -538,7 +604,10 @@ void cala::vk::CommandBuffer::pipelineBarrier(std::span<Image::Barrier> imageBar
         b.srcQueueFamilyIndex = -1;
         b.dstQueueFamilyIndex = -1;
         b.pNext = nullptr;
-        barrier.image->setLayout(getImageLayout(barrier.dstLayout));
+        if (_secondary)
+            _pendingLayouts.push_back(std::make_pair(barrier.image, getImageLayout(barrier.dstLayout)));
+        else
+            barrier.image->setLayout(getImageLayout(barrier.dstLayout));
     }
     VkDependencyInfo info{};
     info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
@@ -593,6 +662,20 @@ void cala::vk::CommandBuffer::pipelineBarrier(std::span<MemoryBarrier> memoryBar
     vkCmdPipelineBarrier2(_buffer, &info);
 }
 
+void cala::vk::CommandBuffer::executeCommands(CommandHandle secondary) {
+    assert(secondary->secondary());
+    VkCommandBuffer buffer = secondary->buffer();
+    vkCmdExecuteCommands(_buffer, 1, &buffer);
+    for (auto& [image, layout] : secondary->_pendingLayouts)
+        image->setLayout(layout);
+    secondary->_pendingLayouts.clear();
+    _drawCallCount += secondary->drawCalls();
+    // executed buffer may have changed bound state
+    _currentPipeline = VK_NULL_HANDLE;
+    _pipelineDirty = true;
+    _descriptorDirty = true;
+}
+
 void cala::vk::CommandBuffer::pushDebugLabel(std::string_view label, std::array<f32, 4> colour) {
 #ifndef NDEBUG
     _debugLabels.push_back(label);
@@ -673,6 +756,7 @@ bool cala::vk::CommandBuffer::PipelineEqual::operator()(const PipelineKey &lhs,
 
 void cala::vk::CommandBuffer::writeBufferMarker(cala::vk::PipelineStage stage, std::string_view cmd) {
 #ifndef NDEBUG
+    std::unique_lock lock(_device->_recordMutex);
     if (_device->context().getSupportedExtensions().AMD_buffer_marker && _device->_markerBuffer[_device->frameIndex()]) {
         vkCmdWriteBufferMarkerAMD(_buffer, (VkPipelineStageFlagBits)getPipelineStage(stage), _device->_markerBuffer[_device->frameIndex()]->buffer(), _device->_offset, _device->_marker);
 
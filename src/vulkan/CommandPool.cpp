@@ -1,10 +1,11 @@
 #include <Cala/vulkan/CommandPool.h>
 #include <Cala/vulkan/Device.h>
 
-cala::vk::CommandPool::CommandPool(Device *device, QueueType queueType)
+cala::vk::CommandPool::CommandPool(Device *device, QueueType queueType, bool secondary)
     : _device(device),
     _pool(VK_NULL_HANDLE),
     _queueType(queueType),
+    _secondary(secondary),
     _index(0)
 {
     VkCommandPoolCreateInfo createInfo{};
@@ -29,6 +30,7 @@ cala::vk::CommandPool::CommandPool(cala::vk::CommandPool &&rhs) noexcept {
     std::swap(_pool, rhs._pool);
     std::swap(_buffers, rhs._buffers);
     std::swap(_queueType, rhs._queueType);
+    std::swap(_secondary, rhs._secondary);
     std::swap(_index, rhs._index);
 }
 
@@ -37,6 +39,7 @@ cala::vk::CommandPool &cala::vk::CommandPool::operator=(cala::vk::CommandPool &&
     std::swap(_pool, rhs._pool);
     std::swap(_buffers, rhs._buffers);
     std::swap(_queueType, rhs._queueType);
+    std::swap(_secondary, rhs._secondary);
     std::swap(_index, rhs._index);
     return *this;
 }
@@ -53,7 +56,7 @@ cala::vk::CommandHandle cala::vk::CommandPool::getBuffer() {
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     allocInfo.commandPool = _pool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.level = _secondary ? VK_COMMAND_BUFFER_LEVEL_SECONDARY : VK_COMMAND_BUFFER_LEVEL_PRIMARY;
     allocInfo.commandBufferCount = 1;
     VkCommandBuffer buffer;
     VK_TRY(vkAllocateCommandBuffers(_device->context().device(), &allocInfo, &buffer));
@@ -113,6 +113,9 @@ cala::vk::DeviceProperties getDeviceProperties(VkPhysicalDevice physicalDevice)
 
     properties.deviceLimits.timestampPeriod = deviceProperties.limits.timestampPeriod;
 
+    properties.deviceLimits.minStorageBufferOffsetAlignment = deviceProperties.limits.minStorageBufferOffsetAlignment;
+    properties.deviceLimits.maxViewports = deviceProperties.limits.maxViewports;
+
 
     properties.deviceLimits.maxTaskWorkGroupTotalCount = meshShaderProperties.maxTaskWorkGroupTotalCount;
     properties.deviceLimits.maxTaskWorkGroupCount[0] = meshShaderProperties.maxTaskWorkGroupCount[0];
@@ -288,6 +291,8 @@ std::expected<cala::vk::Context, cala::vk::Error> cala::vk::Context::create(cala
         context._supportedExtensions.KHR_ray_query = checkExtension(supportedDeviceExtensions, VK_KHR_RAY_QUERY_EXTENSION_NAME);
         context._supportedExtensions.KHR_pipeline_library = checkExtension(supportedDeviceExtensions, VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
         context._supportedExtensions.KHR_deferred_host_operations = checkExtension(supportedDeviceExtensions, VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME);
+        context._supportedExtensions.KHR_present_id = checkExtension(supportedDeviceExtensions, VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        context._supportedExtensions.KHR_present_wait = context._supportedExtensions.KHR_present_id && checkExtension(supportedDeviceExtensions, VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
 
         context._supportedExtensions.EXT_debug_report = checkExtension(supportedDeviceExtensions, VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
         context._supportedExtensions.EXT_debug_marker = context._supportedExtensions.EXT_debug_report && checkExtension(supportedDeviceExtensions, VK_EXT_DEBUG_MARKER_EXTENSION_NAME);
@@ -301,7 +306,26 @@ std::expected<cala::vk::Context, cala::vk::Error> cala::vk::Context::create(cala
 
 //    _supportedExtensions.AMD_buffer_marker = false;
 
+    // present wait is only used alongside present ids so both are enabled or neither
+    if (context._supportedExtensions.KHR_present_wait) {
+        VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+        presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+        VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+        presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+        presentIdFeatures.pNext = &presentWaitFeatures;
+        VkPhysicalDeviceFeatures2 features{};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &presentIdFeatures;
+        vkGetPhysicalDeviceFeatures2(context._physicalDevice, &features);
+        context._supportedExtensions.KHR_present_wait = presentIdFeatures.presentId && presentWaitFeatures.presentWait;
+    }
+    context._supportedExtensions.KHR_present_id = context._supportedExtensions.KHR_present_wait;
+
     deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    if (context._supportedExtensions.KHR_present_wait) {
+        deviceExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        deviceExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    }
     if (context._supportedExtensions.EXT_memory_budget)
         deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
 #ifndef NDEBUG
@@ -404,6 +428,17 @@ std::expected<cala::vk::Context, cala::vk::Error> cala::vk::Context::create(cala
     if (info.requestedFeatures.meshShader && context._supportedExtensions.EXT_mesh_shader)
         appendFeatureChain(&deviceFeatures2, &meshShaderFeatures);
 
+    VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+    presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    presentIdFeatures.presentId = VK_TRUE;
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+    presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+    presentWaitFeatures.presentWait = VK_TRUE;
+    if (context._supportedExtensions.KHR_present_wait) {
+        appendFeatureChain(&deviceFeatures2, &presentIdFeatures);
+        appendFeatureChain(&deviceFeatures2, &presentWaitFeatures);
+    }
+
     // create device
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -433,6 +468,7 @@ std::expected<cala::vk::Context, cala::vk::Error> cala::vk::Context::create(cala
     context._enabledFeatures.meshShading = meshShaderFeatures.meshShader;
     context._enabledFeatures.deviceAddress = vulkan12Features.bufferDeviceAddress;
     context._enabledFeatures.sync2 = vulkan13Features.synchronization2;
+    context._enabledFeatures.textureCompressionBC = deviceFeatures2.features.textureCompressionBC;
 
     // init VMA
     VmaAllocatorCreateInfo allocatorCreateInfo{};
@@ -641,6 +677,12 @@ void cala::vk::Context::setDebugName(u32 type, u64 object, std::string_view name
 }
 
 
+bool cala::vk::Context::formatSupported(Format format, VkFormatFeatureFlags features) const {
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(_physicalDevice, getFormat(format), &properties);
+    return (properties.optimalTilingFeatures & features) == features;
+}
+
 bool cala::vk::Context::queueIndex(u32& index, QueueType type, QueueType rejectType) const {
     u32 flags = static_cast<u32>(type);
     u32 rejected = static_cast<u32>(rejectType);
@@ -29,6 +29,10 @@ std::expected<std::unique_ptr<cala::vk::Device>, cala::vk::Error> cala::vk::Devi
     for (auto& frameCommandPool : device->_commandPools) {
         frameCommandPool = { CommandPool(device.get(), QueueType::GRAPHICS), CommandPool(device.get(), QueueType::COMPUTE), CommandPool(device.get(), QueueType::TRANSFER) };
     }
+    for (auto& threadCommandPools : device->_secondaryCommandPools) {
+        for (u32 thread = 0; thread < info.recordingThreads; thread++)
+            threadCommandPools.emplace_back(device.get(), QueueType::GRAPHICS, true);
+    }
 
     device->_timelineSemaphore = Semaphore(device.get(), info.useTimeline ? 10 : -1);
     device->_immediateSemaphore = Semaphore(device.get(), info.useTimeline ? 1 : -1);
@@ -198,6 +202,10 @@ cala::vk::Device::~Device() {
         for (auto& pool : poolArray)
             pool.destroy();
     }
+    for (auto& threadCommandPools : _secondaryCommandPools) {
+        for (auto& pool : threadCommandPools)
+            pool.destroy();
+    }
 
     _descriptorSets.clear();
     vkDestroyDescriptorSetLayout(_context.device(), _bindlessLayout, nullptr);
@@ -261,6 +269,7 @@ cala::vk::Device::Device(cala::vk::Device &&rhs) noexcept {
     std::swap(_logger, rhs._logger);
     std::swap(_context, rhs._context);
     std::swap(_commandPools, rhs._commandPools);
+    std::swap(_secondaryCommandPools, rhs._secondaryCommandPools);
     std::swap(_timelineSemaphore, rhs._timelineSemaphore);
     std::swap(_immediateSemaphore, rhs._immediateSemaphore);
     std::swap(_frameValues, rhs._frameValues);
@@ -301,6 +310,7 @@ cala::vk::Device &cala::vk::Device::operator==(cala::vk::Device &&rhs) noexcept
     std::swap(_logger, rhs._logger);
     std::swap(_context, rhs._context);
     std::swap(_commandPools, rhs._commandPools);
+    std::swap(_secondaryCommandPools, rhs._secondaryCommandPools);
     std::swap(_timelineSemaphore, rhs._timelineSemaphore);
     std::swap(_immediateSemaphore, rhs._immediateSemaphore);
     std::swap(_frameValues, rhs._frameValues);
@@ -358,6 +368,8 @@ std::expected<cala::vk::Device::FrameInfo, cala::vk::Error> cala::vk::Device::be
 
     for (auto& pool : _commandPools[frameIndex()])
         pool.reset();
+    for (auto& pool : _secondaryCommandPools[frameIndex()])
+        pool.reset();
 
     if (waitResult) {
         return FrameInfo{
@@ -374,7 +386,7 @@ std::chrono::high_resolution_clock::duration cala::vk::Device::endFrame() {
     return _lastFrameTime;
 }
 
-std::expected<void, cala::vk::Error> cala::vk::Device::waitFrame(u64 frame, u64 timeout) {
+std::expected<void, cala::vk::Error> cala::vk::Device::waitFrame(u64 frame, u64 timeout, bool reset) {
     PROFILE_NAMED("Device::waitFrame");
     if (usingTimeline()) {
         u64 waitValue = _frameValues[frame];
@@ -385,11 +397,18 @@ std::expected<void, cala::vk::Error> cala::vk::Device::waitFrame(u64 frame, u64
         if (res == VK_ERROR_DEVICE_LOST) {
             return std::unexpected(static_cast<Error>(res));
         }
-        vkResetFences(_context.device(), 1, &fence);
+        if (reset)
+            vkResetFences(_context.device(), 1, &fence);
     }
     return {};
 }
 
+bool cala::vk::Device::frameComplete(u64 frame) {
+    if (usingTimeline())
+        return _timelineSemaphore.queryGPUValue() >= _frameValues[frame];
+    return vkGetFenceStatus(_context.device(), _frameFences[frame]) == VK_SUCCESS;
+}
+
 bool cala::vk::Device::wait(u64 timeout) {
     return VK_SUCCESS == vkQueueWaitIdle(_context.getQueue(QueueType::GRAPHICS));
 }
@@ -449,6 +468,11 @@ cala::vk::CommandHandle cala::vk::Device::getCommandBuffer(u32 frame, QueueType
     return _commandPools[frame][index].getBuffer();
 }
 
+cala::vk::CommandHandle cala::vk::Device::getSecondaryCommandBuffer(u32 frame, u32 thread) {
+    assert(frame < FRAMES_IN_FLIGHT && thread < _secondaryCommandPools[frame].size());
+    return _secondaryCommandPools[frame][thread].getBuffer();
+}
+
 
 bool cala::vk::Device::gc() {
     PROFILE_NAMED("Device::gc");
@@ -707,6 +731,22 @@ cala::vk::ImageHandle cala::vk::Device::createImage(Image::CreateInfo info) {
     return _imageList.getHandle(this, index);
 }
 
+cala::vk::ImageHandle cala::vk::Device::recreateImage(ImageHandle handle, Image::CreateInfo info) {
+    if (!handle)
+        return createImage(info);
+    i32 handleIndex = handle.index();
+    auto newHandle = createImage(info);
+    i32 index = newHandle.index();
+
+    std::swap(_imageList._resources[index].first, _imageList._resources[handleIndex].first);
+
+    bool isSampled = (info.usage & ImageUsage::SAMPLED) == ImageUsage::SAMPLED;
+    bool isStorage = (info.usage & ImageUsage::STORAGE) == ImageUsage::STORAGE;
+    updateBindlessImage(handleIndex, _imageList.getResource(handleIndex)->_defaultView, isSampled, isStorage);
+    // newHandle now refers to the old image and queues it for destruction when released
+    return handle;
+}
+
 cala::vk::ImageHandle cala::vk::Device::getImageHandle(u32 index) {
     assert(index < _imageList.allocated());
     return _imageList.getHandle(this, index);
@@ -793,6 +833,7 @@ cala::vk::PipelineLayoutHandle cala::vk::Device::recreatePipelineLayout(cala::vk
 
 
 cala::vk::SamplerHandle cala::vk::Device::getSampler(Sampler::CreateInfo info) {
+    std::unique_lock lock(_recordMutex);
     for (i32 index = 0; index < _samplers.size(); index++) {
         if (_samplers[index].first == info)
             return { this, index, nullptr };
@@ -955,6 +996,7 @@ void cala::vk::Device::clearFramebuffers() {
 
 VkDescriptorSet cala::vk::Device::getDescriptorSet(CommandBuffer::DescriptorKey key) {
     PROFILE_NAMED("Device::getDescriptorSet");
+    std::unique_lock lock(_recordMutex);
 
     if (key.setLayout == VK_NULL_HANDLE)
         return VK_NULL_HANDLE;
@@ -1024,6 +1066,7 @@ VkDescriptorSet cala::vk::Device::getDescriptorSet(CommandBuffer::DescriptorKey
 
 std::expected<VkPipeline, cala::vk::Error> cala::vk::Device::getPipeline(CommandBuffer::PipelineKey key) {
     PROFILE_NAMED("Device::getPipeline");
+    std::unique_lock lock(_recordMutex);
     // check if exists in cache
     auto it = _pipelines.find(key);
     if (it != _pipelines.end())
@@ -1066,42 +1109,17 @@ std::expected<VkPipeline, cala::vk::Error> cala::vk::Device::getPipeline(Command
         inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
         inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-        auto frameSize = key.framebuffer->extent();
-
-        VkViewport viewport{};
-
-        //default viewport
-        if (key.viewPort.x == 0 &&
-                key.viewPort.y == 0 &&
-                key.viewPort.width == 0 &&
-                key.viewPort.height == 0 &&
-                key.viewPort.minDepth == 0.f &&
-                key.viewPort.maxDepth == 1.f) {
-            viewport.x = 0.f;
-            viewport.y = 0.f;
-            viewport.width = frameSize.first;
-            viewport.height = frameSize.second;
-            viewport.minDepth = 0.f;
-            viewport.maxDepth = 1.f;
-        } else { //custom viewport
-            viewport.x = key.viewPort.x;
-            viewport.y = key.viewPort.y;
-            viewport.width = key.viewPort.width;
-            viewport.height = key.viewPort.height;
-            viewport.minDepth = key.viewPort.minDepth;
-            viewport.maxDepth = key.viewPort.maxDepth;
-        }
-
-        VkRect2D scissor{};
-        scissor.offset = {0, 0};
-        scissor.extent = {.width=frameSize.first, .height=frameSize.second};
-
+        // viewports and scissors including their count are set when recording so pipelines are shared between viewports
         VkPipelineViewportStateCreateInfo viewportState{};
         viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-        viewportState.viewportCount = 1;
-        viewportState.pViewports = &viewport;
-        viewportState.scissorCount = 1;
-        viewportState.pScissors = &scissor;
+        viewportState.viewportCount = 0;
+        viewportState.scissorCount = 0;
+
+        VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT_WITH_COUNT, VK_DYNAMIC_STATE_SCISSOR_WITH_COUNT };
+        VkPipelineDynamicStateCreateInfo dynamicState{};
+        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicState.dynamicStateCount = 2;
+        dynamicState.pDynamicStates = dynamicStates;
 
         VkPipelineRasterizationStateCreateInfo rasterizer{};
         rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -1172,6 +1190,7 @@ std::expected<VkPipeline, cala::vk::Error> cala::vk::Device::getPipeline(Command
         pipelineInfo.pMultisampleState = &multisample;
         pipelineInfo.pDepthStencilState = &depthStencil;
         pipelineInfo.pColorBlendState = &colorBlending;
+        pipelineInfo.pDynamicState = &dynamicState;
         pipelineInfo.layout = key.layout;
 
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
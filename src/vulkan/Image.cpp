@@ -170,6 +170,25 @@ void cala::vk::Image::copy(cala::vk::CommandHandle buffer, cala::vk::Image &dst,
     vkCmdCopyImage(buffer->buffer(), _image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst.image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
 }
 
+void cala::vk::Image::copy(cala::vk::CommandHandle buffer, cala::vk::Image &dst, VkOffset3D srcOffset, VkOffset3D dstOffset, VkExtent3D extent) {
+    VkImageCopy region{};
+
+    region.srcSubresource.aspectMask = isDepthFormat(_format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+    region.srcSubresource.mipLevel = 0;
+    region.srcSubresource.baseArrayLayer = 0;
+    region.srcSubresource.layerCount = 1;
+
+    region.dstSubresource.aspectMask = isDepthFormat(dst._format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+    region.dstSubresource.mipLevel = 0;
+    region.dstSubresource.baseArrayLayer = 0;
+    region.dstSubresource.layerCount = 1;
+
+    region.srcOffset = srcOffset;
+    region.dstOffset = dstOffset;
+    region.extent = extent;
+    vkCmdCopyImage(buffer->buffer(), _image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst.image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+}
+
 void cala::vk::Image::copy(cala::vk::CommandHandle buffer, cala::vk::Buffer &dst, u32 dstOffset, u32 srcLayer, u32 srcMipLevel) {
     VkBufferImageCopy region{};
 
@@ -106,6 +106,7 @@ cala::vk::Swapchain::Swapchain(cala::vk::Swapchain &&rhs) noexcept {
     std::swap(_mode, rhs._mode);
     std::swap(_extent, rhs._extent);
     std::swap(_frame, rhs._frame);
+    std::swap(_lastPresentId, rhs._lastPresentId);
     std::swap(_images, rhs._images);
     std::swap(_imageViews, rhs._imageViews);
     std::swap(_semaphores, rhs._semaphores);
@@ -120,6 +121,7 @@ cala::vk::Swapchain &cala::vk::Swapchain::operator==(cala::vk::Swapchain &&rhs)
     std::swap(_mode, rhs._mode);
     std::swap(_extent, rhs._extent);
     std::swap(_frame, rhs._frame);
+    std::swap(_lastPresentId, rhs._lastPresentId);
     std::swap(_images, rhs._images);
     std::swap(_imageViews, rhs._imageViews);
     std::swap(_semaphores, rhs._semaphores);
@@ -162,6 +164,17 @@ std::expected<bool, cala::vk::Error> cala::vk::Swapchain::present(Frame frame) {
         presentInfo.pImageIndices = &frame.index;
         presentInfo.pResults = nullptr;
 
+        // ids have to be non zero and increasing
+        u64 presentId = frame.id + 1;
+        VkPresentIdKHR presentIdInfo{};
+        presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+        presentIdInfo.swapchainCount = 1;
+        presentIdInfo.pPresentIds = &presentId;
+        if (presentWaitSupported()) {
+            presentInfo.pNext = &presentIdInfo;
+            _lastPresentId = presentId;
+        }
+
         auto res = vkQueuePresentKHR(_device->context().getQueue(QueueType::PRESENT), &presentInfo);
         if (res != VK_SUCCESS && res != VK_SUBOPTIMAL_KHR) {
             return std::unexpected(static_cast<Error>(res));
@@ -171,6 +184,23 @@ std::expected<bool, cala::vk::Error> cala::vk::Swapchain::present(Frame frame) {
     return std::unexpected(Error::INVALID_SURFACE);
 }
 
+bool cala::vk::Swapchain::presentWaitSupported() const {
+    return _surface != VK_NULL_HANDLE && _device->context().getSupportedExtensions().KHR_present_wait;
+}
+
+std::expected<bool, cala::vk::Error> cala::vk::Swapchain::waitForPresent(u64 presentId, u64 timeout) {
+    if (!presentWaitSupported())
+        return std::unexpected(Error::INVALID_SURFACE);
+    if (presentId == 0)
+        return true;
+    auto res = vkWaitForPresentKHR(_device->context().device(), _swapchain, presentId, timeout);
+    if (res == VK_TIMEOUT)
+        return false;
+    if (res == VK_SUCCESS || res == VK_SUBOPTIMAL_KHR || res == VK_ERROR_OUT_OF_DATE_KHR)
+        return true;
+    return std::unexpected(static_cast<Error>(res));
+}
+
 bool cala::vk::Swapchain::resize(u32 width, u32 height) {
     for (auto& view : _imageViews)
         vkDestroyImageView(_device->context().device(), view, nullptr);